@@ -9,6 +9,7 @@
 
 #include <ostream>
 #include <stack>
+#include <vector>
 
 #include <cstdio>
 
@@ -359,6 +360,28 @@ class ViewInfo<kViewTypeImpl> : public ViewInfoBase {
   wxString fun_str_ = "(int row, int col) {\nreturn 0;\n}";
 };
 
+template<>
+class ViewInfo<kViewTypeBand> : public ViewInfoBase {
+ public:
+  ViewInfo() : ViewInfoBase(kViewTypeBand) {}
+  void WriteConfig(JsonPrettyWriter& w) const override {
+    ViewInfoBase::WriteConfig(w);
+    w.String("offsets").StartArray();
+    for (const auto& offset : offsets_)
+      w.Int(offset);
+    w.EndArray();
+  }
+  void ReadConfig(const JsonValue& val) override {
+    ViewInfoBase::ReadConfig(val);
+    const JsonValue& offsets = val["offsets"];
+    offsets_.resize(offsets.Size());
+    for (rapidjson::SizeType i = 0; i < offsets.Size(); ++i)
+      offsets_[i] = offsets[i].GetInt();
+  }
+ private:
+  std::vector<int> offsets_ = {-1, 0, 1};  // column minus row
+};
+
 // TODO: specialize for more view types
 
 ViewInfoBase*
@@ -376,6 +399,7 @@ ViewInfoBase::Create(ViewType type, ViewTree::ItemDataBase::Direction dir) {
     SMVD_SWITCH_CASE(kViewTypeSparse);
     SMVD_SWITCH_CASE(kViewTypeDiag);
     SMVD_SWITCH_CASE(kViewTypeImpl);
+    SMVD_SWITCH_CASE(kViewTypeBand);
     default:
       wxASSERT("Missing switch case");
       return nullptr;
@@ -11,7 +11,8 @@ enum ViewType : unsigned char {
       kViewTypeSparse,
       kViewTypeDiag,
       kViewTypeImpl,
-      kViewTypeMax_ = kViewTypeImpl
+      kViewTypeBand,
+      kViewTypeMax_ = kViewTypeBand
 };
 
 namespace std {
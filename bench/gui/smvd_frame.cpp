@@ -31,6 +31,7 @@ class ViewTypeChoice : public ViewTypeSparseArray<wxString> {
     (*this)[kViewTypeSparse] = "sparse";
     (*this)[kViewTypeDiag] = "diag";
     (*this)[kViewTypeImpl] = "impl";
+    (*this)[kViewTypeBand] = "band";
   }
 };
 
@@ -127,6 +128,7 @@ const ViewParamsChoiceBase& ViewParamsChoiceBase::get(ViewType type) {
     SMVD_SWITCH_CASE(kViewTypeSparse);
     SMVD_SWITCH_CASE(kViewTypeDiag);
     SMVD_SWITCH_CASE(kViewTypeImpl);
+    SMVD_SWITCH_CASE(kViewTypeBand);
   }
 #undef SMVD_SWITCH_CASE
   throw "unreachable";
@@ -0,0 +1,21 @@
+#ifndef CPPVIEWS_BENCH_SM_SPARSE_HASH_FACADE_HPP_
+#define CPPVIEWS_BENCH_SM_SPARSE_HASH_FACADE_HPP_
+
+#include "../../smv_facade.hpp"
+
+#include "../../../src/sparse_list.hpp"
+
+template<typename T>
+#define V_THIS_ADAPTEE_TYPE v::SparseHashList<T, 2>
+class SmvFacade<V_THIS_ADAPTEE_TYPE> : public V_THIS_ADAPTEE_TYPE {
+  typedef V_THIS_ADAPTEE_TYPE ListType;
+#undef V_THIS_ADAPTEE_TYPE
+ public:
+  typedef unsigned CoordType;
+
+  SmvFacade(T* default_value,
+            const CoordType& row_count, const CoordType& col_count)
+      : ListType(v::SparseListTag<2>(), default_value, row_count, col_count) {}
+};
+
+#endif  /* CPPVIEWS_BENCH_SM_SPARSE_HASH_FACADE_HPP_ */
@@ -11,7 +11,27 @@ class SmvFacade {
   template<typename DataType>
   void VecMult(const VecInfo<DataType, CoordType>& vi,
                std::vector<DataType>* res) const {
-    auto& smv_ = *static_cast<const ViewType*>(this);
+    VecMult(*static_cast<const ViewType*>(this), vi, res, 0);
+  }
+
+ private:
+  // use the native kernel if the view provides one (e.g., Diag)
+  template<class SmvType, typename DataType>
+  static auto VecMult(const SmvType& smv_,
+                      const VecInfo<DataType, CoordType>& vi,
+                      std::vector<DataType>* res, int)
+      -> decltype(smv_.Multiply(res->data(), res->data())) {
+    std::vector<DataType> x(ColCount(smv_));
+    for (const auto& e : vi)
+      x[e.first] = e.second;
+    res->resize(RowCount(smv_));
+    smv_.Multiply(x.data(), res->data());
+  }
+
+  template<class SmvType, typename DataType>
+  static void VecMult(const SmvType& smv_,
+                      const VecInfo<DataType, CoordType>& vi,
+                      std::vector<DataType>* res, long) {
     res->resize(RowCount(smv_));
     for (CoordType r = 0, r_end = res->size(); r < r_end; ++r) {
       DataType val = 0;
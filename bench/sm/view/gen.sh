@@ -22,7 +22,13 @@ name=${name%.*}
 mtx=$(find_mtx "$name")
 (( $? != 0 )) && exit 3
 
-hpp="$src_dir/$name.hpp"
+suffix=
+for opt in "$@"; do
+    case "$opt" in
+	--tuple-chain) suffix=_tuple ;;
+    esac
+done
+hpp="$src_dir/$name$suffix.hpp"
 data_type=$(mtx_data_type "$mtx")
 smv_gen_cmd="'$smv_gen' $@ '$smvd' '$mtx' $data_type"
 echo "$smv_gen_cmd > '$hpp'" >&2
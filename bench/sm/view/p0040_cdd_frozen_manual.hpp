@@ -0,0 +1,22 @@
+#ifndef CPPVIEWS_BENCH_SM_VIEW_P0040_CDD_FROZEN_MANUAL_HPP_
+#define CPPVIEWS_BENCH_SM_VIEW_P0040_CDD_FROZEN_MANUAL_HPP_
+
+#include "p0040_cdd_manual.hpp"
+
+#include "../../../src/compiled_view.hpp"
+
+// The same view as p0040_cdd_manual, but frozen into a flat block index
+class p0040_cdd_frozen_manual
+    : public v::CompiledView<int>,
+      public SmvFacade<p0040_cdd_frozen_manual> {
+ public:
+  p0040_cdd_frozen_manual() : v::CompiledView<int>(Source()) {}
+
+ private:
+  static const p0040_cdd_manual& Source() {
+    static p0040_cdd_manual instance;  // the frozen view aliases its storage
+    return instance;
+  }
+};
+
+#endif  // CPPVIEWS_BENCH_SM_VIEW_P0040_CDD_FROZEN_MANUAL_HPP_
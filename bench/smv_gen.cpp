@@ -30,8 +30,50 @@ unsigned ToChainDim(const JsonValue& direction_val) {
   return 1 - direction_val.GetUint();
 }
 
+// Returns the sorted offsets of the diagonals of a band (without duplicates)
+std::vector<int> GetBandOffsets(const JsonValue& val) {
+  const JsonValue& offsets_val = val["offsets"];
+  std::vector<int> offsets;
+  for (rapidjson::SizeType i = 0; i < offsets_val.Size(); ++i)
+    offsets.push_back(offsets_val[i].GetInt());
+  std::sort(offsets.begin(), offsets.end());
+  offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+  return offsets;
+}
+
+// Returns the concrete type of a (nested) view, which is needed only for the
+// sublists of a TupleChain (otherwise, they are stored as v::ListBase)
+std::string GetType(const JsonValue& val, const std::string& data_type) {
+  ViewType type = static_cast<ViewType>(val["type"].GetInt());
+  switch (type) {
+    case kViewTypeChain: {
+      std::string type_name = "v::TupleChain<" +
+          std::to_string(ToChainDim(val["direction"]));
+      SMV_JSON_FOR(m, val) {
+        if (m->name.GetString()[0] == '_')
+          type_name += ", " + GetType(m->value, data_type);
+      }
+      return type_name + " >";
+    }
+    case kViewTypeDiag:
+      return "v::Diag<" + data_type + ", unsigned, " +
+          std::to_string(val["block_rows"].GetUint()) + ", " +
+          std::to_string(val["block_cols"].GetUint()) + ">";
+    case kViewTypeSparse:
+      return "v::SparseHashList<" + data_type + ", 2>";
+    case kViewTypeBand: {
+      std::string type_name = "v::Band<" + data_type;
+      for (const auto& offset : GetBandOffsets(val))
+        type_name += ", " + std::to_string(offset);
+      return type_name + ">";
+    }
+    default:
+      throw std::runtime_error("unsupported view type");
+  }
+}
+
 std::string GetNestingType(const JsonValue& val,
-                           const std::string& data_type) {
+                           const std::string& data_type, bool tuple_chain) {
   // TODO: determine common type by unification of nested view types
   // SMV_JSON_FOR(m, val) {
   //   const char* name = m->name.GetString();
@@ -42,6 +84,8 @@ std::string GetNestingType(const JsonValue& val,
   ViewType type = static_cast<ViewType>(val["type"].GetInt());
   switch (type) {
     case kViewTypeChain:
+      if (tuple_chain)
+        return GetType(val, data_type);
       return "v::Chain<v::ListBase<" + data_type + ", 2>, " +
           std::to_string(ToChainDim(val["direction"])) + ">";
     default:
@@ -85,7 +129,8 @@ bool AllSame(const SM& sm, const Indexes& first, const Indexes& last,
 }
 
 Indexes Generate(const JsonValue& val, const SM& sm,
-                 const std::string& data_type, std::vector<Assignment>* asgns,
+                 const std::string& data_type, bool tuple_chain,
+                 std::vector<Assignment>* asgns,
                  std::string* indent, std::ostream* os) {
   const Indexes first(val["first_row"].GetUint(), val["first_col"].GetUint());
   const Indexes last(val["last_row"].GetUint(), val["last_col"].GetUint());
@@ -97,6 +142,13 @@ Indexes Generate(const JsonValue& val, const SM& sm,
   ViewType type = static_cast<ViewType>(val["type"].GetInt());
   switch (type) {
     case kViewTypeChain:
+      if (tuple_chain) {
+        *os << kLF
+            << *indent << "v::TupleChainTag<" <<
+            ToChainDim(val["direction"]) <<
+            ">(), std::make_tuple(";
+        break;
+      }
       *os << kLF
           << *indent << "v::ChainTag<" <<
           ToChainDim(val["direction"]) <<
@@ -131,6 +183,22 @@ Indexes Generate(const JsonValue& val, const SM& sm,
       Indent(indent);
       return first;
     }
+    case kViewTypeBand: {
+      *os << "[] {" << kLF
+          << *indent << GetType(val, data_type) <<
+          " v(ZeroPtr<" << data_type << ">()" <<
+          ", " << size.row << ", " << size.col << ");" << kLF;
+      for (auto row = first.row; row <= last.row; ++row) {
+        for (auto cols = sm.nonzero_col_range(row, first.col, last.col + 1);
+             cols.first != cols.second; ++cols.first)
+          asgns->emplace_back(row, *cols.first, sm(row, *cols.first));
+      }
+      *os << *indent << "return v;" << kLF;
+      Unindent(indent);
+      *os << *indent << "}()";
+      Indent(indent);
+      return first;
+    }
     case kViewTypeSparse:
       *os << "[] {" << kLF
           << *indent << "auto v = v::MakeList(v::SparseListTag<2>()"
@@ -158,11 +226,23 @@ Indexes Generate(const JsonValue& val, const SM& sm,
   SMV_JSON_FOR(m, val) {
     const char* name = m->name.GetString();
     if (name[0] == '_') {
-      *os << *indent << ".Append(";
+      // the sublists of a TupleChain are the arguments of std::make_tuple
+      // (so nested chains are created by MakeList instead of Append)
+      const bool nested_chain = tuple_chain &&
+          m->value["type"].GetInt() == kViewTypeChain;
+      if (tuple_chain)
+        *os << (nesting_offsets.empty() ? "" : ",") << kLF
+            << *indent << kIndent << (nested_chain ? "v::MakeList(" : "");
+      else
+        *os << *indent << ".Append(";
       Indent(indent), Indent(indent);
-      auto nested_first = Generate(m->value, sm, data_type, asgns, indent, os);
+      auto nested_first = Generate(m->value, sm, data_type, tuple_chain,
+                                   asgns, indent, os);
       Unindent(indent), Unindent(indent);
-      *os << ")" << kLF;
+      if (!tuple_chain || nested_chain)
+        *os << ")";
+      if (!tuple_chain)
+        *os << kLF;
       nesting_offsets.emplace_back(nested_first.row - first.row,
                                    nested_first.col - first.col);
     }
@@ -170,6 +250,8 @@ Indexes Generate(const JsonValue& val, const SM& sm,
 
   switch (type) {
     case kViewTypeChain:
+      if (tuple_chain)
+        *os << ")" << kLF;
       *os << *indent << ", ZeroPtr<" << data_type <<
           ">(), v::ChainOffsetVector<2>({" << kLF;
       Indent(indent), Indent(indent); {
@@ -189,7 +271,8 @@ Indexes Generate(const JsonValue& val, const SM& sm,
 }
 
 void Generate(const std::string& name, const rapidjson::Document& doc,
-              const SM& sm, const std::string& data_type, std::ostream* os) {
+              const SM& sm, const std::string& data_type, bool tuple_chain,
+              std::ostream* os) {
   using namespace std;
   string guard = "CPPVIEWS_BENCH_SM_VIEW_" + name + "_HPP_";
   transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
@@ -202,13 +285,16 @@ void Generate(const std::string& name, const rapidjson::Document& doc,
       << R"(#include "../../smv_factory.hpp")" << kLF
       << R"(#include "../../gui/sm/view_type.hpp")" << kLF
       << kLF
+      << R"(#include "../../../src/band.hpp")" << kLF
       << R"(#include "../../../src/chain.hpp")" << kLF
       << R"(#include "../../../src/diag.hpp")" << kLF
       << R"(#include "../../../src/sparse_list.hpp")" << kLF
+      << (tuple_chain ? R"(#include "../../../src/tuple_chain.hpp")" : "")
+      << (tuple_chain ? "\n" : "")
       << kLF
       << "class " << name << kLF
       << R"(#define SM_BASE_TYPE \)" << kLF
-      << kIndent << GetNestingType(doc, data_type) <<
+      << kIndent << GetNestingType(doc, data_type, tuple_chain) <<
       "  // avoid type repetition" << kLF
       << kIndent << kIndent << ": public SM_BASE_TYPE"
       << ", public SmvFacade<" << name << "> {" << kLF
@@ -221,7 +307,7 @@ void Generate(const std::string& name, const rapidjson::Document& doc,
   std::vector<Assignment> asgns;
   string indent(kIndent);
   Indent(&indent), Indent(&indent);
-  Generate(doc, sm, data_type, &asgns, &indent, os);
+  Generate(doc, sm, data_type, tuple_chain, &asgns, &indent, os);
   Unindent(&indent), Unindent(&indent);
 
   *os << ") {" << kLF;
@@ -265,17 +351,30 @@ int main(int argc, char* argv[]) {
   using namespace std;
   cout.sync_with_stdio(false);
 
-  if (argc <= 2) {
-    cerr << "Usage: " << argv[0] << " SMVD_FILE MTX_FILE [DATA_TYPE]" << endl;
+  // with --tuple-chain, the chains are TupleChains of concrete sublist types
+  // (and the generated view is suffixed by _tuple)
+  bool tuple_chain = false;
+  char** args = argv;
+  int arg_count = argc;
+  for (; arg_count > 1 && !strncmp(args[1], "--", 2); ++args, --arg_count) {
+    if (!strcmp(args[1], "--tuple-chain"))
+      tuple_chain = true;
+    else
+      break;
+  }
+
+  if (arg_count <= 2) {
+    cerr << "Usage: " << argv[0] << " [--tuple-chain]"
+         << " SMVD_FILE MTX_FILE [DATA_TYPE]" << endl;
     return 1;
   }
-  const string json_path(argv[1]);
-  const string mtx_path(argv[2]);
-  const string data_type(argc > 3 ? argv[3] : "int"); // TODO: parse from mtx
+  const string json_path(args[1]);
+  const string mtx_path(args[2]);
+  const string data_type(arg_count > 3 ? args[3] : "int"); // TODO: from mtx
 
   const string basename_path(json_path.substr(0, json_path.rfind('.')));
   const string name = basename_path.substr(
-      basename_path.find_last_of("/\\") + 1);
+      basename_path.find_last_of("/\\") + 1) + (tuple_chain ? "_tuple" : "");
 
   rapidjson::Document doc;
   {
@@ -299,6 +398,6 @@ int main(int argc, char* argv[]) {
     sm.Init(mtx_stream);
   }
 
-  Generate(name, doc, sm, data_type, &cout);
+  Generate(name, doc, sm, data_type, tuple_chain, &cout);
   return 0;
 }
@@ -3,6 +3,7 @@
 #include "smv_run.hpp"
 #include "smv_factory.hpp"
 
+#include "../src/parallel.hpp"
 #include "util/program_options.hpp"
 
 #include <algorithm>
@@ -57,7 +58,13 @@ struct SmvRunOptions : public ProgramOptions<> {
         vector_density("vector-density", "Make vector to mult sparse.", this),
         access_count('c', "access-count",
                      "Sets the total number of accesses the sparse matrix view",
-                     this) {}
+                     this),
+        max_step("max-step",
+                 "Sets the maximum distance between consecutive accesses\n"
+                 "in each dimension (used by local random access)", this),
+        threads('t', "threads",
+                "Sets the number of threads that iterate over the values\n"
+                "(used by nsi if the values support partition())", this) {}
 
   void PrintUsage(const char* argv0, std::ostream* os) const override {
     *os << "Usage: " << argv0 << " <bench>" << std::endl;
@@ -81,6 +88,8 @@ struct SmvRunOptions : public ProgramOptions<> {
 
   Option<double> vector_density;
   Option<size_t> access_count;
+  Option<unsigned> max_step;
+  Option<unsigned> threads;
 
  protected:
   void InitDefaults(int argc, char** argv) {
@@ -100,6 +109,8 @@ struct SmvRunOptions : public ProgramOptions<> {
     SetIfNot(false, &all_runs);
 
     SetIfNot(1.0, &vector_density);
+    SetIfNot(1u, &max_step);
+    SetIfNot(1u, &threads);
   }
 
  private:
@@ -198,6 +209,68 @@ struct SampledRandomAccess : public Benchmark {
   }
 };
 
+// Creates a cursor for repeated accesses if supported (e.g., by v::Chain),
+// otherwise falls back to accessing the matrix directly
+template<class Matrix>
+auto MakeCursor(const Matrix& m, int) -> decltype(m.cursor()) {
+  return m.cursor();
+}
+
+template<class Matrix>
+const Matrix* MakeCursor(const Matrix& m, long) { return &m; }
+
+template<class Cursor>
+auto Seek(Cursor& cursor, Coord row, Coord col)
+    -> decltype(cursor.seek({row, col})) {
+  return cursor.seek({row, col});
+}
+
+template<class Matrix>
+auto Seek(const Matrix* m, Coord row, Coord col) -> decltype((*m)(row, col)) {
+  return (*m)(row, col);
+}
+
+// Accesses the elements in a random walk, moving at most --max-step rows and
+// columns at a time (via a cursor if use_cursor and supported by the matrix)
+template<bool use_cursor>
+struct LocalRandomAccess : public Benchmark {
+  LocalRandomAccess() {
+    if (!gPO.access_count.count())
+      throw std::invalid_argument("Missing --access-count");
+  }
+
+  void Init() override {
+    const long max_step = gPO.max_step();
+    std::uniform_int_distribution<long> step_dis(-max_step, max_step);
+    auto walk = [&](long coord, long coord_count) {
+      coord += step_dis(gen_);
+      return std::min(std::max(coord, 0L), coord_count - 1);
+    };
+
+    coord_pairs_.resize(gPO.access_count());
+    Coord row = RowCount(smv_) / 2, col = ColCount(smv_) / 2;
+    for (auto& cp : coord_pairs_) {
+      cp.first = row = walk(row, RowCount(smv_));
+      cp.second = col = walk(col, ColCount(smv_));
+    }
+  }
+
+  void Run() override {
+    if (use_cursor) {
+      auto cursor = MakeCursor(smv_, 0);
+      for (const auto& cp : coord_pairs_)
+        hash_ += Seek(cursor, cp.first, cp.second);
+    } else {
+      for (const auto& cp : coord_pairs_)
+        hash_ += smv_(cp.first, cp.second);
+    }
+  }
+
+ private:
+  typedef std::pair<Coord, Coord> CoordPair;
+  std::vector<CoordPair> coord_pairs_;
+};
+
 struct FilteredRandomAccess : public Benchmark {
   template<class Func>
   FilteredRandomAccess(Func filter) {
@@ -249,12 +322,42 @@ struct ZeroRandomAccess : public FilteredRandomAccess {
       }) {}
 };
 
+// Adds the sum of values to *hash in parallel if the values support
+// partition() (e.g., those of v::Chain), otherwise returns false
+template<class Matrix>
+auto ParallelSumValues(const Matrix& m, ThreadPool* pool, size_t* hash, int)
+    -> decltype(m.values().partition(1), bool()) {
+  if (hash != nullptr)
+    *hash += v::parallel::Reduce(m.values(), Data(), std::plus<Data>(), pool);
+  return true;
+}
+
+template<class Matrix>
+bool ParallelSumValues(const Matrix& m, ThreadPool* pool, size_t* hash, long) {
+  return false;
+}
+
 struct NonZeroSequentialIteration : public Benchmark {
   NonZeroSequentialIteration()
       : access_count_(
-            gPO.access_count.count() ? gPO.access_count() : smv_.size()) {}
+            gPO.access_count.count() ? gPO.access_count() : smv_.size()) {
+    if (gPO.threads() > 1) {
+      pool_.reset(new ThreadPool(gPO.threads()));
+      if (!ParallelSumValues(smv_, pool_.get(), nullptr, 0))
+        throw std::invalid_argument("Values do not support --threads");
+    }
+  }
 
   void Run() override {
+    if (pool_ != nullptr) {
+      // each pass visits all values (so round up the access count, as nsf)
+      const size_t step = std::max<size_t>(smv_.values().size(), 1);
+      for (size_t i = 0; i < access_count_; i += step)
+        if (!gPO.dry_run())
+          ParallelSumValues(smv_, pool_.get(), &hash_, 0);
+      return;
+    }
+
     for (size_t i = 0; i < access_count_; ++i) {
       const auto& values = smv_.values();
       size_t pos = std::min(values.size(), access_count_ - i);
@@ -269,6 +372,83 @@ struct NonZeroSequentialIteration : public Benchmark {
     }
   }
 
+ private:
+  size_t access_count_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+// Visits the values via internal iteration if supported (e.g., by v::ListBase,
+// which makes one virtual call per span and inlines the visitor over it),
+// otherwise falls back to iterating over values()
+template<class Matrix, class Visitor>
+auto ForEachValue(const Matrix& m, const Visitor& visitor, int)
+    -> decltype(m.ForEach(visitor)) {
+  m.ForEach(visitor);
+}
+
+template<class Matrix, class Visitor>
+void ForEachValue(const Matrix& m, const Visitor& visitor, long) {
+  for (auto& value : m.values())
+    visitor(value);
+}
+
+struct NonZeroSequentialForEach : public Benchmark {
+  NonZeroSequentialForEach()
+      : access_count_(
+            gPO.access_count.count() ? gPO.access_count() : smv_.size()) {}
+
+  void Run() override {
+    // unlike nsi, each pass visits all values (so round up the access count)
+    const size_t value_count = smv_.values().size();
+    const size_t step = std::max<size_t>(value_count, 1);
+    for (size_t i = 0; i < access_count_; i += step) {
+      if (!gPO.dry_run()) {
+        ForEachValue(smv_, [this](const Data& value) { hash_ += value; }, 0);
+      } else {
+        for (size_t pos = value_count; pos--; )
+          hash_ += pos;
+      }
+    }
+  }
+
+ private:
+  size_t access_count_;
+};
+
+// Sums the values via segmented iteration if supported (e.g., by v::ListBase),
+// otherwise falls back to iterating over values()
+template<class Matrix, typename V>
+auto SumValues(const Matrix& m, V init, int)
+    -> decltype(v::SegmentedAccumulate(m.segments(), init)) {
+  return v::SegmentedAccumulate(m.segments(), init);
+}
+
+template<class Matrix, typename V>
+V SumValues(const Matrix& m, V init, long) {
+  for (auto& value : m.values())
+    init += value;
+  return init;
+}
+
+struct NonZeroSequentialSegments : public Benchmark {
+  NonZeroSequentialSegments()
+      : access_count_(
+            gPO.access_count.count() ? gPO.access_count() : smv_.size()) {}
+
+  void Run() override {
+    // like nsf, each pass visits all values (so round up the access count)
+    const size_t value_count = smv_.values().size();
+    const size_t step = std::max<size_t>(value_count, 1);
+    for (size_t i = 0; i < access_count_; i += step) {
+      if (!gPO.dry_run()) {
+        hash_ = SumValues(smv_, hash_, 0);
+      } else {
+        for (size_t pos = value_count; pos--; )
+          hash_ += pos;
+      }
+    }
+  }
+
  private:
   size_t access_count_;
 };
@@ -344,7 +524,11 @@ int main(int argc, char* argv[]) {
     {"sra", [] { return new SampledRandomAccess; } },
     {"nra", [] { return new NonZeroRandomAccess; } },
     {"zra", [] { return new ZeroRandomAccess; } },
+    {"lra", [] { return new LocalRandomAccess<false>; } },
+    {"lrc", [] { return new LocalRandomAccess<true>; } },
     {"nsi", [] { return new NonZeroSequentialIteration; } },
+    {"nsf", [] { return new NonZeroSequentialForEach; } },
+    {"nss", [] { return new NonZeroSequentialSegments; } },
     {"mvm", [] { return new MatrixVectorMultiplication; } },
   };
 
@@ -0,0 +1,451 @@
+#ifndef CPPVIEWS_SRC_BAND_HPP_
+#define CPPVIEWS_SRC_BAND_HPP_
+
+#include "list.hpp"
+
+#include "util/intseq.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+namespace v {
+
+// For the MakeList overload, we need to somehow encode the offsets.
+template<std::ptrdiff_t... offsets>
+struct BandTag {};
+
+struct DynBandTag {};
+
+// A matrix whose values off the diagonals at the given offsets (column index
+// minus row index) are default, with each diagonal stored contiguously
+// (i.e., in the DIA format); the offsets must be increasing
+template<typename DataType, std::ptrdiff_t... offsets>
+using Band = List<BandTag<offsets...>, 2, kListOpVector, DataType, void>;
+
+// Same as Band, but the offsets are passed to the constructor instead
+template<typename DataType>
+using DynBand = List<DynBandTag, 2, kListOpVector, DataType, void>;
+
+namespace detail {
+
+constexpr bool IsIncreasing() { return true; }
+
+constexpr bool IsIncreasing(std::ptrdiff_t) { return true; }
+
+template<typename... Offsets>
+constexpr bool IsIncreasing(std::ptrdiff_t first, std::ptrdiff_t second,
+                            Offsets... offsets) {
+  return first < second && IsIncreasing(second, offsets...);
+}
+
+template<typename T>
+T BandSum(const T& term) { return term; }
+
+template<typename T, typename... Terms>
+T BandSum(const T& term, const Terms&... terms) {
+  return term + BandSum(terms...);
+}
+
+template<typename DataType>
+class BandValueIter
+    : public DefaultIterator<BandValueIter<DataType>,
+                             std::forward_iterator_tag, DataType>,
+      public View<DataType>::IteratorBase {
+  V_DEFAULT_ITERATOR_DERIVED_HEAD(BandValueIter);
+
+ public:
+  BandValueIter(DataType* value) : value_(value) {}
+
+ protected:
+  V_DEF_VIEW_ITER_IS_EQUAL(DataType, BandValueIter)
+
+  bool IsEqual(const BandValueIter& other) const {
+    return value_ == other.value_;
+  }
+
+  void Increment() override { ++value_; }
+
+  DataType& ref() const override { return *value_; }
+
+ private:
+  DataType* value_;
+};
+
+template<typename ListType,  // use CRTP to statically inject ops and funcs
+         typename DataType>
+class BandHelper : public ListBase<DataType, 2>,
+                   public DimIterAccessors<BandHelper<ListType, DataType> > {
+  typedef ListBase<DataType, 2> ListBaseType;
+  friend class DimIterAccessors<BandHelper>;
+
+ public:
+  typedef typename ListBaseType::SizeArray SizeArray;
+
+  class ValuesView : public View<DataType> {
+   public:
+    typedef BandValueIter<DataType> Iterator;
+    typedef std::pair<Iterator, Iterator> Range;
+
+    ValuesView(const BandHelper* band)
+        : View<DataType>(band->diagonals_.size()),
+          band_(band) {}
+    typename View<DataType>::Iterator iterator_begin() const {
+      return Iterator(begin());
+    }
+    typename View<DataType>::Iterator iterator_end() const {
+      return Iterator(end());
+    }
+    Iterator begin() const { return band_->diagonals_.data(); }
+    Iterator end() const { return begin_ptr() + this->size_; }
+
+    // Splits the values into (at most) part_count ranges whose sizes differ by
+    // at most one
+    std::vector<Range> partition(size_t part_count) const {
+      std::vector<Range> parts;
+      parts.reserve(part_count);
+      for (size_t part = 0, from = 0; part++ < part_count; ) {
+        const size_t to = this->size_ * part / part_count;
+        if (from != to)
+          parts.emplace_back(begin_ptr() + from, begin_ptr() + to);
+        from = to;
+      }
+      return parts;
+    }
+
+   private:
+    DataType* begin_ptr() const { return band_->diagonals_.data(); }
+
+    const BandHelper* band_;
+  };
+
+  // iterate over the runs along dimension dim (see Chain)
+  template<unsigned dim>
+  using DimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim>;
+  template<unsigned dim>
+  using ConstDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim>;
+  template<unsigned dim>
+  using NonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim, true>;
+  template<unsigned dim>
+  using ConstNonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim, true>;
+  template<unsigned dim>
+  using EntryDimIterator =
+      typename ListBaseType::template RunEntryDimIter<DataType, dim>;
+  template<unsigned dim>
+  using ConstEntryDimIterator =
+      typename ListBaseType::template RunEntryDimIter<const DataType, dim>;
+
+ protected:
+  BandHelper(DataType* default_value, std::vector<std::ptrdiff_t> offsets,
+             size_t row_count, size_t col_count)
+      : ListBaseType(row_count, col_count),
+        offsets_(std::move(offsets)),
+        default_value_(default_value),
+        values_(this) {
+    std::sort(offsets_.begin(), offsets_.end());
+    offsets_.erase(std::unique(offsets_.begin(), offsets_.end()),
+                   offsets_.end());
+
+    // lay out the diagonals one after another and index them by offset
+    size_t size = 0;
+    diagonal_indexes_.resize(offsets_.empty() ? 0
+                             : offsets_.back() - offsets_.front() + 1, -1);
+    for (size_t k = 0; k < offsets_.size(); ++k) {
+      diagonal_indexes_[offsets_[k] - offsets_.front()] = k;
+      origins_.push_back(size - first_row(offsets_[k]));
+      size += end_row(offsets_[k]) - first_row(offsets_[k]);
+    }
+    diagonals_.resize(size);
+    values_ = ValuesView(this);
+  }
+
+  // the values view has to point to the copied/moved diagonals
+  BandHelper(const BandHelper& src)
+      : ListBaseType(src),
+        offsets_(src.offsets_),
+        origins_(src.origins_),
+        diagonal_indexes_(src.diagonal_indexes_),
+        diagonals_(src.diagonals_),
+        default_value_(src.default_value_),
+        values_(this) {}
+
+  BandHelper(BandHelper&& src)
+      : ListBaseType(std::move(src)),
+        offsets_(std::move(src.offsets_)),
+        origins_(std::move(src.origins_)),
+        diagonal_indexes_(std::move(src.diagonal_indexes_)),
+        diagonals_(std::move(src.diagonals_)),
+        default_value_(src.default_value_),
+        values_(this) {}
+
+  BandHelper& operator=(const BandHelper& rhs) {
+    ListBaseType::operator=(rhs);
+    offsets_ = rhs.offsets_;
+    origins_ = rhs.origins_;
+    diagonal_indexes_ = rhs.diagonal_indexes_;
+    diagonals_ = rhs.diagonals_;
+    default_value_ = rhs.default_value_;
+    values_ = ValuesView(this);
+    return *this;
+  }
+
+  BandHelper& operator=(BandHelper&& rhs) {
+    ListBaseType::operator=(std::move(rhs));
+    offsets_ = std::move(rhs.offsets_);
+    origins_ = std::move(rhs.origins_);
+    diagonal_indexes_ = std::move(rhs.diagonal_indexes_);
+    diagonals_ = std::move(rhs.diagonals_);
+    default_value_ = rhs.default_value_;
+    values_ = ValuesView(this);
+    return *this;
+  }
+
+ public:
+  DataType& operator()(size_t row, size_t col) const {
+    const size_t k = diagonal_index(static_cast<std::ptrdiff_t>(col) -
+                                    static_cast<std::ptrdiff_t>(row));
+    return k == size_t(-1) ? *default_value_ : diagonals_[origins_[k] + row];
+  }
+
+  DataType& get(SizeArray&& indexes) const override {
+    return operator()(indexes[0], indexes[1]);
+  }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    if (!diagonals_.empty())
+      visitor(diagonals_.data(), diagonals_.size());
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    SizeArray indexes;
+    for (size_t k = 0; k < offsets_.size(); ++k) {
+      for (indexes[0] = first_row(offsets_[k]);
+           indexes[0] < end_row(offsets_[k]); ++indexes[0]) {
+        indexes[1] = indexes[0] + offsets_[k];
+        visitor(indexes, diagonals_[origins_[k] + indexes[0]]);
+      }
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<DataType>* runs) const override {
+    // the offsets increase along a row but decrease along a column
+    const std::ptrdiff_t lateral_index = indexes[!dim];
+    const std::ptrdiff_t line_size = this->sizes_[dim];
+    std::ptrdiff_t cur = 0;  // the next index in dimension dim
+    for (size_t i = 0; i < offsets_.size(); ++i) {
+      const size_t k = dim ? i : offsets_.size() - 1 - i;
+      const std::ptrdiff_t index = dim ? lateral_index + offsets_[k]
+                                   : lateral_index - offsets_[k];
+      if (index < 0 || index >= line_size)
+        continue;
+      const size_t row = dim ? lateral_index : index;
+      AppendRun(start + cur, index - cur, default_value_, true, runs);
+      AppendRun(start + index, 1, &diagonals_[origins_[k] + row], false, runs);
+      cur = index + 1;
+    }
+    AppendRun(start + cur, line_size - cur, default_value_, true, runs);
+  }
+
+  typename View<DataType>::Iterator iterator_begin() const override {
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  const ValuesView& values() const override { return values_; }
+  DataType* default_value() const override { return default_value_; }
+
+  const std::vector<std::ptrdiff_t>& offsets() const { return offsets_; }
+
+  // Computes y = A x, where A is this matrix (see MultiplyAdd)
+  void Multiply(const DataType* x, DataType* y) const {
+    std::fill(y, y + this->sizes_[0], DataType());
+    static_cast<const ListType*>(this)->MultiplyAdd(x, y);
+  }
+
+  // Computes y += A x, where A is this matrix (x and y must hold as many
+  // values as A has columns and rows, respectively)
+  void MultiplyAdd(const DataType* x, DataType* y) const {
+    MultiplyAddDiagonals(x, y, 0, this->sizes_[0]);
+    MultiplyAddDefault(x, y);
+  }
+
+ protected:
+  // Adds the products of the rows in [row_begin, row_end) to y, one diagonal
+  // at a time (the inner loop streams through the diagonal, x and y)
+  void MultiplyAddDiagonals(const DataType* x, DataType* y,
+                            size_t row_begin, size_t row_end) const {
+    for (size_t k = 0; k < offsets_.size(); ++k) {
+      const size_t first = std::max(row_begin, first_row(offsets_[k]));
+      const size_t last = std::min(row_end, end_row(offsets_[k]));
+      if (first >= last)
+        continue;
+      const DataType* diagonal = &diagonals_[origins_[k] + first];
+      const DataType* x_first = x + (first + offsets_[k]);
+      DataType* y_first = y + first;
+      for (size_t i = 0, i_end = last - first; i < i_end; ++i)
+        y_first[i] += diagonal[i] * x_first[i];
+    }
+  }
+
+  // Adds the products of the default values outside the diagonals to y
+  // (unless the default value is zero, in which case nothing changes)
+  void MultiplyAddDefault(const DataType* x, DataType* y) const {
+    if (default_value_ == nullptr || *default_value_ == DataType())
+      return;
+    const std::ptrdiff_t col_count = this->sizes_[1];
+    DataType x_sum = DataType();
+    for (std::ptrdiff_t c = 0; c < col_count; ++c)
+      x_sum += x[c];
+    for (size_t r = 0; r < this->sizes_[0]; ++r) {
+      DataType band_x_sum = DataType();
+      for (const auto& offset : offsets_) {
+        const std::ptrdiff_t c = static_cast<std::ptrdiff_t>(r) + offset;
+        if (c >= 0 && c < col_count)
+          band_x_sum += x[c];
+      }
+      y[r] += *default_value_ * (x_sum - band_x_sum);
+    }
+  }
+
+  // Returns the index of the diagonal at the offset, or -1 if there is none
+  size_t diagonal_index(std::ptrdiff_t offset) const {
+    const size_t i = offset - (offsets_.empty() ? 0 : offsets_.front());
+    return i < diagonal_indexes_.size() ? diagonal_indexes_[i] : -1;
+  }
+
+  // Returns the first row that the diagonal at the offset intersects
+  size_t first_row(std::ptrdiff_t offset) const {
+    return std::min<std::ptrdiff_t>(std::max<std::ptrdiff_t>(-offset, 0),
+                                    end_row(offset));
+  }
+
+  // Returns one past the last row that the diagonal at the offset intersects
+  size_t end_row(std::ptrdiff_t offset) const {
+    const std::ptrdiff_t rows = this->sizes_[0], cols = this->sizes_[1];
+    return std::max<std::ptrdiff_t>(std::min(rows, cols - offset), 0);
+  }
+
+  std::vector<std::ptrdiff_t> offsets_;  // sorted and unique
+  std::vector<std::ptrdiff_t> origins_;  // the position of row 0 of each
+  std::vector<size_t> diagonal_indexes_;  // by offset - offsets_.front()
+  mutable std::vector<DataType> diagonals_;
+  DataType* default_value_;
+
+ private:
+  ValuesView values_;
+};
+
+}  // namespace detail
+
+template<typename DataType, std::ptrdiff_t... offsets>
+#define V_LIST_TYPE \
+  List<BandTag<offsets...>, 2, kListOpVector, DataType, void>
+class V_LIST_TYPE
+#define V_THIS_BASE_TYPE detail::BandHelper<V_LIST_TYPE, DataType>
+    : public V_THIS_BASE_TYPE {
+  typedef V_THIS_BASE_TYPE BandHelper;
+#undef V_THIS_BASE_TYPE
+#undef V_LIST_TYPE
+
+  static_assert(sizeof...(offsets) > 0, "No diagonals");
+  static_assert(detail::IsIncreasing(offsets...),
+                "The offsets are not increasing");
+
+ public:
+  List(DataType* default_value, size_t row_count, size_t col_count)
+      : BandHelper(default_value, {offsets...}, row_count, col_count) {}
+
+  // used by MakeList
+  template<typename... Args>
+  List(BandTag<offsets...>, Args&&... args)
+      : List(std::forward<Args>(args)...) {}
+
+  friend List MakeList(List&& list) { return std::forward<List>(list); }
+
+  // Same as in DynBand, except that the rows intersected by all diagonals are
+  // processed in a single pass, which is unrolled over the diagonals
+  void MultiplyAdd(const DataType* x, DataType* y) const {
+    static constexpr std::ptrdiff_t offset_array[] = {offsets...};
+    const size_t row_count = this->sizes_[0];
+    const size_t first = std::min(this->first_row(offset_array[0]), row_count);
+    const size_t last = std::max(
+        first, this->end_row(offset_array[sizeof...(offsets) - 1]));
+    this->MultiplyAddDiagonals(x, y, 0, first);
+    MultiplyAddInner(x, y, first, last,
+                     cpp14::make_index_sequence<sizeof...(offsets)>());
+    this->MultiplyAddDiagonals(x, y, last, row_count);
+    this->MultiplyAddDefault(x, y);
+  }
+
+ private:
+  template<size_t... Ks>
+  void MultiplyAddInner(const DataType* x, DataType* y, size_t first,
+                        size_t last, cpp14::index_sequence<Ks...>) const {
+    if (first >= last)
+      return;
+    const DataType* diagonals[] = {
+      this->diagonals_.data() + (this->origins_[Ks] + first)...
+    };
+    const DataType* x_first = x + first;
+    DataType* y_first = y + first;
+    for (std::ptrdiff_t i = 0, i_end = last - first; i < i_end; ++i)
+      y_first[i] += detail::BandSum((diagonals[Ks][i] *
+                                     x_first[i + offsets])...);
+  }
+};
+
+template<typename DataType>
+class List<DynBandTag, 2, kListOpVector, DataType, void>
+    : public detail::BandHelper<List<DynBandTag, 2, kListOpVector,
+                                     DataType, void>,
+                                DataType> {
+  typedef detail::BandHelper<List, DataType> BandHelper;
+
+ public:
+  List(DataType* default_value, std::vector<std::ptrdiff_t> offsets,
+       size_t row_count, size_t col_count)
+      : BandHelper(default_value, std::move(offsets), row_count, col_count) {}
+
+  // used by MakeList
+  template<typename... Args>
+  List(DynBandTag, Args&&... args) : List(std::forward<Args>(args)...) {}
+
+  friend List MakeList(List&& list) { return std::forward<List>(list); }
+};
+
+template<typename DataType, std::ptrdiff_t... offsets>
+auto MakeList(BandTag<offsets...>, DataType* default_value,
+              size_t row_count, size_t col_count)
+#define V_LIST_TYPE Band<DataType, offsets...>
+    -> V_LIST_TYPE { return V_LIST_TYPE(default_value, row_count, col_count); }
+#undef V_LIST_TYPE
+
+template<typename DataType>
+DynBand<DataType> MakeList(DynBandTag, DataType* default_value,
+                           std::vector<std::ptrdiff_t> offsets,
+                           size_t row_count, size_t col_count) {
+  return DynBand<DataType>(default_value, std::move(offsets), row_count,
+                           col_count);
+}
+
+}  // namespace v
+
+#endif  /* CPPVIEWS_SRC_BAND_HPP_ */
@@ -3,8 +3,11 @@
 
 #include "list.hpp"
 
+#include "util/divider.hpp"
+
 #include <algorithm>
 #include <numeric>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -12,7 +15,8 @@ namespace v {
 
 namespace detail {
 
-template<class SublistType, unsigned chain_dim>
+template<class SublistType, unsigned chain_dim,
+         template<class> class SkipList = ImmutableSkipList>
 class ChainedListVector : public ListVector<SublistType> {
   typedef ListVector<SublistType> ListVectorType;
   typedef typename ListVectorType::SizeType SizeType;
@@ -51,27 +55,44 @@ class ChainValues : public View<typename SublistType::DataType> {
  public:
   using typename View<typename SublistType::DataType>::DataType;
 
-  class Iterator
-      : public DefaultIterator<Iterator, std::forward_iterator_tag, DataType>,
+ private:
+  typedef typename std::decay<
+    decltype(std::declval<SublistType>().values())
+    >::type::Iterator InnerIter;
+
+  // the iterators of polymorphic sublists are as big as the inline storage of
+  // View<DataType>::Iterator, so the iterator over their values cannot hold
+  // them in place (it walks over their spans instead, see SegmentIter)
+  typedef std::is_same<InnerIter, typename View<DataType>::Iterator>
+  IsPolymorphic;
+
+  class NestedIter
+      : public DefaultIterator<NestedIter, std::forward_iterator_tag,
+                               DataType>,
         public View<DataType>::IteratorBase {
-    V_DEFAULT_ITERATOR_DERIVED_HEAD(Iterator);
+    V_DEFAULT_ITERATOR_DERIVED_HEAD(NestedIter);
 
     typedef typename ListVectorType::ConstIterator OuterIter;
-    typedef typename std::decay<
-      decltype(std::declval<SublistType>().values())
-      >::type::Iterator InnerIter;
 
    public:
-    Iterator(const OuterIter& outer_cur, const OuterIter& outer_max)
+    NestedIter(const OuterIter& outer_cur, const OuterIter& outer_max)
         : inner_cur_(outer_cur->values().begin()),
           inner_end_(outer_cur->values().end()),
           outer_cur_(outer_cur),
           outer_max_(outer_max) {}
 
+    // (inner_cur must not be the end of the values of *outer_cur)
+    NestedIter(const OuterIter& outer_cur, const OuterIter& outer_max,
+               const InnerIter& inner_cur)
+        : inner_cur_(inner_cur),
+          inner_end_(outer_cur->values().end()),
+          outer_cur_(outer_cur),
+          outer_max_(outer_max) {}
+
    protected:
-    V_DEF_VIEW_ITER_IS_EQUAL(DataType, Iterator)
+    V_DEF_VIEW_ITER_IS_EQUAL(DataType, NestedIter)
 
-    bool IsEqual(const Iterator& other) const {
+    bool IsEqual(const NestedIter& other) const {
       return outer_cur_ == other.outer_cur_ && inner_cur_ == other.inner_cur_;
     }
 
@@ -93,33 +114,224 @@ class ChainValues : public View<typename SublistType::DataType> {
     OuterIter outer_max_;
   };
 
+  // Iterates over the (non-empty) spans of values fetched by AppendSegments(),
+  // followed by an empty sentinel span
+  class SegmentIter
+      : public DefaultIterator<SegmentIter, std::forward_iterator_tag,
+                               DataType>,
+        public View<DataType>::IteratorBase {
+    V_DEFAULT_ITERATOR_DERIVED_HEAD(SegmentIter);
+
+   public:
+    explicit SegmentIter(const Segment<DataType>* segment)
+        : segment_(segment),
+          cur_(segment->data) {}
+
+    // (cur must be within the segment)
+    SegmentIter(const Segment<DataType>* segment, DataType* cur)
+        : segment_(segment),
+          cur_(cur) {}
+
+   protected:
+    V_DEF_VIEW_ITER_IS_EQUAL(DataType, SegmentIter)
+
+    bool IsEqual(const SegmentIter& other) const {
+      return segment_ == other.segment_ && cur_ == other.cur_;
+    }
+
+    void Increment() override {
+      if (++cur_ == segment_->end())
+        cur_ = (++segment_)->data;
+    }
+
+    DataType& ref() const override { return *cur_; }
+
+   private:
+    const Segment<DataType>* segment_;
+    DataType* cur_;
+  };
+
  public:
-  ChainValues(const ListVectorType& lists) : lists_(&lists) {
+  typedef typename std::conditional<IsPolymorphic::value,
+                                    SegmentIter, NestedIter>::type Iterator;
+  typedef std::pair<Iterator, Iterator> Range;
+
+  // (the spans of the values of polymorphic sublists are fetched once, so
+  // that, like the size, they reflect the values at the time of construction;
+  // the chains construct it again if outdated() when their values() is called)
+  ChainValues(const ListVectorType& lists)
+      : lists_(&lists),
+        value_offsets_(1 + lists.size()) {
+    // value_offsets_[i] is the number of values in the sublists before i-th
+    // (excluding the dummies, whose values need not be empty, e.g., of Diag)
     this->size_ = 0;
-    for (const auto& list : *lists_)
-      this->size_ += list.values().size();
+    for (size_t i = 1; i + 1 < lists.size(); ++i)
+      value_offsets_[i + 1] = this->size_ += lists[i].values().size();
+    value_offsets_.back() = this->size_;
+    if (IsPolymorphic::value)
+      FetchSegments();
   }
   typename View<DataType>::Iterator iterator_begin() const {
-    return new Iterator(begin());
+    return Iterator(begin());
   }
   typename View<DataType>::Iterator iterator_end() const {
-    return new Iterator(end());
+    return Iterator(end());
+  }
+  Iterator begin() const { return At(1); }
+  Iterator end() const { return At(lists_->size() - 1); }
+
+  // Returns whether the number of values of a sublist has changed since the
+  // construction, e.g., by inserting a value into a sparse sublist
+  bool outdated() const {
+    for (size_t i = 1; i + 1 < lists_->size(); ++i)
+      if ((*lists_)[i].values().size() !=
+          value_offsets_[i + 1] - value_offsets_[i])
+        return true;
+    return false;
+  }
+
+  // Splits the values into (at most) part_count consecutive ranges that have
+  // roughly the same number of values. The ranges of polymorphic sublists are
+  // split at the exact values (found over their spans); the others between
+  // the sublists if the nearest boundary is off by at most 1/kSplitGranularity
+  // of a range, or else within a sublist by its own partition(), if any (e.g.,
+  // of Diag, Band or DynDiag), whose parts are as fine.
+  std::vector<Range> partition(size_t part_count) const {
+    std::vector<Range> parts;
+    parts.reserve(part_count);
+    SublistParts sublist_parts{0, {}};  // of the last sublist split
+    Iterator from = begin();
+    for (size_t part = 1; part <= part_count; ++part) {
+      Iterator to = part == part_count ? end()
+          : Split(this->size_ * part / part_count,
+                  this->size_ / (part_count * kSplitGranularity),
+                  &sublist_parts, IsPolymorphic());
+      if (!(from == to))
+        parts.emplace_back(from, to);
+      from = std::move(to);
+    }
+    return parts;
+  }
+
+ private:
+  typedef std::vector<std::pair<InnerIter, InnerIter> > InnerRanges;
+
+  struct SublistParts {
+    size_t index;
+    InnerRanges ranges;
+  };
+
+  static constexpr size_t kSplitGranularity = 16;
+
+  // Returns the index of the sublist whose first value is the nearest to the
+  // value_index-th value (ties are broken towards the former)
+  size_t NearestBoundary(size_t value_index) const {
+    const auto next = std::upper_bound(value_offsets_.begin() + 1,
+                                       value_offsets_.end() - 1, value_index);
+    const auto prev = next - 1;
+    return (value_index - *prev <= *next - value_index ? prev : next) -
+        value_offsets_.begin();
+  }
+
+  // Returns the iterator to the value_index-th value
+  Iterator Split(size_t value_index, size_t, SublistParts*,
+                 std::true_type) const {
+    const auto segment = std::upper_bound(
+        segments_.begin(), segments_.end(), value_index,
+        [](size_t value_index, const Segment<DataType>& segment) {
+          return value_index < segment.offset;
+        }) - 1;
+    return Iterator(&*segment, segment->data + value_index - segment->offset);
+  }
+
+  // Returns the iterator to the first value of the nearest sublist if it is
+  // off by at most tolerance, or else to that of the nearest part of the
+  // containing sublist split into parts of at most tolerance values (which
+  // are kept in *sublist_parts for the next values in the same sublist)
+  Iterator Split(size_t value_index, size_t tolerance,
+                 SublistParts* sublist_parts, std::false_type) const {
+    const size_t boundary = NearestBoundary(value_index);
+    const size_t offset = value_offsets_[boundary];
+    if (std::max(offset, value_index) - std::min(offset, value_index) <=
+        tolerance)
+      return At(boundary);
+
+    const size_t index = std::upper_bound(value_offsets_.begin() + 1,
+                                          value_offsets_.end() - 1,
+                                          value_index) -
+        value_offsets_.begin() - 1;
+    const auto& values = (*lists_)[index].values();
+    if (sublist_parts->index != index) {
+      sublist_parts->index = index;
+      sublist_parts->ranges =
+          PartitionSublist(values, values.size() / (tolerance + 1) + 1, 0);
+    }
+    const InnerRanges& ranges = sublist_parts->ranges;
+    if (ranges.empty())
+      return At(boundary);
+    // (the parts of the sublist have roughly the same number of values)
+    const size_t part = ((value_index - value_offsets_[index]) *
+                         ranges.size() + values.size() / 2) / values.size();
+    if (part == 0 || part == ranges.size())
+      return At(index + (part != 0));
+    return Iterator(lists_->begin() + index, --lists_->end(),
+                    ranges[part].first);
+  }
+
+  // Returns the ranges of the values of a sublist split by its partition(),
+  // or none if it does not implement one
+  template<class Values>
+  static auto PartitionSublist(const Values& values, size_t part_count, int)
+      -> decltype(InnerRanges(values.partition(part_count))) {
+    return values.partition(part_count);
+  }
+
+  template<class Values>
+  static InnerRanges PartitionSublist(const Values&, size_t, long) {
+    return InnerRanges();
   }
-  Iterator begin() const {
-    auto it = ++lists_->begin(), it_max = --lists_->end();
-    if (!it->values().size() && it != it_max) {
+
+  // Returns the iterator to the first value of the index-th sublist or of the
+  // next non-empty one, or end() if there are none
+  Iterator At(size_t index) const { return At(index, IsPolymorphic()); }
+
+  Iterator At(size_t index, std::false_type) const {
+    auto it = lists_->begin() + index, it_max = --lists_->end();
+    if (it != it_max && !it->values().size()) {
       // unroll once to boost performance if first is not empty (common case)
-      do ++it; while (!it->values().size() && it != it_max);
+      do ++it; while (it != it_max && !it->values().size());
     }
     return Iterator(it, it_max);
   }
-  Iterator end() const {
-    auto it_max = --lists_->end();
-    return Iterator(it_max, it_max);
+
+  Iterator At(size_t index, std::true_type) const {
+    // (clamped, since there are no dummy sublists if there are none at all)
+    return Iterator(segments_.data() + segment_begins_[
+        std::min(index, segment_begins_.size() - 1)]);
+  }
+
+  void FetchSegments() {
+    // segment_begins_[i] is the index of the first span of the i-th sublist
+    // (the spans of adjacent sublists are not merged, so that it is exact)
+    segment_begins_.assign(std::max<size_t>(lists_->size(), 1), 0);
+    SegmentVector<DataType> sublist_segments;
+    for (size_t i = 1; i + 1 < lists_->size(); ++i) {
+      segment_begins_[i] = segments_.size();
+      sublist_segments.clear();
+      (*lists_)[i].AppendSegments(&sublist_segments);
+      for (auto& segment : sublist_segments) {
+        segment.offset += value_offsets_[i];
+        segments_.push_back(segment);
+      }
+    }
+    segment_begins_.back() = segments_.size();
+    segments_.push_back(Segment<DataType>{nullptr, 0, this->size_});
   }
 
- private:
   const ListVectorType* lists_;
+  std::vector<size_t> value_offsets_;
+  SegmentVector<DataType> segments_;  // fetched only if IsPolymorphic
+  std::vector<size_t> segment_begins_;
 };
 
 }  // namespace detail
@@ -131,25 +343,34 @@ class ChainValues : public View<typename SublistType::DataType> {
 template<unsigned chain_dim>
 struct ChainTag {};
 
+// (SkipList finds the sublists, and it can be replaced by a more cache-friendly
+// layout, e.g., BTreePrefixIndex, if there are many of them)
 template<class SublistType,
          unsigned chain_dim,
          ListFlags flags = kListOpVector,
-         unsigned dims = ListTraits<SublistType>::kDims>  // it can also be >
+         unsigned dims = ListTraits<SublistType>::kDims,  // it can also be >
+         template<class> class SkipList = ImmutableSkipList>
 using Chain = List<SublistType, dims, flags,
-                   detail::ChainedListVector<SublistType, chain_dim>,
+                   detail::ChainedListVector<SublistType, chain_dim, SkipList>,
                    typename SublistType::DataType>;
 
-template<class SublistType, unsigned dims, unsigned chain_dim>
-class List<
-  SublistType,
-  dims,
-  kListOpVector,
+template<class SublistType, unsigned dims, unsigned chain_dim,
+         template<class> class SkipList>
+#define V_LIST_TYPE                                                     \
+  List<SublistType,                                                     \
+       dims,                                                            \
+       kListOpVector,                                                   \
+       detail::ChainedListVector<SublistType, chain_dim, SkipList>,     \
+       typename SublistType::DataType,                                  \
+       typename std::enable_if<                                         \
+         dims >= ListTraits<SublistType>::kDims>::type>
+class V_LIST_TYPE
 #define V_THIS_DATA_TYPE typename SublistType::DataType
-  detail::ChainedListVector<SublistType, chain_dim>,
-  V_THIS_DATA_TYPE,
-  typename std::enable_if<dims >= ListTraits<SublistType>::kDims>::type>
     : public ListBase<V_THIS_DATA_TYPE, dims>,
+      public DimIterAccessors<V_LIST_TYPE>,
       protected detail::ChainHelper<SublistType> {
+  friend class DimIterAccessors<V_LIST_TYPE>;
+#undef V_LIST_TYPE
   static_assert(chain_dim < dims, "chain_dim < dims");
 #define V_CHAIN_FOR_LATERAL_DIM(dim, body)                              \
   for (unsigned dim = 0; dim < chain_dim; ++dim) do body while (false); \
@@ -162,99 +383,205 @@ class List<
 
  private:
   typedef ListBase<DataType, dims> ListBaseType;
-  typedef detail::ChainedListVector<SublistType, chain_dim> Container;
+  typedef detail::ChainedListVector<SublistType, chain_dim, SkipList>
+  Container;
   typedef std::array<size_t, dims - 1> LateralOffset;
   struct Disabler {};  // used for SFINAE (to disable constructors)
 
+  // Iterates over the entries of the sublists that intersect a line along
+  // dimension dim. Since the entry is stashed in the iterator, it is only a
+  // forward iterator, but Advance and DistanceTo move by n entries (or find
+  // the distance) in time proportional to the number of sublists crossed,
+  // provided that the sublists' entry iterators implement them likewise
+  // (so EntryLowerBound() searches the line in O(#sublists log n) time)
   template<typename V, unsigned dim>
   class EntryDimIter
-      : public List::template EntryDimIteratorBase<EntryDimIter<V, dim>,
-                                                   V,
-                                                   // TODO: make bidirectional
-                                                   std::forward_iterator_tag> {
-    // TODO: Factor out most of the nested iterator logic into a helper class
+      : public List::template EntryDimIteratorBase<
+    EntryDimIter<V, dim>, V, std::forward_iterator_tag> {
     V_DEFAULT_ITERATOR_DERIVED_HEAD(EntryDimIter);
     template<typename, unsigned> friend class EntryDimIter;
     template<typename FromType, typename ToType, class Type>
     using EnableIfConvertible = typename std::enable_if<
       std::is_convertible<FromType, ToType>::value, Type>::type;
     typedef typename SublistType::template EntryDimIterator<dim> InnerIter;
-    typedef typename ListVector<SublistType>::ConstIterator OuterIter;
-    typedef typename List::NestingOffsetVector::const_iterator OffsetIter;
 
    public:
-    template<typename... Indexes>
-    explicit EntryDimIter(OuterIter outer_cur, OuterIter outer_max,
-                          OffsetIter offset_cur,
-                          // TODO: use unique_ptr?
-                          // LateralOffset&& offset)
-                          Indexes&&... lateral_indexes)
-        : outer_cur_(outer_cur),
+    // Constructs the iterator at the first entry of the sublists in range
+    // [outer_min, outer_max) if begin is true, or past the last one otherwise
+    EntryDimIter(const List* chain, size_t outer_min, size_t outer_max,
+                 LateralOffset&& lateral, bool begin)
+        : chain_(chain),
+          outer_min_(outer_min),
           outer_max_(outer_max),
-          offset_cur_(offset_cur),
-          // offset_(std::move(offset)) {
-          offset_{{static_cast<size_t>(lateral_indexes)...}} {
-      InitInner(cpp14::index_sequence_for<Indexes...>());
+          outer_(outer_max),
+          lateral_(std::move(lateral)),
+          e_() {
+      if (begin)
+        NextOuter(outer_min);
+    }
+    template<typename V2>
+    EntryDimIter(const EntryDimIter<V2, dim>& copy,
+                 EnableIfConvertible<V2*, V*, typename EntryDimIter::Enabler>
+                 enabler = typename EntryDimIter::Enabler())
+        : chain_(copy.chain_),
+          outer_min_(copy.outer_min_),
+          outer_max_(copy.outer_max_),
+          outer_(copy.outer_),
+          lateral_(copy.lateral_),
+          inner_begin_(copy.inner_begin_),
+          inner_cur_(copy.inner_cur_),
+          inner_end_(copy.inner_end_) {}
+    EntryDimIter() = default;
+
+    static constexpr unsigned kDim = dim;
+
+    // Moves by n entries, which may be negative
+    void Advance(std::ptrdiff_t n) {
+      for (; n > 0 && outer_ < outer_max_; NextOuter(outer_ + 1)) {
+        const std::ptrdiff_t after = inner_cur_.DistanceTo(inner_end_);
+        if (n < after) {
+          inner_cur_.Advance(n);
+          return;
+        }
+        n -= after;
+      }
+      while (n < 0) {
+        if (outer_ == outer_max_ || inner_cur_ == inner_begin_)
+          PrevOuter();
+        const std::ptrdiff_t before = inner_begin_.DistanceTo(inner_cur_);
+        if (-n <= before) {
+          inner_cur_.Advance(n);
+          return;
+        }
+        n += before;
+        inner_cur_ = inner_begin_;
+      }
+    }
+
+    // Returns the number of entries from this iterator to the other one
+    template<typename V2>
+    EnableIfConvertible<V2, V, std::ptrdiff_t>
+    DistanceTo(const EntryDimIter<V2, dim>& other) const {
+      if (outer_ == other.outer_)
+        return outer_ == outer_max_ ? 0 : inner_cur_.DistanceTo(
+            other.inner_cur_);
+      // count the entries from the former to the latter across the sublists
+      const bool forward = outer_ < other.outer_;
+      std::ptrdiff_t distance = forward ? After() + other.Before()
+          : other.After() + Before();
+      for (size_t i = std::min(outer_, other.outer_) + 1,
+               i_end = std::max(outer_, other.outer_); i < i_end; ++i)
+        distance += InnerBegin(i).DistanceTo(InnerEnd(i));
+      return forward ? distance : -distance;
     }
 
    protected:
     void Increment() override {
       if (++inner_cur_ == inner_end_)
-        do {
-          ++outer_cur_, ++offset_cur_;
-          InitInner(cpp14::make_index_sequence<dims - 1>());
-        } while (inner_cur_ == inner_end_ && outer_cur_ != outer_max_);
+        NextOuter(outer_ + 1);
     }
 
     template<typename V2>
     EnableIfConvertible<V2, V, bool>
     IsEqual(const EntryDimIter<V2, dim>& other) const {
-      return outer_cur_ == other.outer_cur_ && inner_cur_ == other.inner_cur_;
+      return outer_ == other.outer_ &&
+          (outer_ == outer_max_ || inner_cur_ == other.inner_cur_);
     }
 
     typename EntryDimIter::reference ref() const override {
-      return *inner_cur_;
+      auto& inner = *inner_cur_;
+      SizeArray indexes(inner.indexes());
+      const SizeArray& offset = chain_->nesting_offsets_[outer_];
+      for (unsigned d = 0; d < dims; ++d)
+        indexes[d] += offset[d];
+      e_ = typename EntryDimIter::value_type(&inner.value(),
+                                             std::move(indexes));
+      return e_;
     }
 
    private:
+    // Moves to the first entry of the first non-empty sublist from index i on
+    // (or past the end if there is none)
+    void NextOuter(size_t i) {
+      for (outer_ = i; outer_ < outer_max_; ++outer_) {
+        inner_begin_ = InnerBegin(outer_);
+        inner_end_ = InnerEnd(outer_);
+        if (inner_begin_ != inner_end_)
+          break;
+      }
+      inner_cur_ = inner_begin_;
+    }
+
+    // Moves past the last entry of the previous non-empty sublist
+    void PrevOuter() {
+      do {
+        --outer_;
+        inner_begin_ = InnerBegin(outer_);
+        inner_end_ = InnerEnd(outer_);
+      } while (inner_begin_ == inner_end_ && outer_ > outer_min_);
+      inner_cur_ = inner_end_;
+    }
+
+    // the number of entries before and after (including) the current one
+    // within the current sublist
+    std::ptrdiff_t Before() const {
+      return outer_ == outer_max_ ? 0 : inner_begin_.DistanceTo(inner_cur_);
+    }
+    std::ptrdiff_t After() const {
+      return outer_ == outer_max_ ? 0 : inner_cur_.DistanceTo(inner_end_);
+    }
+
+    InnerIter InnerBegin(size_t i) const {
+      return InnerBegin(i, cpp14::make_index_sequence<dims - 1>());
+    }
+    InnerIter InnerEnd(size_t i) const {
+      return InnerEnd(i, cpp14::make_index_sequence<dims - 1>());
+    }
+
+    // the lateral indexes of the line relative to the i-th sublist
+    // (they wrap around if it is before the sublist, so it has no entries)
     template<size_t... Is>
-    void InitInner(cpp14::index_sequence<Is...>) {
-      // 0 [1] 2 3 // offset_cur
-      // 0     1 2 // Is
-      // Is >= chain_dim
-      InitInner0((std::get<Is>(offset_) -
-                 std::get<Is + (Is >= chain_dim)>(*offset_cur_))...);
-      OffsetInner(cpp14::make_index_sequence<dims>(), inner_cur_);
-      // TODO: we should change inner_end_ to inner_max_ and uncomment below
-      // OffsetInner(cpp14::make_index_sequence<dims>(), inner_end_);
-    }
-    template<typename... Offsets>
-    void InitInner0(Offsets&&... offsets) {
-      inner_end_ = outer_cur_->template entry_dim_end<dim>(
-          std::forward<Offsets>(offsets)...);
-      inner_cur_ = outer_cur_->template entry_dim_begin<dim>(
-          std::forward<Offsets>(offsets)...);
+    InnerIter InnerBegin(size_t i, cpp14::index_sequence<Is...>) const {
+      const SizeArray& offset = chain_->nesting_offsets_[i];
+      return chain_->lists_[i].template entry_dim_begin<dim>(
+          std::get<Is>(lateral_) - offset[Is + (Is >= dim)]...);
     }
     template<size_t... Is>
-    void OffsetInner(cpp14::index_sequence<Is...>, InnerIter& inner_it) {
-      static_assert(sizeof...(Is) == dims, "");
-      auto& inds = this->template GetEntryIndexes(*inner_it);
-      list_detail::Ignore(std::get<Is>(inds) += std::get<Is>(*offset_cur_)...);
+    InnerIter InnerEnd(size_t i, cpp14::index_sequence<Is...>) const {
+      const SizeArray& offset = chain_->nesting_offsets_[i];
+      return chain_->lists_[i].template entry_dim_end<dim>(
+          std::get<Is>(lateral_) - offset[Is + (Is >= dim)]...);
     }
 
-    OuterIter outer_cur_, outer_max_;
-    // std::array<size_t, dims - 1> offset_;
-    OffsetIter offset_cur_;
-    LateralOffset offset_;
-    InnerIter inner_cur_, inner_end_;
+    const List* chain_;
+    size_t outer_min_, outer_max_;
+    size_t outer_;  // the index of the current sublist (outer_max_ if at end)
+    LateralOffset lateral_;
+    InnerIter inner_begin_, inner_cur_, inner_end_;
+    mutable typename EntryDimIter::value_type e_;
   };
 
+ public:
   template<unsigned dim>
   using EntryDimIterator = EntryDimIter<DataType, dim>;
   template<unsigned dim>
   using ConstEntryDimIterator = EntryDimIter<const DataType, dim>;
 
- public:
+  // iterate over the runs of a row (column, ...) along dimension dim, which
+  // visits only the sublists that intersect it (and optionally skips defaults)
+  template<unsigned dim>
+  using DimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim>;
+  template<unsigned dim>
+  using ConstDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim>;
+  template<unsigned dim>
+  using NonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim, true>;
+  template<unsigned dim>
+  using ConstNonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim, true>;
+
   typedef typename ListBaseType::SizeArray SizeArray;  // bring to scope
   typedef std::vector<SizeArray> NestingOffsetVector;
   typedef std::pair<size_t, LateralOffset> LateralOffsetEntry;
@@ -273,7 +600,9 @@ class List<
         nesting_offsets_(InsertDummies(lists_, this->sizes_,
                                        std::move(nesting_offsets))),
         fwd_skip_list_(nesting_offsets_.size() - 1, &nesting_offsets_),
-        values_(lists_) {}
+        values_(lists_) {
+    IndexCoverage();
+  }
 
   explicit List(ListVector<SublistType>&& lists,
                 DataType* default_value = nullptr,
@@ -328,6 +657,9 @@ class List<
     InsertDummies(lists_, this->sizes_, std::move(nesting_offsets_));
     fwd_skip_list_ = decltype(fwd_skip_list_)(nesting_offsets_.size() - 1,
                                               &nesting_offsets_);
+    this->size_ = this->element_count();
+    values_ = ValuesView(lists_);  // recount with the dummies
+    IndexCoverage();
   }
 
   // List(const List&) = delete;  // redundant since ListVector is not copyable
@@ -337,6 +669,9 @@ class List<
         default_value_(src.default_value_),
         nesting_offsets_(std::move(src.nesting_offsets_)),
         fwd_skip_list_(std::move(src.fwd_skip_list_)),
+        coverage_(std::move(src.coverage_)),
+        lateral_end_max_(std::move(src.lateral_end_max_)),
+        lateral_start_min_(std::move(src.lateral_start_min_)),
         values_(lists_) {
     // the size getter points to nesting_offsets_ that is moved, so update it
     fwd_skip_list_.bucket_size_getter().o_ = &nesting_offsets_;
@@ -360,60 +695,121 @@ class List<
   void ShrinkToFirst() override {
     ListBaseType::ShrinkToFirst();
     lists_.Erase(++lists_.begin(), lists_.end());
+    coverage_ = CoverageGrid<dims>();
+    lateral_end_max_.clear();
+    lateral_start_min_.clear();
   }
 
   DataType& get(SizeArray&& indexes) const override {
-    auto nonlateral_pos = fwd_skip_list_.get(indexes[chain_dim]);
-    const auto& list = lists_[nonlateral_pos.first];
-    bool within = nonlateral_pos.second < list.sizes()[chain_dim];
-    indexes[chain_dim] = nonlateral_pos.second;
-    const auto& offset = nesting_offsets_[nonlateral_pos.first];
-    V_CHAIN_FOR_LATERAL_DIM(dim, {
-        within &= (offset[dim] <= indexes[dim]) &
-            (indexes[dim] < offset[dim] + list.sizes()[dim]);
-        indexes[dim] -= offset[dim];
-      });
-    return within ? list.get(std::move(indexes)) : *default_value_;
+    if (!coverage_.empty() && !coverage_.covers(indexes))
+      return *default_value_;
+    return GetAt(fwd_skip_list_.get(indexes[chain_dim]), std::move(indexes));
+  }
+
+  // Builds an index of the regions covered by the (nested) sublists, so that
+  // get() of most default elements returns without descending into them
+  // (called by the constructors, but must be called again if the layout of a
+  // sublist changes, or to change the number of cells)
+  void IndexCoverage(
+      size_t max_cell_count = CoverageGrid<dims>::kDefaultMaxCellCount) {
+    std::vector<typename ListBaseType::Box> boxes;
+    AppendCoverage(SizeArray{}, default_value_, &boxes);
+    coverage_ = CoverageGrid<dims>(this->sizes_, boxes, max_cell_count);
+    IndexLateralBounds();
+  }
+
+  const CoverageGrid<dims>& coverage() const { return coverage_; }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    // skip the dummy sublists at the front and back
+    for (size_t i = 1; i + 1 < lists_.size(); ++i)
+      lists_[i].ForEachSpan(visitor);
+  }
+
+  void AppendCoverage(const SizeArray& offset, const DataType* default_value,
+                      std::vector<typename ListBaseType::Box>* boxes)
+      const override {
+    if (default_value != default_value_)
+      return ListBaseType::AppendCoverage(offset, default_value, boxes);
+    for (size_t i = 1; i + 1 < lists_.size(); ++i) {
+      SizeArray nested_offset(offset);
+      for (unsigned dim = 0; dim < dims; ++dim)
+        nested_offset[dim] += nesting_offsets_[i][dim];
+      lists_[i].AppendCoverage(nested_offset, default_value, boxes);
+    }
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    for (size_t i = 1; i + 1 < lists_.size(); ++i) {
+      const SizeArray& offset = nesting_offsets_[i];
+      lists_[i].ForEachEntry([&](const SizeArray& indexes, DataType& value) {
+          SizeArray nested_indexes;
+          for (unsigned dim = 0; dim < dims; ++dim)
+            nested_indexes[dim] = indexes[dim] + offset[dim];
+          visitor(nested_indexes, value);
+        });
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(dims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<DataType>* runs) const override {
+    // if chained in dimension dim, the sublists are ordered along the line
+    // (otherwise, only the one at indexes[chain_dim] can intersect the line)
+    size_t i, i_end;
+    if (chain_dim != dim) {
+      i = fwd_skip_list_.get(indexes[chain_dim]).first;
+      i_end = i + 1;
+    } else {
+      std::tie(i, i_end) = LateralRange(indexes[kLateralDim]);
+    }
+
+    size_t cur = 0;  // the next index in dimension dim
+    for (; i < i_end; ++i) {
+      const auto& list = lists_[i];
+      const SizeArray& offset = nesting_offsets_[i];
+      SizeArray nested_indexes(indexes);
+      bool within = true;
+      for (unsigned d = 0; d < dims; ++d)
+        if (d != dim) {
+          within &= (offset[d] <= indexes[d]) &
+              (indexes[d] < offset[d] + list.sizes()[d]);
+          nested_indexes[d] -= offset[d];
+        }
+      if (!within)
+        continue;
+
+      AppendRun(start + cur, offset[dim] - cur, default_value_, true, runs);
+      list.AppendDimRuns(dim, nested_indexes, start + offset[dim], runs);
+      cur = offset[dim] + list.sizes()[dim];
+    }
+    AppendRun(start + cur, this->sizes_[dim] - cur, default_value_, true,
+              runs);
   }
 
   typename View<DataType>::Iterator iterator_begin() const override {
-    // TODO: implement
-    return *reinterpret_cast<typename View<DataType>::Iterator*>(NULL);
-  }
-
-  // Define dimension iterator accessors with the signature:
-  //   template<unsigned dim, typename Index, typename... Indexes>
-  //   [Const]DimIterator<dim> dim_[c]<infix>(begin|end)\<dim\>(
-  //       Index&& lateral_index, Indexes&&... lateral_indexes) const;
-  // Each forwards the call to dim_[c]<infix>(begin|end)0\<dim\>
-#define V_THIS_DEF_DIM_ITER_ACCESSOR0(Tpl, method, method0)             \
-  template<unsigned dim, typename... Indexes>                           \
-  Tpl<dim> method(Indexes&&... lateral_indexes) const {                 \
-    return method0<Tpl<dim> >(                                          \
-        std::forward<Indexes>(lateral_indexes)...);                     \
-  }
-#define V_THIS_DEF_DIM_ITER_ACCESSOR1(Tpl, prefix, c, which)            \
-  V_THIS_DEF_DIM_ITER_ACCESSOR0(Tpl, prefix ## c ## which, prefix ## which ## 0)
-#define V_THIS_DEF_DIM_ITER_ACCESSOR(Tpl, infix, c, which)       \
-      V_THIS_DEF_DIM_ITER_ACCESSOR1(Tpl, infix ## dim_, c, which)
-#define V_THIS_DEF_DIM_ITER_ACCESSORS0(Tpl, infix, c)            \
-  V_THIS_DEF_DIM_ITER_ACCESSOR(infix, Tpl, c, begin)             \
-  V_THIS_DEF_DIM_ITER_ACCESSOR(infix, Tpl, c, end)
-#define V_THIS_DEF_DIM_ITER_ACCESSORS(Tpl, infix, c)    \
-  V_THIS_DEF_DIM_ITER_ACCESSORS0(infix, Tpl, c)
-
-  // V_THIS_DEF_DIM_ITER_ACCESSORS(DimIterator, ,)
-  // V_THIS_DEF_DIM_ITER_ACCESSORS(ConstDimIterator, , c)
-  V_THIS_DEF_DIM_ITER_ACCESSORS(EntryDimIterator, entry_,)
-  V_THIS_DEF_DIM_ITER_ACCESSORS(ConstEntryDimIterator, entry_, c)
-
-#undef V_THIS_DEF_DIM_ITER_ACCESSORS
-#undef V_THIS_DEF_DIM_ITER_ACCESSORS0
-#undef V_THIS_DEF_DIM_ITER_ACCESSOR
-#undef V_THIS_DEF_DIM_ITER_ACCESSOR1
-#undef V_THIS_DEF_DIM_ITER_ACCESSOR0
-
-  const ValuesView& values() const override { return values_; }
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  const ValuesView& values() const override {
+    // (rebuilt only if a value has been inserted since, so that reading the
+    // values of an unchanged chain does not modify it)
+    if (values_.outdated())
+      values_ = ValuesView(lists_);
+    return values_;
+  }
+  DataType* default_value() const override { return default_value_; }
 
   const SizeArray& nesting_offset(size_t index) const {
     return nesting_offsets_[++index];
@@ -432,7 +828,46 @@ class List<
     mutable const std::vector<List::SizeArray>* o_;
   };
 
-  typedef ImmutableSkipList<NonLateralBucketSizeGetter> SkipListType;
+  typedef SkipList<NonLateralBucketSizeGetter> SkipListType;
+
+ public:
+  // A finger into the chain that remembers the sublist of the last accessed
+  // element, so that accessing nearby elements (in the chain dimension) is
+  // faster than via get()
+  class Cursor {
+   public:
+    explicit Cursor(const List& chain)
+        : chain_(&chain),
+          finger_(chain.fwd_skip_list_.cursor()) {}
+
+    DataType& seek(SizeArray&& indexes) {
+      return chain_->GetAt(finger_.seek(indexes[chain_dim]),
+                          std::move(indexes));
+    }
+
+   private:
+    const List* chain_;
+    typename SkipListType::Cursor finger_;
+  };
+
+  Cursor cursor() const { return Cursor(*this); }
+
+ private:
+  // Returns the element at the indexes, given the position of the sublist
+  // that spans indexes[chain_dim] (relative to which it is within that list)
+  DataType& GetAt(const typename SkipListType::Position& nonlateral_pos,
+                  SizeArray&& indexes) const {
+    const auto& list = lists_[nonlateral_pos.first];
+    bool within = nonlateral_pos.second < list.sizes()[chain_dim];
+    indexes[chain_dim] = nonlateral_pos.second;
+    const auto& offset = nesting_offsets_[nonlateral_pos.first];
+    V_CHAIN_FOR_LATERAL_DIM(dim, {
+        within &= (offset[dim] <= indexes[dim]) &
+            (indexes[dim] < offset[dim] + list.sizes()[dim]);
+        indexes[dim] -= offset[dim];
+      });
+    return within ? list.get(std::move(indexes)) : *default_value_;
+  }
 
   static void ComputeLateralSize(const Container& lists,
                                  const NestingOffsetVector& nesting_offsets,
@@ -479,24 +914,86 @@ class List<
 
   template<class DimIterType, typename... Indexes>
   DimIterType entry_dim_begin0(Indexes&&... lateral_indexes) const {
-    return DimIterType(++lists_.cbegin(), --lists_.cend(),
-                       ++nesting_offsets_.cbegin(),
-                       std::forward<Indexes>(lateral_indexes)...);
-                       // LateralOffset{static_cast<size_t>(lateral_indexes)...});
+    return MakeEntryDimIter<DimIterType>(
+        LateralOffset{{static_cast<size_t>(lateral_indexes)...}}, true);
   }
 
-  template<class DimIterType, typename Index, typename... Indexes>
+  template<class DimIterType, typename... Indexes>
   DimIterType entry_dim_end0(Indexes&&... lateral_indexes) const {
-    auto outer_max = --lists_.cend();
-    return DimIterType(outer_max, outer_max, --nesting_offsets_.cend(),
-                       std::forward<Indexes>(lateral_indexes)...);
+    return MakeEntryDimIter<DimIterType>(
+        LateralOffset{{static_cast<size_t>(lateral_indexes)...}}, false);
+  }
+
+  // the lateral dimension in which the sublists are bounded (see LateralRange)
+  static constexpr unsigned kLateralDim = chain_dim == 0 && dims > 1 ? 1 : 0;
+
+  // Computes the bounds that LateralRange() searches
+  void IndexLateralBounds() {
+    // excluding the dummies (if any are left after ShrinkToFirst())
+    const size_t count = std::max<size_t>(lists_.size(), 2) - 2;
+    lateral_end_max_.resize(count);
+    lateral_start_min_.resize(count);
+    size_t end_max = 0, start_min = size_t(-1);
+    for (size_t k = 0; k < count; ++k) {
+      const size_t offset = nesting_offsets_[1 + k][kLateralDim];
+      end_max = std::max(end_max, offset + lists_[1 + k].sizes()[kLateralDim]);
+      lateral_end_max_[k] = end_max;
+    }
+    for (size_t k = count; k--; ) {
+      start_min = std::min(start_min, nesting_offsets_[1 + k][kLateralDim]);
+      lateral_start_min_[k] = start_min;
+    }
+  }
+
+  // Returns the range [i, i_end) of the sublists that can contain the index
+  // in dimension kLateralDim (those outside of it cannot), found by binary
+  // searches over the prefix maximums of the ends and the suffix minimums of
+  // the starts of the sublists in that dimension (which are both sorted).
+  // It is exact if those are sorted as well (e.g., in a block diagonal).
+  std::pair<size_t, size_t> LateralRange(size_t index) const {
+    if (dims == 1)
+      return std::make_pair(size_t(1), lists_.size() - 1);
+    const size_t i = 1 + (std::upper_bound(lateral_end_max_.begin(),
+                                           lateral_end_max_.end(), index) -
+                          lateral_end_max_.begin());
+    const size_t i_end = 1 + (std::upper_bound(lateral_start_min_.begin(),
+                                               lateral_start_min_.end(),
+                                               index) -
+                              lateral_start_min_.begin());
+    return std::make_pair(i, i_end);  // i <= i_end, since starts <= ends
+  }
+
+  // Returns the entry iterator over the sublists that can intersect the line,
+  // i.e., the one spanning it if it is not along chain_dim, or else those in
+  // the LateralRange() of its index in kLateralDim
+  template<class DimIterType>
+  DimIterType MakeEntryDimIter(LateralOffset&& lateral, bool begin) const {
+    static constexpr unsigned dim = DimIterType::kDim;
+    size_t outer_min = 1, outer_max = lists_.size() - 1;
+    if (dim != chain_dim) {
+      const size_t index = lateral[chain_dim - (chain_dim > dim)];
+      if (index < this->sizes_[chain_dim]) {
+        const size_t i = fwd_skip_list_.get(index).first;
+        outer_min = std::max<size_t>(i, 1);  // skip the dummy sublist
+        outer_max = std::min(i + 1, outer_max);
+      } else {
+        outer_min = outer_max;
+      }
+    } else if (dims > 1) {
+      std::tie(outer_min, outer_max) = LateralRange(
+          lateral[kLateralDim - (kLateralDim > chain_dim)]);
+    }
+    return DimIterType(this, outer_min, outer_max, std::move(lateral), begin);
   }
 
   Container lists_;
   DataType* default_value_;
   NestingOffsetVector nesting_offsets_;
   SkipListType fwd_skip_list_;
-  ValuesView values_;
+  CoverageGrid<dims> coverage_;  // empty only after ShrinkToFirst()
+  std::vector<size_t> lateral_end_max_;
+  std::vector<size_t> lateral_start_min_;
+  mutable ValuesView values_;
 };
 
 // specialization for Uniform Chain (same sublist sizes + no lateral offsets)
@@ -543,17 +1040,23 @@ using UniformChain = List<SublistType, dims, flags,
 
 template<class SublistType, unsigned dims, unsigned chain_dim,
          size_t uniform_size_, size_t gap_before_, size_t gap_after_>
-class List<
-  SublistType,
-  dims,
-  kListOpVector,
+#define V_LIST_TYPE                                                     \
+  List<SublistType,                                                     \
+       dims,                                                            \
+       kListOpVector,                                                   \
+       detail::UniformlyChainedListVector<SublistType, chain_dim,       \
+                                          uniform_size_, gap_before_,   \
+                                          gap_after_>,                  \
+       typename SublistType::DataType,                                  \
+       typename std::enable_if<                                         \
+         dims >= ListTraits<SublistType>::kDims>::type>
+class V_LIST_TYPE
 #define V_THIS_DATA_TYPE typename SublistType::DataType
-  detail::UniformlyChainedListVector<SublistType, chain_dim, uniform_size_,
-                                     gap_before_, gap_after_>,
-  V_THIS_DATA_TYPE,
-  typename std::enable_if<dims >= ListTraits<SublistType>::kDims>::type>
     : public ListBase<V_THIS_DATA_TYPE, dims>,
+      public DimIterAccessors<V_LIST_TYPE>,
       protected detail::ChainHelper<SublistType> {
+  friend class DimIterAccessors<V_LIST_TYPE>;
+#undef V_LIST_TYPE
   static_assert(chain_dim < dims, "chain_dim < dims");
 
   typedef ListBase<V_THIS_DATA_TYPE, dims> ListBaseType;
@@ -569,6 +1072,20 @@ class List<
  public:
   typedef detail::ChainValues<SublistType> ValuesView;
 
+  // iterate over the runs along dimension dim (see Chain)
+  template<unsigned dim>
+  using DimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim>;
+  template<unsigned dim>
+  using ConstDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim>;
+  template<unsigned dim>
+  using NonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim, true>;
+  template<unsigned dim>
+  using ConstNonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim, true>;
+
   template<typename... Sizes>
   List(ListVector<SublistType>&& lists, DataType* default_value)
       : lists_(std::move(lists)),
@@ -579,7 +1096,9 @@ class List<
     this->sizes_[chain_dim] = uniform_size_ + gap_before_ + gap_after_;
     this->sizes_[chain_dim] *= lists_.size();
     this->offsets_.fill(0);
+    this->size_ = this->element_count();
     this->InsertDummies(&lists_);
+    values_ = ValuesView(lists_);  // recount with the dummies
   }
 
   // List(const List&) = delete;  // redundant since ListVector is not copyable
@@ -618,12 +1137,89 @@ class List<
                               : *default_value_;
   }
 
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    // skip the dummy sublists at the front and back
+    for (size_t i = 1; i + 1 < lists_.size(); ++i)
+      lists_[i].ForEachSpan(visitor);
+  }
+
+  void AppendCoverage(const SizeArray& offset, const DataType* default_value,
+                      std::vector<typename ListBaseType::Box>* boxes)
+      const override {
+    if (default_value != default_value_)
+      return ListBaseType::AppendCoverage(offset, default_value, boxes);
+    for (size_t i = 1; i + 1 < lists_.size(); ++i) {
+      SizeArray nested_offset(offset);
+      nested_offset[chain_dim] += gap_before_ + (i - 1) * bucket_size();
+      lists_[i].AppendCoverage(nested_offset, default_value, boxes);
+    }
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    for (size_t i = 1; i + 1 < lists_.size(); ++i) {
+      const size_t offset = gap_before_ + (i - 1) * bucket_size();
+      lists_[i].ForEachEntry([&](const SizeArray& indexes, DataType& value) {
+          SizeArray nested_indexes(indexes);
+          nested_indexes[chain_dim] += offset;
+          visitor(nested_indexes, value);
+        });
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(dims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<DataType>* runs) const override {
+    const size_t list_count = lists_.size() - 2;  // excluding dummies
+    SizeArray nested_indexes(indexes);
+    size_t k = 0, k_end = list_count;
+    if (chain_dim != dim) {
+      // only the sublist at indexes[chain_dim] (if any) intersects the line
+      auto& nonlateral_index = nested_indexes[chain_dim];
+      k_end = 0;
+      if (nonlateral_index >= gap_before_) {
+        k = (nonlateral_index -= gap_before_) / bucket_size();
+        nonlateral_index -= k * bucket_size();
+        if (nonlateral_index < uniform_size_ && k < list_count)
+          k_end = k + 1;
+      }
+    }
+
+    size_t cur = 0;  // the next index in dimension dim
+    for (; k < k_end; ++k) {
+      const auto& list = lists_[1 + k];
+      const size_t offset = chain_dim == dim ? gap_before_ + k * bucket_size()
+                            : 0;
+      AppendRun(start + cur, offset - cur, default_value_, true, runs);
+      list.AppendDimRuns(dim, nested_indexes, start + offset, runs);
+      cur = offset + list.sizes()[dim];
+    }
+    AppendRun(start + cur, this->sizes_[dim] - cur, default_value_, true,
+              runs);
+  }
+
   typename View<DataType>::Iterator iterator_begin() const override {
-    // TODO: implement
-    return *static_cast<typename View<DataType>::Iterator*>(nullptr);
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
   }
 
-  const ValuesView& values() const override { return values_; }
+  const ValuesView& values() const override {
+    // (rebuilt only if a value has been inserted since, so that reading the
+    // values of an unchanged chain does not modify it)
+    if (values_.outdated())
+      values_ = ValuesView(lists_);
+    return values_;
+  }
+  DataType* default_value() const override { return default_value_; }
 
  private:
   static constexpr size_t bucket_size() {
@@ -632,7 +1228,265 @@ class List<
 
   Container lists_;
   DataType* default_value_;
-  ValuesView values_;
+  mutable ValuesView values_;
+};
+
+// specialization for Uniform Chain whose sizes are known only at runtime
+
+namespace detail {
+
+template<class SublistType, unsigned chain_dim>
+class DynUniformlyChainedListVector
+#define V_THIS_BASE_TYPE ChainedListVector<SublistType, chain_dim>
+    : public V_THIS_BASE_TYPE {
+  typedef V_THIS_BASE_TYPE ChainedListVectorType;
+#undef V_THIS_BASE_TYPE
+  typedef ListVector<SublistType> ListVectorType;
+ public:
+  using ChainedListVectorType::ChainedListVectorType;
+
+  DynUniformlyChainedListVector(ListVectorType&& sv)
+      : ChainedListVectorType(std::move(sv)) {}
+};
+
+}  // namespace detail
+
+template<unsigned chain_dim>
+struct DynUniformChainTag {};
+
+// Same as UniformChain, but the sizes are passed to the constructor instead,
+// and the bucket index is found by a precomputed libdivide division.
+template<class SublistType,
+         unsigned chain_dim,
+         ListFlags flags = kListOpVector,
+         unsigned dims = ListTraits<SublistType>::kDims>  // it can also be >
+using DynUniformChain = List<SublistType, dims, flags,
+                             detail::DynUniformlyChainedListVector<
+                               SublistType, chain_dim>,
+                             typename SublistType::DataType>;
+
+template<class SublistType, unsigned dims, unsigned chain_dim>
+#define V_LIST_TYPE                                                     \
+  List<SublistType,                                                     \
+       dims,                                                            \
+       kListOpVector,                                                   \
+       detail::DynUniformlyChainedListVector<SublistType, chain_dim>,   \
+       typename SublistType::DataType,                                  \
+       typename std::enable_if<                                         \
+         dims >= ListTraits<SublistType>::kDims>::type>
+class V_LIST_TYPE
+#define V_THIS_DATA_TYPE typename SublistType::DataType
+    : public ListBase<V_THIS_DATA_TYPE, dims>,
+      public DimIterAccessors<V_LIST_TYPE>,
+      protected detail::ChainHelper<SublistType> {
+  friend class DimIterAccessors<V_LIST_TYPE>;
+#undef V_LIST_TYPE
+  static_assert(chain_dim < dims, "chain_dim < dims");
+
+  typedef ListBase<V_THIS_DATA_TYPE, dims> ListBaseType;
+  typedef detail::DynUniformlyChainedListVector<SublistType, chain_dim>
+  Container;
+
+ public:
+  // redeclared for convenience of the implementation
+  typedef V_THIS_DATA_TYPE DataType;
+  typedef typename ListBaseType::SizeArray SizeArray;
+#undef V_THIS_DATA_TYPE
+
+ public:
+  typedef detail::ChainValues<SublistType> ValuesView;
+
+  // iterate over the runs along dimension dim (see Chain)
+  template<unsigned dim>
+  using DimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim>;
+  template<unsigned dim>
+  using ConstDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim>;
+  template<unsigned dim>
+  using NonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<DataType, dim, true>;
+  template<unsigned dim>
+  using ConstNonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<const DataType, dim, true>;
+  template<unsigned dim>
+  using EntryDimIterator =
+      typename ListBaseType::template RunEntryDimIter<DataType, dim>;
+  template<unsigned dim>
+  using ConstEntryDimIterator =
+      typename ListBaseType::template RunEntryDimIter<const DataType, dim>;
+
+  List(ListVector<SublistType>&& lists, DataType* default_value,
+       size_t uniform_size, size_t gap_before = 0, size_t gap_after = 0)
+      : lists_(std::move(lists)),
+        default_value_(default_value),
+        uniform_size_(uniform_size),
+        gap_before_(gap_before),
+        gap_after_(gap_after),
+        bucket_size_(uniform_size + gap_before + gap_after),
+        values_(lists_) {
+    const libdivide::libdivide_u64_t divider =
+        libdivide::libdivide_u64_gen(bucket_size_ ? bucket_size_ : 1);
+    bucket_magic_ = divider.magic;
+    bucket_more_ = divider.more;
+
+    const auto& first_sizes = lists_[0].sizes();
+    std::copy(first_sizes.begin(), first_sizes.end(), this->sizes_.begin());
+    this->sizes_[chain_dim] = bucket_size_ * lists_.size();
+    this->offsets_.fill(0);
+    this->size_ = this->element_count();
+    this->InsertDummies(&lists_);
+    values_ = ValuesView(lists_);  // recount with the dummies
+  }
+
+  // List(const List&) = delete;  // redundant since ListVector is not copyable
+  List(List&& src)
+      : ListBaseType(std::move(src)),
+        lists_(std::move(src.lists_)),
+        default_value_(src.default_value_),
+        uniform_size_(src.uniform_size_),
+        gap_before_(src.gap_before_),
+        gap_after_(src.gap_after_),
+        bucket_size_(src.bucket_size_),
+        bucket_magic_(src.bucket_magic_),
+        bucket_more_(src.bucket_more_),
+        values_(lists_) {}
+
+  // used by MakeList
+  template<typename... Args>
+  List(DynUniformChainTag<chain_dim>, Args&&... args)
+      : List(std::forward<Args>(args)...) {}
+
+  friend List MakeList(List&& list) {
+    return std::forward<List>(List(std::move(list)));
+  }
+
+  template<typename... Indexes>
+  DataType& operator()(Indexes&&... indexes) const {
+    return get(SizeArray{static_cast<size_t>(indexes)...});
+  }
+
+  void ShrinkToFirst() override {
+    ListBaseType::ShrinkToFirst();
+    lists_.Erase(++lists_.begin(), lists_.end());
+  }
+
+  DataType& get(SizeArray&& indexes) const override {
+    if (indexes[chain_dim] < gap_before_)
+      return *default_value_;
+
+    auto& nonlateral_index = indexes[chain_dim];
+    const auto list_index = BucketIndex(nonlateral_index -= gap_before_);
+    nonlateral_index -= list_index * bucket_size_;
+    return nonlateral_index < uniform_size_
+                              ? lists_[1 + list_index].get(std::move(indexes))
+                              : *default_value_;
+  }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    // skip the dummy sublists at the front and back
+    for (size_t i = 1; i + 1 < lists_.size(); ++i)
+      lists_[i].ForEachSpan(visitor);
+  }
+
+  void AppendCoverage(const SizeArray& offset, const DataType* default_value,
+                      std::vector<typename ListBaseType::Box>* boxes)
+      const override {
+    if (default_value != default_value_)
+      return ListBaseType::AppendCoverage(offset, default_value, boxes);
+    for (size_t i = 1; i + 1 < lists_.size(); ++i) {
+      SizeArray nested_offset(offset);
+      nested_offset[chain_dim] += gap_before_ + (i - 1) * bucket_size_;
+      lists_[i].AppendCoverage(nested_offset, default_value, boxes);
+    }
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    for (size_t i = 1; i + 1 < lists_.size(); ++i) {
+      const size_t offset = gap_before_ + (i - 1) * bucket_size_;
+      lists_[i].ForEachEntry([&](const SizeArray& indexes, DataType& value) {
+          SizeArray nested_indexes(indexes);
+          nested_indexes[chain_dim] += offset;
+          visitor(nested_indexes, value);
+        });
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(dims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<DataType>* runs) const override {
+    const size_t list_count = lists_.size() - 2;  // excluding dummies
+    SizeArray nested_indexes(indexes);
+    size_t k = 0, k_end = list_count;
+    if (chain_dim != dim) {
+      // only the sublist at indexes[chain_dim] (if any) intersects the line
+      auto& nonlateral_index = nested_indexes[chain_dim];
+      k_end = 0;
+      if (nonlateral_index >= gap_before_) {
+        k = BucketIndex(nonlateral_index -= gap_before_);
+        nonlateral_index -= k * bucket_size_;
+        if (nonlateral_index < uniform_size_ && k < list_count)
+          k_end = k + 1;
+      }
+    }
+
+    size_t cur = 0;  // the next index in dimension dim
+    for (; k < k_end; ++k) {
+      const auto& list = lists_[1 + k];
+      const size_t offset = chain_dim == dim ? gap_before_ + k * bucket_size_
+                            : 0;
+      AppendRun(start + cur, offset - cur, default_value_, true, runs);
+      list.AppendDimRuns(dim, nested_indexes, start + offset, runs);
+      cur = offset + list.sizes()[dim];
+    }
+    AppendRun(start + cur, this->sizes_[dim] - cur, default_value_, true,
+              runs);
+  }
+
+  typename View<DataType>::Iterator iterator_begin() const override {
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  const ValuesView& values() const override {
+    // (rebuilt only if a value has been inserted since, so that reading the
+    // values of an unchanged chain does not modify it)
+    if (values_.outdated())
+      values_ = ValuesView(lists_);
+    return values_;
+  }
+  DataType* default_value() const override { return default_value_; }
+
+  size_t uniform_size() const { return uniform_size_; }
+  size_t gap_before() const { return gap_before_; }
+  size_t gap_after() const { return gap_after_; }
+
+ private:
+  // Returns index / bucket_size_ (using mults and shifts)
+  size_t BucketIndex(size_t index) const {
+    const libdivide::libdivide_u64_t divider{bucket_magic_, bucket_more_};
+    return libdivide::libdivide_u64_do(index, &divider);
+  }
+
+  Container lists_;
+  DataType* default_value_;
+  size_t uniform_size_;
+  size_t gap_before_;
+  size_t gap_after_;
+  size_t bucket_size_;
+  uint64_t bucket_magic_;  // libdivide::libdivide_u64_t has internal linkage
+  uint8_t bucket_more_;
+  mutable ValuesView values_;
 };
 
 // functions
@@ -667,6 +1521,19 @@ auto MakeList(UniformChainTag<chain_dim, uniform_size, gap_before, gap_after>,
 }
 #undef V_LIST_TYPE
 
+template<class Sublist, unsigned chain_dim>
+auto MakeList(DynUniformChainTag<chain_dim>,
+              ListVector<Sublist>&& lists,
+              typename Sublist::DataType* default_value,
+              size_t uniform_size, size_t gap_before = 0, size_t gap_after = 0)
+#define V_LIST_TYPE \
+    DynUniformChain<Sublist, chain_dim>
+    -> V_LIST_TYPE {
+  return V_LIST_TYPE(std::move(lists), default_value, uniform_size,
+                     gap_before, gap_after);
+}
+#undef V_LIST_TYPE
+
 }  // namespace v
 
 #endif  /* CPPVIEWS_SRC_CHAIN_HPP_ */
@@ -0,0 +1,385 @@
+#ifndef CPPVIEWS_SRC_COMPILED_VIEW_HPP_
+#define CPPVIEWS_SRC_COMPILED_VIEW_HPP_
+
+#include "list.hpp"
+#include "run.hpp"
+#include "util/coverage_grid.hpp"
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v {
+
+// A flat index over the layout of a (possibly nested) 2D list, which maps each
+// element directly to its storage without any virtual calls. The consecutive
+// rows whose runs have the same shape are grouped into bands (looked up by row
+// in O(1) time), and each band into column intervals sorted by the column at
+// which they start (binary searched), each being a pointer plus a stride (per
+// row and column) into the original storage.
+// Therefore, the writes through either of them are visible in both, but the
+// source list must outlive this view and its layout must not change.
+// The elements that are the source's default value are not stored, and all
+// reads (including the values and entries) are served from the intervals.
+template<typename T>
+class CompiledView : public ListBase<T, 2> {
+  typedef ListBase<T, 2> ListBaseType;
+
+  // Elements [col, col + length) in the row band_start + dr start at column
+  // col + dr * col_shift and are stored from data + dr * row_stride onward
+  // (col_stride is 0 if they are all equal to that value, i.e., repeated).
+  // The strides are in bytes between integer addresses, since the rows of a
+  // band need not be stored in the same object (so pointer arithmetic across
+  // them would be undefined).
+  struct Interval {
+    size_t col;
+    size_t length;
+    std::ptrdiff_t col_shift;
+    T* data;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t col_stride;
+
+    std::ptrdiff_t begin(std::ptrdiff_t dr) const {
+      return col + dr * col_shift;
+    }
+
+    // Returns the address of the element at position pos in the row dr
+    // (which is not dereferenceable unless pos < length)
+    T* at(std::ptrdiff_t dr, size_t pos) const {
+      // (wraps around rather than overflows, hence the unsigned arithmetic)
+      return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(data) +
+                                  uintptr_t(dr) * uintptr_t(row_stride) +
+                                  pos * uintptr_t(col_stride));
+    }
+  };
+
+ public:
+  typedef T DataType;
+  typedef typename ListBaseType::SizeArray SizeArray;  // bring to scope
+
+  // Iterates over the stored values in row-major order, an interval at a time
+  // (the repeated intervals are skipped, since they are defaults of sublists)
+  class ValueIter
+      : public DefaultIterator<ValueIter, std::forward_iterator_tag, T>,
+        public View<T>::IteratorBase {
+    V_DEFAULT_ITERATOR_DERIVED_HEAD(ValueIter);
+
+   public:
+    ValueIter(const CompiledView* view, bool end)
+        : view_(view),
+          row_(end ? view->sizes_[0] : 0),
+          dr_(0),
+          interval_(0),
+          interval_end_(0),
+          pos_(0) {
+      if (row_ < view->sizes_[0]) {
+        SeekRow();
+        SkipRepeated();
+      }
+    }
+
+   protected:
+    V_DEF_VIEW_ITER_IS_EQUAL(T, ValueIter)
+
+    bool IsEqual(const ValueIter& other) const {
+      return row_ == other.row_ && interval_ == other.interval_ &&
+          pos_ == other.pos_;
+    }
+
+    void Increment() override {
+      if (++pos_ == view_->intervals_[interval_].length) {
+        pos_ = 0;
+        ++interval_;
+        SkipRepeated();
+      }
+    }
+
+    T& ref() const override {
+      return *view_->intervals_[interval_].at(dr_, pos_);
+    }
+
+   private:
+    void SeekRow() {
+      const size_t band = view_->row_bands_[row_];
+      dr_ = row_ - view_->band_rows_[band];
+      interval_ = view_->band_offsets_[band];
+      interval_end_ = view_->band_offsets_[band + 1];
+    }
+
+    // Moves to the next interval that is not repeated, in this row or after
+    void SkipRepeated() {
+      for (;;) {
+        for (; interval_ != interval_end_; ++interval_)
+          if (view_->intervals_[interval_].col_stride)
+            return;
+        if (++row_ == view_->sizes_[0]) {
+          interval_ = interval_end_ = 0;  // same as the end
+          return;
+        }
+        SeekRow();
+      }
+    }
+
+    const CompiledView* view_;
+    size_t row_;
+    std::ptrdiff_t dr_;
+    size_t interval_;
+    size_t interval_end_;
+    size_t pos_;
+  };
+
+  class ValuesView : public View<T> {
+   public:
+    typedef ValueIter Iterator;
+
+    ValuesView(const CompiledView* view, size_t size)
+        : View<T>(size),
+          view_(view) {}
+    typename View<T>::Iterator iterator_begin() const {
+      return Iterator(begin());
+    }
+    typename View<T>::Iterator iterator_end() const {
+      return Iterator(end());
+    }
+    Iterator begin() const { return Iterator(view_, false); }
+    Iterator end() const { return Iterator(view_, true); }
+
+   private:
+    const CompiledView* view_;
+  };
+
+  // Also indexes the coverage of the intervals, which operator() consults
+  // first, so that most reads of the default value skip the interval search
+  explicit CompiledView(
+      const ListBaseType& source,
+      size_t max_cell_count = CoverageGrid<2>::kDefaultMaxCellCount)
+      : ListBaseType(source.sizes()[0], source.sizes()[1]),
+        default_value_(source.default_value()),
+        values_(this, 0) {
+    values_ = ValuesView(this, Compile(source));
+    IndexCoverage(max_cell_count);
+  }
+
+  // the values view has to point to the copied/moved intervals
+  CompiledView(const CompiledView& src)
+      : ListBaseType(src),
+        default_value_(src.default_value_),
+        row_bands_(src.row_bands_),
+        band_rows_(src.band_rows_),
+        band_offsets_(src.band_offsets_),
+        intervals_(src.intervals_),
+        coverage_(src.coverage_),
+        values_(this, src.values_.size()) {}
+
+  CompiledView(CompiledView&& src)
+      : ListBaseType(std::move(src)),
+        default_value_(src.default_value_),
+        row_bands_(std::move(src.row_bands_)),
+        band_rows_(std::move(src.band_rows_)),
+        band_offsets_(std::move(src.band_offsets_)),
+        intervals_(std::move(src.intervals_)),
+        coverage_(std::move(src.coverage_)),
+        values_(this, src.values_.size()) {}
+
+  CompiledView& operator=(const CompiledView& rhs) {
+    return *this = CompiledView(rhs);
+  }
+
+  CompiledView& operator=(CompiledView&& rhs) {
+    ListBaseType::operator=(std::move(rhs));
+    default_value_ = rhs.default_value_;
+    row_bands_ = std::move(rhs.row_bands_);
+    band_rows_ = std::move(rhs.band_rows_);
+    band_offsets_ = std::move(rhs.band_offsets_);
+    intervals_ = std::move(rhs.intervals_);
+    coverage_ = std::move(rhs.coverage_);
+    values_ = ValuesView(this, rhs.values_.size());
+    return *this;
+  }
+
+  DataType& operator()(size_t row, size_t col) const {
+    if (!coverage_.covers(SizeArray{{row, col}}))
+      return *default_value_;
+    const size_t band = row_bands_[row];
+    const std::ptrdiff_t dr = row - band_rows_[band];
+    const Interval* interval = intervals_.data() + band_offsets_[band];
+    size_t count = band_offsets_[band + 1] - band_offsets_[band];
+    if (!count)
+      return *default_value_;
+    // find the last interval that starts at or before col (unless it is the
+    // first one), without branches that are mispredicted for random accesses
+    while (count > 1) {
+      const size_t half = count >> 1;
+      interval = interval[half].begin(dr) <= static_cast<std::ptrdiff_t>(col)
+          ? interval + half : interval;
+      count -= half;
+    }
+    const size_t pos = col - interval->begin(dr);  // wraps around if before
+    T* value = interval->at(dr, pos);
+    return *(pos < interval->length ? value : default_value_);
+  }
+
+  DataType& get(SizeArray&& indexes) const override {
+    return operator()(indexes[0], indexes[1]);
+  }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    for (size_t row = 0; row < this->sizes_[0]; ++row) {
+      const size_t band = row_bands_[row];
+      const std::ptrdiff_t dr = row - band_rows_[band];
+      for (size_t i = band_offsets_[band]; i < band_offsets_[band + 1]; ++i)
+        if (intervals_[i].col_stride)
+          visitor(intervals_[i].at(dr, 0), intervals_[i].length);
+    }
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    SizeArray indexes;
+    for (size_t row = 0; row < this->sizes_[0]; ++row) {
+      const size_t band = row_bands_[row];
+      const std::ptrdiff_t dr = row - band_rows_[band];
+      indexes[0] = row;
+      for (size_t i = band_offsets_[band]; i < band_offsets_[band + 1]; ++i) {
+        const Interval& interval = intervals_[i];
+        if (!interval.col_stride)
+          continue;
+        indexes[1] = interval.begin(dr);
+        for (size_t pos = 0; pos < interval.length; ++pos, ++indexes[1])
+          visitor(indexes, *interval.at(dr, pos));
+      }
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    const size_t band = row_bands_[indexes[0]];
+    const std::ptrdiff_t dr = indexes[0] - band_rows_[band];
+    size_t cur = 0;  // the next column
+    for (size_t i = band_offsets_[band]; i < band_offsets_[band + 1]; ++i) {
+      const Interval& interval = intervals_[i];
+      const size_t col = interval.begin(dr);
+      AppendRun(start + cur, col - cur, default_value_, true, runs);
+      AppendRun(start + col, interval.length,
+                interval.at(dr, 0), !interval.col_stride, runs);
+      cur = col + interval.length;
+    }
+    AppendRun(start + cur, this->sizes_[1] - cur, default_value_, true, runs);
+  }
+
+  typename View<DataType>::Iterator iterator_begin() const override {
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  const ValuesView& values() const override { return values_; }
+  DataType* default_value() const override { return default_value_; }
+
+  size_t band_count() const { return band_rows_.size(); }
+  size_t interval_count() const { return intervals_.size(); }
+
+  const CoverageGrid<2>& coverage() const { return coverage_; }
+
+ private:
+  // Collects the runs of the row, except those of the default value
+  void FetchRuns(const ListBaseType& source, size_t row,
+                 RunVector<DataType>* runs) const {
+    runs->clear();
+    source.AppendLineRuns(SizeArray{{row, 0}}, 0, runs);
+    size_t kept = 0;
+    for (const auto& run : *runs)
+      if (!(run.repeated && run.value == default_value_))
+        (*runs)[kept++] = run;
+    runs->resize(kept);
+  }
+
+  // Returns true iff the runs are those of the last band shifted by dr rows
+  // (determines the shifts and strides from the second row of the band)
+  bool ExtendsLastBand(const RunVector<DataType>& runs, std::ptrdiff_t dr) {
+    Interval* first = intervals_.data() + band_offsets_.back();
+    if (runs.size() != intervals_.size() - band_offsets_.back())
+      return false;
+    for (size_t i = 0; i < runs.size(); ++i) {
+      const Interval& interval = first[i];
+      if (runs[i].length != interval.length ||
+          runs[i].repeated != !interval.col_stride)
+        return false;
+      if (dr > 1 && (interval.begin(dr) !=
+                     static_cast<std::ptrdiff_t>(runs[i].start) ||
+                     interval.at(dr, 0) != runs[i].value))
+        return false;
+    }
+    if (dr == 1)
+      for (size_t i = 0; i < runs.size(); ++i) {
+        first[i].col_shift = runs[i].start - first[i].col;
+        first[i].row_stride = reinterpret_cast<uintptr_t>(runs[i].value) -
+            reinterpret_cast<uintptr_t>(first[i].data);
+      }
+    return true;
+  }
+
+  // Returns the number of stored values (i.e., in the intervals not repeated)
+  size_t Compile(const ListBaseType& source) {
+    const size_t row_count = this->sizes_[0];
+    RunVector<DataType> runs;
+    size_t value_count = 0;
+    for (size_t row = 0; row < row_count; ++row) {
+      FetchRuns(source, row, &runs);
+      for (const auto& run : runs)
+        if (!run.repeated)
+          value_count += run.length;
+      if (band_rows_.empty() ||
+          !ExtendsLastBand(runs, row - band_rows_.back())) {
+        band_rows_.push_back(row);
+        band_offsets_.push_back(intervals_.size());
+        for (const auto& run : runs)
+          intervals_.push_back(Interval{
+              run.start, run.length, 0, run.value, 0,
+              run.repeated ? 0 : static_cast<std::ptrdiff_t>(sizeof(T))});
+      }
+      row_bands_.push_back(band_rows_.size() - 1);
+    }
+    band_offsets_.push_back(intervals_.size());
+    return value_count;
+  }
+
+  // Marks the cells that overlap any interval (in any row of its band)
+  void IndexCoverage(size_t max_cell_count) {
+    coverage_ = CoverageGrid<2>(this->sizes_, {}, max_cell_count);
+    for (size_t row = 0; row < this->sizes_[0]; ++row) {
+      const size_t band = row_bands_[row];
+      const std::ptrdiff_t dr = row - band_rows_[band];
+      for (size_t i = band_offsets_[band]; i < band_offsets_[band + 1]; ++i) {
+        const size_t col = intervals_[i].begin(dr);
+        coverage_.Mark({{{row, col}}, {{row + 1, col + intervals_[i].length}}});
+      }
+    }
+  }
+
+  DataType* default_value_;
+  std::vector<size_t> row_bands_;  // the band of each row
+  std::vector<size_t> band_rows_;  // the first row of each band
+  std::vector<size_t> band_offsets_;  // the first interval of each band
+  std::vector<Interval> intervals_;
+  CoverageGrid<2> coverage_;
+  ValuesView values_;
+};
+
+// functions
+
+template<typename T>
+CompiledView<T> Freeze(const ListBase<T, 2>& list) {
+  return CompiledView<T>(list);
+}
+
+}  // namespace v
+
+#endif  /* CPPVIEWS_SRC_COMPILED_VIEW_HPP_ */
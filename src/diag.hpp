@@ -3,16 +3,21 @@
 
 #include "list.hpp"
 
+#include "util/aligned_allocator.hpp"
 #include "util/bit_twiddling.hpp"
 #include "util/intseq.hpp"
 
 #ifndef V_DIAG_NLIBDIVIDE
-#include "util/libdivide.h"
+#include "util/divider.hpp"
 #endif  // !defined(V_DIAG_NLIBDIVIDE)
 #include "util/proxy_pointer.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace v {
 
@@ -65,7 +70,52 @@ class DiagDimScaler<Size, rhs, typename std::enable_if<rhs == 1>::type> {
   friend Size operator/(const Size& lhs, const DiagDimScaler&) { return lhs; }
 };
 
-// A multi-dimensional array wrapper with operator()(indexes...) indexing
+// Same as DiagDimScaler, but for a divisor that is known only at runtime:
+// powers of 2 (including 1) are handled by bit shifts only, and the other
+// divisors by a precomputed libdivide division (with a branch to pick either).
+class DynDiagDimScaler {
+ public:
+  explicit DynDiagDimScaler(size_t rhs = 1)
+      : rhs_(rhs),
+        rhs_lg_(IsPow2(rhs) ? FindFirstSet(rhs) - 1 : kNotPow2) {
+    assert(rhs && "Zero divisor");
+#ifndef V_DIAG_NLIBDIVIDE
+    const libdivide::libdivide_u64_t divider =
+        libdivide::libdivide_u64_gen(rhs);
+    magic_ = divider.magic;
+    more_ = divider.more;
+#endif  // !defined(V_DIAG_NLIBDIVIDE)
+  }
+
+  friend size_t operator*(const size_t& lhs, const DynDiagDimScaler& s) {
+    return s.rhs_lg_ != kNotPow2 ? lhs << s.rhs_lg_ : lhs * s.rhs_;
+  }
+  friend size_t operator/(const size_t& lhs, const DynDiagDimScaler& s) {
+    if (s.rhs_lg_ != kNotPow2)
+      return lhs >> s.rhs_lg_;
+#ifndef V_DIAG_NLIBDIVIDE
+    const libdivide::libdivide_u64_t divider{s.magic_, s.more_};
+    return libdivide::libdivide_u64_do(lhs, &divider);
+#else
+    return lhs / s.rhs_;
+#endif  // !defined(V_DIAG_NLIBDIVIDE)
+  }
+
+  size_t rhs() const { return rhs_; }
+
+ private:
+  static constexpr unsigned char kNotPow2 = -1;
+
+  size_t rhs_;
+  unsigned char rhs_lg_;
+#ifndef V_DIAG_NLIBDIVIDE
+  uint64_t magic_;  // libdivide::libdivide_u64_t has internal linkage
+  uint8_t more_;
+#endif  // !defined(V_DIAG_NLIBDIVIDE)
+};
+
+// A multi-dimensional array wrapper with operator()(indexes...) indexing,
+// which stores the values in row-major order (the last index varies fastest)
 template<typename T, typename BlockSize, BlockSize block_size,
          BlockSize... block_sizes>
 class DiagBlock {
@@ -97,6 +147,36 @@ class DiagBlock<T, BlockSize, block_size> {
   NativeType b_;
 };
 
+// The blocks are stored contiguously, starting at a cache line boundary
+template<typename T, typename BlockSize, BlockSize... block_sizes>
+using DiagBlockVector = std::vector<
+  DiagBlock<T, BlockSize, block_sizes...>,
+  AlignedAllocator<DiagBlock<T, BlockSize, block_sizes...>, 64> >;
+
+// Computes y += B x for a dense rows x cols block B (stored in row-major order)
+// with the loop over the columns unrolled, so that it can be vectorized
+template<typename T, size_t rows, size_t cols>
+class DiagBlockKernel {
+ public:
+  static void MultiplyAdd(const T* block, const T* x, T* y) {
+    for (size_t r = 0; r < rows; ++r, block += cols)
+      y[r] += Dot(block, x, cpp14::make_index_sequence<cols>());
+  }
+
+ private:
+  template<size_t... Is>
+  static T Dot(const T* row, const T* x, cpp14::index_sequence<Is...>) {
+    return Sum((row[Is] * x[Is])...);
+  }
+
+  static T Sum(const T& term) { return term; }
+
+  template<typename... Terms>
+  static T Sum(const T& term, const Terms&... terms) {
+    return term + Sum(terms...);
+  }
+};
+
 template<typename V>
 class DiagBlockVectorTraits {
  private:
@@ -122,7 +202,7 @@ constexpr Int BitwiseOr(Int&& i) { return std::forward<Int>(i); }
 template<typename Int, typename... Ints>
 constexpr typename std::common_type<Int, Ints...>::type
 BitwiseOr(Int&& i, Ints&&... is) {
-  return i & BitwiseOr(std::forward<Ints>(is)...);
+  return i | BitwiseOr(std::forward<Ints>(is)...);
 }
 
 template<typename Size, Size... sizes>
@@ -181,6 +261,90 @@ class DiagHelper
     static const BlockSize kBlockSizes[] = {block_sizes...};
     return kBlockSizes[dim];
   }
+
+  // Computes y = A x, where A is this matrix (see MultiplyAdd)
+  void Multiply(const DataType* x, DataType* y) const {
+    std::fill(y, y + this->sizes_[0], DataType());
+    static_cast<const ListType*>(this)->MultiplyAdd(x, y);
+  }
+
+ protected:
+  // Adds the products of the default values outside the blocks to y
+  // (unless the default value is zero, in which case nothing changes)
+  void MultiplyAddDefault(const DataType* default_value, size_t block_count,
+                          const DataType* x, DataType* y) const {
+    if (default_value == nullptr || *default_value == DataType())
+      return;
+    static constexpr size_t rows = block_size<0>(), cols = block_size<1>();
+    const size_t row_cnt = this->sizes_[0], col_cnt = this->sizes_[1];
+    DataType x_sum = DataType();
+    for (size_t c = 0; c < col_cnt; ++c)
+      x_sum += x[c];
+    for (size_t block = 0, r = 0; r < row_cnt; ++block) {
+      DataType block_x_sum = DataType();
+      if (block < block_count)
+        for (size_t c = block * cols; c < std::min((block + 1) * cols, col_cnt);
+             ++c)
+          block_x_sum += x[c];
+      for (const size_t r_end = std::min(r + rows, row_cnt); r < r_end; ++r)
+        y[r] += *default_value * (x_sum - block_x_sum);
+    }
+  }
+
+  // Visits the values of the block as visitor(indexes, value) in memory order,
+  // skipping those out of range (only possible in the last block).
+  template<class Visitor>
+  void ForEachInBlock(size_t block, Visitor&& visitor) const {
+    typename ListBaseType::SizeArray first, last, indexes;
+    for (unsigned dim = 0; dim < DiagHelper::kDims; ++dim) {
+      indexes[dim] = first[dim] = block * block_size(dim);
+      last[dim] = std::min(first[dim] + block_size(dim), this->sizes_[dim]);
+    }
+    DataType* value = static_cast<const ListType*>(this)->block_values(block);
+    for (size_t i = block_size_product(); i--; ++value) {
+      bool within = true;
+      for (unsigned dim = 0; dim < DiagHelper::kDims; ++dim)
+        within &= indexes[dim] < last[dim];
+      if (within)
+        visitor(indexes, *value);
+
+      // advance to the next position (the last dimension varies the fastest)
+      for (unsigned dim = DiagHelper::kDims; dim--; ) {
+        if (++indexes[dim] != first[dim] + block_size(dim))
+          break;
+        indexes[dim] = first[dim];
+      }
+    }
+  }
+
+  template<size_t... Is, typename... Sizes>
+  static size_t ComputeBlockCount(cpp14::index_sequence<Is...>,
+                                  Sizes&&... sizes) {
+    return list_detail::MinSize(((sizes + (block_sizes - 1)) /
+                                 std::get<Is>(dim_scalers()))...);
+  }
+
+  template<size_t... Is, typename... Sizes>
+  static bool IsLastBlockFull(const size_t& block_cnt,
+                              cpp14::index_sequence<Is...>,
+                              Sizes&&... sizes) {
+    using namespace detail;
+    return !BitwiseOr((static_cast<size_t>(block_cnt *
+                                           std::get<Is>(dim_scalers())) >
+                       static_cast<size_t>(sizes))...);
+  }
+
+  static constexpr size_t block_size_product() {
+    return list_detail::SizeProduct(static_cast<size_t>(block_sizes)...);
+  }
+
+  // use static singleton accessor to avoid a global definition
+  static const std::tuple<detail::DiagDimScaler<BlockSize, block_sizes>...>&
+  dim_scalers() {
+    static const std::tuple<
+      detail::DiagDimScaler<BlockSize, block_sizes>...> instance;
+    return instance;
+  }
 };
 
 template<typename DataType, typename BlockSize, BlockSize... block_sizes>
@@ -190,8 +354,8 @@ class DiagValueIter
       public View<DataType>::IteratorBase {
   V_DEFAULT_ITERATOR_DERIVED_HEAD(DiagValueIter);
 
-  typedef detail::DiagBlock<DataType, BlockSize, block_sizes...> DiagBlockType;
-  typedef typename std::vector<DiagBlockType>::iterator OuterIter;
+  typedef typename detail::DiagBlockVector<DataType, BlockSize,
+                                           block_sizes...>::iterator OuterIter;
 
   static constexpr unsigned dims() { return sizeof...(block_sizes); }
 
@@ -199,11 +363,14 @@ class DiagValueIter
   SizeArray;
 
  public:
+  // (block_index must be the index of the outer block if it is not the first)
   DiagValueIter(OuterIter outer, bool last_block_full, const size_t& block_cnt,
-                const SizeArray* sizes)
+                const SizeArray* sizes, size_t block_index = 0)
       : DiagValueIter(outer, last_block_full, block_cnt,
                       cpp14::make_index_sequence<dims()>(),
-                      *sizes) {}
+                      *sizes) {
+    global_ -= block_index * block_size_product();
+  }
 
  protected:
   V_DEF_VIEW_ITER_IS_EQUAL(DataType, DiagValueIter)
@@ -233,10 +400,11 @@ class DiagValueIter
     return WithinLastBlock(inner_, cpp14::make_index_sequence<dims()>());
   }
 
+  // WithinLast() expects the fastest varying dimension first, whereas the
+  // blocks are row-major, so pass the (block) sizes in the reverse order
   template<size_t... Is>
   constexpr bool WithinLastBlock(size_t pos, cpp14::index_sequence<Is...>) const
   {
-    // TODO: messy, because the block has the reverse memory order
     return list_detail::WithinLast<BlockSize,
                                    list_detail::GetNth<
                                      static_cast<BlockSize>(dims() - Is - 1),
@@ -262,12 +430,7 @@ class DiagValueIter
         outer_(outer),
         inner_(0),
         last_block_sizes_({static_cast<BlockSize>(
-            std::get<Is>(sizes) - block_sizes * full_block_cnt_)...}) {
-    // TODO: uncomment when memory order of DiagBlock is reversed
-    // if (!last_block_full)
-    //   global_ += list_detail::SizeProduct(static_cast<size_t>(
-    //       std::min(std::get<Is>(last_block_sizes_), block_sizes))...);
-  }
+            std::get<Is>(sizes) - block_sizes * full_block_cnt_)...}) {}
 
   static constexpr size_t block_size_product() {
     return list_detail::SizeProduct(static_cast<size_t>(block_sizes)...);
@@ -309,6 +472,141 @@ class SimpleDiagValueIter
   OuterIter outer_;  // block iterator
 };
 
+// Iterates over the values of a DynDiag, which are stored contiguously
+// one block after another, skipping those out of range in the last block
+template<typename DataType, unsigned dims>
+class DynDiagValueIter
+    : public DefaultIterator<DynDiagValueIter<DataType, dims>,
+                             std::forward_iterator_tag, DataType>,
+      public View<DataType>::IteratorBase {
+  V_DEFAULT_ITERATOR_DERIVED_HEAD(DynDiagValueIter);
+
+  typedef typename ListBase<DataType, dims>::SizeArray SizeArray;
+
+ public:
+  // (last_block must point past the values if the last block is full)
+  DynDiagValueIter(DataType* value, DataType* last_block, DataType* end,
+                   const SizeArray* block_sizes,
+                   const SizeArray* last_block_sizes)
+      : value_(value),
+        last_block_(last_block),
+        end_(end),
+        block_sizes_(block_sizes),
+        last_block_sizes_(last_block_sizes) {}
+
+ protected:
+  V_DEF_VIEW_ITER_IS_EQUAL(DataType, DynDiagValueIter)
+
+  bool IsEqual(const DynDiagValueIter& other) const {
+    return value_ == other.value_;
+  }
+
+  void Increment() override {
+    // the first value of the last block is always within range
+    if (++value_ > last_block_)
+      while (value_ != end_ && !WithinLastBlock())
+        ++value_;
+  }
+
+  DataType& ref() const override { return *value_; }
+
+ private:
+  bool WithinLastBlock() const {
+    size_t pos = value_ - last_block_;
+    for (unsigned dim = dims; dim--; pos /= (*block_sizes_)[dim])
+      if (pos % (*block_sizes_)[dim] >= (*last_block_sizes_)[dim])
+        return false;
+    return true;
+  }
+
+  DataType* value_;
+  DataType* last_block_;
+  DataType* end_;
+  const SizeArray* block_sizes_;
+  const SizeArray* last_block_sizes_;
+};
+
+// Iterates over the values of the allocated blocks of a LazyDiag (in order),
+// skipping those out of range in the last block
+template<typename DataType, typename BlockSize, BlockSize... block_sizes>
+class LazyDiagValueIter
+    : public DefaultIterator<LazyDiagValueIter<DataType, BlockSize,
+                                               block_sizes...>,
+                             std::forward_iterator_tag, DataType>,
+      public View<DataType>::IteratorBase {
+  V_DEFAULT_ITERATOR_DERIVED_HEAD(LazyDiagValueIter);
+
+  typedef typename std::vector<std::unique_ptr<
+    DiagBlock<DataType, BlockSize, block_sizes...> > >::const_iterator
+  OuterIter;
+
+  static constexpr unsigned dims() { return sizeof...(block_sizes); }
+
+ public:
+  // (partial must be the last block if it is not full, or end otherwise)
+  LazyDiagValueIter(OuterIter outer, OuterIter end, OuterIter partial,
+                    const std::array<BlockSize, dims()>* last_block_sizes)
+      : outer_(outer),
+        end_(end),
+        partial_(partial),
+        inner_(0),
+        last_block_sizes_(last_block_sizes) {
+    SkipUnallocated();
+  }
+
+ protected:
+  V_DEF_VIEW_ITER_IS_EQUAL(DataType, LazyDiagValueIter)
+
+  bool IsEqual(const LazyDiagValueIter& other) const {
+    return outer_ == other.outer_ && inner_ == other.inner_;
+  }
+
+  void Increment() override {
+    static constexpr auto block_size = block_size_product();
+    do {
+      if (++inner_ == block_size) {
+        inner_ = 0;
+        ++outer_;
+        SkipUnallocated();
+      }
+    } while (outer_ == partial_ && outer_ != end_ && !WithinLastBlock());
+  }
+
+  DataType& ref() const override {
+    return reinterpret_cast<DataType*>(outer_->get())[inner_];
+  }
+
+ private:
+  void SkipUnallocated() {
+    while (outer_ != end_ && *outer_ == nullptr)
+      ++outer_;
+  }
+
+  bool WithinLastBlock() const {
+    return WithinLastBlock(inner_, cpp14::make_index_sequence<dims()>());
+  }
+
+  // see DiagValueIter
+  template<size_t... Is>
+  bool WithinLastBlock(size_t pos, cpp14::index_sequence<Is...>) const {
+    return list_detail::WithinLast<BlockSize,
+                                   list_detail::GetNth<
+                                     static_cast<BlockSize>(dims() - Is - 1),
+                                     BlockSize, block_sizes...>::value...>
+        (pos, std::get<dims() - Is - 1>(*last_block_sizes_)...);
+  }
+
+  static constexpr size_t block_size_product() {
+    return list_detail::SizeProduct(static_cast<size_t>(block_sizes)...);
+  }
+
+  OuterIter outer_;  // block iterator
+  OuterIter end_;
+  OuterIter partial_;
+  size_t inner_;    // linearized index within the block
+  const std::array<BlockSize, dims()>* last_block_sizes_;
+};
+
 }  // namespace detail
 
 // For the MakeList overload, we need to somehow encode the block sizes.
@@ -342,20 +640,27 @@ class V_LIST_TYPE
 #undef V_THIS_BASE_TYPE
 #undef V_LIST_TYPE
 
+  using DiagHelper::ForEachInBlock;
+  using DiagHelper::ComputeBlockCount;
+  using DiagHelper::IsLastBlockFull;
+  using DiagHelper::block_size_product;
+  using DiagHelper::dim_scalers;
+
   typedef detail::DiagValueIter<DataType, BlockSize, block_sizes...> ValueIter;
 
   class ValuesView : public View<DataType> {
    public:
     typedef ValueIter Iterator;
+    typedef std::pair<Iterator, Iterator> Range;
 
     ValuesView(List* list, const size_t& size)
         : View<DataType>(size),
           list_(list) {}
     typename View<DataType>::Iterator iterator_begin() const {
-      return new Iterator(begin());
+      return Iterator(begin());
     }
     typename View<DataType>::Iterator iterator_end() const {
-      return new Iterator(end());
+      return Iterator(end());
     }
     Iterator begin() const {
       return Iterator(list_->blocks_.begin(), list_->last_block_full_,
@@ -365,9 +670,32 @@ class V_LIST_TYPE
       return Iterator(list_->blocks_.end(), list_->last_block_full_,
                       list_->blocks_.size(), &list_->sizes());
     }
+
+    // Splits the values into (at most) part_count ranges of consecutive blocks
+    // whose counts differ by at most one (so do the counts of the values,
+    // except for those in the last block if it is not full)
+    std::vector<Range> partition(size_t part_count) const {
+      std::vector<Range> parts;
+      parts.reserve(part_count);
+      const size_t block_count = list_->blocks_.size();
+      for (size_t part = 0, from = 0; part++ < part_count; ) {
+        const size_t to = block_count * part / part_count;
+        if (from != to)
+          parts.emplace_back(At(from), At(to));
+        from = to;
+      }
+      return parts;
+    }
+
    private:
     void MoveTo(List* list) { list_ = list; }
 
+    Iterator At(size_t block_index) const {
+      return Iterator(list_->blocks_.begin() + block_index,
+                      list_->last_block_full_, list_->blocks_.size(),
+                      &list_->sizes(), block_index);
+    }
+
     List* list_;
     friend class List;
   };
@@ -414,24 +742,122 @@ class V_LIST_TYPE
   friend List MakeList(List&& list) { return std::forward<List>(list); }
 
   typename View<DataType>::Iterator iterator_begin() const override {
-    // TODO: implement
-    return *reinterpret_cast<typename View<DataType>::Iterator*>(NULL);
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  void AppendLineRuns(const typename List::SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(List::kDims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const typename List::SizeArray& indexes,
+                     size_t start, RunVector<DataType>* runs) const override {
+    const size_t line_size = this->sizes_[dim];
+
+    // the line intersects a block only if all but the index in dim are within
+    const unsigned lateral_dim = !dim;
+    const size_t block = indexes[lateral_dim] /
+        DiagHelper::block_size(lateral_dim);
+    bool within = block < blocks_.size();
+    for (unsigned d = 0; d < List::kDims; ++d)
+      within &= d == dim || indexes[d] / DiagHelper::block_size(d) == block;
+    const size_t from = within ? block * DiagHelper::block_size(dim)
+                        : line_size;
+    const size_t to = within ? std::min(from + DiagHelper::block_size(dim),
+                                        line_size)
+                      : line_size;
+
+    // the values along the last dimension are contiguous within the block
+    // (but not along the others, so append those one by one)
+    AppendRun(start, from, default_value_, true, runs);
+    typename List::SizeArray cur(indexes);
+    const size_t step = dim == List::kDims - 1 ? to - from : 1;
+    for (cur[dim] = from; cur[dim] < to; cur[dim] += step) {
+      typename List::SizeArray first(cur);
+      AppendRun(start + cur[dim], step, &this->get(std::move(first)), false,
+                runs);
+    }
+    AppendRun(start + to, line_size - to, default_value_, true, runs);
+  }
+
+  void ForEachSpan(const typename DiagHelper::SpanVisitor& visitor)
+      const override {
+    // the full blocks form a single span, followed by the values of the last
+    const size_t full_block_cnt = blocks_.size() - !last_block_full_;
+    if (full_block_cnt)
+      visitor(reinterpret_cast<DataType*>(blocks_.data()),
+              full_block_cnt * block_size_product());
+    if (!last_block_full_)
+      ForEachInBlock(full_block_cnt, [&](const typename List::SizeArray&,
+                                         DataType& value) {
+          visitor(&value, 1);
+        });
+  }
+
+  void ForEachEntry(const typename DiagHelper::EntryVisitor& visitor)
+      const override {
+    for (size_t block = 0; block < blocks_.size(); ++block)
+      ForEachInBlock(block, visitor);
+  }
+
+  // covers only the blocks (the rest are default values)
+  void AppendCoverage(const typename List::SizeArray& offset,
+                      const DataType* default_value,
+                      std::vector<typename List::Box>* boxes) const override {
+    if (default_value != default_value_)
+      return DiagHelper::AppendCoverage(offset, default_value, boxes);
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+      typename List::Box box(offset, offset);
+      for (unsigned dim = 0; dim < List::kDims; ++dim) {
+        box.first[dim] += block * DiagHelper::block_size(dim);
+        box.second[dim] += std::min((block + 1) * DiagHelper::block_size(dim),
+                                    this->sizes_[dim]);
+      }
+      boxes->push_back(box);
+    }
   }
 
   const ValuesView& values() const override { return values_; }
+  DataType* default_value() const override { return default_value_; }
 
   size_t block_count() const { return blocks_.size(); }
 
- private:
-  typedef detail::DiagBlock<DataType, BlockSize, block_sizes...> DiagBlockType;
+  // Computes y += A x, where A is this matrix (x and y must hold as many
+  // values as A has columns and rows, respectively)
+  void MultiplyAdd(const DataType* x, DataType* y) const {
+    static_assert(List::kDims == 2, "Not a matrix");
+    static constexpr size_t rows = DiagHelper::template block_size<0>();
+    static constexpr size_t cols = DiagHelper::template block_size<1>();
+
+    // stream the full blocks through the fixed-size kernel
+    const size_t full_block_cnt = blocks_.size() - !last_block_full_;
+    const DataType* block = reinterpret_cast<const DataType*>(blocks_.data());
+    for (size_t i = 0; i < full_block_cnt; ++i, block += rows * cols)
+      detail::DiagBlockKernel<DataType, rows, cols>::MultiplyAdd(
+          block, x + i * cols, y + i * rows);
+
+    // the last block can be cut off in either dimension
+    if (!last_block_full_) {
+      const DataType* last_x = x + full_block_cnt * cols;
+      DataType* last_y = y + full_block_cnt * rows;
+      const size_t row_cnt = std::min(
+          rows, this->sizes_[0] - full_block_cnt * rows);
+      const size_t col_cnt = std::min(
+          cols, this->sizes_[1] - full_block_cnt * cols);
+      for (size_t r = 0; r < row_cnt; ++r, block += cols)
+        for (size_t c = 0; c < col_cnt; ++c)
+          last_y[r] += block[c] * last_x[c];
+    }
 
-  template<size_t... Is, typename... Sizes>
-  static size_t ComputeBlockCount(cpp14::index_sequence<Is...>,
-                                  Sizes&&... sizes) {
-    return list_detail::MinSize(((sizes + (block_sizes - 1)) /
-                                 std::get<Is>(dim_scalers()))...);
+    this->MultiplyAddDefault(default_value_, blocks_.size(), x, y);
   }
 
+ private:
   template<typename... Sizes>
   static constexpr size_t ComputeNonDefaultValueCount(const size_t& block_count,
                                                       bool last_block_full,
@@ -443,24 +869,8 @@ class V_LIST_TYPE
             block_sizes)...);
   }
 
-  template<size_t... Is, typename... Sizes>
-  static bool IsLastBlockFull(const size_t& block_cnt,
-                              cpp14::index_sequence<Is...>,
-                              Sizes&&... sizes) {
-    using namespace detail;
-    return BitwiseOr((block_cnt * std::get<Is>(dim_scalers()) > sizes)...);
-  }
-
-  static constexpr size_t block_size_product() {
-    return list_detail::SizeProduct(static_cast<size_t>(block_sizes)...);
-  }
-
-  // use static singleton accessor to avoid a global definition
-  static const std::tuple<detail::DiagDimScaler<BlockSize, block_sizes>...>&
-  dim_scalers() {
-    static const std::tuple<
-      detail::DiagDimScaler<BlockSize, block_sizes>...> instance;
-    return instance;
+  DataType* block_values(size_t block) const {
+    return reinterpret_cast<DataType*>(&blocks_[block]);
   }
 
   template<size_t I, size_t... Is, typename Index, typename... Indexes>
@@ -476,7 +886,7 @@ class V_LIST_TYPE
         (indexes - block_index * std::get<Is>(dim_scalers()))...);
   }
 
-  mutable std::vector<DiagBlockType> blocks_;
+  mutable detail::DiagBlockVector<DataType, BlockSize, block_sizes...> blocks_;
   DataType* default_value_;
   bool last_block_full_;
   ValuesView values_;
@@ -498,8 +908,10 @@ template<typename DataType, unsigned dims, typename BlockSize,
 class V_LIST_TYPE
 #define V_THIS_BASE_TYPE                                                \
   detail::DiagHelper<V_LIST_TYPE, DataType, BlockSize, block_sizes...>
-    : public V_THIS_BASE_TYPE {
+    : public V_THIS_BASE_TYPE,
+      public DimIterAccessors<V_LIST_TYPE> {
   friend class V_THIS_BASE_TYPE;
+  friend class DimIterAccessors<V_LIST_TYPE>;
   typedef V_THIS_BASE_TYPE DiagHelper;
 #undef V_THIS_BASE_TYPE
 #undef V_LIST_TYPE
@@ -507,6 +919,7 @@ class V_LIST_TYPE
   class ValuesView : public View<DataType> {
    public:
     typedef detail::SimpleDiagValueIter<DataType> Iterator;
+    typedef std::pair<Iterator, Iterator> Range;
 
     ValuesView(typename std::vector<DataType>::iterator begin,
                typename std::vector<DataType>::iterator end)
@@ -514,17 +927,31 @@ class V_LIST_TYPE
           begin_(begin),
           end_(end) {}
     typename View<DataType>::Iterator iterator_begin() const {
-      return new Iterator(begin());
+      return Iterator(begin());
     }
     typename View<DataType>::Iterator iterator_end() const {
-      return new Iterator(end());
+      return Iterator(end());
     }
     Iterator begin() const { return begin_; }
     Iterator end() const { return end_; }
 
+    // Splits the values into (at most) part_count ranges whose sizes differ by
+    // at most one
+    std::vector<Range> partition(size_t part_count) const {
+      std::vector<Range> parts;
+      parts.reserve(part_count);
+      for (size_t part = 0, from = 0; part++ < part_count; ) {
+        const size_t to = this->size_ * part / part_count;
+        if (from != to)
+          parts.emplace_back(begin_ + from, begin_ + to);
+        from = to;
+      }
+      return parts;
+    }
+
    private:
-    Iterator begin_;
-    Iterator end_;
+    typename std::vector<DataType>::iterator begin_;
+    typename std::vector<DataType>::iterator end_;
   };
 
   template<typename V, unsigned dim>
@@ -575,11 +1002,12 @@ class V_LIST_TYPE
     ValuePtr default_value_;
   };
 
+  // Iterates over the (at most one) entry of a line, which is at position 0
+  // (a forward iterator, since the entry is stashed in it)
   template<typename V, unsigned dim>
   class EntryDimIter
-      : public List::template EntryDimIteratorBase<EntryDimIter<V, dim>,
-                                                   V,
-                                                   std::forward_iterator_tag> {
+      : public List::template EntryDimIteratorBase<
+    EntryDimIter<V, dim>, V, std::forward_iterator_tag> {
     V_DEFAULT_ITERATOR_DERIVED_HEAD(EntryDimIter);
     template<typename, unsigned> friend class EntryDimIter;
     template<typename FromType, typename ToType, class Type>
@@ -588,8 +1016,9 @@ class V_LIST_TYPE
     typedef typename detail::DiagBlockVectorTraits<V>::ValuePtr ValuePtr;
 
    public:
-    explicit EntryDimIter(ValuePtr block, const size_t& nonlateral_index = -1)
-        : EntryDimIter(block, nonlateral_index,
+    explicit EntryDimIter(ValuePtr block, const size_t& nonlateral_index = -1,
+                          std::ptrdiff_t pos = 0)
+        : EntryDimIter(block, nonlateral_index, pos,
                        cpp14::make_index_sequence<dims>()) {
     }
     // TODO: consider adding a conversion from Entry<V> to Entry<const V>,
@@ -598,26 +1027,35 @@ class V_LIST_TYPE
     EntryDimIter(const EntryDimIter<V2, dim>& copy,
             EnableIfConvertible<V2*, V*, typename EntryDimIter::Enabler>
             enabler = typename EntryDimIter::Enabler())
-        : e_(&copy.e_.value(), typename List::SizeArray(copy.e_.indexes())) {}
+        : e_(&copy.e_.value(), typename List::SizeArray(copy.e_.indexes())),
+          pos_(copy.pos_) {}
     // provide a move constructor to avoid copying/creating a new array in Entry
     template<typename V2>
     EntryDimIter(EntryDimIter<V2, dim>&& tmp,
             EnableIfConvertible<V2*, V*, typename EntryDimIter::Enabler>
             enabler = typename EntryDimIter::Enabler())
-        : e_(&tmp.e_.value(), std::move(this->GetEntryIndexes(tmp.e_))) {}
+        : e_(&tmp.e_.value(), std::move(this->GetEntryIndexes(tmp.e_))),
+          pos_(tmp.pos_) {}
     EntryDimIter() = default;
 
     static constexpr unsigned kDim = dim;
 
-   protected:
-    void Increment() override {
-      this->template SetEntryIndex<dim>(-1, e_);
+    // Moves by n entries (or finds the distance) in constant time
+    void Advance(std::ptrdiff_t n) { pos_ += n; }
+
+    template<typename V2>
+    EnableIfConvertible<V2, V, std::ptrdiff_t>
+    DistanceTo(const EntryDimIter<V2, dim>& other) const {
+      return other.pos_ - pos_;
     }
 
+   protected:
+    void Increment() override { ++pos_; }
+
     template<typename V2>
     EnableIfConvertible<V2, V, bool>
     IsEqual(const EntryDimIter<V2, dim>& other) const {
-      return std::get<dim>(e_.indexes()) == std::get<dim>(other.e_.indexes());
+      return pos_ == other.pos_;
     }
 
     typename EntryDimIter::reference ref() const override { return e_; }
@@ -625,11 +1063,13 @@ class V_LIST_TYPE
    private:
     template<size_t... Is>
     EntryDimIter(ValuePtr block, const size_t& nonlateral_index,
-                 cpp14::index_sequence<Is...>)
+                 std::ptrdiff_t pos, cpp14::index_sequence<Is...>)
         : e_(block, typename List::SizeArray{
-            list_detail::ConstSize<Is>(nonlateral_index)...}) {}
+            list_detail::ConstSize<Is>(nonlateral_index)...}),
+          pos_(pos) {}
 
     mutable typename EntryDimIter::value_type e_;
+    std::ptrdiff_t pos_;
   };
 
  public:
@@ -667,6 +1107,35 @@ class V_LIST_TYPE
         default_value_(default_value),
         values_(blocks_.begin(), blocks_.end()) {}
 
+  // the values view has to point to the copied/moved blocks
+  List(const List& src)
+      : DiagHelper(src),
+        blocks_(src.blocks_),
+        default_value_(src.default_value_),
+        values_(blocks_.begin(), blocks_.end()) {}
+
+  List(List&& src)
+      : DiagHelper(std::move(src)),
+        blocks_(std::move(src.blocks_)),
+        default_value_(src.default_value_),
+        values_(blocks_.begin(), blocks_.end()) {}
+
+  List& operator=(const List& rhs) {
+    DiagHelper::operator=(rhs);
+    blocks_ = rhs.blocks_;
+    default_value_ = rhs.default_value_;
+    values_ = ValuesView(blocks_.begin(), blocks_.end());
+    return *this;
+  }
+
+  List& operator=(List&& rhs) {
+    DiagHelper::operator=(std::move(rhs));
+    blocks_ = std::move(rhs.blocks_);
+    default_value_ = rhs.default_value_;
+    values_ = ValuesView(blocks_.begin(), blocks_.end());
+    return *this;
+  }
+
   // used by MakeList
   template<typename... Args>
   List(DiagTag<BlockSize, block_sizes...>, Args&&... args)
@@ -675,47 +1144,80 @@ class V_LIST_TYPE
   friend List MakeList(List&& list) { return std::forward<List>(list); }
 
   typename View<DataType>::Iterator iterator_begin() const override {
-    // TODO: implement
-    return *reinterpret_cast<typename View<DataType>::Iterator*>(NULL);
-  }
-
-  // Define dimension iterator accessors with the signature:
-  //   template<unsigned dim, typename Index, typename... Indexes>
-  //   [Const]DimIterator<dim> dim_[c]<infix>(begin|end)\<dim\>(
-  //       Index&& lateral_index, Indexes&&... lateral_indexes) const;
-  // Each forwards the call to dim_[c]<infix>(begin|end)0\<dim\>
-#define V_THIS_DEF_DIM_ITER_ACCESSOR0(Tpl, method, method0)             \
-  template<unsigned dim, typename Index, typename... Indexes>           \
-  Tpl<dim> method(Index&& lateral_index, Indexes&&... lateral_indexes) const { \
-    return method0<Tpl<dim> >(                                          \
-        std::forward<Index>(lateral_index),                             \
-        std::forward<Indexes>(lateral_indexes)...);                     \
-  }
-#define V_THIS_DEF_DIM_ITER_ACCESSOR1(Tpl, prefix, c, which)            \
-  V_THIS_DEF_DIM_ITER_ACCESSOR0(Tpl, prefix ## c ## which, prefix ## which ## 0)
-#define V_THIS_DEF_DIM_ITER_ACCESSOR(Tpl, infix, c, which)       \
-      V_THIS_DEF_DIM_ITER_ACCESSOR1(Tpl, infix ## dim_, c, which)
-#define V_THIS_DEF_DIM_ITER_ACCESSORS0(Tpl, infix, c)            \
-  V_THIS_DEF_DIM_ITER_ACCESSOR(infix, Tpl, c, begin)             \
-  V_THIS_DEF_DIM_ITER_ACCESSOR(infix, Tpl, c, end)
-#define V_THIS_DEF_DIM_ITER_ACCESSORS(Tpl, infix, c)     \
-  V_THIS_DEF_DIM_ITER_ACCESSORS0(infix, Tpl, c)
-
-  V_THIS_DEF_DIM_ITER_ACCESSORS(DimIterator, ,)
-  V_THIS_DEF_DIM_ITER_ACCESSORS(ConstDimIterator, , c)
-  V_THIS_DEF_DIM_ITER_ACCESSORS(EntryDimIterator, entry_,)
-  V_THIS_DEF_DIM_ITER_ACCESSORS(ConstEntryDimIterator, entry_, c)
-
-#undef V_THIS_DEF_DIM_ITER_ACCESSORS
-#undef V_THIS_DEF_DIM_ITER_ACCESSORS0
-#undef V_THIS_DEF_DIM_ITER_ACCESSOR
-#undef V_THIS_DEF_DIM_ITER_ACCESSOR1
-#undef V_THIS_DEF_DIM_ITER_ACCESSOR0
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  void AppendLineRuns(const typename List::SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(List::kDims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const typename List::SizeArray& indexes,
+                     size_t start, RunVector<DataType>* runs) const override {
+    const size_t line_size = this->sizes_[dim];
+    const size_t i = indexes[!dim];
+    bool within = i < blocks_.size();
+    for (unsigned d = 0; d < List::kDims; ++d)
+      within &= d == dim || indexes[d] == i;
+    if (!within) {
+      AppendRun(start, line_size, default_value_, true, runs);
+      return;
+    }
+    AppendRun(start, i, default_value_, true, runs);
+    AppendRun(start + i, 1, &blocks_[i], false, runs);
+    AppendRun(start + i + 1, line_size - i - 1, default_value_, true, runs);
+  }
+
+  void ForEachSpan(const typename DiagHelper::SpanVisitor& visitor)
+      const override {
+    if (!blocks_.empty())
+      visitor(blocks_.data(), blocks_.size());
+  }
+
+  void ForEachEntry(const typename DiagHelper::EntryVisitor& visitor)
+      const override {
+    typename List::SizeArray indexes;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      indexes.fill(i);
+      visitor(indexes, blocks_[i]);
+    }
+  }
+
+  // covers only the diagonal (the rest are default values)
+  void AppendCoverage(const typename List::SizeArray& offset,
+                      const DataType* default_value,
+                      std::vector<typename List::Box>* boxes) const override {
+    if (default_value != default_value_)
+      return DiagHelper::AppendCoverage(offset, default_value, boxes);
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      typename List::Box box(offset, offset);
+      for (unsigned dim = 0; dim < List::kDims; ++dim) {
+        box.first[dim] += i;
+        box.second[dim] += i + 1;
+      }
+      boxes->push_back(box);
+    }
+  }
 
   const ValuesView& values() const override { return values_; }
+  DataType* default_value() const override { return default_value_; }
 
   size_t block_count() const { return blocks_.size(); }
 
+  // Computes y += A x, where A is this matrix (x and y must hold as many
+  // values as A has columns and rows, respectively)
+  void MultiplyAdd(const DataType* x, DataType* y) const {
+    static_assert(List::kDims == 2, "Not a matrix");
+    for (size_t i = 0, i_end = blocks_.size(); i < i_end; ++i)
+      y[i] += blocks_[i] * x[i];
+    this->MultiplyAddDefault(default_value_, blocks_.size(), x, y);
+  }
+
  private:
   template<size_t I, size_t... Is, typename Index, typename... Indexes>
   DataType& get0(cpp14::index_sequence<I, Is...>, Index&& index,
@@ -749,8 +1251,7 @@ class V_LIST_TYPE
   template<class DimIterType, typename Index, typename... Indexes>
   DimIterType entry_dim_begin0(Index&& lateral_index,
                                Indexes&&... lateral_indexes) const {
-    return list_detail::SameSize(lateral_index,
-                                 std::forward<Indexes>(lateral_indexes)...)
+    return HasEntry(lateral_index, std::forward<Indexes>(lateral_indexes)...)
         ? DimIterType(blocks_.data() + lateral_index, lateral_index)
         : DimIterType(nullptr);
   }
@@ -758,12 +1259,20 @@ class V_LIST_TYPE
   template<class DimIterType, typename Index, typename... Indexes>
   DimIterType entry_dim_end0(Index&& lateral_index,
                              Indexes&&... lateral_indexes) const {
-    return list_detail::SameSize(lateral_index,
-                                 std::forward<Indexes>(lateral_indexes)...)
-        ? DimIterType(blocks_.data() + lateral_index)
+    return HasEntry(lateral_index, std::forward<Indexes>(lateral_indexes)...)
+        ? DimIterType(blocks_.data() + lateral_index, lateral_index, 1)
         : DimIterType(nullptr);
   }
 
+  // Returns true iff the line through the lateral indexes crosses the diagonal
+  template<typename Index, typename... Indexes>
+  bool HasEntry(const Index& lateral_index, Indexes&&... lateral_indexes)
+      const {
+    return list_detail::SameSize(lateral_index,
+                                 std::forward<Indexes>(lateral_indexes)...) &&
+        static_cast<size_t>(lateral_index) < blocks_.size();
+  }
+
   mutable std::vector<DataType> blocks_;
   DataType* default_value_;
   ValuesView values_;
@@ -777,6 +1286,692 @@ auto MakeList(DiagTag<BlockSize, block_sizes...>,
     -> V_LIST_TYPE { return V_LIST_TYPE(default_value, sizes...); }
 #undef V_LIST_TYPE
 
+// For the MakeList overload, we need to somehow encode the block sizes.
+template<typename BlockSize, BlockSize... block_sizes>
+struct LazyDiagTag {};
+
+// Same as Diag, but each block is allocated upon the first mutable access to
+// one of its values, so the memory is proportional to the touched blocks
+// (the values of the others read as default and are skipped by values()).
+template<typename DataType, typename BlockSize, BlockSize... block_sizes>
+using LazyDiag = List<cpp14::integer_sequence<BlockSize, block_sizes...>,
+                      sizeof...(block_sizes),
+                      kListOpMutable,
+                      DataType,
+                      void>;
+
+template<typename DataType, unsigned dims, typename BlockSize,
+         BlockSize... block_sizes>
+#define V_LIST_TYPE                                                     \
+  List<cpp14::integer_sequence<BlockSize, block_sizes...>,              \
+       dims,                                                            \
+       kListOpMutable,                                                  \
+       DataType,                                                        \
+       void,                                                            \
+       typename std::enable_if<dims == sizeof...(block_sizes)>::type>
+class V_LIST_TYPE
+#define V_THIS_BASE_TYPE \
+  detail::DiagHelper<V_LIST_TYPE, DataType, BlockSize, block_sizes...>
+    : public V_THIS_BASE_TYPE {
+  friend class V_THIS_BASE_TYPE;
+  typedef V_THIS_BASE_TYPE DiagHelper;
+#undef V_THIS_BASE_TYPE
+#undef V_LIST_TYPE
+
+  using DiagHelper::ForEachInBlock;
+  using DiagHelper::ComputeBlockCount;
+  using DiagHelper::IsLastBlockFull;
+  using DiagHelper::block_size_product;
+  using DiagHelper::dim_scalers;
+
+  typedef detail::DiagBlock<DataType, BlockSize, block_sizes...> Block;
+  typedef detail::LazyDiagValueIter<DataType, BlockSize, block_sizes...>
+  ValueIter;
+
+  class ValuesView : public View<DataType> {
+   public:
+    typedef ValueIter Iterator;
+
+    ValuesView(List* list) : View<DataType>(0), list_(list) {}
+    typename View<DataType>::Iterator iterator_begin() const {
+      return Iterator(begin());
+    }
+    typename View<DataType>::Iterator iterator_end() const {
+      return Iterator(end());
+    }
+    Iterator begin() const { return At(list_->blocks_.begin()); }
+    Iterator end() const { return At(list_->blocks_.end()); }
+
+   private:
+    void MoveTo(List* list) { list_ = list; }
+    void Grow(size_t value_count) { this->size_ += value_count; }
+
+    Iterator At(typename decltype(List::blocks_)::const_iterator outer) const {
+      const auto& blocks = list_->blocks_;
+      return Iterator(outer, blocks.end(),
+                      blocks.end() - !list_->last_block_full_,
+                      &list_->last_block_sizes_);
+    }
+
+    List* list_;
+    friend class List;
+  };
+
+ public:
+  typedef BlockSize BlockSizeType;
+
+  template<typename... Sizes>
+  List(DataType* default_value, const size_t& size, Sizes&&... sizes)
+      : DiagHelper(size, sizes...),
+        blocks_(ComputeBlockCount(cpp14::index_sequence_for<size_t, Sizes...>(),
+                                  size, sizes...)),
+        default_value_(default_value),
+        last_block_full_(IsLastBlockFull(
+            blocks_.size(),
+            cpp14::index_sequence_for<size_t, Sizes...>(), size, sizes...)),
+        values_(this) {
+    const size_t full_block_cnt = blocks_.size() - !last_block_full_;
+    for (unsigned dim = 0; dim < dims; ++dim)
+      last_block_sizes_[dim] = std::min<size_t>(
+          DiagHelper::block_size(dim),
+          this->sizes_[dim] - full_block_cnt * DiagHelper::block_size(dim));
+  }
+
+  List(List&& src)
+      : DiagHelper(std::move(src)),
+        blocks_(std::move(src.blocks_)),
+        default_value_(src.default_value_),
+        last_block_full_(src.last_block_full_),
+        last_block_sizes_(src.last_block_sizes_),
+        values_(std::move(src.values_)) {
+    values_.MoveTo(this);
+  }
+
+  // used by MakeList
+  template<typename... Args>
+  List(LazyDiagTag<BlockSize, block_sizes...>, Args&&... args)
+      : List(std::forward<Args>(args)...) {}
+
+  friend List MakeList(List&& list) { return std::forward<List>(list); }
+
+  // Returns the value without allocating its block (unlike operator())
+  template<typename... Indexes>
+  const DataType& get(Indexes&&... indexes) const {
+    return *Find(false, cpp14::index_sequence_for<Indexes...>(),
+                 std::forward<Indexes>(indexes)...);
+  }
+
+  using DiagHelper::get;
+
+  typename View<DataType>::Iterator iterator_begin() const override {
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  void AppendLineRuns(const typename List::SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(List::kDims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const typename List::SizeArray& indexes,
+                     size_t start, RunVector<DataType>* runs) const override {
+    const size_t line_size = this->sizes_[dim];
+
+    // the line intersects an allocated block only if all but the index in dim
+    // are within it
+    const unsigned lateral_dim = !dim;
+    const size_t block = indexes[lateral_dim] /
+        DiagHelper::block_size(lateral_dim);
+    bool within = block < blocks_.size() && blocks_[block] != nullptr;
+    for (unsigned d = 0; d < List::kDims; ++d)
+      within &= d == dim || indexes[d] / DiagHelper::block_size(d) == block;
+    const size_t from = within ? block * DiagHelper::block_size(dim)
+                        : line_size;
+    const size_t to = within ? std::min(from + DiagHelper::block_size(dim),
+                                        line_size)
+                      : line_size;
+
+    // the values along the last dimension are contiguous within the block
+    // (but not along the others, so append those one by one)
+    AppendRun(start, from, default_value_, true, runs);
+    typename List::SizeArray cur(indexes);
+    const size_t step = dim == List::kDims - 1 ? to - from : 1;
+    for (cur[dim] = from; cur[dim] < to; cur[dim] += step)
+      AppendRun(start + cur[dim], step, Peek(cur),
+                false, runs);
+    AppendRun(start + to, line_size - to, default_value_, true, runs);
+  }
+
+  void ForEachSpan(const typename DiagHelper::SpanVisitor& visitor)
+      const override {
+    const size_t full_block_cnt = blocks_.size() - !last_block_full_;
+    for (size_t block = 0; block < full_block_cnt; ++block)
+      if (blocks_[block] != nullptr)
+        visitor(block_values(block), block_size_product());
+    if (!last_block_full_ && blocks_.back() != nullptr)
+      ForEachInBlock(full_block_cnt, [&](const typename List::SizeArray&,
+                                         DataType& value) {
+          visitor(&value, 1);
+        });
+  }
+
+  void ForEachEntry(const typename DiagHelper::EntryVisitor& visitor)
+      const override {
+    for (size_t block = 0; block < blocks_.size(); ++block)
+      if (blocks_[block] != nullptr)
+        ForEachInBlock(block, visitor);
+  }
+
+  // covers all blocks, including those not allocated yet, since a write
+  // through the covering list (e.g., a Chain) may allocate any of them
+  void AppendCoverage(const typename List::SizeArray& offset,
+                      const DataType* default_value,
+                      std::vector<typename List::Box>* boxes) const override {
+    if (default_value != default_value_)
+      return DiagHelper::AppendCoverage(offset, default_value, boxes);
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+      typename List::Box box(offset, offset);
+      for (unsigned dim = 0; dim < List::kDims; ++dim) {
+        box.first[dim] += block * DiagHelper::block_size(dim);
+        box.second[dim] += std::min((block + 1) * DiagHelper::block_size(dim),
+                                    this->sizes_[dim]);
+      }
+      boxes->push_back(box);
+    }
+  }
+
+  const ValuesView& values() const override { return values_; }
+  DataType* default_value() const override { return default_value_; }
+
+  size_t block_count() const { return blocks_.size(); }
+
+  size_t allocated_block_count() const {
+    return std::count_if(blocks_.begin(), blocks_.end(),
+                         [](const std::unique_ptr<Block>& block) {
+                           return block != nullptr;
+                         });
+  }
+
+  // Returns the equivalent Diag, which stores all blocks contiguously
+  // (those not allocated are filled with the default value, if any)
+  Diag<DataType, BlockSize, block_sizes...> Compact() const {
+    return Compact(cpp14::make_index_sequence<dims>());
+  }
+
+  // Computes y += A x, where A is this matrix (x and y must hold as many
+  // values as A has columns and rows, respectively)
+  void MultiplyAdd(const DataType* x, DataType* y) const {
+    static_assert(List::kDims == 2, "Not a matrix");
+    static constexpr size_t rows = DiagHelper::template block_size<0>();
+    static constexpr size_t cols = DiagHelper::template block_size<1>();
+    const bool default_zero = default_value_ == nullptr ||
+        *default_value_ == DataType();
+
+    // the last block can be cut off in either dimension
+    const size_t full_block_cnt = blocks_.size() - !last_block_full_;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      const DataType* block = block_values(i);
+      const DataType* block_x = x + i * cols;
+      DataType* block_y = y + i * rows;
+      if (block != nullptr && i < full_block_cnt) {
+        detail::DiagBlockKernel<DataType, rows, cols>::MultiplyAdd(
+            block, block_x, block_y);
+        continue;
+      }
+      const size_t row_cnt = std::min(rows, this->sizes_[0] - i * rows);
+      const size_t col_cnt = std::min(cols, this->sizes_[1] - i * cols);
+      if (block != nullptr) {
+        for (size_t r = 0; r < row_cnt; ++r, block += cols)
+          for (size_t c = 0; c < col_cnt; ++c)
+            block_y[r] += block[c] * block_x[c];
+      } else if (!default_zero) {  // all values of the block are default
+        DataType block_x_sum = DataType();
+        for (size_t c = 0; c < col_cnt; ++c)
+          block_x_sum += block_x[c];
+        for (size_t r = 0; r < row_cnt; ++r)
+          block_y[r] += *default_value_ * block_x_sum;
+      }
+    }
+
+    this->MultiplyAddDefault(default_value_, blocks_.size(), x, y);
+  }
+
+ private:
+  DataType* block_values(size_t block) const {
+    return reinterpret_cast<DataType*>(blocks_[block].get());
+  }
+
+  // Returns the block, allocating it (filled with default values) if needed
+  Block* Allocate(size_t block_index) const {
+    auto& block = blocks_[block_index];
+    if (block == nullptr) {
+      block.reset(new Block());
+      if (default_value_ != nullptr)
+        std::fill_n(block_values(block_index), block_size_product(),
+                    *default_value_);
+      values_.Grow(block_index + 1 == blocks_.size() && !last_block_full_
+                   ? LastBlockValueCount() : block_size_product());
+    }
+    return block.get();
+  }
+
+  size_t LastBlockValueCount() const {
+    size_t count = 1;
+    for (const auto& size : last_block_sizes_)
+      count *= size;
+    return count;
+  }
+
+  template<size_t I, size_t... Is, typename Index, typename... Indexes>
+  DataType* Find(bool allocate, cpp14::index_sequence<I, Is...>,
+                 Index&& index, Indexes&&... indexes) const {
+    size_t block_index;
+    if (!list_detail::SameSize(block_index = index / std::get<I>(dim_scalers()),
+                               (indexes / std::get<Is>(dim_scalers()))...))
+      return default_value_;
+
+    Block* block = allocate ? Allocate(block_index)
+        : blocks_[block_index].get();
+    if (block == nullptr)
+      return default_value_;
+    return &(*block)(index - block_index * std::get<I>(dim_scalers()),
+                     (indexes - block_index * std::get<Is>(dim_scalers()))...);
+  }
+
+  template<size_t... Is, typename... Indexes>
+  DataType& get0(cpp14::index_sequence<Is...> seq, Indexes&&... indexes) const {
+    return *Find(true, seq, std::forward<Indexes>(indexes)...);
+  }
+
+  DataType* Peek(const typename List::SizeArray& indexes) const {
+    return Peek(indexes, cpp14::make_index_sequence<dims>());
+  }
+
+  template<size_t... Is>
+  DataType* Peek(const typename List::SizeArray& indexes,
+                 cpp14::index_sequence<Is...> seq) const {
+    return Find(false, seq, indexes[Is]...);
+  }
+
+  template<size_t... Is>
+  Diag<DataType, BlockSize, block_sizes...> Compact(
+      cpp14::index_sequence<Is...>) const {
+    Diag<DataType, BlockSize, block_sizes...> dense(default_value_,
+                                                    this->sizes_[Is]...);
+    dense.ForEachEntry([this](const typename List::SizeArray& indexes,
+                              DataType& value) {
+        const DataType* lazy_value = Peek(indexes);
+        if (lazy_value != nullptr)
+          value = *lazy_value;
+      });
+    return dense;
+  }
+
+  mutable std::vector<std::unique_ptr<Block> > blocks_;  // null: all default
+  DataType* default_value_;
+  bool last_block_full_;
+  std::array<BlockSize, dims> last_block_sizes_;
+  mutable ValuesView values_;
+};
+
+template<typename DataType, typename BlockSize, BlockSize... block_sizes,
+         typename... Sizes>
+auto MakeList(LazyDiagTag<BlockSize, block_sizes...>,
+              DataType* default_value, Sizes... sizes)
+#define V_LIST_TYPE LazyDiag<DataType, BlockSize, block_sizes...>
+    -> V_LIST_TYPE { return V_LIST_TYPE(default_value, sizes...); }
+#undef V_LIST_TYPE
+
+// For the MakeList overload, we need to somehow encode the number of dims.
+template<unsigned dims>
+struct DynDiagTag {};
+
+// Same as Diag, but the block sizes are passed to the constructor instead,
+// and the values of all blocks are stored in a single contiguous array.
+template<typename DataType, unsigned dims>
+using DynDiag = List<DynDiagTag<dims>, dims, kListOpVector, DataType, void>;
+
+template<typename DataType, unsigned dims>
+class List<DynDiagTag<dims>, dims, kListOpVector, DataType, void>
+    : public ListBase<DataType, dims> {
+  typedef ListBase<DataType, dims> ListBaseType;
+  typedef detail::DynDiagValueIter<DataType, dims> ValueIter;
+
+  static_assert(dims >= 2, "Too few dimensions");
+
+ public:
+  typedef typename ListBaseType::SizeArray SizeArray;
+
+  class ValuesView : public View<DataType> {
+   public:
+    typedef ValueIter Iterator;
+    typedef std::pair<Iterator, Iterator> Range;
+
+    ValuesView(const List* list, const size_t& size)
+        : View<DataType>(size),
+          list_(list) {}
+    typename View<DataType>::Iterator iterator_begin() const {
+      return Iterator(begin());
+    }
+    typename View<DataType>::Iterator iterator_end() const {
+      return Iterator(end());
+    }
+    Iterator begin() const { return At(0); }
+    Iterator end() const { return At(list_->block_count_); }
+
+    // Splits the values into (at most) part_count ranges of consecutive blocks
+    // whose counts differ by at most one (so do the counts of the values,
+    // except for those in the last block if it is not full)
+    std::vector<Range> partition(size_t part_count) const {
+      std::vector<Range> parts;
+      parts.reserve(part_count);
+      const size_t block_count = list_->block_count_;
+      for (size_t part = 0, from = 0; part++ < part_count; ) {
+        const size_t to = block_count * part / part_count;
+        if (from != to)
+          parts.emplace_back(At(from), At(to));
+        from = to;
+      }
+      return parts;
+    }
+
+   private:
+    Iterator At(size_t block_index) const {
+      DataType* values = list_->blocks_.data();
+      const size_t full_block_cnt =
+          list_->block_count_ - !list_->last_block_full_;
+      return Iterator(values + block_index * list_->block_size_product_,
+                      values + full_block_cnt * list_->block_size_product_,
+                      values + list_->blocks_.size(),
+                      &list_->block_sizes_, &list_->last_block_sizes_);
+    }
+
+    const List* list_;
+  };
+
+  template<typename... Sizes>
+  List(DataType* default_value, const SizeArray& block_sizes,
+       const size_t& size, Sizes&&... sizes)
+      : ListBaseType(size, sizes...),
+        default_value_(default_value),
+        block_sizes_(block_sizes),
+        values_(this, 0) {
+    block_size_product_ = 1;
+    block_count_ = -1;
+    for (unsigned dim = 0; dim < dims; ++dim) {
+      dim_scalers_[dim] = detail::DynDiagDimScaler(block_sizes_[dim]);
+      block_size_product_ *= block_sizes_[dim];
+      block_count_ = std::min(block_count_, (this->sizes_[dim] +
+                                             block_sizes_[dim] - 1) /
+                              dim_scalers_[dim]);
+    }
+
+    last_block_full_ = true;
+    for (unsigned dim = 0; dim < dims; ++dim)
+      last_block_full_ &= block_count_ * dim_scalers_[dim] <= this->sizes_[dim];
+    const size_t full_block_cnt = block_count_ - !last_block_full_;
+    size_t last_block_size_product = 1;
+    for (unsigned dim = 0; dim < dims; ++dim) {
+      last_block_sizes_[dim] = !block_count_ ? 0 : std::min(
+          block_sizes_[dim],
+          this->sizes_[dim] - (block_count_ - 1) * dim_scalers_[dim]);
+      last_block_size_product *= last_block_sizes_[dim];
+    }
+
+    blocks_.resize(block_count_ * block_size_product_);
+    values_ = ValuesView(this, full_block_cnt * block_size_product_ +
+                         (last_block_full_ ? 0 : last_block_size_product));
+  }
+
+  // the values view has to point to the copied/moved list
+  List(const List& src)
+      : ListBaseType(src),
+        blocks_(src.blocks_),
+        default_value_(src.default_value_),
+        block_sizes_(src.block_sizes_),
+        last_block_sizes_(src.last_block_sizes_),
+        dim_scalers_(src.dim_scalers_),
+        block_size_product_(src.block_size_product_),
+        block_count_(src.block_count_),
+        last_block_full_(src.last_block_full_),
+        values_(this, src.values_.size()) {}
+
+  List(List&& src)
+      : ListBaseType(std::move(src)),
+        blocks_(std::move(src.blocks_)),
+        default_value_(src.default_value_),
+        block_sizes_(src.block_sizes_),
+        last_block_sizes_(src.last_block_sizes_),
+        dim_scalers_(src.dim_scalers_),
+        block_size_product_(src.block_size_product_),
+        block_count_(src.block_count_),
+        last_block_full_(src.last_block_full_),
+        values_(this, src.values_.size()) {}
+
+  List& operator=(const List& rhs) {
+    return *this = List(rhs);
+  }
+
+  List& operator=(List&& rhs) {
+    ListBaseType::operator=(std::move(rhs));
+    blocks_ = std::move(rhs.blocks_);
+    default_value_ = rhs.default_value_;
+    block_sizes_ = rhs.block_sizes_;
+    last_block_sizes_ = rhs.last_block_sizes_;
+    dim_scalers_ = rhs.dim_scalers_;
+    block_size_product_ = rhs.block_size_product_;
+    block_count_ = rhs.block_count_;
+    last_block_full_ = rhs.last_block_full_;
+    values_ = ValuesView(this, rhs.values_.size());
+    return *this;
+  }
+
+  // used by MakeList
+  template<typename... Args>
+  List(DynDiagTag<dims>, Args&&... args)
+      : List(std::forward<Args>(args)...) {}
+
+  friend List MakeList(List&& list) { return std::forward<List>(list); }
+
+  template<typename... Indexes>
+  DataType& operator()(Indexes&&... indexes) const {
+    return get0(SizeArray{{static_cast<size_t>(indexes)...}});
+  }
+
+  DataType& get(SizeArray&& indexes) const override { return get0(indexes); }
+
+  typename View<DataType>::Iterator iterator_begin() const override {
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(dims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes,
+                     size_t start, RunVector<DataType>* runs) const override {
+    const size_t line_size = this->sizes_[dim];
+
+    // the line intersects a block only if all but the index in dim are within
+    const unsigned lateral_dim = !dim;
+    const size_t block = indexes[lateral_dim] / dim_scalers_[lateral_dim];
+    bool within = block < block_count_;
+    for (unsigned d = 0; d < dims; ++d)
+      within &= d == dim || indexes[d] / dim_scalers_[d] == block;
+    const size_t from = within ? block * dim_scalers_[dim] : line_size;
+    const size_t to = within ? std::min(from + block_sizes_[dim], line_size)
+                      : line_size;
+
+    // the values along the last dimension are contiguous within the block
+    // (but not along the others, so append those one by one)
+    AppendRun(start, from, default_value_, true, runs);
+    SizeArray cur(indexes);
+    const size_t step = dim == dims - 1 ? to - from : 1;
+    for (cur[dim] = from; cur[dim] < to; cur[dim] += step)
+      AppendRun(start + cur[dim], step, &get0(cur), false, runs);
+    AppendRun(start + to, line_size - to, default_value_, true, runs);
+  }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    // the full blocks form a single span, followed by the values of the last
+    const size_t full_block_cnt = block_count_ - !last_block_full_;
+    if (full_block_cnt)
+      visitor(blocks_.data(), full_block_cnt * block_size_product_);
+    if (!last_block_full_)
+      ForEachInBlock(full_block_cnt, [&](const SizeArray&, DataType& value) {
+          visitor(&value, 1);
+        });
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    for (size_t block = 0; block < block_count_; ++block)
+      ForEachInBlock(block, visitor);
+  }
+
+  // covers only the blocks (the rest are default values)
+  void AppendCoverage(const SizeArray& offset,
+                      const DataType* default_value,
+                      std::vector<typename List::Box>* boxes) const override {
+    if (default_value != default_value_)
+      return ListBaseType::AppendCoverage(offset, default_value, boxes);
+    for (size_t block = 0; block < block_count_; ++block) {
+      typename List::Box box(offset, offset);
+      for (unsigned dim = 0; dim < dims; ++dim) {
+        box.first[dim] += block * dim_scalers_[dim];
+        box.second[dim] += std::min((block + 1) * dim_scalers_[dim],
+                                    this->sizes_[dim]);
+      }
+      boxes->push_back(box);
+    }
+  }
+
+  const ValuesView& values() const override { return values_; }
+  DataType* default_value() const override { return default_value_; }
+
+  size_t block_size(unsigned dim) const { return block_sizes_[dim]; }
+
+  const SizeArray& block_sizes() const { return block_sizes_; }
+
+  size_t block_count() const { return block_count_; }
+
+  // Computes y = A x, where A is this matrix (see MultiplyAdd)
+  void Multiply(const DataType* x, DataType* y) const {
+    std::fill(y, y + this->sizes_[0], DataType());
+    MultiplyAdd(x, y);
+  }
+
+  // Computes y += A x, where A is this matrix (x and y must hold as many
+  // values as A has columns and rows, respectively)
+  void MultiplyAdd(const DataType* x, DataType* y) const {
+    static_assert(dims == 2, "Not a matrix");
+    const size_t rows = block_sizes_[0], cols = block_sizes_[1];
+
+    // the last block can be cut off in either dimension
+    const DataType* block = blocks_.data();
+    for (size_t i = 0; i < block_count_; ++i) {
+      const size_t row_cnt = std::min(rows, this->sizes_[0] - i * rows);
+      const size_t col_cnt = std::min(cols, this->sizes_[1] - i * cols);
+      const DataType* block_x = x + i * cols;
+      DataType* block_y = y + i * rows;
+      for (size_t r = 0; r < row_cnt; ++r) {
+        DataType sum = DataType();
+        for (size_t c = 0; c < col_cnt; ++c)
+          sum += block[r * cols + c] * block_x[c];
+        block_y[r] += sum;
+      }
+      block += rows * cols;
+    }
+
+    // add the products of the default values outside the blocks
+    if (default_value_ == nullptr || *default_value_ == DataType())
+      return;
+    const size_t row_cnt = this->sizes_[0], col_cnt = this->sizes_[1];
+    DataType x_sum = DataType();
+    for (size_t c = 0; c < col_cnt; ++c)
+      x_sum += x[c];
+    for (size_t block = 0, r = 0; r < row_cnt; ++block) {
+      DataType block_x_sum = DataType();
+      if (block < block_count_)
+        for (size_t c = block * cols; c < std::min((block + 1) * cols, col_cnt);
+             ++c)
+          block_x_sum += x[c];
+      for (const size_t r_end = std::min(r + rows, row_cnt); r < r_end; ++r)
+        y[r] += *default_value_ * (x_sum - block_x_sum);
+    }
+  }
+
+ private:
+  DataType& get0(const SizeArray& indexes) const {
+    // a single division suffices, since the other indexes must be within the
+    // same block (if an index precedes the block, the difference wraps around)
+    const size_t block = indexes[0] / dim_scalers_[0];
+    size_t offset = indexes[0] - block * dim_scalers_[0];
+    for (unsigned dim = 1; dim < dims; ++dim) {
+      const size_t inner = indexes[dim] - block * dim_scalers_[dim];
+      if (inner >= block_sizes_[dim])
+        return *default_value_;
+      offset = offset * dim_scalers_[dim] + inner;
+    }
+    return blocks_[block * block_size_product_ + offset];
+  }
+
+  // Visits the values of the block as visitor(indexes, value) in memory order,
+  // skipping those out of range (only possible in the last block).
+  template<class Visitor>
+  void ForEachInBlock(size_t block, Visitor&& visitor) const {
+    SizeArray first, last, indexes;
+    for (unsigned dim = 0; dim < dims; ++dim) {
+      indexes[dim] = first[dim] = block * dim_scalers_[dim];
+      last[dim] = std::min(first[dim] + block_sizes_[dim], this->sizes_[dim]);
+    }
+    DataType* value = blocks_.data() + block * block_size_product_;
+    for (size_t i = block_size_product_; i--; ++value) {
+      bool within = true;
+      for (unsigned dim = 0; dim < dims; ++dim)
+        within &= indexes[dim] < last[dim];
+      if (within)
+        visitor(indexes, *value);
+
+      // advance to the next position (the last dimension varies the fastest)
+      for (unsigned dim = dims; dim--; ) {
+        if (++indexes[dim] != first[dim] + block_sizes_[dim])
+          break;
+        indexes[dim] = first[dim];
+      }
+    }
+  }
+
+  mutable std::vector<DataType, AlignedAllocator<DataType, 64> > blocks_;
+  DataType* default_value_;
+  SizeArray block_sizes_;
+  SizeArray last_block_sizes_;
+  std::array<detail::DynDiagDimScaler, dims> dim_scalers_;
+  size_t block_size_product_;
+  size_t block_count_;
+  bool last_block_full_;
+  ValuesView values_;
+};
+
+template<typename DataType, unsigned dims, typename... Sizes>
+auto MakeList(DynDiagTag<dims>, DataType* default_value,
+              const typename DynDiag<DataType, dims>::SizeArray& block_sizes,
+              Sizes... sizes)
+#define V_LIST_TYPE DynDiag<DataType, dims>
+    -> V_LIST_TYPE { return V_LIST_TYPE(default_value, block_sizes, sizes...); }
+#undef V_LIST_TYPE
+
 }  // namespace v
 
 #endif  /* CPPVIEWS_SRC_DIAG_HPP_ */
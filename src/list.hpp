@@ -4,17 +4,27 @@
 #include "map.hpp"
 #include "portion.hpp"
 #include "portion_helper.hpp"
+#include "run.hpp"
+#include "segment.hpp"
 #include "view.hpp"
+#include "util/coverage_grid.hpp"
 #include "util/immutable_skip_list.hpp"
 #include "util/intseq.hpp"
+#include "util/order_statistic_tree.hpp"
 #include "util/poly_vector.hpp"
+#include "util/prefix_index.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstdint>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace v {
 
@@ -58,7 +68,8 @@ constexpr Size MinSize(Size&& size) { return std::forward<Size>(size); }
 template<typename Size1, typename Size2, typename... Sizes>
 constexpr typename std::common_type<Size1, Size2, Sizes...>::type
 MinSize(Size1&& size1, Size2&& size2, Sizes&&... sizes) {
-  return size1 < size2
+  typedef typename std::common_type<Size1, Size2>::type CommonSize;
+  return static_cast<CommonSize>(size1) < static_cast<CommonSize>(size2)
                  ? MinSize(size1, std::forward<Sizes>(sizes)...)
                  : MinSize(size2, std::forward<Sizes>(sizes)...);
 }
@@ -70,7 +81,8 @@ template<typename Size1, typename Size2, typename... Sizes>
 constexpr bool SameSize(const Size1& size1, const Size2& size2,
                         Sizes&&... sizes) {
   using namespace std;
-  return (size1 == size2) & SameSize(size1, forward<Sizes>(sizes)...);
+  return (static_cast<size_t>(size1) == static_cast<size_t>(size2)) &
+      SameSize(size1, forward<Sizes>(sizes)...);
 }
 
 template <typename... Ns>
@@ -172,21 +184,135 @@ struct ListSizeGetter {
   const SubviewContainer& c_;
 };
 
-template<class SubviewContainer, unsigned dim = 1>
+// Indexes the elements of all subviews (e.g., portions) linearly, such that
+// the position of the element in a subview can be found via the skip list.
+// The subviews are in the same order in the container, so the index of each
+// one in it (i.e., its slot) is the same as its bucket index.
+template<class SubviewContainer, unsigned dim = 1,
+         class SkipList = ImmutableSkipList<
+           ListSizeGetter<SubviewContainer, dim> > >
 class LinearizedMonotonicIndexer {
-  typedef ImmutableSkipList<ListSizeGetter<SubviewContainer, dim> >
-  ImmutableSkipListType;
  public:
+  typedef SkipList SkipListType;
+  typedef typename SkipListType::Position Position;
+  // finds the (slot, local_index) of elements near the last found one
+  typedef typename SkipListType::Cursor Cursor;
+  static constexpr bool kInOrder = true;
+
   LinearizedMonotonicIndexer(const SubviewContainer& c) :
       bsg_(c),
       fwd_(c.size(), bsg_) {}
   size_t bucket_size(const size_t& index) const { return bsg_(index); }
-  const ImmutableSkipListType& fwd() const { return fwd_; }
+  const SkipListType& fwd() const { return fwd_; }
+
+  size_t slot(size_t bucket_index) const { return bucket_index; }
+  size_t slot_size(size_t slot) const { return bsg_(slot); }
+
+  // Returns the slot of the subview that contains the global_index-th element
+  // and the local index in it.
+  Position locate(size_t global_index) const { return fwd_.get(global_index); }
+
+  void locate_batch(const size_t* global_indexes, size_t n,
+                    Position* out) const {
+    fwd_.get_batch(global_indexes, n, out);
+  }
+
+  Cursor cursor() const { return fwd_.cursor(); }
+
+  // Calls the visitor with the slots of the first count subviews in order.
+  template<class Visitor>
+  void ForEachSlot(size_t count, Visitor&& visitor) const {
+    for (size_t slot = 0; slot < count; ++slot)
+      visitor(slot);
+  }
+
+ private:
+  ListSizeGetter<SubviewContainer, dim> bsg_;
+  // the skip counts are symmetric, so backward skips go through fwd_ as well
+  // (see ImmutableSkipList::get_backward)
+  SkipListType fwd_;
+};
+
+// The subviews can be inserted and erased anywhere in O(lg N) without
+// rebuilding the tree from scratch, and without moving the other subviews in
+// the container, since the tree stores the slot of each one (as its value).
+template<class SubviewContainer, unsigned dim>
+class LinearizedMonotonicIndexer<SubviewContainer, dim, OrderStatisticTree> {
+ public:
+  typedef OrderStatisticTree SkipListType;
+  typedef SkipListType::Position Position;
+  static constexpr bool kInOrder = false;
+
+  LinearizedMonotonicIndexer(const SubviewContainer& c) :
+      bsg_(c),
+      fwd_(c.size(), bsg_) {}
+  size_t bucket_size(const size_t& index) const { return bsg_(slot(index)); }
+  const SkipListType& fwd() const { return fwd_; }
+
+  size_t slot(size_t bucket_index) const { return fwd_.value(bucket_index); }
+  size_t slot_size(size_t slot) const { return bsg_(slot); }
+
+  Position locate(size_t global_index) const {
+    return fwd_.locate(global_index);
+  }
+
+  void locate_batch(const size_t* global_indexes, size_t n,
+                    Position* out) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = fwd_.locate(global_indexes[i]);
+  }
+
+  class Cursor {
+   public:
+    explicit Cursor(const SkipListType& tree) : finger_(tree.cursor()) {}
+    Position seek(size_t global_index) {
+      const size_t local_index = finger_.seek(global_index).second;
+      return Position(finger_.value(), local_index);
+    }
+
+   private:
+    SkipListType::Cursor finger_;
+  };
+
+  Cursor cursor() const { return Cursor(fwd_); }
+
+  template<class Visitor>
+  void ForEachSlot(size_t count, Visitor&& visitor) const {
+    fwd_.ForEachValue(count, visitor);
+  }
+
+  // Takes a slot freed by Erase (for a subview to be put in), if any.
+  bool PopFreeSlot(size_t* slot) {
+    if (free_slots_.empty())
+      return false;
+    *slot = free_slots_.back();
+    free_slots_.pop_back();
+    return true;
+  }
+
+  // Updates the tree after a subview is put in the slot, so that it is the
+  // bucket_index-th one.
+  void Insert(size_t bucket_index, size_t slot) {
+    fwd_.Insert(bucket_index, bsg_(slot), slot);
+  }
+
+  // Updates the tree before the bucket_index-th subview is erased
+  // (its slot becomes free).
+  void Erase(size_t bucket_index) {
+    free_slots_.push_back(slot(bucket_index));
+    fwd_.Erase(bucket_index);
+  }
+
+  // Updates the tree after all subviews are erased from the container.
+  void Clear() {
+    fwd_ = SkipListType();
+    free_slots_.clear();
+  }
+
  private:
   ListSizeGetter<SubviewContainer, dim> bsg_;
-  ImmutableSkipListType fwd_;
-  // TODO optimize short jumps (need also a "backward" skip list)
-  // ImmutableSkipList<ReverseBucketSizeGetter> bwd_;
+  SkipListType fwd_;
+  std::vector<size_t> free_slots_;
 };
 
 constexpr bool And2(bool cond1, bool cond2) { return cond1 && cond2; }
@@ -194,7 +320,7 @@ constexpr bool And2(bool cond1, bool cond2) { return cond1 && cond2; }
 // Checks whether the unlinearized position "pos" is in the range [0, to_index).
 template<typename Size, Size size, typename LastIndex>
 constexpr bool WithinLast(const size_t& pos, LastIndex&& to_index) {
-  return pos < to_index;
+  return pos < static_cast<size_t>(to_index);
 }
 
 // Checks whether the unlinearized position "pos" is in the range
@@ -205,7 +331,7 @@ constexpr bool WithinLast(const size_t& pos, Index&& to_index,
                           Indexes&&... to_indexes) {
   return WithinLast<Size, sizes...>(pos / size,
                                     std::forward<Indexes>(to_indexes)...) &
-      (pos - pos / size * size < to_index);
+      (pos - pos / size * size < static_cast<size_t>(to_index));
 }
 
 template<class OuterIter, class ListType, typename DataType>
@@ -299,10 +425,11 @@ class List1DIter
                  std::is_convertible<OuterIter2, OuterIter>::value,
                  std::is_convertible<DataType2*, DataType*>::value),
              Enabler>::type = Enabler())
-      : indexer_(indexer_),
+      : indexer_(other.indexer_),
         outer_begin_(other.outer_begin_),
         inner_cur_(other.inner_cur_),
         bucket_index_(other.bucket_index_),
+        bucket_size_(other.bucket_size_),
         local_index_(other.local_index_),
         global_index_(other.global_index_) {}
   List1DIter() = default;
@@ -318,28 +445,42 @@ class List1DIter
 
   void Increment() override {
     ++global_index_;
-    if (++local_index_ == indexer_->bucket_size(bucket_index_)) {
+    if (++local_index_ == bucket_size_) {
       // rely on the invariant that list contains no empty portions/subviews,
       // except the last one which is used as a sentinel
       // (this reduces the time complexity of this operation)
+      ++bucket_index_;
+      local_index_ = 0;
       UpdateInner(0);
     } else
       ++inner_cur_;
   }
 
-  void Advance(typename List1DIter::difference_type n) {
-    global_index_ += n;
-
-    // TODO implement indexer_->bwd() and use it
-    if (n <= 0) {
+  void Decrement() {
+    --global_index_;
+    if (local_index_) {
+      --local_index_;
+      --inner_cur_;
+    } else {
       std::tie(bucket_index_, local_index_) = indexer_->fwd()
-          .get(global_index_);
+          .get_backward(1, bucket_index_);
       UpdateInner(local_index_);
-      return;
     }
+  }
 
-    std::tie(bucket_index_, local_index_) = indexer_->fwd()
-        .get(local_index_ + n, bucket_index_);
+  // skips from the current bucket in both directions, so that the time
+  // complexity is O(lg |n|) rather than O(lg N)
+  void Advance(typename List1DIter::difference_type n) {
+    global_index_ += n;
+    if (n >= 0) {
+      std::tie(bucket_index_, local_index_) = indexer_->fwd()
+          .get(local_index_ + n, bucket_index_);
+    } else if (static_cast<size_t>(-n) <= local_index_) {
+      local_index_ += n;
+    } else {
+      std::tie(bucket_index_, local_index_) = indexer_->fwd()
+          .get_backward(-n - local_index_, bucket_index_);
+    }
     UpdateInner(local_index_);
   }
 
@@ -358,13 +499,25 @@ class List1DIter
   typedef typename SubviewType::Iterator InnerIter;
 
   void UpdateInner(size_t local_index) {
-    inner_cur_ = (outer_begin_ + bucket_index_)->begin() + local_index;
+    // past the end, the skip list skips the (empty) sentinel bucket as well
+    // (unless there are no buckets at all, i.e., the list is empty)
+    if (bucket_index_ == indexer_->fwd().bucket_count()) {
+      if (!bucket_index_)
+        return;
+      --bucket_index_;
+    }
+    // the subview is looked up (and its size cached) only once per bucket,
+    // since that is O(lg N) if the subviews are not in order
+    const size_t slot = indexer_->slot(bucket_index_);
+    bucket_size_ = indexer_->slot_size(slot);
+    inner_cur_ = (outer_begin_ + slot)->begin() + local_index;
   }
 
   const Indexer* indexer_;
   OuterIter outer_begin_;
   InnerIter inner_cur_;
   size_t bucket_index_;
+  size_t bucket_size_;
   size_t local_index_;
   size_t global_index_;
 };
@@ -429,6 +582,94 @@ class ListBase : public View<T>,
   virtual T& get(SizeArray&& indexes) const = 0;
   T& get(const SizeArray& indexes) const { return get(SizeArray(indexes)); }
 
+  typedef std::function<void(const SizeArray&, T&)> EntryVisitor;
+  typedef std::function<void(T*, size_t)> SpanVisitor;
+
+  // Visits the values (in the same order as values()) as contiguous spans
+  // [data, data + size), so that a list makes one virtual call per span
+  // rather than per value (adjacent spans need not be merged)
+  virtual void ForEachSpan(const SpanVisitor& visitor) const = 0;
+
+  // Internal iteration over the values (in the same order as values()), which
+  // calls the visitor inline in a tight loop over each span of ForEachSpan()
+  template<class Func>
+  void ForEach(Func&& visitor) const {
+    ForEachSpan([&visitor](T* data, size_t size) {
+        for (T* end = data + size; data != end; ++data)
+          visitor(*data);
+      });
+  }
+
+  // Same as ForEach(), but also passes the indexes of each value
+  virtual void ForEachEntry(const EntryVisitor& visitor) const = 0;
+
+  // Appends the spans of ForEachSpan(), merging those adjacent in memory
+  void AppendSegments(SegmentVector<T>* segments) const {
+    ForEachSpan([segments](T* data, size_t size) {
+        AppendSegment(data, size, segments);
+      });
+  }
+
+  SegmentVector<T> segments() const {
+    SegmentVector<T> segments;
+    AppendSegments(&segments);
+    return segments;
+  }
+
+  // Appends the runs of elements at (indexes[0], ..., indexes[dims - 2], i)
+  // for all i in [0, sizes().back()), where the last index is ignored and
+  // start is the linearized index of the first one (by default, uses get())
+  virtual void AppendLineRuns(const SizeArray& indexes, size_t start,
+                              RunVector<T>* runs) const {
+    SizeArray line(indexes);
+    for (line.back() = 0; line.back() < sizes_.back(); ++line.back())
+      AppendRun(start + line.back(), 1, &get(line), false, runs);
+  }
+
+  // Appends the runs of elements along dimension dim through the indexes
+  // (whose index in dim is ignored), where start is the position of the first
+  // one (by default, uses AppendLineRuns() for the last dimension and get()
+  // for the others)
+  virtual void AppendDimRuns(unsigned dim, const SizeArray& indexes,
+                             size_t start, RunVector<T>* runs) const {
+    if (dim >= dims - 1)
+      return AppendLineRuns(indexes, start, runs);
+    SizeArray line(indexes);
+    for (line[dim] = 0; line[dim] < sizes_[dim]; ++line[dim])
+      AppendRun(start + line[dim], 1, &get(line), false, runs);
+  }
+
+  typedef typename CoverageGrid<dims>::Box Box;
+
+  // Appends the boxes (shifted by offset) that together cover all elements
+  // other than *default_value, i.e., those outside of them must be the same
+  // object as *default_value (by default, covers the whole list)
+  virtual void AppendCoverage(const SizeArray& offset, const T* default_value,
+                              std::vector<Box>* boxes) const {
+    Box box(offset, offset);
+    for (unsigned dim = 0; dim < dims; ++dim)
+      box.second[dim] += sizes_[dim];
+    boxes->push_back(box);
+  }
+
+  // Returns the object that all the elements not stored in the list are
+  // (or nullptr if every element is stored, e.g., in a SimpleList)
+  virtual T* default_value() const { return nullptr; }
+
+  // Returns the runs of all elements in row-major order
+  RunVector<T> runs() const {
+    RunVector<T> runs;
+    if (element_count()) {
+      SizeArray line{};
+      size_t start = 0;
+      do {
+        AppendLineRuns(line, start, &runs);
+        start += sizes_.back();
+      } while (NextLine(&line));
+    }
+    return runs;
+  }
+
   const SizeArray& sizes() const { return sizes_; }
 
   typename View<T>::Iterator fbegin() const {
@@ -439,16 +680,112 @@ class ListBase : public View<T>,
   }
 
  protected:
+  // Iterates over all elements in row-major order, one line of runs at a time
+  // (which skips stretches of default values without calling get())
+  class DenseIter
+      : public DefaultIterator<DenseIter, std::forward_iterator_tag, T>,
+        public View<T>::IteratorBase {
+    V_DEFAULT_ITERATOR_DERIVED_HEAD(DenseIter);
+
+   public:
+    DenseIter(const ListBase* list, bool end)
+        : list_(list),
+          index_(end ? list->element_count() : 0),
+          run_(0),
+          pos_(0),
+          line_{} {
+      if (index_ < list->element_count())
+        FetchRuns();
+    }
+
+   protected:
+    V_DEF_VIEW_ITER_IS_EQUAL(T, DenseIter)
+
+    bool IsEqual(const DenseIter& other) const {
+      return index_ == other.index_;
+    }
+
+    void Increment() override {
+      ++index_;
+      if (++pos_ == (*runs_)[run_].length) {
+        pos_ = 0;
+        if (++run_ == runs_->size()) {
+          run_ = 0;
+          if (list_->NextLine(&line_))
+            FetchRuns();
+        }
+      }
+    }
+
+    T& ref() const override { return (*runs_)[run_][pos_]; }
+
+   private:
+    void FetchRuns() {
+      ResetRuns(&runs_);
+      list_->AppendLineRuns(line_, index_, runs_.get());
+    }
+
+    const ListBase* list_;
+    size_t index_;
+    std::shared_ptr<RunVector<T> > runs_;
+    size_t run_;  // the index of the current run in runs_
+    size_t pos_;  // the position within the current run
+    SizeArray line_;
+  };
+
+  // Empties the runs for reuse, unless they are shared with a copy of the
+  // iterator that owns them, in which case they are replaced by a spare buffer
+  // (one per thread), so that the iterators allocate runs only while copied
+  static void ResetRuns(std::shared_ptr<RunVector<T> >* runs) {
+    static thread_local std::shared_ptr<RunVector<T> > spare;
+    if (*runs && runs->use_count() == 1 + (*runs == spare)) {
+      (*runs)->clear();
+      return;
+    }
+    if (spare.use_count() == 1)
+      spare->clear();
+    else
+      spare = std::make_shared<RunVector<T> >();
+    *runs = spare;
+  }
+
+  DenseIter dense_begin() const { return DenseIter(this, false); }
+  DenseIter dense_end() const { return DenseIter(this, true); }
+
+  // Advances the indexes to the next line in row-major order (i.e., increments
+  // all but the last one), or returns false if there is none
+  bool NextLine(SizeArray* indexes) const {
+    for (unsigned dim = dims - 1; dim--; ) {
+      if (++(*indexes)[dim] < sizes_[dim])
+        return true;
+      (*indexes)[dim] = 0;
+    }
+    return false;
+  }
+
+  size_t element_count() const {
+    size_t count = 1;
+    for (const auto& size : sizes_)
+      count *= size;
+    return count;
+  }
+
   template<typename V>
   class PolyDimIterator {
+   public:
+    virtual ~PolyDimIterator() = default;
+
    protected:
     typedef bool (*IsEqualPointer)(const PolyDimIterator& lhs,
                                    const PolyDimIterator& rhs);
 
     virtual PolyDimIterator* Clone() const = 0;
+    virtual PolyDimIterator* Clone(void* buf, size_t size) const = 0;
     virtual void Increment() = 0;
     virtual V& ref() const = 0;
     virtual IsEqualPointer equal() const = 0;
+
+    template<class, size_t> friend class ::InplacePointer;
   };
 
   // helper class for easy derivation of PolyDimIterator by the subclasses
@@ -461,6 +798,9 @@ class ListBase : public View<T>,
     PolyDimIterator<V>* Clone() const override {
       return new Derived(this->derived());
     }
+    PolyDimIterator<V>* Clone(void* buf, size_t size) const override {
+      return NewInplace<Derived>(buf, size, this->derived());
+    }
     static bool IsEqual(const PolyDimIterator<V>& lhs,
                         const PolyDimIterator<V>& rhs) {
       return static_cast<const Derived&>(lhs) ==
@@ -497,7 +837,15 @@ class ListBase : public View<T>,
    public:
     DimIterator(PolyDimIterator<V>*&& it) :
         it_(std::forward<PolyDimIterator<V>*&&>(it)) {}
-    DimIterator(const DimIterator& copy) : it_(copy.it_->Clone()) {}
+    // constructs a copy of the iterator in place (avoids heap allocation)
+    // (DimIterator is a PolyDimIterator itself, so exclude it explicitly)
+    template<class Iter, class Enable = typename std::enable_if<
+               std::is_base_of<PolyDimIterator<V>,
+                               typename std::decay<Iter>::type>::value &&
+               !std::is_same<DimIterator,
+                             typename std::decay<Iter>::type>::value>::type>
+    DimIterator(Iter&& it) : it_(std::forward<Iter>(it)) {}
+    DimIterator(const DimIterator& copy) = default;
     DimIterator(DimIterator&& other) = default;
     DimIterator& operator=(const DimIterator& rhs) = default;
     DimIterator& operator=(DimIterator&& rhs) = default;
@@ -508,13 +856,300 @@ class ListBase : public View<T>,
     }
     virtual V& ref() const override { return it_->ref(); }
    private:
-    std::unique_ptr<PolyDimIterator<V> > it_;
+    InplacePointer<PolyDimIterator<V>,
+                   View<T>::kIteratorInplaceSize> it_;
   };
 
+  // Iterates along dimension dim over the runs fetched once by AppendDimRuns(),
+  // so that the stretches of default values are skipped in O(1) time, and
+  // optionally over the elements other than *default_value only
+  template<typename V, unsigned dim, bool nondefault = false>
+  class RunDimIter
+      : public DimIteratorBase<RunDimIter<V, dim, nondefault>,
+                               V,
+                               std::forward_iterator_tag> {
+    V_DEFAULT_ITERATOR_DERIVED_HEAD(RunDimIter);
+    template<typename, unsigned, bool> friend class RunDimIter;
+    template<typename FromType, typename ToType, class Type>
+    using EnableIfConvertible = typename std::enable_if<
+      std::is_convertible<FromType, ToType>::value, Type>::type;
+
+   public:
+    RunDimIter(std::shared_ptr<const RunVector<T> > runs,
+               const T* default_value)
+        : runs_(std::move(runs)),
+          default_value_(default_value),
+          run_(0),
+          pos_(0),
+          index_(0) {
+      SkipDefault();
+    }
+    // constructs the end iterator of a line of the size
+    explicit RunDimIter(size_t size)
+        : default_value_(nullptr), run_(0), pos_(0), index_(size) {}
+    template<typename V2>
+    RunDimIter(const RunDimIter<V2, dim, nondefault>& copy,
+               EnableIfConvertible<V2*, V*, typename RunDimIter::Enabler>
+               enabler = typename RunDimIter::Enabler())
+        : runs_(copy.runs_),
+          default_value_(copy.default_value_),
+          run_(copy.run_),
+          pos_(copy.pos_),
+          index_(copy.index_) {}
+    RunDimIter() = default;
+
+    static constexpr unsigned kDim = dim;
+
+    // Returns the index in dimension dim of the current element
+    size_t index() const { return index_; }
+
+   protected:
+    void Increment() override {
+      ++index_;
+      if (++pos_ == (*runs_)[run_].length) {
+        pos_ = 0;
+        ++run_;
+        SkipDefault();
+      }
+    }
+
+    template<typename V2>
+    EnableIfConvertible<V2, V, bool>
+    IsEqual(const RunDimIter<V2, dim, nondefault>& other) const {
+      return index_ == other.index_;
+    }
+
+    V& ref() const override { return (*runs_)[run_][pos_]; }
+
+   private:
+    void SkipDefault() {
+      if (nondefault)
+        for (; run_ < runs_->size() && (*runs_)[run_].repeated &&
+                 (*runs_)[run_].value == default_value_; ++run_)
+          index_ += (*runs_)[run_].length;
+    }
+
+    std::shared_ptr<const RunVector<T> > runs_;
+    const T* default_value_;
+    size_t run_;  // the index of the current run in runs_
+    size_t pos_;  // the position within the current run
+    size_t index_;
+  };
+
+  // Iterates over the entries along dimension dim that are not *default_value
+  // (via RunDimIter, so it also skips the stretches of default values)
+  template<typename V, unsigned dim>
+  class RunEntryDimIter
+      : public EntryDimIteratorBase<RunEntryDimIter<V, dim>,
+                                    V,
+                                    std::forward_iterator_tag> {
+    V_DEFAULT_ITERATOR_DERIVED_HEAD(RunEntryDimIter);
+    template<typename, unsigned> friend class RunEntryDimIter;
+    template<typename FromType, typename ToType, class Type>
+    using EnableIfConvertible = typename std::enable_if<
+      std::is_convertible<FromType, ToType>::value, Type>::type;
+
+   public:
+    typedef RunDimIter<V, dim, true> ValueIter;
+
+    RunEntryDimIter(ValueIter&& it, const SizeArray& indexes)
+        : it_(std::move(it)),
+          indexes_(indexes) {}
+    template<typename V2>
+    RunEntryDimIter(const RunEntryDimIter<V2, dim>& copy,
+                    EnableIfConvertible<V2*, V*,
+                    typename RunEntryDimIter::Enabler>
+                    enabler = typename RunEntryDimIter::Enabler())
+        : it_(copy.it_),
+          indexes_(copy.indexes_) {}
+    RunEntryDimIter() = default;
+
+    static constexpr unsigned kDim = dim;
+
+   protected:
+    void Increment() override { ++it_; }
+
+    template<typename V2>
+    EnableIfConvertible<V2, V, bool>
+    IsEqual(const RunEntryDimIter<V2, dim>& other) const {
+      return it_ == other.it_;
+    }
+
+    typename RunEntryDimIter::reference ref() const override {
+      SizeArray indexes(indexes_);
+      indexes[dim] = it_.index();
+      e_ = typename RunEntryDimIter::value_type(&*it_, std::move(indexes));
+      return e_;
+    }
+
+   private:
+    ValueIter it_;
+    SizeArray indexes_;  // of the line (the index in dim is ignored)
+    mutable typename RunEntryDimIter::value_type e_;
+  };
+
+  // Returns the indexes of the line along dimension dim through the lateral
+  // indexes (i.e., all but the one in that dimension, which is set to 0)
+  template<unsigned dim, typename... Indexes>
+  static SizeArray LineIndexes(Indexes&&... lateral_indexes) {
+    const std::array<size_t, dims - 1> lateral{{
+        static_cast<size_t>(lateral_indexes)...}};
+    SizeArray indexes;
+    std::copy(lateral.begin() + dim, lateral.end(),
+              1 + std::copy_n(lateral.begin(), dim, indexes.begin()));
+    indexes[dim] = 0;
+    return indexes;
+  }
+
+  // Returns the RunDimIter at the beginning of the line along its dimension
+  // through the lateral indexes
+  template<class DimIterType, typename... Indexes>
+  DimIterType run_dim_begin(const T* default_value,
+                            Indexes&&... lateral_indexes) const {
+    static constexpr unsigned dim = DimIterType::kDim;
+    std::shared_ptr<RunVector<T> > runs;
+    ResetRuns(&runs);  // reuses the buffer of the last line if it is done
+    AppendDimRuns(dim, LineIndexes<dim>(
+        std::forward<Indexes>(lateral_indexes)...), 0, runs.get());
+    return DimIterType(std::move(runs), default_value);
+  }
+
+  template<class DimIterType, typename... Indexes>
+  DimIterType run_dim_end(Indexes&&...) const {
+    return DimIterType(sizes_[DimIterType::kDim]);
+  }
+
+  template<class DimIterType, typename... Indexes>
+  DimIterType run_entry_dim_begin(const T* default_value,
+                                  Indexes&&... lateral_indexes) const {
+    static constexpr unsigned dim = DimIterType::kDim;
+    return DimIterType(
+        run_dim_begin<typename DimIterType::ValueIter>(
+            default_value, lateral_indexes...),
+        LineIndexes<dim>(std::forward<Indexes>(lateral_indexes)...));
+  }
+
+  template<class DimIterType, typename... Indexes>
+  DimIterType run_entry_dim_end(Indexes&&...) const {
+    return DimIterType(run_dim_end<typename DimIterType::ValueIter>(),
+                       SizeArray{});
+  }
+
   SizeArray sizes_;
   SizeArray offsets_;
 };
 
+// Defines the dimension iterator accessors of ListType (which derives from it
+// via CRTP and befriends it) with the signature:
+//   template<unsigned dim, typename... Indexes>
+//   [Const][NonDefault|Entry]DimIterator<dim> [nondefault_|entry_]dim_[c]
+//       (begin|end)\<dim\>(Indexes&&... lateral_indexes) const;
+// Each forwards the call to [nondefault_|entry_]dim_(begin|end)0, which
+// default to the RunDimIter of ListBase, unless ListType hides them (the List
+// parameter defers the lookup of the iterator type until the call, so that
+// ListType need not be complete, nor define all of the iterator types)
+template<class ListType>
+class DimIterAccessors {
+ public:
+#define V_THIS_DEF_DIM_ITER_ACCESSOR0(Tpl, method, method0)             \
+  template<unsigned dim, class List = ListType, typename... Indexes>    \
+  typename List::template Tpl<dim> method(                              \
+      Indexes&&... lateral_indexes) const {                             \
+    return derived().template method0<typename List::template Tpl<dim> >( \
+        std::forward<Indexes>(lateral_indexes)...);                     \
+  }
+#define V_THIS_DEF_DIM_ITER_ACCESSOR1(Tpl, prefix, c, which)            \
+  V_THIS_DEF_DIM_ITER_ACCESSOR0(Tpl, prefix ## c ## which, prefix ## which ## 0)
+#define V_THIS_DEF_DIM_ITER_ACCESSOR(Tpl, infix, c, which)       \
+      V_THIS_DEF_DIM_ITER_ACCESSOR1(Tpl, infix ## dim_, c, which)
+#define V_THIS_DEF_DIM_ITER_ACCESSORS0(Tpl, infix, c)            \
+  V_THIS_DEF_DIM_ITER_ACCESSOR(infix, Tpl, c, begin)             \
+  V_THIS_DEF_DIM_ITER_ACCESSOR(infix, Tpl, c, end)
+#define V_THIS_DEF_DIM_ITER_ACCESSORS(Tpl, infix, c)    \
+  V_THIS_DEF_DIM_ITER_ACCESSORS0(infix, Tpl, c)
+
+  V_THIS_DEF_DIM_ITER_ACCESSORS(DimIterator, ,)
+  V_THIS_DEF_DIM_ITER_ACCESSORS(ConstDimIterator, , c)
+  V_THIS_DEF_DIM_ITER_ACCESSORS(NonDefaultDimIterator, nondefault_,)
+  V_THIS_DEF_DIM_ITER_ACCESSORS(ConstNonDefaultDimIterator, nondefault_, c)
+  V_THIS_DEF_DIM_ITER_ACCESSORS(EntryDimIterator, entry_,)
+  V_THIS_DEF_DIM_ITER_ACCESSORS(ConstEntryDimIterator, entry_, c)
+
+#undef V_THIS_DEF_DIM_ITER_ACCESSORS
+#undef V_THIS_DEF_DIM_ITER_ACCESSORS0
+#undef V_THIS_DEF_DIM_ITER_ACCESSOR
+#undef V_THIS_DEF_DIM_ITER_ACCESSOR1
+#undef V_THIS_DEF_DIM_ITER_ACCESSOR0
+
+ protected:
+  template<class DimIterType, typename... Indexes>
+  DimIterType dim_begin0(Indexes&&... lateral_indexes) const {
+    return derived().template run_dim_begin<DimIterType>(
+        derived().default_value(), std::forward<Indexes>(lateral_indexes)...);
+  }
+
+  template<class DimIterType, typename... Indexes>
+  DimIterType dim_end0(Indexes&&... lateral_indexes) const {
+    return derived().template run_dim_end<DimIterType>(
+        std::forward<Indexes>(lateral_indexes)...);
+  }
+
+  // the runs of the default value are skipped by the iterators themselves
+  template<class DimIterType, typename... Indexes>
+  DimIterType nondefault_dim_begin0(Indexes&&... lateral_indexes) const {
+    return derived().template dim_begin0<DimIterType>(
+        std::forward<Indexes>(lateral_indexes)...);
+  }
+
+  template<class DimIterType, typename... Indexes>
+  DimIterType nondefault_dim_end0(Indexes&&... lateral_indexes) const {
+    return derived().template dim_end0<DimIterType>(
+        std::forward<Indexes>(lateral_indexes)...);
+  }
+
+  template<class DimIterType, typename... Indexes>
+  DimIterType entry_dim_begin0(Indexes&&... lateral_indexes) const {
+    return derived().template run_entry_dim_begin<DimIterType>(
+        derived().default_value(), std::forward<Indexes>(lateral_indexes)...);
+  }
+
+  template<class DimIterType, typename... Indexes>
+  DimIterType entry_dim_end0(Indexes&&... lateral_indexes) const {
+    return derived().template run_entry_dim_end<DimIterType>(
+        std::forward<Indexes>(lateral_indexes)...);
+  }
+
+ private:
+  const ListType& derived() const {
+    return static_cast<const ListType&>(*this);
+  }
+};
+
+// Returns the first entry iterator in [first, last) whose entry e satisfies
+// !comp(e, value), like std::lower_bound, but moves the iterators by halves via
+// Advance() and DistanceTo() (which the entry iterators provide instead of
+// being random-access, since they stash the entry). Therefore, it makes
+// O(log n) comparisons and moves, e.g., it takes O(k log n) time along a line
+// through k sublists of a Chain rather than O(n) increments.
+template<class EntryIter, typename V, class Compare>
+EntryIter EntryLowerBound(EntryIter first, const EntryIter& last,
+                          const V& value, Compare comp) {
+  std::ptrdiff_t count = first.DistanceTo(last);
+  while (count > 0) {
+    const std::ptrdiff_t half = count >> 1;
+    EntryIter mid(first);
+    mid.Advance(half);
+    if (comp(*mid, value)) {
+      first = std::move(mid);
+      first.Advance(1);
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  return first;
+}
+
 enum ListFlags : uint8_t {
   kListNoFlags,
       kListOpMin,
@@ -534,7 +1169,8 @@ enum ListFlags : uint8_t {
       kListOpDel = kListOpDelEnd | kListOpDelMid,
       kListOpVector = kListOpInsBack | kListOpDelBack,
       kListOpQueue = kListOpInsBack | kListOpDelFront,
-      kListOpDeque = kListOpInsEnd | kListOpDelEnd
+      kListOpDeque = kListOpInsEnd | kListOpDelEnd,
+      kListOpList = kListOpIns | kListOpDel
       };
 
 struct ListFactory;
@@ -572,8 +1208,12 @@ class List<void, dims, kListNoFlags, void, T> : public ListBase<T, dims> {
     return *static_cast<T*>(nullptr);  // Undefined Behavior, but fast
   }
 
+  void ForEachSpan(const typename ListBaseType::SpanVisitor&) const override {}
+  void ForEachEntry(const typename ListBaseType::EntryVisitor&) const override
+  {}
+
   typename View<T>::Iterator iterator_begin() const override {
-    return new Iterator();
+    return Iterator();
   }
 
   // define iterator accessors of the following form:
@@ -627,18 +1267,30 @@ struct SimpleListHelper<PortionBase<T> > {
 template<typename T, class P = PortionBase<T> >
 using PortionVector = PolyVector<P, PortionBase<T>, PortionFactory>;
 
-#define V_LIST_INDEXER_TYPE list_detail:: \
-  LinearizedMonotonicIndexer<PortionVector<typename P::DataType, P> >
+#define V_LIST_INDEXER_TYPE(...) list_detail:: \
+  LinearizedMonotonicIndexer<PortionVector<typename P::DataType, P>, 1, \
+                             __VA_ARGS__>
 
-template<class P>
-using SimpleList = List<P, 1, kListOpVector, V_LIST_INDEXER_TYPE>;
+// a simple list whose portions are found via the SkipList, which can be
+// replaced by a more cache-friendly layout (e.g., EytzingerPrefixIndex)
+template<class P, template<class> class SkipList = ImmutableSkipList>
+using SimpleList = List<P, 1, kListOpVector, V_LIST_INDEXER_TYPE(
+    SkipList<list_detail::ListSizeGetter<PortionVector<typename P::DataType, P>,
+                                         1> >)>;
 
+// a simple list whose portions can be inserted and erased anywhere in O(lg N)
+// time without rebuilding it (the portions are stored unordered, and the tree
+// keeps their order instead)
 template<class P>
-class List<P, 1, kListOpVector, V_LIST_INDEXER_TYPE>
+using MutableSimpleList = List<P, 1, kListOpList,
+                               V_LIST_INDEXER_TYPE(OrderStatisticTree)>;
+
+template<class P, ListFlags flags, class SkipList>
+class List<P, 1, flags, V_LIST_INDEXER_TYPE(SkipList)>
     : public ListBase<typename P::DataType>,
       public PortionHelper<P, typename P::DataType>,
       protected detail::SimpleListHelper<P> {
-  typedef V_LIST_INDEXER_TYPE Indexer;
+  typedef V_LIST_INDEXER_TYPE(SkipList) Indexer;
   typedef typename P::DataType DataType;
   typedef PortionVector<DataType, P> Container;
 #undef V_LIST_INDEXER_TYPE
@@ -646,17 +1298,21 @@ class List<P, 1, kListOpVector, V_LIST_INDEXER_TYPE>
   typedef typename ListBase<DataType>::SizeArray SizeArray;
 
  public:
-  typedef list_detail::List1DForwardIter<typename Container::Iterator,
-                                         List,
-                                         DataType> ForwardIterator;
-
   typedef list_detail::List1DIter<typename Container::Iterator,
                                   Indexer,
                                   DataType> Iterator;
+  // walking the container is faster, but only possible if it is in order
+  typedef typename std::conditional<
+    Indexer::kInOrder,
+    list_detail::List1DForwardIter<typename Container::Iterator,
+                                   List,
+                                   DataType>,
+    Iterator>::type ForwardIterator;
   // XXX: change to ConstIterator after adding conversions for FakePointer
   typedef list_detail::List1DIter<typename Container::Iterator,
                                   Indexer,
                                   /* const */ DataType> ConstIterator;
+  typedef std::reverse_iterator<Iterator> ReverseIterator;
 
   // List() : indexer_(portions_) {}
   List(Container&& pv)
@@ -673,15 +1329,99 @@ class List<P, 1, kListOpVector, V_LIST_INDEXER_TYPE>
     container_.Erase(++container_.begin(), container_.end());
   }
 
+  // Inserts a (non-empty) portion constructed from the args before the
+  // index-th portion. This invalidates all iterators.
+  // The portion is put in a slot freed by Erase or appended to the container,
+  // so the other portions are not moved.
+  template<typename... Args>
+  void Insert(size_t index, Args&&... args) {
+    static_assert(flags & kListOpInsMid, "Insertion is not supported");
+    const bool was_empty = container_.empty();
+    assert(index <= portion_count());
+    size_t slot;
+    if (indexer_.PopFreeSlot(&slot)) {
+      container_.Replace(slot, std::forward<Args>(args)...);
+    } else {
+      slot = container_.size();
+      container_.Append(std::forward<Args>(args)...);
+    }
+    assert(container_[slot].size() && "Cannot insert an empty portion");
+    Resize(this->size_ + container_[slot].size());
+    indexer_.Insert(index, slot);
+    if (was_empty) {
+      AppendDummy(container_);
+      indexer_.Insert(1, 1);
+    }
+  }
+
+  // Erases the index-th portion. This invalidates all iterators.
+  void Erase(size_t index) {
+    static_assert(flags & kListOpDelMid, "Erasure is not supported");
+    assert(index < portion_count());
+    const size_t slot = indexer_.slot(index);
+    Resize(this->size_ - container_[slot].size());
+    indexer_.Erase(index);
+    if (indexer_.fwd().bucket_count() == 1) {  // only the dummy is left
+      container_.Erase(container_.begin(), container_.end());
+      indexer_.Clear();
+    } else {
+      container_.reset(slot, nullptr);
+    }
+  }
+
+  // Returns the number of portions (excluding the dummy portion).
+  size_t portion_count() const {
+    const size_t bucket_count = indexer_.fwd().bucket_count();
+    return bucket_count - !!bucket_count;
+  }
+
   inline void set(const DataType& value, const size_t& index) const {
     const_cast<DataType&>(this->get(index)) = value;
   }
 
   inline const DataType& get(const size_t& index) const {
-    auto pos = indexer_.fwd().get(index);
+    auto pos = indexer_.locate(index);
     return container_[pos.first].get(pos.second);
   }
 
+  // A finger into the list that remembers the portion of the last accessed
+  // element, so that accessing nearby elements is faster than via get()
+  class Cursor {
+   public:
+    explicit Cursor(const List& list)
+        : list_(&list),
+          finger_(list.indexer_.cursor()) {}
+
+    DataType& seek(const size_t& index) {
+      auto pos = finger_.seek(index);
+      return const_cast<DataType&>(list_->container_[pos.first].get(
+          pos.second));
+    }
+
+   private:
+    const List* list_;
+    typename Indexer::Cursor finger_;
+  };
+
+  Cursor cursor() const { return Cursor(*this); }
+
+  // Copies the elements at the indexes to out, and returns the output iterator
+  // past the last copied element. This is faster than calling get() for each
+  // index, since the lookups in the skip list are batched (see get_batch).
+  template<class OutputIterator>
+  OutputIterator gather(const std::vector<size_t>& indexes,
+                        OutputIterator out) const {
+    constexpr size_t kChunkSize = 64;
+    typename Indexer::Position positions[kChunkSize];
+    for (size_t from = 0; from < indexes.size(); from += kChunkSize) {
+      const size_t count = std::min(indexes.size() - from, kChunkSize);
+      indexer_.locate_batch(indexes.data() + from, count, positions);
+      for (size_t i = 0; i < count; ++i, ++out)
+        *out = container_[positions[i].first].get(positions[i].second);
+    }
+    return out;
+  }
+
   DataType& get(SizeArray&& indexes) const override {
     return const_cast<DataType&>(this->get(indexes.front()));
   }
@@ -689,17 +1429,36 @@ class List<P, 1, kListOpVector, V_LIST_INDEXER_TYPE>
     set(value, indexes.front());
   }
 
+  void ForEachSpan(const typename ListBase<DataType>::SpanVisitor& visitor)
+      const override {
+    // skip the sentinel portion at the back
+    indexer_.ForEachSlot(portion_count(), [this, &visitor](size_t slot) {
+        container_[slot].ForEachSpan(visitor);
+      });
+  }
+
+  void ForEachEntry(const typename ListBase<DataType>::EntryVisitor& visitor)
+      const override {
+    SizeArray indexes{{0}};
+    for (auto it = begin(), it_end = end(); it != it_end; ++it, ++indexes[0])
+      visitor(indexes, *it);
+  }
+
+  void AppendLineRuns(const SizeArray&, size_t start,
+                      RunVector<DataType>* runs) const override {
+    for (const auto& segment : this->segments())
+      AppendRun(start + segment.offset, segment.size, segment.data, false,
+                runs);
+  }
+
   inline size_t max_size() const { return container_.max_size(); }
 
   ForwardIterator begin() const {
-    return ForwardIterator(const_cast<Container&>(container_).begin(), *this);
+    return begin(std::integral_constant<bool, Indexer::kInOrder>());
   }
 
   ForwardIterator end() const {
-    auto it = const_cast<Container&>(container_).end();
-    if (this->size_)
-      --it;
-    return ForwardIterator(it, *this);
+    return end(std::integral_constant<bool, Indexer::kInOrder>());
   }
 
   Iterator lbegin() const {
@@ -711,19 +1470,40 @@ class List<P, 1, kListOpVector, V_LIST_INDEXER_TYPE>
                     indexer_);
   }
 
+  ReverseIterator rbegin() const { return ReverseIterator(lend()); }
+  ReverseIterator rend() const { return ReverseIterator(lbegin()); }
+
   const List& values() const override { return *this; }
 
  protected:
   typename View<DataType>::Iterator iterator_begin() const override {
-    return new ForwardIterator(this->begin());
+    return ForwardIterator(this->begin());
   }
 
   // overrides View<DataType>::Iterator to provide O(1) time complexity
   typename View<DataType>::Iterator iterator_end() const override {
-    return new ForwardIterator(this->end());
+    return ForwardIterator(this->end());
   }
 
  private:
+  void Resize(size_t size) {
+    this->size_ = this->sizes_[0] = size;
+  }
+
+  ForwardIterator begin(std::true_type in_order) const {
+    return ForwardIterator(const_cast<Container&>(container_).begin(), *this);
+  }
+
+  ForwardIterator end(std::true_type in_order) const {
+    auto it = const_cast<Container&>(container_).end();
+    if (this->size_)
+      --it;
+    return ForwardIterator(it, *this);
+  }
+
+  ForwardIterator begin(std::false_type in_order) const { return lbegin(); }
+  ForwardIterator end(std::false_type in_order) const { return lend(); }
+
   static Container& AppendDummy(Container& container) {
     // put a sentinel empty portion at the back
     if (container.size())
@@ -857,6 +1637,12 @@ class List<void, dims, kListNoFlags, Accessor, T>
     return this->get0(std::move(indexes), cpp14::make_index_sequence<dims>());
   }
 
+  // there are no stored values to visit (consistent with values())
+  void ForEachSpan(const typename ListBase<T, dims>::SpanVisitor&)
+      const override {}
+  void ForEachEntry(const typename ListBase<T, dims>::EntryVisitor&)
+      const override {}
+
   Accessor& accessor() { return accessor_; }
   const Accessor& accessor() const { return accessor_; }
 
@@ -890,13 +1676,13 @@ class List<void, dims, kListNoFlags, Accessor, T>
   }
 
   template<size_t... Is>
-  Iterator* begin(cpp14::index_sequence<Is...>) const {
-    return new Iterator(this, list_detail::ZeroSize<Is>()...);
+  Iterator begin(cpp14::index_sequence<Is...>) const {
+    return Iterator(this, list_detail::ZeroSize<Is>()...);
   }
 
   template<size_t I, size_t... Is>
-  Iterator* end(cpp14::index_sequence<I, Is...>) const {
-    return new Iterator(this, sizes_.front(), list_detail::ZeroSize<Is>()...);
+  Iterator end(cpp14::index_sequence<I, Is...>) const {
+    return Iterator(this, sizes_.front(), list_detail::ZeroSize<Is>()...);
   }
 
   Accessor accessor_;
@@ -0,0 +1,70 @@
+#ifndef CPPVIEWS_SRC_PARALLEL_HPP_
+#define CPPVIEWS_SRC_PARALLEL_HPP_
+
+#include "util/thread_pool.hpp"
+
+#include <functional>
+#include <future>
+#include <vector>
+
+#include <cstddef>
+
+namespace v {
+
+namespace parallel {
+
+// Returns the pool that is used if none is passed (one thread per core)
+inline ThreadPool& DefaultThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+// Parallel versions of std algorithms over values that support partition()
+// (e.g., the values() of Chain or Diag), each of which splits them into one
+// range per thread of the pool and processes the ranges concurrently
+
+template<class Values, class Func>
+void ForEach(const Values& values, Func func, ThreadPool* pool = nullptr) {
+  if (pool == nullptr)
+    pool = &DefaultThreadPool();
+  std::vector<std::future<void> > done;
+  for (const auto& range : values.partition(pool->size()))
+    done.push_back(pool->Submit([&func, range] {
+          for (auto it = range.first; it != range.second; ++it)
+            func(*it);
+        }));
+  // wait for all before rethrowing any exception (func is shared)
+  for (auto& part_done : done)
+    part_done.wait();
+  for (auto& part_done : done)
+    part_done.get();
+}
+
+// Combines init and the values via op, which has to be associative
+// (but not necessarily commutative, since the order of values is preserved)
+template<class Values, typename V, class BinaryOp = std::plus<V> >
+V Reduce(const Values& values, V init, BinaryOp op = BinaryOp(),
+         ThreadPool* pool = nullptr) {
+  if (pool == nullptr)
+    pool = &DefaultThreadPool();
+  std::vector<std::future<V> > partial_results;
+  for (const auto& range : values.partition(pool->size()))
+    partial_results.push_back(pool->Submit([&op, range] {
+          auto it = range.first;  // the range is not empty
+          V result = *it;
+          while (++it != range.second)
+            result = op(result, *it);
+          return result;
+        }));
+  for (auto& partial_result : partial_results)
+    partial_result.wait();
+  for (auto& partial_result : partial_results)
+    init = op(init, partial_result.get());
+  return init;
+}
+
+}  // namespace parallel
+
+}  // namespace v
+
+#endif  /* CPPVIEWS_SRC_PARALLEL_HPP_ */
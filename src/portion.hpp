@@ -2,9 +2,11 @@
 #ifndef CPPVIEWS_SRC_PORTION_HPP_
 #define CPPVIEWS_SRC_PORTION_HPP_
 
+#include "segment.hpp"
 #include "util/iterator.hpp"
 
 #include <deque>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <limits>
@@ -37,6 +39,21 @@ class PortionBase {
 
   size_t dim_size(unsigned dim) const { return size(); }  // used by List
 
+  typedef std::function<void(T*, size_t)> SpanVisitor;
+
+  // Visits the values as contiguous spans (by default, one value at a time)
+  virtual void ForEachSpan(const SpanVisitor& visitor) const {
+    for (size_t i = 0, n = size(); i < n; ++i)
+      visitor(&get(i), 1);
+  }
+
+  // Appends the contiguous spans of values (merging adjacent ones)
+  void AppendSegments(SegmentVector<T>* segments) const {
+    ForEachSpan([segments](T* data, size_t size) {
+        AppendSegment(data, size, segments);
+      });
+  }
+
   Iterator begin() const { return Iterator(*this, 0); }
   Iterator end() const { return Iterator(*this, size()); }
 };
@@ -81,7 +98,22 @@ class Portion : public PortionBase<T> {
   Iterator begin() const { return begin_; }
   Iterator end() const { return std::next(begin_, size_); }
 
+  void ForEachSpan(const typename PortionBase<T>::SpanVisitor& visitor)
+      const override {
+    ForEachSpan(visitor, IsContiguousIter<ForwardIter>());
+  }
+
  private:
+  void ForEachSpan(const typename PortionBase<T>::SpanVisitor& visitor,
+                   std::true_type) const {
+    if (size_)
+      visitor(&*begin_, size_);
+  }
+  void ForEachSpan(const typename PortionBase<T>::SpanVisitor& visitor,
+                   std::false_type) const {
+    PortionBase<T>::ForEachSpan(visitor);
+  }
+
   ForwardIter begin_;
   DiffType size_;
 };
@@ -225,6 +257,9 @@ class Portion<void, T> : public PortionBase<T> {
   size_t size() const override { return 1; }
   size_t max_size() const override { return 0; }
 
+  void ForEachSpan(const typename PortionBase<T>::SpanVisitor&)
+      const override {}
+
   static Portion* instance() noexcept {
     static Portion kInstance;
     return &kInstance;
@@ -0,0 +1,46 @@
+#ifndef CPPVIEWS_SRC_RUN_HPP_
+#define CPPVIEWS_SRC_RUN_HPP_
+
+#include <vector>
+
+#include <cstddef>
+
+namespace v {
+
+// A run of length consecutive elements (in row-major order) starting at the
+// linearized index start, which are either all equal to *value (repeated, e.g.,
+// a stretch of default values), or stored contiguously from value onward
+template<typename T>
+struct Run {
+  T& operator[](size_t pos) const { return repeated ? *value : value[pos]; }
+
+  size_t start;
+  size_t length;
+  T* value;
+  bool repeated;
+};
+
+template<typename T>
+using RunVector = std::vector<Run<T> >;
+
+// Appends a run after the last one, and merges them into one if possible
+// (i.e., both repeat the same value, or their values are adjacent in memory).
+template<typename T>
+void AppendRun(size_t start, size_t length, T* value, bool repeated,
+               RunVector<T>* runs) {
+  if (!length)
+    return;
+  if (!runs->empty()) {
+    Run<T>& last = runs->back();
+    if (last.start + last.length == start && last.repeated == repeated &&
+        (repeated ? last.value == value : last.value + last.length == value)) {
+      last.length += length;
+      return;
+    }
+  }
+  runs->push_back(Run<T>{start, length, value, repeated});
+}
+
+}  // namespace v
+
+#endif  /* CPPVIEWS_SRC_RUN_HPP_ */
@@ -0,0 +1,110 @@
+#ifndef CPPVIEWS_SRC_SEGMENT_HPP_
+#define CPPVIEWS_SRC_SEGMENT_HPP_
+
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+
+namespace v {
+
+// A contiguous span of values [data, data + size), which starts at position
+// offset in the iteration order of the values (i.e., values() of a list)
+template<typename T>
+struct Segment {
+  T* begin() const { return data; }
+  T* end() const { return data + size; }
+
+  T* data;
+  size_t size;
+  size_t offset;
+};
+
+template<typename T>
+using SegmentVector = std::vector<Segment<T> >;
+
+// Appends the span [data, data + size) after the last segment, and merges
+// them into one if they are adjacent in memory.
+template<typename T>
+void AppendSegment(T* data, size_t size, SegmentVector<T>* segments) {
+  if (!size)
+    return;
+  if (segments->empty()) {
+    segments->push_back(Segment<T>{data, size, 0});
+    return;
+  }
+  Segment<T>& last = segments->back();
+  if (last.end() == data)
+    last.size += size;
+  else
+    segments->push_back(Segment<T>{data, size, last.offset + last.size});
+}
+
+// Visits the values in [first, last) as the maximal spans of values adjacent in
+// memory, i.e., calls visitor(data, size) once per span
+template<class ForwardIter, class SpanVisitor>
+void ForEachAdjacentSpan(ForwardIter first, ForwardIter last,
+                         SpanVisitor&& visitor) {
+  typedef typename std::remove_reference<decltype(*first)>::type T;
+  T* data = nullptr;
+  size_t size = 0;
+  for (; first != last; ++first) {
+    T* value = &*first;
+    if (value != data + size) {
+      if (size)
+        visitor(data, size);
+      data = value;
+      size = 0;
+    }
+    ++size;
+  }
+  if (size)
+    visitor(data, size);
+}
+
+template<typename T>
+size_t SegmentedSize(const SegmentVector<T>& segments) {
+  return segments.empty() ? 0 : segments.back().offset + segments.back().size;
+}
+
+// Segment-aware versions of std algorithms, each of which processes the spans
+// in a tight loop that can be vectorized (which the standard library already
+// turns into memmove when copying trivial types into a pointer)
+
+template<typename T, class OutputIter>
+OutputIter SegmentedCopy(const SegmentVector<T>& segments, OutputIter out) {
+  for (const auto& segment : segments)
+    out = std::copy(segment.begin(), segment.end(), out);
+  return out;
+}
+
+template<typename T, typename V>
+void SegmentedFill(const SegmentVector<T>& segments, const V& value) {
+  for (const auto& segment : segments)
+    std::fill(segment.begin(), segment.end(), value);
+}
+
+template<typename T, typename V>
+V SegmentedAccumulate(const SegmentVector<T>& segments, V init) {
+  for (const auto& segment : segments)
+    init = std::accumulate(segment.begin(), segment.end(), init);
+  return init;
+}
+
+// Returns the position of the first value equal to the given one
+// (or SegmentedSize(segments) if there is none)
+template<typename T, typename V>
+size_t SegmentedFind(const SegmentVector<T>& segments, const V& value) {
+  for (const auto& segment : segments) {
+    T* it = std::find(segment.begin(), segment.end(), value);
+    if (it != segment.end())
+      return segment.offset + (it - segment.begin());
+  }
+  return SegmentedSize(segments);
+}
+
+}  // namespace v
+
+#endif  /* CPPVIEWS_SRC_SEGMENT_HPP_ */
@@ -2,12 +2,20 @@
 #define CPPVIEWS_SRC_SPARSE_LIST_HPP_
 
 #include "list.hpp"
+#include "util/bit_twiddling.hpp"
 #include "util/intseq.hpp"
 #include "util/iterator.hpp"
+#include "util/morton.hpp"
+#include "util/occupancy.hpp"
+#include "util/robin_hood_map.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstdint>
 #include <map>
+#include <numeric>
+#include <vector>
 
 namespace v {
 
@@ -18,42 +26,53 @@ struct SparseListTag {};
 template<typename T, unsigned dims>
 using SparseHashList = List<void, dims, kListOpMutable, void, T>;
 
+struct SparseCsrTag {};
+
+// A read-only matrix that stores the values other than default row by row,
+// along with their column indexes (i.e., in the CSR format)
+template<typename T>
+using SparseCsrList = List<SparseCsrTag, 2, kListOpVector, T, void>;
+
+struct SparseMortonTag {};
+
+// A sparse matrix that keeps the values other than default sorted by the
+// Morton (Z-order) keys of their indexes, so that the nearby values are close
+// in the order, and those in a rectangular range can be found quickly
+template<typename T>
+using SparseMortonList = List<SparseMortonTag, 2, kListOpMutable, T, void>;
+
+// Iterates over the values of the map in the order given by their insertion
+// indexes (i.e., sorted by their keys)
 template<class MapType>
 class SparseListForwardIter
     : public DefaultIterator<SparseListForwardIter<MapType>,
                              std::forward_iterator_tag,
-                             typename MapType::mapped_type>,
-      public View<typename MapType::mapped_type>::IteratorBase {
+                             typename MapType::iterator::value_type>,
+      public View<typename MapType::iterator::value_type>::IteratorBase {
 
   V_DEFAULT_ITERATOR_DERIVED_HEAD(SparseListForwardIter);
-  template<typename> friend class SparseListForwardIter;
 
-  using Enabler = typename SparseListForwardIter::Enabler;
-  using DataType = typename MapType::mapped_type;
+  using DataType = typename MapType::iterator::value_type;
 
  public:
-  template<typename DataType2>
-  SparseListForwardIter(const SparseListForwardIter<DataType2>& other,
-                        EnableIfIterConvertible<DataType2, DataType,
-                        Enabler> = Enabler()) {}
-
-  SparseListForwardIter(typename MapType::iterator it)
-      : it_(std::move(it)) {}
+  SparseListForwardIter(MapType* map, const uint32_t* index)
+      : map_(map),
+        index_(index) {}
 
  protected:
   V_DEF_VIEW_ITER_IS_EQUAL(DataType, SparseListForwardIter);
 
-  template<typename DataType2>
-  bool IsEqual(const SparseListForwardIter<DataType2>& other) const {
-    return true;  // conforms to C++ spec. (this->it_ == other.it_ is no better)
+  bool IsEqual(const SparseListForwardIter& other) const {
+    return index_ == other.index_;
   }
 
-  void Increment() override { ++it_; }
+  void Increment() override { ++index_; }
 
-  DataType& ref() const override { return it_->second; }
+  DataType& ref() const override { return map_->value(*index_); }
 
  private:
-  typename MapType::iterator it_;
+  MapType* map_;
+  const uint32_t* index_;
 };
 
 template<typename T, unsigned dims>
@@ -64,22 +83,112 @@ class List<void, dims, kListOpMutable, void, T>
   using typename ListBaseType::SizeArray;
   using ListBaseType::kDims;
 
-  // template<typename E>
-  // struct Get2ndTransformer {
-  //   auto operator=(const E& e) -> decltype(e.second) { return e.second; }
-  // };
+  // Hashes the indexes by packing them into 64 bits, giving each as many bits
+  // as its size has (the last index the lowest), which is injective if the
+  // sizes allow it; otherwise, the indexes are mixed (and may collide, so the
+  // map compares the indexes as well)
+  class KeyHash {
+   public:
+    explicit KeyHash(const SizeArray& sizes) {
+      unsigned shift = 0;
+      for (unsigned dim = dims; dim--; shift += FindFirstSet(sizes[dim]))
+        shifts_[dim] = shift;
+      packed_ = shift <= 64;
+    }
+    KeyHash() = default;
+
+    uint64_t operator()(const SizeArray& indexes) const {
+      uint64_t hash = 0;
+      if (packed_) {
+        for (unsigned dim = 0; dim < dims; ++dim)
+          hash |= uint64_t(indexes[dim]) << shifts_[dim];
+      } else {
+        for (unsigned dim = 0; dim < dims; ++dim) {
+          hash = (hash ^ indexes[dim]) * UINT64_C(0xFF51AFD7ED558CCD);
+          hash ^= hash >> 32;
+        }
+      }
+      return hash;
+    }
+
+    bool packed() const { return packed_; }
 
-  using MapType = std::map<std::array<size_t, dims>, T>;
+   private:
+    std::array<unsigned, dims> shifts_;
+    bool packed_;
+  };
+
+  using MapType = RobinHoodMap<T, SizeArray, KeyHash>;
 
  public:
   using ForwardIterator = SparseListForwardIter<MapType>;
 
+  // the stored values, in row-major order (kept up to date by get())
+  class ValuesView : public View<T> {
+   public:
+    typedef ForwardIterator Iterator;
+
+    ValuesView(const List* list)
+        : View<T>(list->map_.size()),
+          list_(list) {}
+    typename View<T>::Iterator iterator_begin() const {
+      return Iterator(begin());
+    }
+    typename View<T>::Iterator iterator_end() const {
+      return Iterator(end());
+    }
+    Iterator begin() const { return list_->begin(); }
+    Iterator end() const { return list_->end(); }
+
+   private:
+    const List* list_;
+  };
+
   // TODO use SFINAE to enable only if dims == sizeof...(Sizes)
   template<typename... Sizes>
   explicit List(SparseListTag<sizeof...(Sizes)>,
        T* default_value,
        Sizes&&... sizes)
-      : ListBaseType(std::forward<Sizes>(sizes)...) {
+      : ListBaseType(std::forward<Sizes>(sizes)...),
+        map_(0, KeyHash(this->sizes_)),
+        default_val_(default_value),
+        values_view_(this) {}
+
+  // the values view has to point to the copied/moved values
+  List(const List& src)
+      : ListBaseType(src),
+        map_(src.map_),
+        sorted_(src.sorted_),
+        default_val_(src.default_val_),
+        filter_(src.filter_),
+        values_view_(this) {}
+
+  List(List&& src)
+      : ListBaseType(std::move(src)),
+        map_(std::move(src.map_)),
+        sorted_(std::move(src.sorted_)),
+        default_val_(src.default_val_),
+        filter_(std::move(src.filter_)),
+        values_view_(this) {}
+
+  List& operator=(const List& rhs) {
+    ListBaseType::operator=(rhs);
+    map_ = rhs.map_;
+    sorted_ = rhs.sorted_;
+    default_val_ = rhs.default_val_;
+    filter_ = rhs.filter_;
+    values_view_ = ValuesView(this);
+    return *this;
+  }
+
+  List& operator=(List&& rhs) {
+    ListBaseType::operator=(std::move(rhs));
+    map_ = std::move(rhs.map_);
+    sorted_ = std::move(rhs.sorted_);
+    default_val_ = rhs.default_val_;
+    filter_ = std::move(rhs.filter_);
+    values_view_ = ValuesView(this);
+    return *this;
   }
 
   friend List MakeList(List&& list) { return std::forward<List>(list); }
@@ -93,40 +202,622 @@ class List<void, dims, kListOpMutable, void, T>
 
   template<typename... Indexes>
   const T& get(Indexes&&... indexes) const {
-    try {
-      return map_.at(SizeArray{{std::forward<Indexes>(indexes)...}});
-    } catch (const std::out_of_range&) {
-      return *default_val_;
+    const T* value = find(SizeArray{{static_cast<size_t>(indexes)...}});
+    return value != nullptr ? *value : *default_val_;
+  }
+
+  T& get(SizeArray&& indexes) const override {
+    const size_t count = map_.size();
+    T& value = map_[indexes];
+    if (map_.size() != count) {
+      Filter(map_.hash(indexes));
+      Sort(count);
+      values_view_ = ValuesView(this);
+    }
+    return value;
+  }
+
+  // Returns the value without inserting it, or nullptr if there is none
+  // (consults a Bloom filter of the indexes of the values first, so that most
+  // reads of the default value skip the lookup in the hash map)
+  T* find(const SizeArray& indexes) const {
+    const uint64_t hash = map_.hash(indexes);
+    if (!filter_.MayContain(hash))
+      return nullptr;
+    return map_.find(indexes, hash);
+  }
+
+  // Returns the number of bytes used by the occupancy filter
+  size_t occupancy_memory_usage() const { return filter_.memory_usage(); }
+
+  // (the values are visited in row-major order, like by std::map, merging
+  // those adjacent in memory, i.e., inserted one after another in that order)
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    ForEachAdjacentSpan(begin(), end(), visitor);
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    for (const auto& index : sorted())
+      visitor(map_.key(index), map_.value(index));
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<T>* runs) const override {
+    // the indexes are sorted in row-major order, so the line is contiguous
+    SizeArray first(indexes);
+    first.back() = 0;
+    const size_t line_size = this->sizes_.back();
+    const auto& sorted = this->sorted();
+    size_t cur = 0;  // the next index in the last dimension
+    for (auto it = std::lower_bound(sorted.begin(), sorted.end(), first,
+                                    [this](uint32_t index,
+                                           const SizeArray& indexes) {
+                                      return map_.key(index) < indexes;
+                                    });
+         it != sorted.end() && std::equal(first.begin(), first.end() - 1,
+                                          map_.key(*it).begin()); ++it) {
+      const size_t index = map_.key(*it).back();
+      AppendRun(start + cur, index - cur, default_val_, true, runs);
+      AppendValueRun(start + index, &map_.value(*it), runs);
+      cur = index + 1;
     }
+    AppendRun(start + cur, line_size - cur, default_val_, true, runs);
   }
 
-  T& get(SizeArray&& indexes) const override { return map_[indexes]; }
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<T>* runs) const override {
+    if (dim >= dims - 1)
+      return AppendLineRuns(indexes, start, runs);
+    // look up each element instead of get(), which would insert it
+    SizeArray cur_indexes(indexes);
+    const size_t line_size = this->sizes_[dim];
+    size_t cur = 0;  // the next index in dimension dim
+    for (size_t index = 0; index < line_size; ++index) {
+      cur_indexes[dim] = index;
+      T* value = find(cur_indexes);
+      if (value == nullptr)
+        continue;
+      AppendRun(start + cur, index - cur, default_val_, true, runs);
+      AppendValueRun(start + index, value, runs);
+      cur = index + 1;
+    }
+    AppendRun(start + cur, line_size - cur, default_val_, true, runs);
+  }
 
-  const List& values() const override { return *this; }
+  const ValuesView& values() const override { return values_view_; }
 
   size_t nondefault_count() const { return map_.size(); }
 
-  // non-polymorphic iterators (no dynamic allocation)
+  T* default_value() const override { return default_val_; }
 
-  ForwardIterator begin() const { return ForwardIterator(map_.begin()); }
-  ForwardIterator end() const { return ForwardIterator(map_.end()); }
+  // Returns the equivalent SparseCsrList, which is faster to read
+  SparseCsrList<T> Compact() const {
+    static_assert(dims == 2, "Not a matrix");
+    return SparseCsrList<T>(*this);
+  }
+
+  // non-polymorphic iterators (no dynamic allocation), which iterate in
+  // row-major order and are invalidated by get() of a new value
+
+  ForwardIterator begin() const {
+    return ForwardIterator(&map_, sorted().data());
+  }
+  ForwardIterator end() const {
+    return ForwardIterator(&map_, sorted().data() + map_.size());
+  }
 
  protected:
 
   // polymorphic iterators
 
   typename View<T>::Iterator iterator_begin() const override {
-    return new ForwardIterator(map_.begin());
+    return begin();
   }
 
   // overrides View<DataType>::Iterator to provide O(1) time complexity
   typename View<T>::Iterator iterator_end() const override {
-    return new ForwardIterator(map_.end());
+    return end();
   }
 
  private:
+  // Appends a run of a single stored value, never merging it with the previous
+  // one since the values are adjacent in memory only by insertion order
+  static void AppendValueRun(size_t start, T* value, RunVector<T>* runs) {
+    runs->push_back(Run<T>{start, 1, value, false});
+  }
+
+  // Returns the insertion indexes sorted by key (i.e., in row-major order)
+  const std::vector<uint32_t>& sorted() const { return sorted_; }
+
+  // Inserts the insertion index of a new value into the sorted indexes, which
+  // only appends it if the values are inserted in row-major order (so that
+  // reads neither allocate nor modify the list)
+  void Sort(uint32_t index) const {
+    const SizeArray& key = map_.key(index);
+    if (sorted_.empty() || map_.key(sorted_.back()) < key) {
+      sorted_.push_back(index);
+      return;
+    }
+    sorted_.insert(std::upper_bound(sorted_.begin(), sorted_.end(), key,
+                                    [this](const SizeArray& key,
+                                           uint32_t index) {
+                                      return key < map_.key(index);
+                                    }),
+                   index);
+  }
+
+  // Adds the hash of the indexes of a new value to the filter, or rebuilds a
+  // filter twice as large if it would become too full
+  void Filter(uint64_t hash) const {
+    if (map_.size() > filter_.capacity())
+      RebuildFilter();
+    else
+      filter_.Insert(hash);
+  }
+
+  void RebuildFilter() const {
+    filter_ = BlockedBloomFilter(2 * map_.size());
+    for (size_t index = 0; index < map_.size(); ++index)
+      filter_.Insert(map_.hash(map_.key(index)));
+  }
+
   mutable MapType map_;
+  mutable std::vector<uint32_t> sorted_;
   T* default_val_;
+  mutable BlockedBloomFilter filter_;  // kept up to date by get()
+  mutable ValuesView values_view_;
+};
+
+template<typename T>
+class SparseCsrValueIter
+    : public DefaultIterator<SparseCsrValueIter<T>,
+                             std::forward_iterator_tag, T>,
+      public View<T>::IteratorBase {
+  V_DEFAULT_ITERATOR_DERIVED_HEAD(SparseCsrValueIter);
+
+ public:
+  SparseCsrValueIter(T* value) : value_(value) {}
+
+ protected:
+  V_DEF_VIEW_ITER_IS_EQUAL(T, SparseCsrValueIter)
+
+  bool IsEqual(const SparseCsrValueIter& other) const {
+    return value_ == other.value_;
+  }
+
+  void Increment() override { ++value_; }
+
+  T& ref() const override { return *value_; }
+
+ private:
+  T* value_;
+};
+
+template<typename T>
+class List<SparseCsrTag, 2, kListOpVector, T, void>
+    : public ListBase<T, 2>,
+      public DimIterAccessors<List<SparseCsrTag, 2, kListOpVector, T, void> > {
+  using ListBaseType = ListBase<T, 2>;
+  friend class DimIterAccessors<List>;
+
+ public:
+  using typename ListBaseType::SizeArray;
+
+  class ValuesView : public View<T> {
+   public:
+    typedef SparseCsrValueIter<T> Iterator;
+
+    ValuesView(const List* list)
+        : View<T>(list->values_.size()),
+          list_(list) {}
+    typename View<T>::Iterator iterator_begin() const {
+      return Iterator(begin());
+    }
+    typename View<T>::Iterator iterator_end() const {
+      return Iterator(end());
+    }
+    Iterator begin() const { return list_->values_.data(); }
+    Iterator end() const { return list_->values_.data() + this->size_; }
+
+   private:
+    const List* list_;
+  };
+
+  // iterate over the runs along dimension dim (see Chain)
+  template<unsigned dim>
+  using DimIterator =
+      typename ListBaseType::template RunDimIter<T, dim>;
+  template<unsigned dim>
+  using ConstDimIterator =
+      typename ListBaseType::template RunDimIter<const T, dim>;
+  template<unsigned dim>
+  using NonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<T, dim, true>;
+  template<unsigned dim>
+  using ConstNonDefaultDimIterator =
+      typename ListBaseType::template RunDimIter<const T, dim, true>;
+  template<unsigned dim>
+  using EntryDimIterator =
+      typename ListBaseType::template RunEntryDimIter<T, dim>;
+  template<unsigned dim>
+  using ConstEntryDimIterator =
+      typename ListBaseType::template RunEntryDimIter<const T, dim>;
+
+  // Copies the values of the sparse list, which are visited in row-major order
+  explicit List(const SparseHashList<T, 2>& src)
+      : ListBaseType(src.sizes()[0], src.sizes()[1]),
+        row_ptrs_(src.sizes()[0] + 1),
+        default_value_(src.default_value()),
+        values_view_(this) {
+    assert(src.sizes()[1] <= uint32_t(-1) && "Too many columns");
+    cols_.reserve(src.nondefault_count());
+    values_.reserve(src.nondefault_count());
+    src.ForEachEntry([this](const SizeArray& indexes, T& value) {
+        ++row_ptrs_[indexes[0] + 1];
+        cols_.push_back(indexes[1]);
+        values_.push_back(value);
+      });
+    std::partial_sum(row_ptrs_.begin(), row_ptrs_.end(), row_ptrs_.begin());
+    values_view_ = ValuesView(this);
+  }
+
+  // used by MakeList
+  List(SparseCsrTag, const SparseHashList<T, 2>& src) : List(src) {}
+
+  // the values view has to point to the copied/moved values
+  List(const List& src)
+      : ListBaseType(src),
+        row_ptrs_(src.row_ptrs_),
+        cols_(src.cols_),
+        values_(src.values_),
+        default_value_(src.default_value_),
+        values_view_(this) {}
+
+  List(List&& src)
+      : ListBaseType(std::move(src)),
+        row_ptrs_(std::move(src.row_ptrs_)),
+        cols_(std::move(src.cols_)),
+        values_(std::move(src.values_)),
+        default_value_(src.default_value_),
+        values_view_(this) {}
+
+  List& operator=(const List& rhs) {
+    ListBaseType::operator=(rhs);
+    row_ptrs_ = rhs.row_ptrs_;
+    cols_ = rhs.cols_;
+    values_ = rhs.values_;
+    default_value_ = rhs.default_value_;
+    values_view_ = ValuesView(this);
+    return *this;
+  }
+
+  List& operator=(List&& rhs) {
+    ListBaseType::operator=(std::move(rhs));
+    row_ptrs_ = std::move(rhs.row_ptrs_);
+    cols_ = std::move(rhs.cols_);
+    values_ = std::move(rhs.values_);
+    default_value_ = rhs.default_value_;
+    values_view_ = ValuesView(this);
+    return *this;
+  }
+
+  friend List MakeList(List&& list) { return std::forward<List>(list); }
+
+  // Looks up the value by binary search through the row (no value is inserted)
+  T& operator()(size_t row, size_t col) const {
+    const size_t k = Find(row, col);
+    return k == size_t(-1) ? *default_value_ : values_[k];
+  }
+
+  T& get(SizeArray&& indexes) const override {
+    return operator()(indexes[0], indexes[1]);
+  }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    if (!values_.empty())
+      visitor(values_.data(), values_.size());
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    SizeArray indexes;
+    for (indexes[0] = 0; indexes[0] < this->sizes_[0]; ++indexes[0]) {
+      for (size_t k = row_ptrs_[indexes[0]]; k < row_ptrs_[indexes[0] + 1];
+           ++k) {
+        indexes[1] = cols_[k];
+        visitor(indexes, values_[k]);
+      }
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<T>* runs) const override {
+    // the values in consecutive columns are adjacent, so they form one run
+    const size_t row = indexes[0];
+    size_t cur = 0;  // the next column
+    for (size_t k = row_ptrs_[row]; k < row_ptrs_[row + 1]; ++k) {
+      AppendRun(start + cur, cols_[k] - cur, default_value_, true, runs);
+      AppendRun(start + cols_[k], 1, &values_[k], false, runs);
+      cur = cols_[k] + 1;
+    }
+    AppendRun(start + cur, this->sizes_[1] - cur, default_value_, true, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<T>* runs) const override {
+    if (dim)
+      return AppendLineRuns(indexes, start, runs);
+    const size_t col = indexes[1];
+    size_t cur = 0;  // the next row
+    for (size_t row = 0; row < this->sizes_[0]; ++row) {
+      const size_t k = Find(row, col);
+      if (k == size_t(-1))
+        continue;
+      AppendRun(start + cur, row - cur, default_value_, true, runs);
+      AppendRun(start + row, 1, &values_[k], false, runs);
+      cur = row + 1;
+    }
+    AppendRun(start + cur, this->sizes_[0] - cur, default_value_, true, runs);
+  }
+
+  const ValuesView& values() const override { return values_view_; }
+  T* default_value() const override { return default_value_; }
+
+  size_t nondefault_count() const { return values_.size(); }
+
+  // Computes y = A x, where A is this matrix (see MultiplyAdd)
+  void Multiply(const T* x, T* y) const {
+    std::fill(y, y + this->sizes_[0], T());
+    MultiplyAdd(x, y);
+  }
+
+  // Computes y += A x, where A is this matrix (x and y must hold as many
+  // values as A has columns and rows, respectively)
+  void MultiplyAdd(const T* x, T* y) const {
+    const bool default_zero = default_value_ == nullptr ||
+        *default_value_ == T();
+    T x_sum = T();
+    if (!default_zero)
+      for (size_t c = 0; c < this->sizes_[1]; ++c)
+        x_sum += x[c];
+    for (size_t r = 0; r < this->sizes_[0]; ++r) {
+      T sum = T();
+      T nondefault_x_sum = T();
+      for (size_t k = row_ptrs_[r]; k < row_ptrs_[r + 1]; ++k) {
+        sum += values_[k] * x[cols_[k]];
+        if (!default_zero)
+          nondefault_x_sum += x[cols_[k]];
+      }
+      if (!default_zero)
+        sum += *default_value_ * (x_sum - nondefault_x_sum);
+      y[r] += sum;
+    }
+  }
+
+  typename View<T>::Iterator iterator_begin() const override {
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<T>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+ private:
+  // Returns the position of the value at (row, col), or -1 if it is default
+  size_t Find(size_t row, size_t col) const {
+    const auto first = cols_.begin() + row_ptrs_[row];
+    const auto last = cols_.begin() + row_ptrs_[row + 1];
+    const auto it = std::lower_bound(first, last, col);
+    return it != last && *it == col ? it - cols_.begin() : size_t(-1);
+  }
+
+  std::vector<size_t> row_ptrs_;  // the position of the first value of each row
+  std::vector<uint32_t> cols_;  // the column of each value (sorted by row)
+  mutable std::vector<T> values_;
+  T* default_value_;
+  ValuesView values_view_;
+};
+
+template<class MapType>
+class SparseMortonForwardIter
+    : public DefaultIterator<SparseMortonForwardIter<MapType>,
+                             std::forward_iterator_tag,
+                             typename MapType::mapped_type>,
+      public View<typename MapType::mapped_type>::IteratorBase {
+  V_DEFAULT_ITERATOR_DERIVED_HEAD(SparseMortonForwardIter);
+
+  using DataType = typename MapType::mapped_type;
+
+ public:
+  SparseMortonForwardIter(typename MapType::iterator it)
+      : it_(std::move(it)) {}
+
+ protected:
+  V_DEF_VIEW_ITER_IS_EQUAL(DataType, SparseMortonForwardIter)
+
+  bool IsEqual(const SparseMortonForwardIter& other) const {
+    return it_ == other.it_;
+  }
+
+  void Increment() override { ++it_; }
+
+  DataType& ref() const override { return it_->second; }
+
+ private:
+  typename MapType::iterator it_;
+};
+
+template<typename T>
+class List<SparseMortonTag, 2, kListOpMutable, T, void>
+    : public ListBase<T, 2> {
+  using ListBaseType = ListBase<T, 2>;
+  using MapType = std::map<uint64_t, T>;
+
+ public:
+  using typename ListBaseType::SizeArray;
+  using ForwardIterator = SparseMortonForwardIter<MapType>;
+
+  // the stored values, in Morton order (refreshed by each values() call,
+  // since get() may insert values after it)
+  class ValuesView : public View<T> {
+   public:
+    typedef ForwardIterator Iterator;
+
+    ValuesView(const List* list)
+        : View<T>(list->map_.size()),
+          list_(list) {}
+    typename View<T>::Iterator iterator_begin() const {
+      return Iterator(begin());
+    }
+    typename View<T>::Iterator iterator_end() const {
+      return Iterator(end());
+    }
+    Iterator begin() const { return list_->begin(); }
+    Iterator end() const { return list_->end(); }
+
+   private:
+    const List* list_;
+  };
+
+  List(T* default_value, size_t row_count, size_t col_count)
+      : ListBaseType(row_count, col_count),
+        default_val_(default_value),
+        values_view_(this) {
+    assert(row_count <= uint64_t(1) << 32 && col_count <= uint64_t(1) << 32 &&
+           "The indexes do not fit in 32 bits");
+  }
+
+  // used by MakeList
+  template<typename... Args>
+  List(SparseMortonTag, Args&&... args) : List(std::forward<Args>(args)...) {}
+
+  friend List MakeList(List&& list) { return std::forward<List>(list); }
+
+  // Returns the value without inserting it (see get())
+  const T& operator()(size_t row, size_t col) const {
+    const T* value = find(row, col);
+    return value != nullptr ? *value : *default_val_;
+  }
+
+  T& get(SizeArray&& indexes) const override {
+    return map_[MortonEncode(indexes[0], indexes[1])];
+  }
+
+  // Returns the value without inserting it, or nullptr if there is none
+  T* find(size_t row, size_t col) const {
+    auto it = map_.find(MortonEncode(row, col));
+    return it != map_.end() ? &it->second : nullptr;
+  }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    for (auto& entry : map_)
+      visitor(&entry.second, 1);
+  }
+
+  // Visits the entries in Morton order, like values() (not in row-major order,
+  // which ForEachInRange() over each row gives, or the runs)
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    for (auto& entry : map_)
+      visitor(Indexes(entry.first), entry.second);
+  }
+
+  // Visits the entries in [from[0], to[0]) x [from[1], to[1]) in Morton order,
+  // skipping each stretch of the keys outside of the range by looking up
+  // BIGMIN in O(log n) time, unless the range resumes within the next
+  // kRangeScanLength keys, which are scanned first (so it takes
+  // O((log n) (k + 1)) time, where k is the number of the stretches, which is
+  // at most the number of rows in the range)
+  template<class Visitor>
+  void ForEachInRange(const SizeArray& from, const SizeArray& to,
+                      Visitor&& visitor) const {
+    if (from[0] >= to[0] || from[1] >= to[1])
+      return;
+    const uint64_t min_key = MortonEncode(from[0], from[1]);
+    const uint64_t max_key = MortonEncode(to[0] - 1, to[1] - 1);
+    unsigned skipped = 0;  // the keys outside of the range since the last one
+    for (auto it = map_.lower_bound(min_key);
+         it != map_.end() && it->first <= max_key; ) {
+      const SizeArray indexes = Indexes(it->first);
+      if (indexes[0] < from[0] || indexes[0] >= to[0] ||
+          indexes[1] < from[1] || indexes[1] >= to[1]) {
+        if (++skipped <= kRangeScanLength) {
+          ++it;
+        } else {
+          it = map_.lower_bound(MortonBigMin(it->first, min_key, max_key));
+          skipped = 0;
+        }
+        continue;
+      }
+      visitor(indexes, it->second);
+      ++it;
+      skipped = 0;
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<T>* runs) const override {
+    AppendDimRuns(1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<T>* runs) const override {
+    // the Morton order along a row or a column is increasing
+    SizeArray from(indexes), to(indexes);
+    from[dim] = 0;
+    to[dim] = this->sizes_[dim];
+    ++to[!dim];
+    size_t cur = 0;  // the next index in dimension dim
+    ForEachInRange(from, to, [&](const SizeArray& entry_indexes, T& value) {
+        const size_t index = entry_indexes[dim];
+        AppendRun(start + cur, index - cur, default_val_, true, runs);
+        AppendRun(start + index, 1, &value, false, runs);
+        cur = index + 1;
+      });
+    AppendRun(start + cur, this->sizes_[dim] - cur, default_val_, true, runs);
+  }
+
+  const ValuesView& values() const override {
+    values_view_ = ValuesView(this);
+    return values_view_;
+  }
+
+  size_t nondefault_count() const { return map_.size(); }
+
+  T* default_value() const override { return default_val_; }
+
+  // non-polymorphic iterators (no dynamic allocation)
+
+  ForwardIterator begin() const { return ForwardIterator(map_.begin()); }
+  ForwardIterator end() const { return ForwardIterator(map_.end()); }
+
+  typename View<T>::Iterator iterator_begin() const override {
+    return ForwardIterator(map_.begin());
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<T>::Iterator iterator_end() const override {
+    return ForwardIterator(map_.end());
+  }
+
+ private:
+  static SizeArray Indexes(uint64_t key) {
+    return SizeArray{{MortonDecodeRow(key), MortonDecodeCol(key)}};
+  }
+
+  // the number of keys outside of the range that ForEachInRange() steps over
+  // before it looks up BIGMIN (which saves the lookups in sparse ranges, where
+  // the stretches are short, and costs little in dense ones)
+  static constexpr unsigned kRangeScanLength = 8;
+
+  mutable MapType map_;
+  T* default_val_;
+  mutable ValuesView values_view_;
 };
 
 template<typename T, unsigned dims, typename... Sizes>
@@ -136,6 +827,17 @@ auto MakeList(SparseListTag<dims>, T* default_value, Sizes... sizes)
   return V_LIST_TYPE(SparseListTag<dims>(), default_value, sizes...); }
 #undef V_LIST_TYPE
 
+template<typename T>
+SparseMortonList<T> MakeList(SparseMortonTag, T* default_value,
+                             size_t row_count, size_t col_count) {
+  return SparseMortonList<T>(default_value, row_count, col_count);
+}
+
+template<typename T>
+SparseCsrList<T> MakeList(SparseCsrTag, const SparseHashList<T, 2>& src) {
+  return SparseCsrList<T>(src);
+}
+
 }  // namespace v
 
 #endif  /* CPPVIEWS_SRC_SPARSE_LIST_HPP_ */
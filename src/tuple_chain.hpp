@@ -0,0 +1,326 @@
+#ifndef CPPVIEWS_SRC_TUPLE_CHAIN_HPP_
+#define CPPVIEWS_SRC_TUPLE_CHAIN_HPP_
+
+#include "list.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace v {
+
+namespace detail {
+
+// Used in place of the indexer to distinguish the TupleChain specialization
+template<unsigned chain_dim>
+struct ChainedTuple {};
+
+}  // namespace detail
+
+// For the MakeList overload, we need to somehow encode the chaining dimension.
+template<unsigned chain_dim>
+struct TupleChainTag {};
+
+// A Chain of sublists whose (concrete) types are known at compile time, which
+// stores them inline and finds the sublist of an element by binary search over
+// the nesting offsets that is unrolled at compile time, so that get() does not
+// make any virtual calls (unless a sublist does so itself).
+template<unsigned chain_dim, class Sublist, class... Sublists>
+using TupleChain = List<std::tuple<Sublist, Sublists...>,
+                        ListTraits<Sublist>::kDims,
+                        kListOpVector,
+                        detail::ChainedTuple<chain_dim>,
+                        typename Sublist::DataType>;
+
+template<class... Sublists, unsigned dims, unsigned chain_dim, typename T>
+class List<std::tuple<Sublists...>, dims, kListOpVector,
+           detail::ChainedTuple<chain_dim>, T, void>
+    : public ListBase<T, dims> {
+  static_assert(chain_dim < dims, "chain_dim < dims");
+
+  typedef ListBase<T, dims> ListBaseType;
+  typedef std::tuple<Sublists...> Container;
+  static constexpr size_t kListCount = sizeof...(Sublists);
+
+ public:
+  typedef T DataType;
+  typedef typename ListBaseType::SizeArray SizeArray;  // bring to scope
+  typedef std::vector<SizeArray> NestingOffsetVector;
+
+  class ValuesView : public View<DataType> {
+   public:
+    class Iterator
+        : public DefaultIterator<Iterator, std::forward_iterator_tag, DataType>,
+          public View<DataType>::IteratorBase {
+      V_DEFAULT_ITERATOR_DERIVED_HEAD(Iterator);
+      typedef typename View<DataType>::Iterator InnerIter;
+
+     public:
+      Iterator(const List* chain, size_t index, bool end)
+          : chain_(chain),
+            index_(index),
+            inner_cur_(end ? Values().end() : Values().begin()),
+            inner_end_(Values().end()) {
+        if (inner_cur_ == inner_end_)
+          NextInner();
+      }
+
+     protected:
+      V_DEF_VIEW_ITER_IS_EQUAL(DataType, Iterator)
+
+      bool IsEqual(const Iterator& other) const {
+        return index_ == other.index_ && inner_cur_ == other.inner_cur_;
+      }
+
+      void Increment() override {
+        if (++inner_cur_ == inner_end_)
+          NextInner();
+      }
+
+      DataType& ref() const override { return *inner_cur_; }
+
+     private:
+      const View<DataType>& Values() const {
+        return chain_->GetSublist(index_).values();
+      }
+
+      // skips the empty sublists (but stays at the end of the last one)
+      void NextInner() {
+        while (index_ + 1 < kListCount) {
+          ++index_;
+          inner_end_ = Values().end();
+          inner_cur_ = Values().begin();
+          if (inner_cur_ != inner_end_)
+            break;
+        }
+      }
+
+      const List* chain_;
+      size_t index_;
+      InnerIter inner_cur_;
+      InnerIter inner_end_;  // value iterator creation can be expensive
+    };
+
+    ValuesView(const List* chain) : chain_(chain) {
+      this->size_ = 0;
+      for (size_t i = 0; i < kListCount; ++i)
+        this->size_ += chain_->GetSublist(i).values().size();
+    }
+    typename View<DataType>::Iterator iterator_begin() const override {
+      return begin();
+    }
+    typename View<DataType>::Iterator iterator_end() const override {
+      return end();
+    }
+    Iterator begin() const { return Iterator(chain_, 0, false); }
+    Iterator end() const { return Iterator(chain_, kListCount - 1, true); }
+
+   private:
+    const List* chain_;
+  };
+
+  template<typename... Sizes>
+  List(Container&& lists, DataType* default_value,
+       const NestingOffsetVector& nesting_offsets,
+       const size_t& size, Sizes&&... sizes)
+      : ListBaseType(size, std::forward<Sizes>(sizes)...),
+        lists_(std::move(lists)),
+        default_value_(default_value),
+        values_(this) {
+    assert(nesting_offsets.size() == kListCount && "one offset per sublist");
+    std::copy(nesting_offsets.begin(), nesting_offsets.end(),
+              nesting_offsets_.begin());
+  }
+
+  // List(const List&) = delete;  // redundant since values_ points to this
+  List(List&& src)
+      : ListBaseType(std::move(src)),
+        lists_(std::move(src.lists_)),
+        default_value_(src.default_value_),
+        nesting_offsets_(src.nesting_offsets_),
+        values_(this) {}
+
+  // used by MakeList
+  template<typename... Args>
+  List(TupleChainTag<chain_dim>, Args&&... args)
+      : List(std::forward<Args>(args)...) {}
+
+  friend List MakeList(List&& list) {
+    return std::forward<List>(List(std::move(list)));
+  }
+
+  template<typename... Indexes>
+  DataType& operator()(Indexes&&... indexes) const {
+    return Find<0, kListCount - 1>(
+        SizeArray{static_cast<size_t>(indexes)...});
+  }
+
+  DataType& get(SizeArray&& indexes) const override {
+    return Find<0, kListCount - 1>(std::move(indexes));
+  }
+
+  void ForEachSpan(const typename ListBaseType::SpanVisitor& visitor)
+      const override {
+    for (size_t i = 0; i < kListCount; ++i)
+      GetSublist(i).ForEachSpan(visitor);
+  }
+
+  void AppendCoverage(const SizeArray& offset, const DataType* default_value,
+                      std::vector<typename ListBaseType::Box>* boxes)
+      const override {
+    if (default_value != default_value_)
+      return ListBaseType::AppendCoverage(offset, default_value, boxes);
+    for (size_t i = 0; i < kListCount; ++i) {
+      SizeArray nested_offset(offset);
+      for (unsigned dim = 0; dim < dims; ++dim)
+        nested_offset[dim] += nesting_offsets_[i][dim];
+      GetSublist(i).AppendCoverage(nested_offset, default_value, boxes);
+    }
+  }
+
+  void ForEachEntry(const typename ListBaseType::EntryVisitor& visitor)
+      const override {
+    for (size_t i = 0; i < kListCount; ++i) {
+      const SizeArray& offset = nesting_offsets_[i];
+      GetSublist(i).ForEachEntry(
+          [&](const SizeArray& indexes, DataType& value) {
+            SizeArray nested_indexes;
+            for (unsigned dim = 0; dim < dims; ++dim)
+              nested_indexes[dim] = indexes[dim] + offset[dim];
+            visitor(nested_indexes, value);
+          });
+    }
+  }
+
+  void AppendLineRuns(const SizeArray& indexes, size_t start,
+                      RunVector<DataType>* runs) const override {
+    AppendDimRuns(dims - 1, indexes, start, runs);
+  }
+
+  void AppendDimRuns(unsigned dim, const SizeArray& indexes, size_t start,
+                     RunVector<DataType>* runs) const override {
+    // the sublists are ordered along the line if chained in dimension dim
+    // (otherwise, at most one of them intersects it)
+    size_t cur = 0;  // the next index in dimension dim
+    for (size_t i = 0; i < kListCount; ++i) {
+      const ListBaseType& list = GetSublist(i);
+      const SizeArray& offset = nesting_offsets_[i];
+      SizeArray nested_indexes(indexes);
+      bool within = true;
+      for (unsigned d = 0; d < dims; ++d)
+        if (d != dim) {
+          within &= (offset[d] <= indexes[d]) &
+              (indexes[d] < offset[d] + list.sizes()[d]);
+          nested_indexes[d] -= offset[d];
+        }
+      if (!within)
+        continue;
+
+      AppendRun(start + cur, offset[dim] - cur, default_value_, true, runs);
+      list.AppendDimRuns(dim, nested_indexes, start + offset[dim], runs);
+      cur = offset[dim] + list.sizes()[dim];
+    }
+    AppendRun(start + cur, this->sizes_[dim] - cur, default_value_, true,
+              runs);
+  }
+
+  typename View<DataType>::Iterator iterator_begin() const override {
+    return this->dense_begin();
+  }
+
+  // overrides View<DataType>::Iterator to provide O(1) time complexity
+  typename View<DataType>::Iterator iterator_end() const override {
+    return this->dense_end();
+  }
+
+  const ValuesView& values() const override { return values_; }
+  DataType* default_value() const override { return default_value_; }
+
+  template<size_t index>
+  const typename std::tuple_element<index, Container>::type& sublist() const {
+    return std::get<index>(lists_);
+  }
+
+  const SizeArray& nesting_offset(size_t index) const {
+    return nesting_offsets_[index];
+  }
+
+  static constexpr unsigned chain_dimension() { return chain_dim; }
+
+ private:
+  // Finds the sublist in range [lo, hi] that spans indexes[chain_dim]
+  // by comparing against the offsets of the sublists that are in the middle
+  template<size_t lo, size_t hi>
+  typename std::enable_if<(lo < hi), DataType&>::type
+  Find(SizeArray&& indexes) const {
+    return indexes[chain_dim] < std::get<(lo + hi + 1) / 2>(
+        nesting_offsets_)[chain_dim]
+        ? Find<lo, (lo + hi + 1) / 2 - 1>(std::move(indexes))
+        : Find<(lo + hi + 1) / 2, hi>(std::move(indexes));
+  }
+
+  template<size_t lo, size_t hi>
+  typename std::enable_if<lo == hi, DataType&>::type
+  Find(SizeArray&& indexes) const {
+    return GetAt<lo>(std::move(indexes));
+  }
+
+  // Returns the element at the indexes, which are relative to the chain, if
+  // it is within index-th sublist (calls its get() non-virtually)
+  template<size_t index>
+  DataType& GetAt(SizeArray&& indexes) const {
+    typedef typename std::tuple_element<index, Container>::type SublistType;
+    const SublistType& list = std::get<index>(lists_);
+    const SizeArray& offset = std::get<index>(nesting_offsets_);
+    bool within = true;
+    for (unsigned dim = 0; dim < dims; ++dim) {
+      within &= (offset[dim] <= indexes[dim]) &
+          (indexes[dim] < offset[dim] + list.sizes()[dim]);
+      indexes[dim] -= offset[dim];
+    }
+    return within ? list.SublistType::get(std::move(indexes))
+        : *default_value_;
+  }
+
+  const ListBaseType& GetSublist(size_t index) const {
+    return *GetSublists(cpp14::make_index_sequence<kListCount>())[index];
+  }
+
+  template<size_t... Is>
+  std::array<const ListBaseType*, kListCount>
+  GetSublists(cpp14::index_sequence<Is...>) const {
+    return {{&std::get<Is>(lists_)...}};
+  }
+
+  Container lists_;
+  DataType* default_value_;
+  std::array<SizeArray, kListCount> nesting_offsets_;
+  ValuesView values_;
+};
+
+// functions
+
+template<unsigned chain_dim, class Sublist, class... Sublists,
+         typename... Sizes>
+auto MakeList(TupleChainTag<chain_dim>,
+              std::tuple<Sublist, Sublists...>&& lists,
+              typename Sublist::DataType* default_value,
+              const std::vector<std::array<size_t, Sublist::kDims> >&
+              nesting_offsets,
+              Sizes&&... sizes)
+#define V_LIST_TYPE \
+    TupleChain<chain_dim, Sublist, Sublists...>
+    -> V_LIST_TYPE {
+  using namespace std;
+  return V_LIST_TYPE(move(lists), default_value, nesting_offsets,
+                     forward<Sizes>(sizes)...);
+}
+#undef V_LIST_TYPE
+
+}  // namespace v
+
+#endif  /* CPPVIEWS_SRC_TUPLE_CHAIN_HPP_ */
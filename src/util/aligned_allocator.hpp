@@ -0,0 +1,51 @@
+#ifndef CPPVIEWS_SRC_UTIL_ALIGNED_ALLOCATOR_HPP_
+#define CPPVIEWS_SRC_UTIL_ALIGNED_ALLOCATOR_HPP_
+
+#include <memory>
+#include <new>
+
+#include <cstddef>
+#include <cstdint>
+
+// An allocator that aligns the storage of the elements to the given boundary
+// (e.g., 64 bytes for a cache line), which must be a power of 2.
+// The pointer returned by operator new is stored right before the storage.
+template<typename T, size_t alignment>
+class AlignedAllocator {
+  static_assert(alignment && !(alignment & (alignment - 1)),
+                "alignment must be a power of 2");
+  static_assert(alignment >= alignof(void*), "alignment is too small");
+
+ public:
+  typedef T value_type;
+
+  template<typename U>
+  struct rebind { typedef AlignedAllocator<U, alignment> other; };
+
+  AlignedAllocator() = default;
+  template<typename U>
+  AlignedAllocator(const AlignedAllocator<U, alignment>&) {}
+
+  T* allocate(size_t n) {
+    const size_t size = n * sizeof(T) + alignment + sizeof(void*);
+    if (n > (size_t(-1) - alignment - sizeof(void*)) / sizeof(T))
+      throw std::bad_alloc();
+    void* raw = ::operator new(size);
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+    void* aligned = reinterpret_cast<void*>(
+        (begin + alignment - 1) & ~uintptr_t(alignment - 1));
+    static_cast<void**>(aligned)[-1] = raw;
+    return static_cast<T*>(aligned);
+  }
+
+  void deallocate(T* p, size_t) {
+    ::operator delete(reinterpret_cast<void**>(p)[-1]);
+  }
+
+  template<typename U>
+  bool operator==(const AlignedAllocator<U, alignment>&) const { return true; }
+  template<typename U>
+  bool operator!=(const AlignedAllocator<U, alignment>&) const { return false; }
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_ALIGNED_ALLOCATOR_HPP_ */
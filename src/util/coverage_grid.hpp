@@ -0,0 +1,111 @@
+#ifndef CPPVIEWS_SRC_UTIL_COVERAGE_GRID_HPP_
+#define CPPVIEWS_SRC_UTIL_COVERAGE_GRID_HPP_
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+// A conservative index of the points covered by a set of (hyper)boxes, which
+// coarsens the space into a grid of cells whose sizes are powers of 2, and
+// marks those that intersect any box. Therefore, covers() has no false
+// negatives, and false positives only in the cells that are partially covered.
+// The bits of the cells are summarized by a bit per word of them, so a lookup
+// in an uncovered region is mostly answered by the small summary alone.
+template<unsigned dims>
+class CoverageGrid {
+ public:
+  typedef std::array<size_t, dims> SizeArray;
+  typedef std::pair<SizeArray, SizeArray> Box;  // [first, second)
+
+  static constexpr size_t kDefaultMaxCellCount = 1 << 18;  // 32 KiB of bits
+
+  CoverageGrid() : cell_count_(0) {}
+
+  CoverageGrid(const SizeArray& sizes, const std::vector<Box>& boxes,
+               size_t max_cell_count = kDefaultMaxCellCount)
+      : shifts_{},
+        cell_count_(1) {
+    // coarsen the dimension with the most cells until there are few enough
+    SizeArray counts(sizes);
+    while (Product(counts) > max_cell_count) {
+      unsigned widest = 0;
+      for (unsigned dim = 1; dim < dims; ++dim)
+        if (counts[dim] > counts[widest])
+          widest = dim;
+      ++shifts_[widest];
+      counts[widest] = (counts[widest] + 1) >> 1;
+    }
+    for (unsigned dim = dims; dim--; ) {
+      strides_[dim] = cell_count_;
+      cell_count_ *= counts[dim] ? counts[dim] : 1;
+    }
+    bits_.assign((cell_count_ + 63) >> 6, 0);
+    summary_.assign((bits_.size() + 63) >> 6, 0);
+
+    for (const auto& box : boxes)
+      Mark(box);
+  }
+
+  bool covers(const SizeArray& indexes) const {
+    size_t cell = 0;
+    for (unsigned dim = 0; dim < dims; ++dim)
+      cell += (indexes[dim] >> shifts_[dim]) * strides_[dim];
+    const size_t word = cell >> 6;
+    return (summary_[word >> 6] >> (word & 63) & 1) &&
+        (bits_[word] >> (cell & 63) & 1);
+  }
+
+  // Marks the cells that intersect the box as covered
+  void Mark(const Box& box) {
+    SizeArray first, last, cell;
+    for (unsigned dim = 0; dim < dims; ++dim) {
+      if (box.first[dim] >= box.second[dim])
+        return;  // the box is empty
+      cell[dim] = first[dim] = box.first[dim] >> shifts_[dim];
+      last[dim] = (box.second[dim] - 1) >> shifts_[dim];
+    }
+    // visit all cells within [first, last] (the last dimension varies fastest)
+    for (;;) {
+      size_t index = 0;
+      for (unsigned dim = 0; dim < dims; ++dim)
+        index += cell[dim] * strides_[dim];
+      bits_[index >> 6] |= uint64_t(1) << (index & 63);
+      summary_[index >> 12] |= uint64_t(1) << ((index >> 6) & 63);
+
+      unsigned dim = dims;
+      while (dim-- && cell[dim] == last[dim])
+        cell[dim] = first[dim];
+      if (dim >= dims)
+        return;
+      ++cell[dim];
+    }
+  }
+
+  bool empty() const { return bits_.empty(); }
+
+  size_t cell_count() const { return cell_count_; }
+
+  // Returns the number of bytes used by the bits (and their summary)
+  size_t memory_usage() const {
+    return (bits_.size() + summary_.size()) * sizeof(uint64_t);
+  }
+
+ private:
+  static size_t Product(const SizeArray& counts) {
+    size_t product = 1;
+    for (const auto& count : counts)
+      product *= count ? count : 1;
+    return product;
+  }
+
+  std::array<unsigned, dims> shifts_;
+  SizeArray strides_;
+  size_t cell_count_;
+  std::vector<uint64_t> bits_;
+  std::vector<uint64_t> summary_;  // a bit per word of bits_
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_COVERAGE_GRID_HPP_ */
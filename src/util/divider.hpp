@@ -0,0 +1,8 @@
+#ifndef CPPVIEWS_SRC_UTIL_DIVIDER_HPP_
+#define CPPVIEWS_SRC_UTIL_DIVIDER_HPP_
+
+// libdivide.h is kept as released, which has no include guard, so it must be
+// included only through this header
+#include "libdivide.h"
+
+#endif  /* CPPVIEWS_SRC_UTIL_DIVIDER_HPP_ */
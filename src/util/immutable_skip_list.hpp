@@ -2,8 +2,10 @@
 #define CPPVIEWS_SRC_UTIL_IMMUTABLE_SKIP_LIST_HPP_
 
 #include "bit_twiddling.hpp"
+#include "divider.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -31,7 +33,8 @@ class ImmutableSkipList {
       : bkt_cnt_(bucket_count),
         size_getter_(bucket_size_getter),
         skip_cnts_(Pow2RoundUp(bucket_count) + (bucket_count < 2)),
-        skip_lvl_max_(FindFirstSet(skip_cnts_.size()) - 3u) {
+        skip_lvl_max_(FindFirstSet(skip_cnts_.size()) - 3u),
+        uniform_size_(0) {
         // Note: skip_lvl_max_ is size_t(-1) for bucket_count == 0
     // fast-path for nearly empty skip list
     if (bucket_count <= 2) {
@@ -69,7 +72,8 @@ class ImmutableSkipList {
       *--skip_cnts_it = size_getter_(--bkt_ind) + size_getter_(--bkt_ind);
 
     // initialize the skip counts in the remaining levels in linear time
-    assert(skip_cnts_it - skip_cnts_.begin() == (skip_cnts_.size() >> 1));
+    assert(static_cast<size_t>(skip_cnts_it - skip_cnts_.begin()) ==
+           (skip_cnts_.size() >> 1));
     auto skip_cnts_fast_it = skip_cnts_.cend();
     for (auto lvl_size = skip_cnts_.size() >> 1; lvl_size >>= 1; ) {
       for (auto itr = lvl_size; itr--; )
@@ -83,28 +87,41 @@ class ImmutableSkipList {
 #elif defined __clang__
 #pragma clang diagnostic pop
 #endif
+
+    InitUniform();
   }
 
   // Returns the position of the global_index-th element,
   // starting at offset-th bucket.
   Position get(size_t global_index, size_t offset = 0) const {
+    if (uniform_size_)
+      return GetUniform(global_index + UniformPrefixSum(offset));
+
     // normalize the position to be relative to the bucket that is a left child
     global_index += -(offset & 1) & size_getter_(offset & ~1);
     const size_t ind_to = skip_cnts_.size();
     size_t ind = (ind_to + offset) >> 1;
     if (skip_cnts_[ind] > global_index) // in offset-th bucket or its sibling
       ind <<= 1;
+    else if (ind_to <= 2)               // past the end of the only pair
+      ind <<= 1;
     else {                              // otherwise, follow skip lists
-      if (offset && (offset & 0x1FFu)) { // if < 8 levels, ascend linearly
-        // (note: "offset &&" is an optimization)
-        // ascend the tree by moving up (or up-back) - O(lg N) steps
-        for (auto ind_next = ind; skip_cnts_[ind_next >>= 1] <= global_index;
-             ind = ind_next) {
-          // adjust the global_index if it was a right child (an up-back skip)
-          global_index += -(ind & 1) & skip_cnts_[ind_next << 1];
+      if (offset) {                     // if not leftmost, ascend linearly
+        // (ancestors of a right child do not start where it does, so binary
+        // search over the levels would compare against wrong skip counts)
+        // ascend the tree by moving up (or up-back) until the element is in
+        // the next node at the same level - O(lg D) steps for skip of D
+        for (; ind > 1; ind >>= 1) {
+          if (ind & 1)        // adjust the global_index (an up-back skip)
+            global_index += skip_cnts_[ind - 1];
+          else if (skip_cnts_[ind >> 1] > global_index)
+            break;
         }
-      } else {                   // otherwise, binary search is faster
+      }
+      if (ind <= 1 || !offset) { // otherwise (or if past the end), search
+        // from the leftmost bucket, since global_index is no longer relative
         // ascend the tree using at most lg(levels) jumps - O(lg lg N) steps
+        ind = ind_to >> 1;
         decltype(skip_lvl_max_) ind_rs_lo(0);
         for (auto ind_rs_hi = skip_lvl_max_; ind_rs_lo < ind_rs_hi;) {
           decltype(ind_rs_hi) ind_rs_mid = (ind_rs_lo + ind_rs_hi + 1u) >> 1;
@@ -127,13 +144,119 @@ class ImmutableSkipList {
       }
     } // for random skip of N: at most 1/4 lg lg N + 7/4 lg N steps - O(lg N)
 
-    // normalize the position to be relative to the bucket that is a left child
-    ind -= ind_to;         // compute bucket index (out of leaf index)
-    size_t left_size = size_getter_(ind); // left bucket always exists
-    size_t right = -(left_size <= global_index);
-    return Position(ind - right, global_index - (right & left_size));
+    return LeafPosition(ind, global_index);
   }
 
+  // Returns the position of the element that is distance (> 0) elements
+  // before the first one in the offset-th bucket. This ascends the tree only
+  // until the target is in the subtree, so short backward skips are O(1).
+  Position get_backward(size_t distance, size_t offset) const {
+    assert(distance > 0);
+    if (uniform_size_)
+      return GetUniform(UniformPrefixSum(offset) - distance);
+
+    if (offset & 1) {                   // try the sibling (left) bucket first
+      size_t left_size = size_getter_(offset - 1);
+      if (distance <= left_size)
+        return Position(offset - 1, left_size - distance);
+      distance -= left_size;
+    }
+
+    // ascend the tree by moving up (or up-back) - O(lg D) steps for skip of D
+    const size_t ind_to = skip_cnts_.size();
+    size_t ind = (ind_to + offset) >> 1;
+    for (; !(ind & 1) || skip_cnts_[ind - 1] < distance; ind >>= 1) {
+      assert(ind > 1 && "distance out of range");
+      if (ind & 1)                      // skip over the whole left sibling
+        distance -= skip_cnts_[ind - 1];
+    }
+
+    // descend the tree by moving forward-down - O(lg D) steps
+    size_t global_index = skip_cnts_[--ind] - distance;
+    while ((ind <<= 1) < ind_to)
+      if (skip_cnts_[ind] <= global_index)
+        global_index -= skip_cnts_[ind++];
+    return LeafPosition(ind, global_index);
+  }
+
+  // Finds the positions of n elements (each index less than the sum of sizes),
+  // and stores them to out. The lookups descend the tree in lock-step, in
+  // groups, such that the nodes kBatchPrefetchDepth levels below are
+  // prefetched for the whole group first, which hides the memory latency if
+  // the tree does not fit in the cache.
+  void get_batch(const size_t* global_indexes, size_t n, Position* out) const {
+    const size_t ind_to = skip_cnts_.size();
+    if (bkt_cnt_ <= 2 || uniform_size_) { // no levels to descend (or no need)
+      for (size_t i = 0; i < n; ++i)
+        out[i] = get(global_indexes[i]);
+      return;
+    }
+
+    size_t inds[kBatchGroupSize];
+    size_t rel_indexes[kBatchGroupSize];
+    for (size_t from = 0; from < n; from += kBatchGroupSize) {
+      const size_t group_size = n - from < kBatchGroupSize
+          ? n - from : kBatchGroupSize;
+      std::fill_n(inds, group_size, 1);
+      std::copy_n(global_indexes + from, group_size, rel_indexes);
+
+      // descend the tree by moving down (or down-forward) from the root
+      while ((inds[0] << 1) < ind_to) {  // all nodes are at the same level
+        if ((inds[0] << kBatchPrefetchDepth) < ind_to) {
+          for (size_t j = 0; j < group_size; ++j) {
+#ifdef __GNUC__
+            __builtin_prefetch(&skip_cnts_[inds[j] << kBatchPrefetchDepth]);
+#endif
+          }
+        }
+        for (size_t j = 0; j < group_size; ++j) {
+          // without branches, which would be mispredicted half of the time
+          // (and squash the loads of the other lookups in flight)
+          size_t& ind = inds[j];
+          ind <<= 1;
+          const size_t skip_cnt = skip_cnts_[ind];
+          const size_t forward = skip_cnt <= rel_indexes[j];
+          rel_indexes[j] -= -forward & skip_cnt;
+          ind += forward;
+        }
+      }
+
+      for (size_t j = 0; j < group_size; ++j)
+        out[from + j] = LeafPosition(inds[j] << 1, rel_indexes[j]);
+    }
+  }
+
+  // A finger into the skip list that remembers the bucket of the last found
+  // element, so that finding nearby elements (both forward and backward)
+  // needs to go only as far up the tree as the distance requires.
+  class Cursor {
+   public:
+    explicit Cursor(const ImmutableSkipList& skip_list)
+        : skip_list_(&skip_list),
+          bucket_index_(0),
+          bucket_start_(0) {}
+
+    // Returns the position of the global_index-th element (like get()).
+    Position seek(size_t global_index) {
+      Position pos = global_index >= bucket_start_
+          ? skip_list_->get(global_index - bucket_start_, bucket_index_)
+          : skip_list_->get_backward(bucket_start_ - global_index,
+                                     bucket_index_);
+      bucket_index_ = pos.first;
+      bucket_start_ = global_index - pos.second;
+      return pos;
+    }
+
+    size_t bucket_index() const { return bucket_index_; }
+
+   private:
+    const ImmutableSkipList* skip_list_;
+    size_t bucket_index_;
+    size_t bucket_start_;               // global index of its first element
+  };
+
+  Cursor cursor() const { return Cursor(*this); }
+
   // Returns the skip count for a specific tree node index.
   size_t skip_count(size_t index) const { return skip_cnts_[index]; }
 
@@ -143,11 +266,117 @@ class ImmutableSkipList {
   size_t bucket_count() const { return bkt_cnt_; }
   const BucketSizeGetter& bucket_size_getter() const { return size_getter_; }
 
+  // Returns the size shared by all buckets but a few exceptions (e.g., empty
+  // sentinels or a shorter last bucket), or 0 if the sizes are not uniform.
+  // Lookups in such skip lists divide instead of searching the tree.
+  size_t uniform_size() const { return uniform_size_; }
+
 private:
+  // the number of lookups that get_batch interleaves
+  static constexpr size_t kBatchGroupSize = 16;
+
+  // the number of levels get_batch prefetches ahead (the descendants of a node
+  // on that level are adjacent, e.g., 8 skip counts fill a 64-byte cache line)
+  static constexpr unsigned kBatchPrefetchDepth = 3;
+
+  // the maximum number of buckets whose size can differ from uniform_size_
+  static constexpr size_t kUniformExceptionCountMax = 4;
+
+  // A bucket whose size differs from uniform_size_, such that all buckets
+  // between it and the previous exception are of uniform size.
+  struct UniformException {
+    size_t bucket_to;                   // bucket index + 1
+    size_t start;                       // global index of its first element
+    size_t size;
+  };
+
+  // Detects whether the bucket sizes are uniform (with a few exceptions),
+  // guessing the uniform size from the middle bucket, since the exceptions
+  // are typically at the front or back. Gives up as soon as there are too
+  // many exceptions, so this is cheap for non-uniform sizes.
+  void InitUniform() {
+    const size_t size = size_getter_(bkt_cnt_ >> 1);
+    if (!size)
+      return;
+
+    // the first exception is a virtual empty bucket before the first one,
+    // so that searching the exceptions always finds one
+    uniform_exceptions_[0] = UniformException{0, 0, 0};
+    size_t exception_count = 1;
+    size_t start = 0;
+    for (size_t bkt_ind = 0; bkt_ind < bkt_cnt_; ++bkt_ind) {
+      const size_t bkt_size = size_getter_(bkt_ind);
+      if (bkt_size != size) {
+        if (exception_count > kUniformExceptionCountMax)
+          return;
+        uniform_exceptions_[exception_count++] =
+            UniformException{bkt_ind + 1, start, bkt_size};
+      }
+      start += bkt_size;
+    }
+
+    uniform_exception_cnt_ = exception_count;
+    uniform_sizes_sum_ = start;
+    const libdivide::libdivide_u64_t divider =
+        libdivide::libdivide_u64_gen(size);
+    uniform_magic_ = divider.magic;
+    uniform_more_ = divider.more;
+    uniform_size_ = size;
+  }
+
+  // Returns the global index of the first element in the bucket_index-th
+  // bucket, provided that the sizes are uniform.
+  size_t UniformPrefixSum(size_t bucket_index) const {
+    // find the last exception before the bucket (buckets in between are
+    // of uniform size)
+    const UniformException* e = uniform_exceptions_ + uniform_exception_cnt_;
+    while ((--e)->bucket_to > bucket_index)
+      ;
+    return e->start + e->size + (bucket_index - e->bucket_to) * uniform_size_;
+  }
+
+  // Returns the position of the global_index-th element, provided that the
+  // sizes are uniform, in O(1) time (for a constant number of exceptions).
+  Position GetUniform(size_t global_index) const {
+    if (global_index >= uniform_sizes_sum_) // past the end
+      return Position(bkt_cnt_, global_index - uniform_sizes_sum_);
+
+    // find the last exception that starts at or before the element
+    const UniformException* e = uniform_exceptions_ + uniform_exception_cnt_;
+    while ((--e)->start > global_index)
+      ;
+    size_t rel_index = global_index - e->start;
+    if (rel_index < e->size)            // in the exception itself
+      return Position(e->bucket_to - 1, rel_index);
+
+    // otherwise, divide by the uniform size (using mults and shifts)
+    rel_index -= e->size;
+    const libdivide::libdivide_u64_t divider{uniform_magic_, uniform_more_};
+    const size_t bkt_skip = libdivide::libdivide_u64_do(rel_index, &divider);
+    return Position(e->bucket_to + bkt_skip,
+                    rel_index - bkt_skip * uniform_size_);
+  }
+
+  // Converts the index of the last (implicit) level of the tree, which groups
+  // buckets in pairs, into the position relative to the left or right bucket.
+  Position LeafPosition(size_t ind, size_t global_index) const {
+    ind -= skip_cnts_.size();   // compute bucket index (out of leaf index)
+    size_t left_size = size_getter_(ind); // left bucket always exists
+    size_t right = -(left_size <= global_index);
+    return Position(ind - right, global_index - (right & left_size));
+  }
+
   size_t bkt_cnt_;
   BucketSizeGetter size_getter_;
   std::vector<size_t> skip_cnts_;
   unsigned skip_lvl_max_;
+  size_t uniform_size_;                 // 0 unless the sizes are uniform
+  size_t uniform_sizes_sum_;
+  // (libdivide types have internal linkage, so store the divider's fields)
+  uint64_t uniform_magic_;
+  uint8_t uniform_more_;
+  size_t uniform_exception_cnt_;
+  UniformException uniform_exceptions_[kUniformExceptionCountMax + 1];
 };
 
 #endif  /* CPPVIEWS_SRC_UTIL_IMMUTABLE_SKIP_LIST_HPP_ */
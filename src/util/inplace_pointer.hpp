@@ -0,0 +1,106 @@
+#ifndef CPPVIEWS_SRC_UTIL_INPLACE_POINTER_HPP_
+#define CPPVIEWS_SRC_UTIL_INPLACE_POINTER_HPP_
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+// Checks whether T can be constructed in a buffer of the given size,
+// aligned as std::max_align_t (such as the one in InplacePointer)
+template<class T>
+constexpr bool FitsInplace(size_t size) {
+  return sizeof(T) <= size && alignof(T) <= alignof(std::max_align_t);
+}
+
+// Constructs T in the buffer if it fits, otherwise allocates it on the heap
+template<class T, typename... Args>
+T* NewInplace(void* buf, size_t size, Args&&... args) {
+  return FitsInplace<T>(size)
+      ? ::new(buf) T(std::forward<Args>(args)...)
+      : new T(std::forward<Args>(args)...);
+}
+
+// A smart pointer that owns a polymorphic object, which is stored in an inline
+// buffer if it fits (small-buffer optimization) or on the heap otherwise.
+// Base needs a virtual destructor and a Clone method of the form:
+//   Base* Clone(void* buf, size_t size) const;  // e.g., via NewInplace()
+template<class Base, size_t capacity>
+class InplacePointer {
+  template<class Derived>
+  using EnableIfDerived = typename std::enable_if<
+    std::is_base_of<Base, typename std::decay<Derived>::type>::value>::type;
+
+ public:
+  static constexpr size_t kCapacity = capacity;
+
+  // takes the ownership of a heap-allocated object
+  InplacePointer(Base*&& ptr) noexcept : ptr_(ptr) {}
+
+  // constructs a copy of the object in place (or on the heap if too big)
+  template<class Derived, class Enable = EnableIfDerived<Derived> >
+  InplacePointer(Derived&& obj)
+      : ptr_(NewInplace<typename std::decay<Derived>::type>(
+          &buf_, capacity, std::forward<Derived>(obj))) {}
+
+  InplacePointer(const InplacePointer& copy) : ptr_(CloneFrom(copy)) {}
+
+  InplacePointer(InplacePointer&& src) : ptr_(MoveFrom(src)) {}
+
+  ~InplacePointer() { reset(); }
+
+  InplacePointer& operator=(const InplacePointer& rhs) {
+    if (this != &rhs) {
+      reset();
+      ptr_ = CloneFrom(rhs);
+    }
+    return *this;
+  }
+
+  InplacePointer& operator=(InplacePointer&& rhs) {
+    if (this != &rhs) {
+      reset();
+      ptr_ = MoveFrom(rhs);
+    }
+    return *this;
+  }
+
+  void reset() {
+    if (inplace())
+      ptr_->~Base();
+    else
+      delete ptr_;
+    ptr_ = nullptr;
+  }
+
+  Base* get() const noexcept { return ptr_; }
+  Base& operator*() const noexcept { return *ptr_; }
+  Base* operator->() const noexcept { return ptr_; }
+
+  // Returns whether the object is stored in the inline buffer
+  bool inplace() const noexcept {
+    // the base subobject need not be at the beginning (multiple inheritance)
+    const char* p = reinterpret_cast<const char*>(ptr_);
+    const char* buf = reinterpret_cast<const char*>(&buf_);
+    return p >= buf && p < buf + capacity;
+  }
+
+ private:
+  Base* CloneFrom(const InplacePointer& other) {
+    return other.ptr_ ? other.ptr_->Clone(&buf_, capacity) : nullptr;
+  }
+
+  Base* MoveFrom(InplacePointer& other) {
+    if (other.inplace())  // the object is cheap to copy (it fits the buffer)
+      return CloneFrom(other);
+    Base* ptr = other.ptr_;
+    other.ptr_ = nullptr;
+    return ptr;
+  }
+
+  typename std::aligned_storage<capacity, alignof(std::max_align_t)>::type buf_;
+  Base* ptr_;
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_INPLACE_POINTER_HPP_ */
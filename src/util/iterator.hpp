@@ -108,6 +108,23 @@ using IsConstIter = std::is_const<
     >::type
   >;
 
+// Whether the iterator points to values contiguous in memory (like the
+// contiguous iterators of C++20), which is detected for pointers and for the
+// iterators of std::vector and std::basic_string of libstdc++ and libc++
+// (those of std::array are pointers)
+template<class Iter>
+struct IsContiguousIter : std::is_pointer<Iter> {};
+
+#if defined(__GLIBCXX__)
+template<class Pointer, class Container>
+struct IsContiguousIter<__gnu_cxx::__normal_iterator<Pointer, Container> >
+    : std::is_pointer<Pointer> {};
+#elif defined(_LIBCPP_VERSION)
+template<class Pointer>
+struct IsContiguousIter<std::__wrap_iter<Pointer> >
+    : std::is_pointer<Pointer> {};
+#endif
+
 template<class FromValue, class ToValue, class Return>
 using EnableIfIterConvertible = typename std::enable_if<
   std::is_convertible<FromValue*, ToValue*>::value, Return>::type;
@@ -0,0 +1,152 @@
+#ifndef CPPVIEWS_SRC_UTIL_MORTON_HPP_
+#define CPPVIEWS_SRC_UTIL_MORTON_HPP_
+
+#include <cstdint>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// the bits of the column and the row index in a Morton key, respectively
+constexpr uint64_t kMortonEvenBits = UINT64_C(0x5555555555555555);
+constexpr uint64_t kMortonOddBits = UINT64_C(0xAAAAAAAAAAAAAAAA);
+
+// Deposits the low bits of x into the positions of the bits set in mask,
+// from the lowest to the highest (as the BMI2 instruction pdep does).
+inline uint64_t DepositBits(uint64_t x, uint64_t mask) {
+#ifdef __BMI2__
+  return _pdep_u64(x, mask);
+#else
+  uint64_t result = 0;
+  for (uint64_t bit = 1; mask; bit <<= 1, mask &= mask - 1)
+    if (x & bit)
+      result |= mask & -mask;
+  return result;
+#endif
+}
+
+// Extracts the bits of x in the positions of the bits set in mask into the
+// low bits of the result (as the BMI2 instruction pext does).
+inline uint64_t ExtractBits(uint64_t x, uint64_t mask) {
+#ifdef __BMI2__
+  return _pext_u64(x, mask);
+#else
+  uint64_t result = 0;
+  for (uint64_t bit = 1; mask; bit <<= 1, mask &= mask - 1)
+    if (x & mask & -mask)
+      result |= bit;
+  return result;
+#endif
+}
+
+namespace detail {
+
+// Same as DepositBits(x, kMortonEvenBits), but in O(log bits) steps
+inline uint64_t SpreadEvenBits(uint32_t x) {
+  uint64_t r = x;
+  r = (r | (r << 16)) & UINT64_C(0x0000FFFF0000FFFF);
+  r = (r | (r << 8)) & UINT64_C(0x00FF00FF00FF00FF);
+  r = (r | (r << 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+  r = (r | (r << 2)) & UINT64_C(0x3333333333333333);
+  return (r | (r << 1)) & kMortonEvenBits;
+}
+
+// Same as ExtractBits(x, kMortonEvenBits), but in O(log bits) steps
+inline uint32_t CompactEvenBits(uint64_t x) {
+  uint64_t r = x & kMortonEvenBits;
+  r = (r | (r >> 1)) & UINT64_C(0x3333333333333333);
+  r = (r | (r >> 2)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+  r = (r | (r >> 4)) & UINT64_C(0x00FF00FF00FF00FF);
+  r = (r | (r >> 8)) & UINT64_C(0x0000FFFF0000FFFF);
+  return static_cast<uint32_t>(r | (r >> 16));
+}
+
+// Returns the bits below bit that belong to the same index as bit
+inline uint64_t MortonLowerBits(unsigned bit) {
+  return (bit & 1 ? kMortonOddBits : kMortonEvenBits) &
+      ((uint64_t(1) << bit) - 1);
+}
+
+// Sets the bit and clears the lower bits of the same index ("load 1000")
+inline uint64_t MortonLoadOnes(uint64_t key, unsigned bit) {
+  return (key | (uint64_t(1) << bit)) & ~MortonLowerBits(bit);
+}
+
+// Clears the bit and sets the lower bits of the same index ("load 0111")
+inline uint64_t MortonLoadZeros(uint64_t key, unsigned bit) {
+  return (key & ~(uint64_t(1) << bit)) | MortonLowerBits(bit);
+}
+
+}  // namespace detail
+
+// Computes the Morton (Z-order) key of (row, col) by interleaving their bits,
+// so that the keys are ordered by the rows within each aligned square
+inline uint64_t MortonEncode(uint32_t row, uint32_t col) {
+#ifdef __BMI2__
+  return DepositBits(row, kMortonOddBits) | DepositBits(col, kMortonEvenBits);
+#else
+  return (detail::SpreadEvenBits(row) << 1) | detail::SpreadEvenBits(col);
+#endif
+}
+
+inline uint32_t MortonDecodeRow(uint64_t key) {
+  return detail::CompactEvenBits(key >> 1);
+}
+
+inline uint32_t MortonDecodeCol(uint64_t key) {
+  return detail::CompactEvenBits(key);
+}
+
+// Computes the smallest key greater than key whose row and column are within
+// those of min_key and max_key (inclusive), given that key is not, but it is
+// between them (BIGMIN by Tropf and Herzog).
+inline uint64_t MortonBigMin(uint64_t key, uint64_t min_key,
+                             uint64_t max_key) {
+  uint64_t big_min = 0;
+  for (unsigned bit = 64; bit--; ) {
+    const unsigned bits = (key >> bit & 1) << 2 | (min_key >> bit & 1) << 1 |
+        (max_key >> bit & 1);
+    switch (bits) {
+      case 1:  // the box straddles the bit, which is 0 in key
+        big_min = detail::MortonLoadOnes(min_key, bit);
+        max_key = detail::MortonLoadZeros(max_key, bit);
+        break;
+      case 3:  // the box is above key
+        return min_key;
+      case 4:  // the box is below key
+        return big_min;
+      case 5:  // the box straddles the bit, which is 1 in key
+        min_key = detail::MortonLoadOnes(min_key, bit);
+        break;
+    }
+  }
+  return big_min;
+}
+
+// Computes the largest key less than key whose row and column are within
+// those of min_key and max_key (inclusive), given that key is not, but it is
+// between them (LITMAX by Tropf and Herzog).
+inline uint64_t MortonLitMax(uint64_t key, uint64_t min_key,
+                             uint64_t max_key) {
+  uint64_t lit_max = 0;
+  for (unsigned bit = 64; bit--; ) {
+    const unsigned bits = (key >> bit & 1) << 2 | (min_key >> bit & 1) << 1 |
+        (max_key >> bit & 1);
+    switch (bits) {
+      case 1:  // the box straddles the bit, which is 0 in key
+        max_key = detail::MortonLoadZeros(max_key, bit);
+        break;
+      case 3:  // the box is above key
+        return lit_max;
+      case 4:  // the box is below key
+        return max_key;
+      case 5:  // the box straddles the bit, which is 1 in key
+        lit_max = detail::MortonLoadZeros(max_key, bit);
+        min_key = detail::MortonLoadOnes(min_key, bit);
+        break;
+    }
+  }
+  return lit_max;
+}
+
+#endif  /* CPPVIEWS_SRC_UTIL_MORTON_HPP_ */
@@ -0,0 +1,78 @@
+#ifndef CPPVIEWS_SRC_UTIL_OCCUPANCY_HPP_
+#define CPPVIEWS_SRC_UTIL_OCCUPANCY_HPP_
+
+#include "aligned_allocator.hpp"
+#include "bit_twiddling.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// A Bloom filter over 64-bit keys split into cache-line-sized blocks, so that
+// each lookup touches a single cache line: the key selects a block, in which
+// it sets (or tests) one bit per word (the high half of the hash selects the
+// block, and the low half the bits).
+// It has no false negatives; the rate of false positives is below 1% as long
+// as the number of keys inserted does not exceed the capacity.
+class BlockedBloomFilter {
+ public:
+  explicit BlockedBloomFilter(size_t capacity = 0)
+      : blocks_(Pow2RoundUp(std::max<size_t>(capacity / kKeysPerBlock, 1))) {
+    assert(blocks_.size() <= uint64_t(1) << 32 && "Too many blocks");
+  }
+
+  void Insert(uint64_t key) {
+    const uint64_t hash = Hash(key);
+    Block& block = blocks_[hash >> 32 & (blocks_.size() - 1)];
+    for (unsigned i = 0; i < kWords; ++i)
+      block.words[i] |= Mask(hash, i);
+  }
+
+  // Returns false only if the key has not been inserted
+  bool MayContain(uint64_t key) const {
+    const uint64_t hash = Hash(key);
+    const Block& block = blocks_[hash >> 32 & (blocks_.size() - 1)];
+    uint64_t missing = 0;
+    for (unsigned i = 0; i < kWords; ++i)
+      missing |= Mask(hash, i) & ~block.words[i];
+    return !missing;
+  }
+
+  // Returns the number of keys that keep the false positive rate low
+  size_t capacity() const { return blocks_.size() * kKeysPerBlock; }
+
+  // Returns the number of bytes used by the filter
+  size_t memory_usage() const { return blocks_.size() * sizeof(Block); }
+
+ private:
+  static constexpr unsigned kWords = 8;
+  static constexpr size_t kKeysPerBlock = 32;  // i.e., 16 bits per key
+
+  struct Block { uint64_t words[kWords]; };
+
+  // the finalizer of MurmurHash3, since the keys are often consecutive
+  static uint64_t Hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= UINT64_C(0xFF51AFD7ED558CCD);
+    key ^= key >> 33;
+    key *= UINT64_C(0xC4CEB9FE1A85EC53);
+    return key ^ (key >> 33);
+  }
+
+  // Selects a bit of the i-th word by multiplying the low half of the hash
+  // by an odd salt and taking the top 6 bits (as in Parquet's split blocks)
+  static uint64_t Mask(uint64_t hash, unsigned i) {
+    static constexpr uint32_t kSalts[kWords] = {
+      0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU,
+      0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U
+    };
+    return uint64_t(1) << (static_cast<uint32_t>(hash) * kSalts[i] >> 26);
+  }
+
+  std::vector<Block, AlignedAllocator<Block, 64> > blocks_;
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_OCCUPANCY_HPP_ */
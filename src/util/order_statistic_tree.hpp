@@ -0,0 +1,315 @@
+#ifndef CPPVIEWS_SRC_UTIL_ORDER_STATISTIC_TREE_HPP_
+#define CPPVIEWS_SRC_UTIL_ORDER_STATISTIC_TREE_HPP_
+
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// A mutable alternative to ImmutableSkipList with the same lookup interface,
+// which also supports inserting and erasing buckets anywhere in O(lg N).
+// Buckets are nodes of a treap (ordered implicitly by their index), each of
+// which stores the sum of bucket sizes and the number of buckets in its subtree.
+// Each bucket also has a value (e.g., where its subview is stored), so that
+// the subviews need not be moved when a bucket is inserted or erased.
+class OrderStatisticTree {
+ public:
+  // position in the tree: (bucket_index, local_index)
+  typedef std::pair<size_t, size_t> Position;
+
+  OrderStatisticTree() : nodes_(1), root_(kNil), rand_(0x9E3779B9u) {}
+
+  // Builds the tree in linear time (as a Cartesian tree),
+  // such that the value of each bucket is its index.
+  template<class BucketSizeGetter>
+  OrderStatisticTree(size_t bucket_count,
+                     const BucketSizeGetter& bucket_size_getter)
+      : OrderStatisticTree() {
+    nodes_.reserve(bucket_count + 1);
+    std::vector<size_t> right_spine;
+    for (size_t bkt_ind = 0; bkt_ind < bucket_count; ++bkt_ind) {
+      size_t node = New(bucket_size_getter(bkt_ind), bkt_ind);
+      size_t last = kNil;
+      while (!right_spine.empty() &&
+             nodes_[right_spine.back()].priority < nodes_[node].priority) {
+        last = right_spine.back();
+        right_spine.pop_back();
+      }
+      nodes_[node].left = last;
+      if (!right_spine.empty())
+        nodes_[right_spine.back()].right = node;
+      right_spine.push_back(node);
+    }
+    if (!right_spine.empty())
+      root_ = right_spine.front();
+    UpdateAll(root_);
+  }
+
+  // Inserts a bucket of the given size (and value)
+  // before the bucket_index-th one.
+  void Insert(size_t bucket_index, size_t size, size_t value = 0) {
+    assert(bucket_index <= bucket_count());
+    size_t left, right;
+    Split(root_, bucket_index, &left, &right);
+    root_ = Merge(Merge(left, New(size, value)), right);
+  }
+
+  // Erases the bucket_index-th bucket.
+  void Erase(size_t bucket_index) {
+    assert(bucket_index < bucket_count());
+    size_t left, mid, right;
+    Split(root_, bucket_index, &left, &right);
+    Split(right, 1, &mid, &right);
+    free_.push_back(mid);
+    root_ = Merge(left, right);
+  }
+
+  // Returns the position of the global_index-th element,
+  // starting at offset-th bucket.
+  Position get(size_t global_index, size_t offset = 0) const {
+    if (offset)
+      global_index += prefix_sum(offset);
+    size_t bkt_ind = 0;
+    for (size_t node = root_; node != kNil; ) {
+      const Node& n = nodes_[node];
+      const Node& l = nodes_[n.left];
+      if (global_index < l.sum) {
+        node = n.left;
+        continue;
+      }
+      global_index -= l.sum;
+      bkt_ind += l.count;
+      if (global_index < n.size)
+        return Position(bkt_ind, global_index);
+      global_index -= n.size;
+      ++bkt_ind;
+      node = n.right;
+    }
+    return Position(bkt_ind, global_index);  // past the end
+  }
+
+  // Returns the value of the bucket that contains the global_index-th element
+  // and the local index in it (or the same as get() past the end).
+  Position locate(size_t global_index) const {
+    for (size_t node = root_; node != kNil; ) {
+      const Node& n = nodes_[node];
+      const Node& l = nodes_[n.left];
+      if (global_index < l.sum) {
+        node = n.left;
+        continue;
+      }
+      global_index -= l.sum;
+      if (global_index < n.size)
+        return Position(n.value, global_index);
+      global_index -= n.size;
+      node = n.right;
+    }
+    return Position(bucket_count(), global_index);
+  }
+
+  // Returns the value of the bucket_index-th bucket.
+  size_t value(size_t bucket_index) const {
+    assert(bucket_index < bucket_count());
+    for (size_t node = root_; ; ) {
+      const Node& n = nodes_[node];
+      const size_t left_count = nodes_[n.left].count;
+      if (bucket_index < left_count) {
+        node = n.left;
+      } else if (bucket_index == left_count) {
+        return n.value;
+      } else {
+        bucket_index -= left_count + 1;
+        node = n.right;
+      }
+    }
+  }
+
+  // Calls the visitor with the values of the first bucket_count buckets,
+  // in order of their indexes.
+  template<class Visitor>
+  void ForEachValue(size_t bucket_count, Visitor&& visitor) const {
+    ForEachValue(root_, &bucket_count, visitor);
+  }
+
+  // Returns the position of the element that is distance (> 0) elements
+  // before the first one in the offset-th bucket.
+  Position get_backward(size_t distance, size_t offset) const {
+    assert(distance <= prefix_sum(offset));
+    return get(prefix_sum(offset) - distance);
+  }
+
+  // Finds the positions of n elements, and stores them to out.
+  void get_batch(const size_t* global_indexes, size_t n, Position* out) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = get(global_indexes[i]);
+  }
+
+  // Returns the sum of sizes of the first bucket_index buckets.
+  size_t prefix_sum(size_t bucket_index) const {
+    size_t sum = 0;
+    for (size_t node = root_; node != kNil; ) {
+      const Node& n = nodes_[node];
+      const Node& l = nodes_[n.left];
+      if (bucket_index <= l.count) {
+        node = n.left;
+      } else {
+        sum += l.sum + n.size;
+        bucket_index -= l.count + 1;
+        node = n.right;
+      }
+    }
+    return sum;
+  }
+
+  // A cursor with the same interface as ImmutableSkipList::Cursor, which
+  // remembers the path from the root to the last found bucket, so that it
+  // climbs only up to the subtree that contains the next element.
+  // Inserting or erasing a bucket invalidates it.
+  class Cursor {
+   public:
+    explicit Cursor(const OrderStatisticTree& tree) : tree_(&tree) {}
+
+    Position seek(size_t global_index) {
+      while (!path_.empty() && !Contains(path_.back(), global_index))
+        path_.pop_back();
+      if (path_.empty()) {
+        if (global_index >= tree_->size())
+          return tree_->get(global_index);  // past the end
+        path_.push_back(Step{tree_->root_, 0, 0});
+      }
+      for (;;) {
+        const Step s = path_.back();
+        const Node& n = tree_->nodes_[s.node];
+        const Node& l = tree_->nodes_[n.left];
+        const size_t start = s.start + l.sum;
+        if (global_index < start)
+          path_.push_back(Step{n.left, s.start, s.bucket_start});
+        else if (global_index - start < n.size)
+          return Position(s.bucket_start + l.count, global_index - start);
+        else
+          path_.push_back(Step{n.right, start + n.size,
+                  s.bucket_start + l.count + 1});
+      }
+    }
+
+    // Returns the value of the last found bucket.
+    size_t value() const {
+      assert(!path_.empty());
+      return tree_->nodes_[path_.back().node].value;
+    }
+
+   private:
+    struct Step {
+      size_t node;
+      size_t start;                     // global index of its first element
+      size_t bucket_start;              // index of its first bucket
+    };
+
+    bool Contains(const Step& s, size_t global_index) const {
+      return global_index >= s.start &&
+          global_index - s.start < tree_->nodes_[s.node].sum;
+    }
+
+    const OrderStatisticTree* tree_;
+    std::vector<Step> path_;
+  };
+
+  Cursor cursor() const { return Cursor(*this); }
+
+  size_t bucket_count() const { return nodes_[root_].count; }
+  size_t size() const { return nodes_[root_].sum; }
+
+ private:
+  static constexpr size_t kNil = 0;     // the sentinel node (with zero sums)
+
+  struct Node {
+    size_t left;
+    size_t right;
+    size_t size;                        // the bucket size
+    size_t sum;                         // the sum of sizes in the subtree
+    size_t count;                       // the number of nodes in the subtree
+    size_t value;
+    uint32_t priority;
+  };
+
+  size_t New(size_t size, size_t value) {
+    // xorshift32 is random enough to keep the tree balanced (in expectation)
+    rand_ ^= rand_ << 13;
+    rand_ ^= rand_ >> 17;
+    rand_ ^= rand_ << 5;
+    Node n = {kNil, kNil, size, size, 1, value, rand_};
+    if (free_.empty()) {
+      nodes_.push_back(n);
+      return nodes_.size() - 1;
+    }
+    size_t node = free_.back();
+    free_.pop_back();
+    nodes_[node] = n;
+    return node;
+  }
+
+  void Update(size_t node) {
+    Node& n = nodes_[node];
+    n.sum = nodes_[n.left].sum + n.size + nodes_[n.right].sum;
+    n.count = nodes_[n.left].count + 1 + nodes_[n.right].count;
+  }
+
+  void UpdateAll(size_t node) {
+    if (node == kNil)
+      return;
+    UpdateAll(nodes_[node].left);
+    UpdateAll(nodes_[node].right);
+    Update(node);
+  }
+
+  template<class Visitor>
+  void ForEachValue(size_t node, size_t* count, Visitor& visitor) const {
+    if (node == kNil || !*count)
+      return;
+    ForEachValue(nodes_[node].left, count, visitor);
+    if (!*count)
+      return;
+    --*count;
+    visitor(nodes_[node].value);
+    ForEachValue(nodes_[node].right, count, visitor);
+  }
+
+  // Splits the tree into the first count buckets and the rest.
+  void Split(size_t node, size_t count, size_t* left, size_t* right) {
+    if (node == kNil) {
+      *left = *right = kNil;
+      return;
+    }
+    Node& n = nodes_[node];
+    if (count <= nodes_[n.left].count) {
+      Split(n.left, count, left, &n.left);
+      *right = node;
+    } else {
+      Split(n.right, count - nodes_[n.left].count - 1, &n.right, right);
+      *left = node;
+    }
+    Update(node);
+  }
+
+  size_t Merge(size_t left, size_t right) {
+    if (left == kNil || right == kNil)
+      return left == kNil ? right : left;
+    if (nodes_[left].priority > nodes_[right].priority) {
+      nodes_[left].right = Merge(nodes_[left].right, right);
+      Update(left);
+      return left;
+    }
+    nodes_[right].left = Merge(left, nodes_[right].left);
+    Update(right);
+    return right;
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<size_t> free_;
+  size_t root_;
+  uint32_t rand_;
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_ORDER_STATISTIC_TREE_HPP_ */
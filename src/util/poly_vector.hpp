@@ -4,6 +4,7 @@
 #include "fake_pointer.hpp"
 #include "iterator.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -31,6 +32,11 @@ struct PolyVectorEmplaceHelper {
   Emplace(typename Vector::iterator pos, Vector& v, Args&&... args) const {
     return v.emplace(pos, std::forward<Args>(args)...);
   }
+
+  template<class Derived, typename... Args>
+  inline void Replace(typename Vector::reference p, Args&&... args) const {
+    *p = T(std::forward<Args>(args)...);
+  }
 };
 
 template<typename T>
@@ -50,6 +56,11 @@ struct PolyVectorEmplaceHelper<T, T> {
     return v.emplace(pos, Create<Derived>(std::forward<Args>(args)...));
   }
 
+  template<class Derived, typename... Args>
+  inline void Replace(typename Vector::reference p, Args&&... args) const {
+    p.reset(Create<Derived>(std::forward<Args>(args)...));
+  }
+
  private:
   template<class Derived, typename... Args>
   static Derived* Create(Args&&... args) {
@@ -138,6 +149,20 @@ class PolyVector {
                                        std::forward<Args>(args)...);
   }
 
+  // Replaces the element at the index with a newly constructed one
+  // (the other elements are not moved, unlike with Erase and Add).
+  template<typename... Args>
+  inline void Replace(SizeType index, Args&&... args) {
+    this->Replace<decltype(FactoryType()(std::forward<Args>(args)...))>(
+        index, std::forward<Args>(args)...);
+  }
+
+  template<class Derived, typename... Args>
+  void Replace(SizeType index, Args&&... args) {
+    detail::PolyVectorEmplaceHelper<T, Base> h;
+    h.template Replace<Derived>(v_[index], std::forward<Args>(args)...);
+  }
+
   void Shrink() { v_.shrink_to_fit(); }
 
   Iterator Erase(Iterator first, Iterator last) {
@@ -147,6 +172,7 @@ class PolyVector {
   }
 
   void reset(SizeType index, T* ptr) { v_[index].reset(ptr); }
+  void reset(SizeType index, std::nullptr_t) { v_[index].reset(nullptr); }
 
   Iterator begin() { return v_.begin(); }
   Iterator end() { return v_.end(); }
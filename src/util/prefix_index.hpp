@@ -0,0 +1,247 @@
+#ifndef CPPVIEWS_SRC_UTIL_PREFIX_INDEX_HPP_
+#define CPPVIEWS_SRC_UTIL_PREFIX_INDEX_HPP_
+
+#include "bit_twiddling.hpp"
+#include "immutable_skip_list.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+// Cache-friendly alternatives to ImmutableSkipList with the same interface,
+// which search the (sorted) prefix sums of bucket sizes stored in a layout
+// that touches fewer cache lines per lookup for large bucket counts.
+
+namespace pfi {
+
+using isl::SingleElementBucketSizeGetter;
+
+// Stores the prefix sums of bucket sizes (including the total size at the end)
+// and implements the lookups in terms of Derived::Find(global_index, &start),
+// which returns the index of the last prefix sum (start) not greater than
+// global_index, i.e., of the bucket that contains it (the last bucket if equal).
+template<class Derived, class BucketSizeGetter>
+class PrefixIndexBase {
+ public:
+  // position in the index: (bucket_index, local_index)
+  typedef std::pair<size_t, size_t> Position;
+
+  // Returns the position of the global_index-th element,
+  // starting at offset-th bucket.
+  Position get(size_t global_index, size_t offset = 0) const {
+    global_index += sums_[offset];
+    size_t start;  // found together with the bucket to avoid a cache miss
+    size_t bkt_ind = static_cast<const Derived*>(this)->Find(global_index,
+                                                             &start);
+    return Position(bkt_ind, global_index - start);
+  }
+
+  // Returns the position of the element that is distance (> 0) elements
+  // before the first one in the offset-th bucket.
+  Position get_backward(size_t distance, size_t offset) const {
+    assert(distance <= sums_[offset]);
+    return get(sums_[offset] - distance);
+  }
+
+  // Finds the positions of n elements, and stores them to out.
+  void get_batch(const size_t* global_indexes, size_t n, Position* out) const {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = get(global_indexes[i]);
+  }
+
+  // A finger that remembers the bucket of the last found element, and finds
+  // nearby elements by exponential search of the prefix sums in either
+  // direction, in O(lg D) time for the distance of D buckets.
+  class Cursor {
+   public:
+    explicit Cursor(const PrefixIndexBase& index)
+        : sums_(&index.sums_),
+          bucket_index_(0) {}
+
+    // Returns the position of the global_index-th element (like get()).
+    Position seek(size_t global_index) {
+      const std::vector<size_t>& sums = *sums_;
+      // find lo and hi such that sums[lo] <= global_index < sums[hi]
+      size_t lo = bucket_index_, hi = lo, step = 1;
+      if (sums[lo] <= global_index) {
+        for (; (hi = lo + step) < sums.size() && sums[hi] <= global_index;
+             step <<= 1)
+          lo = hi;
+        hi = std::min(hi, sums.size());
+      } else {
+        do {
+          hi = lo;
+          lo = hi > step ? hi - step : 0;
+          step <<= 1;
+        } while (sums[lo] > global_index); // terminates since sums[0] == 0
+      }
+      bucket_index_ = std::upper_bound(sums.begin() + lo + 1,
+                                       sums.begin() + hi,
+                                       global_index) - sums.begin() - 1;
+      return Position(bucket_index_, global_index - sums[bucket_index_]);
+    }
+
+    size_t bucket_index() const { return bucket_index_; }
+
+   private:
+    const std::vector<size_t>* sums_;
+    size_t bucket_index_;
+  };
+
+  Cursor cursor() const { return Cursor(*this); }
+
+  // Returns the sum of sizes of the first bucket_index buckets.
+  size_t prefix_sum(size_t bucket_index) const { return sums_[bucket_index]; }
+
+  size_t bucket_count() const { return sums_.size() - 1; }
+  size_t size() const { return sums_.back(); }
+  const BucketSizeGetter& bucket_size_getter() const { return size_getter_; }
+
+ protected:
+  PrefixIndexBase(size_t bucket_count,
+                  const BucketSizeGetter& bucket_size_getter)
+      : size_getter_(bucket_size_getter),
+        sums_(bucket_count + 1) {
+    sums_[0] = 0;
+    for (size_t bkt_ind = 0; bkt_ind < bucket_count; ++bkt_ind)
+      sums_[bkt_ind + 1] = sums_[bkt_ind] + size_getter_(bkt_ind);
+  }
+
+  BucketSizeGetter size_getter_;
+  std::vector<size_t> sums_;
+};
+
+}  // namespace pfi
+
+// Stores the prefix sums in the Eytzinger (BFS) order of an implicit binary
+// search tree, so that the top levels share cache lines and the lower ones can
+// be prefetched several levels ahead of the (branchless) descent.
+template<class BucketSizeGetter = pfi::SingleElementBucketSizeGetter>
+class EytzingerPrefixIndex
+    : public pfi::PrefixIndexBase<EytzingerPrefixIndex<BucketSizeGetter>,
+                                  BucketSizeGetter> {
+  typedef pfi::PrefixIndexBase<EytzingerPrefixIndex, BucketSizeGetter> Base;
+  friend Base;
+
+ public:
+  EytzingerPrefixIndex(
+      size_t bucket_count,
+      const BucketSizeGetter& bucket_size_getter = BucketSizeGetter())
+      : Base(bucket_count, bucket_size_getter),
+        keys_(this->sums_.size() + 1),
+        ranks_(keys_.size()) {
+    size_t rank = 0;
+    Build(1, &rank);
+    assert(rank == this->sums_.size());
+  }
+
+ private:
+  // the descendants 4 levels below a node are prefetched (they are adjacent,
+  // so their 2^4 keys span only a couple of cache lines)
+  static constexpr size_t kPrefetchShift = 4;
+
+  // Fills the subtree of the k-th node in order (i.e., sorted).
+  void Build(size_t k, size_t* rank) {
+    if (k >= keys_.size())
+      return;
+    Build(k << 1, rank);
+    ranks_[k] = *rank;
+    keys_[k] = this->sums_[(*rank)++];
+    Build((k << 1) | 1, rank);
+  }
+
+  size_t Find(size_t global_index, size_t* start) const {
+    const size_t n = keys_.size();
+    size_t k = 1, last_right_key = 0;
+    while (k < n) {
+#ifdef __GNUC__
+      if ((k << kPrefetchShift) < n)
+        __builtin_prefetch(&keys_[k << kPrefetchShift]);
+#endif
+      const size_t key = keys_[k];
+      const bool right = key <= global_index;
+      last_right_key = right ? key : last_right_key;
+      k = (k << 1) | right;
+    }
+    *start = last_right_key;
+    // the first greater key is in the last node at which the search went
+    // left, so strip the trailing right turns (1s) and that left turn (0)
+    k >>= FindFirstSet(k ^ (k + 1));
+    return (k ? ranks_[k] : this->sums_.size()) - 1;
+  }
+
+  std::vector<size_t> keys_;            // 1-based (keys_[0] is unused)
+  std::vector<size_t> ranks_;           // index of keys_[k] in sums_
+};
+
+// Stores the prefix sums in a static B+-tree (with kNodeSize keys per node),
+// such that each level is searched by counting the keys not greater than the
+// global index, which compilers vectorize (SIMD) since it has no branches.
+template<class BucketSizeGetter = pfi::SingleElementBucketSizeGetter>
+class BTreePrefixIndex
+    : public pfi::PrefixIndexBase<BTreePrefixIndex<BucketSizeGetter>,
+                                  BucketSizeGetter> {
+  typedef pfi::PrefixIndexBase<BTreePrefixIndex, BucketSizeGetter> Base;
+  friend Base;
+
+ public:
+  static constexpr size_t kNodeSize = 16;
+
+  BTreePrefixIndex(
+      size_t bucket_count,
+      const BucketSizeGetter& bucket_size_getter = BucketSizeGetter()) :
+      Base(bucket_count, bucket_size_getter) {
+    // build the levels bottom-up (the leaf level holds all prefix sums),
+    // where the keys of an internal node are the first keys of its children
+    std::vector<std::vector<size_t> > levels(1, this->sums_);
+    for (;;) {
+      std::vector<size_t>& level = levels.back();
+      level.resize(RoundUpToNode(level.size()),  // pad with the max key
+                   std::numeric_limits<size_t>::max());
+      if (level.size() == kNodeSize)
+        break;
+      std::vector<size_t> parent;
+      parent.reserve(level.size() / kNodeSize);
+      for (size_t i = 0; i < level.size(); i += kNodeSize)
+        parent.push_back(level[i]);
+      levels.push_back(std::move(parent));
+    }
+
+    // store the levels top-down (the root first) in a single array
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+      level_begins_.push_back(keys_.size());
+      keys_.insert(keys_.end(), level->begin(), level->end());
+    }
+  }
+
+ private:
+  static constexpr size_t RoundUpToNode(size_t count) {
+    return (count + kNodeSize - 1) / kNodeSize * kNodeSize;
+  }
+
+  size_t Find(size_t global_index, size_t* start) const {
+    // the first key of each visited node is not greater than global_index
+    // (since sums_[0] == 0), so there is always a child to descend to
+    size_t ind = 0;
+    const size_t* keys = nullptr;
+    size_t count = 0;
+    for (size_t level_begin : level_begins_) {
+      keys = keys_.data() + level_begin + ind * kNodeSize;
+      count = 0;
+      for (size_t i = 0; i < kNodeSize; ++i)
+        count += keys[i] <= global_index;
+      ind = ind * kNodeSize + count - 1;
+    }
+    *start = keys[count - 1];           // the leaf level holds prefix sums
+    return ind;
+  }
+
+  std::vector<size_t> keys_;
+  std::vector<size_t> level_begins_;
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_PREFIX_INDEX_HPP_ */
@@ -0,0 +1,140 @@
+#ifndef CPPVIEWS_SRC_UTIL_ROBIN_HOOD_MAP_HPP_
+#define CPPVIEWS_SRC_UTIL_ROBIN_HOOD_MAP_HPP_
+
+#include "bit_twiddling.hpp"
+
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstdint>
+
+// An open-addressing hash map from keys of type Key to values of type T.
+// Collisions are resolved by linear probing with Robin Hood hashing (an entry
+// displaces those closer to their home slot), so a miss stops as soon as it
+// reaches a slot whose entry is closer to home than the probe.
+// The slots hold the 64-bit hashes, so the keys (kept apart, as the values)
+// are compared only if the hashes are equal; if Hash is injective (e.g., the
+// identity of 64-bit keys), that comparison always succeeds.
+// The values are kept apart from the slots in insertion order, so references
+// to them are never invalidated (erasing is not supported).
+template<typename T, typename Key = uint64_t, class Hash = std::hash<Key> >
+class RobinHoodMap {
+ public:
+  typedef Key KeyType;
+  typedef typename std::deque<T>::iterator iterator;
+  typedef typename std::deque<T>::const_iterator const_iterator;
+
+  explicit RobinHoodMap(size_t capacity = 0, const Hash& hash = Hash())
+      : hash_(hash) {
+    reserve(capacity);
+  }
+
+  // Returns the value mapped to the key, or nullptr if there is none
+  T* find(const KeyType& key) { return find(key, hash(key)); }
+  const T* find(const KeyType& key) const { return find(key, hash(key)); }
+
+  // Same as above, but the hash of the key is given (see hash())
+  T* find(const KeyType& key, uint64_t hash) {
+    return const_cast<T*>(static_cast<const RobinHoodMap*>(this)->find(
+        key, hash));
+  }
+
+  const T* find(const KeyType& key, uint64_t hash) const {
+    if (slots_.empty())
+      return nullptr;
+    const size_t mask = slots_.size() - 1;
+    for (size_t pos = Home(hash), dist = 1; ; pos = (pos + 1) & mask, ++dist) {
+      const Slot& slot = slots_[pos];
+      if (slot.dist < dist)  // also if empty (dist is 0)
+        return nullptr;
+      if (slot.hash == hash && keys_[slot.index] == key)
+        return &values_[slot.index];
+    }
+  }
+
+  // Returns the value mapped to the key, inserting T() if there is none
+  T& operator[](const KeyType& key) {
+    const uint64_t h = hash(key);
+    if (T* value = find(key, h))
+      return *value;
+    return Insert(key, h);
+  }
+
+  uint64_t hash(const KeyType& key) const { return hash_(key); }
+
+  void reserve(size_t count) {
+    if (count * kLoadDen > slots_.size() * kLoadNum)
+      Rehash(Pow2RoundUp(count * kLoadDen / kLoadNum + 1));
+  }
+
+  // Return the key and the value of the index-th insertion
+  const KeyType& key(size_t index) const { return keys_[index]; }
+  T& value(size_t index) { return values_[index]; }
+  const T& value(size_t index) const { return values_[index]; }
+
+  size_t size() const { return values_.size(); }
+  bool empty() const { return values_.empty(); }
+  size_t bucket_count() const { return slots_.size(); }
+
+  // iterate over the values in insertion order
+  iterator begin() { return values_.begin(); }
+  iterator end() { return values_.end(); }
+  const_iterator begin() const { return values_.begin(); }
+  const_iterator end() const { return values_.end(); }
+
+ private:
+  struct Slot {
+    uint64_t hash;
+    uint32_t index;  // of the value (and the key in keys_)
+    uint32_t dist;   // one plus the distance from home, or 0 if empty
+  };
+
+  // the maximum load factor is kLoadNum / kLoadDen
+  static constexpr size_t kLoadNum = 7;
+  static constexpr size_t kLoadDen = 8;
+
+  // Fibonacci hashing spreads the consecutive hashes (e.g., of a line)
+  size_t Home(uint64_t hash) const {
+    return (hash * UINT64_C(11400714819323198485)) >> shift_;
+  }
+
+  T& Insert(const KeyType& key, uint64_t hash) {
+    assert(values_.size() < uint32_t(-1) && "Too many values");
+    reserve(values_.size() + 1);
+    Place(Slot{hash, static_cast<uint32_t>(values_.size()), 1});
+    keys_.push_back(key);
+    values_.emplace_back();
+    return values_.back();
+  }
+
+  void Place(Slot s) {
+    const size_t mask = slots_.size() - 1;
+    for (size_t pos = Home(s.hash); ; pos = (pos + 1) & mask, ++s.dist) {
+      Slot& slot = slots_[pos];
+      if (slot.dist == 0) {
+        slot = s;
+        return;
+      }
+      if (slot.dist < s.dist)  // take from the rich
+        std::swap(slot, s);
+    }
+  }
+
+  void Rehash(size_t slot_count) {
+    slots_.assign(slot_count, Slot{0, 0, 0});
+    shift_ = 64 - (FindFirstSet(slot_count) - 1);
+    for (size_t i = 0; i < keys_.size(); ++i)
+      Place(Slot{hash(keys_[i]), static_cast<uint32_t>(i), 1});
+  }
+
+  Hash hash_;
+  std::vector<Slot> slots_;  // the size is a power of 2
+  unsigned shift_;
+  std::vector<KeyType> keys_;
+  std::deque<T> values_;
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_ROBIN_HOOD_MAP_HPP_ */
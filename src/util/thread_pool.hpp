@@ -0,0 +1,86 @@
+#ifndef CPPVIEWS_SRC_UTIL_THREAD_POOL_HPP_
+#define CPPVIEWS_SRC_UTIL_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+// A fixed number of worker threads that run the submitted tasks in FIFO order
+// (the destructor waits for the pending tasks to finish)
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t thread_count = DefaultThreadCount())
+      : stopped_(false) {
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+      workers_.emplace_back([this] { Work(); });
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+  }
+
+  // Schedules func() to run on one of the workers, and returns its future
+  template<class Func>
+  std::future<typename std::result_of<Func()>::type> Submit(Func&& func) {
+    typedef typename std::result_of<Func()>::type Result;
+    auto task = std::make_shared<std::packaged_task<Result()> >(
+        std::forward<Func>(func));
+    std::future<Result> result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([task] { (*task)(); });
+    }
+    cv_.notify_one();
+    return result;
+  }
+
+  size_t size() const { return workers_.size(); }
+
+  static size_t DefaultThreadCount() {
+    const size_t count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+  }
+
+ private:
+  void Work() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+        if (tasks_.empty())
+          return;  // stopped and drained
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()> > tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopped_;
+};
+
+#endif  /* CPPVIEWS_SRC_UTIL_THREAD_POOL_HPP_ */
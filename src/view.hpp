@@ -1,9 +1,12 @@
 #ifndef CPPVIEWS_SRC_VIEW_HPP_
 #define CPPVIEWS_SRC_VIEW_HPP_
 
+#include "util/inplace_pointer.hpp"
+
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <type_traits>
 
 #include <cstddef>
 
@@ -17,11 +20,18 @@ class View {
   class Iterator;
 
   class IteratorBase {
+   public:
+    virtual ~IteratorBase() = default;
+
    protected:
     typedef bool (*IsEqualPointer)(const IteratorBase& lhs,
                                    const IteratorBase& rhs);
 
     virtual IteratorBase* Clone() const = 0;
+    // copies into the buffer if big enough (the default always uses the heap)
+    virtual IteratorBase* Clone(void* buf, size_t size) const {
+      return Clone();
+    }
     virtual void Increment() = 0;
     virtual T& ref() const = 0;
     virtual IsEqualPointer equal() const = 0;
@@ -48,15 +58,30 @@ class View {
                       const typename View<T>::IteratorBase& rhs) {      \
     return static_cast<const Iter&>(lhs) == static_cast<const Iter&>(rhs); \
   }                                                                     \
-  Iter* Clone() const override { return new Iter(*this); }
+  Iter* Clone() const override { return new Iter(*this); }              \
+  Iter* Clone(void* buf, size_t size) const override {                  \
+    return NewInplace<Iter>(buf, size, *this);                          \
+  }
 
     friend class Iterator;
+    template<class, size_t> friend class ::InplacePointer;
   };  // class IteratorBase
 
+  // the size of the inline storage, which fits the iterators of the library
+  // (those over nested polymorphic lists avoid holding their iterators)
+  static constexpr size_t kIteratorInplaceSize = 16 * sizeof(void*);
+
   class Iterator : public std::iterator<std::forward_iterator_tag, T> {
+    template<class Iter>
+    using EnableIfIter = typename std::enable_if<std::is_base_of<
+      IteratorBase, typename std::decay<Iter>::type>::value>::type;
+
    public:
     Iterator(IteratorBase*&& it) : it_(std::forward<IteratorBase*&&>(it)) {}
-    Iterator(const Iterator& copy) : it_(copy.it_->Clone()) {}
+    // constructs a copy of the iterator in place (avoids heap allocation)
+    template<class Iter, class Enable = EnableIfIter<Iter> >
+    Iterator(Iter&& it) : it_(std::forward<Iter>(it)) {}
+    Iterator(const Iterator& copy) = default;
     Iterator(Iterator&& other) = default;
     Iterator& operator=(const Iterator& rhs) = default;
     Iterator& operator=(Iterator&& rhs) = default;
@@ -66,7 +91,7 @@ class View {
     V_DEF_VIEW_ITER_OPERATORS(Iterator, it_);
 
    private:
-    std::unique_ptr<IteratorBase> it_;
+    InplacePointer<IteratorBase, kIteratorInplaceSize> it_;
   };
 
   View(size_t size) : size_(size) {}
@@ -0,0 +1,34 @@
+#include "../src/band.hpp"
+#include "test.hpp"
+
+#include <vector>
+
+namespace {
+
+template<class BandType>
+double MultiplyRepeatedly(const BandType& band) {
+  double val = 0;
+  for (auto& v : band.values()) v = ++val / 1e6;
+  std::vector<double> x(band.sizes()[1], 1), y(band.sizes()[0]);
+  double chksum = 0;
+  for (int i = 0; i < 2000; ++i) {
+    x[i] = i;
+    band.Multiply(x.data(), y.data());
+    chksum += y[i];
+  }
+  return chksum;
+}
+
+}  // namespace
+
+TEST(BandSpeedtest, MultiplyPentadiagonal) {
+  static double zero = 0;
+  Band<double, -2, -1, 0, 1, 2> b(&zero, 100000, 100000);
+  EXPECT_NE(0, MultiplyRepeatedly(b));
+}
+
+TEST(BandSpeedtest, MultiplyPentadiagonalDyn) {
+  static double zero = 0;
+  DynBand<double> b(&zero, {-2, -1, 0, 1, 2}, 100000, 100000);
+  EXPECT_NE(0, MultiplyRepeatedly(b));
+}
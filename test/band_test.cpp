@@ -0,0 +1,168 @@
+#include "../src/band.hpp"
+#include "../src/chain.hpp"
+#include "test.hpp"
+
+#include <vector>
+
+namespace {
+
+template<class BandType>
+void FillDiagonals(const BandType& band) {
+  // the value at (r, c) is 10 * (r + 1) + c + 1
+  band.ForEachEntry([](const typename BandType::SizeArray& indexes, int& v) {
+      v = 10 * (indexes[0] + 1) + indexes[1] + 1;
+    });
+}
+
+template<class BandType, typename T>
+std::vector<T> NaiveProduct(const BandType& band, const std::vector<T>& x) {
+  std::vector<T> y(band.sizes()[0]);
+  for (size_t r = 0; r < y.size(); ++r)
+    for (size_t c = 0; c < x.size(); ++c)
+      y[r] += band(r, c) * x[c];
+  return y;
+}
+
+}  // namespace
+
+TEST(BandTest, Tridiagonal) {
+  //     0  1  2  3  4  5
+  // 0  11 12  .  .  .  .
+  // 1  21 22 23  .  .  .
+  // 2   . 32 33 34  .  .
+  // 3   .  . 43 44 45  .
+  // 4   .  .  . 54 55 56
+  static int zero = 0;
+  Band<int, -1, 0, 1> b(&zero, 5, 6);
+  EXPECT_EQ(30, b.size());
+  EXPECT_EQ(4 + 5 + 5, b.values().size());
+  EXPECT_EQ(std::vector<std::ptrdiff_t>({-1, 0, 1}), b.offsets());
+  FillDiagonals(b);
+  EXPECT_EQ(11, b(0, 0));
+  EXPECT_EQ(12, b(0, 1));
+  EXPECT_EQ(0, b(0, 2));
+  EXPECT_EQ(21, b(1, 0));
+  EXPECT_EQ(0, b(2, 0));
+  EXPECT_EQ(43, b(3, 2));
+  EXPECT_EQ(56, b(4, 5));
+  EXPECT_EQ(0, b(4, 2));
+  EXPECT_EQ(&zero, &b(4, 0));
+  EXPECT_EQ(&zero, &b(0, 5));
+  EXPECT_EQ(45, b.get({3, 4}));
+
+  // the values are stored diagonal by diagonal
+  std::vector<int> values(b.values().begin(), b.values().end());
+  EXPECT_EQ(std::vector<int>({21, 32, 43, 54,
+                              11, 22, 33, 44, 55,
+                              12, 23, 34, 45, 56}), values);
+  std::vector<int> visited;
+  b.ForEach([&](int& v) { visited.push_back(v); });
+  EXPECT_EQ(values, visited);
+  EXPECT_EQ(1, b.segments().size());
+
+  ExpectDenseIteration(b);
+  ExpectDimRuns(b);
+}
+
+TEST(BandTest, DimIter) {
+  static int zero = 0;
+  Band<int, -2, 1> b(&zero, 4, 4);
+  FillDiagonals(b);
+  std::vector<int> line;
+  for (auto it = b.dim_begin<1>(2), it_end = b.dim_end<1>(2); it != it_end;
+       ++it)
+    line.push_back(*it);
+  EXPECT_EQ(std::vector<int>({31, 0, 0, 34}), line);
+
+  line.clear();
+  for (auto it = b.nondefault_dim_cbegin<0>(1),
+           it_end = b.nondefault_dim_cend<0>(1); it != it_end; ++it)
+    line.push_back(*it);
+  EXPECT_EQ(std::vector<int>({12, 42}), line);
+
+  std::vector<size_t> rows;
+  for (auto it = b.entry_dim_begin<0>(0), it_end = b.entry_dim_end<0>(0);
+       it != it_end; ++it)
+    rows.push_back(it->indexes()[0]);
+  EXPECT_EQ(std::vector<size_t>({2}), rows);
+}
+
+TEST(BandTest, DynBandSameAsBand) {
+  static int zero = 0;
+  Band<int, -3, 0, 2, 7> b(&zero, 6, 8);
+  DynBand<int> db(&zero, {7, 2, -3, 0, 2}, 6, 8);
+  EXPECT_EQ(b.offsets(), db.offsets());
+  EXPECT_EQ(b.values().size(), db.values().size());
+  FillDiagonals(b);
+  FillDiagonals(db);
+  for (size_t r = 0; r < 6; ++r)
+    for (size_t c = 0; c < 8; ++c)
+      EXPECT_EQ(b(r, c), db(r, c)) << "(" << r << ", " << c << ")";
+  ExpectDenseIteration(db);
+  ExpectDimRuns(db);
+}
+
+TEST(BandTest, OffsetsOutOfRange) {
+  static int zero = 0;
+  DynBand<int> db(&zero, {-9, 0, 4}, 3, 4);
+  EXPECT_EQ(3, db.values().size());
+  FillDiagonals(db);
+  EXPECT_EQ(33, db(2, 2));
+  EXPECT_EQ(0, db(0, 3));
+  ExpectDimRuns(db);
+}
+
+TEST(BandTest, CopyAndMove) {
+  static int zero = 0;
+  auto b = MakeList(BandTag<0, 1>(), &zero, 3, 3);
+  FillDiagonals(b);
+  auto copy(b);
+  b(0, 0) = 0;
+  EXPECT_EQ(11, *copy.values().begin());
+  auto moved(std::move(copy));
+  EXPECT_EQ(11, *moved.values().begin());
+  EXPECT_EQ(5, std::distance(moved.values().begin(), moved.values().end()));
+  copy = moved;
+  EXPECT_EQ(&copy(0, 0), &*copy.values().begin());
+}
+
+TEST(BandTest, Multiply) {
+  static int zero = 0, two = 2;
+  Band<int, -2, -1, 0, 3> b(&zero, 9, 7);
+  FillDiagonals(b);
+  std::vector<int> x = {1, -1, 2, 0, 3, 1, -2};
+  std::vector<int> y(9, 42);
+  b.Multiply(x.data(), y.data());
+  EXPECT_EQ(NaiveProduct(b, x), y);
+
+  DynBand<int> db(&two, {-2, -1, 0, 3}, 9, 7);
+  FillDiagonals(db);
+  db.Multiply(x.data(), y.data());
+  EXPECT_EQ(NaiveProduct(db, x), y);
+  db.MultiplyAdd(x.data(), y.data());
+  auto exp = NaiveProduct(db, x);
+  for (auto& e : exp) e *= 2;
+  EXPECT_EQ(exp, y);
+
+  // there are no rows intersected by all diagonals
+  Band<int, -2, 3> narrow(&two, 3, 4);
+  FillDiagonals(narrow);
+  std::vector<int> y3(3);
+  narrow.Multiply(x.data(), y3.data());
+  EXPECT_EQ(NaiveProduct(narrow, std::vector<int>(x.begin(), x.begin() + 4)),
+            y3);
+}
+
+TEST(BandTest, InChain) {
+  static int zero = 0;
+  ListVector<ListBase<int, 2> > lv;
+  lv.Append(MakeList(BandTag<0, 1>(), &zero, 2, 2));
+  lv.Append(DynBandTag(), &zero, std::vector<std::ptrdiff_t>({-1}), 2, 3);
+  Chain<ListBase<int, 2>, 1> chain(std::move(lv), &zero);
+  EXPECT_EQ(decltype(chain)::SizeArray({2, 5}), chain.sizes());
+  chain(0, 0) = 1, chain(0, 1) = 2, chain(1, 1) = 3, chain(1, 2) = 4;
+  EXPECT_EQ(4, chain.values().size());
+  EXPECT_EQ(4, chain(1, 2));
+  EXPECT_EQ(0, chain(0, 2));
+  ExpectDenseIteration(chain);
+}
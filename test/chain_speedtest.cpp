@@ -0,0 +1,86 @@
+#include "../src/chain.hpp"
+#include "../src/diag.hpp"
+#include "test.hpp"
+
+#include <cstdlib>
+
+namespace {
+
+typedef Diag<int, unsigned, 1, 1> InnerView;
+
+constexpr size_t kListCount = 1000;
+
+ListVector<InnerView> MakeSublists(int* default_value) {
+  ListVector<InnerView> lists;
+  for (size_t i = 0; i < kListCount; ++i) {
+    lists.Append(DiagTag<unsigned, 1, 1>(), default_value, 3, 3);
+    lists.back()(1, 1) = 1;
+  }
+  return lists;
+}
+
+// Sums random elements, so that the bucket index has to be computed each time
+template<class ChainType>
+int SumRandom(const ChainType& c) {
+  const size_t rows = c.sizes()[0], cols = c.sizes()[1];
+  int chksum = 0;
+  std::srand(42);
+  for (int i = 0; i < 50000000; ++i) {
+    const size_t r = std::rand() % rows;
+    chksum += c(r, i % cols);
+  }
+  return chksum;
+}
+
+}  // namespace
+
+// same workload for both, with a bucket size that is not a power of 2
+
+TEST(ChainSpeedtest, UniformChainRandomGet) {
+  static int zero = 0;
+  UniformChain<InnerView, 0, 3, 1, 3> c(MakeSublists(&zero), &zero);
+  EXPECT_NE(0, SumRandom(c));
+}
+
+TEST(ChainSpeedtest, DynUniformChainRandomGet) {
+  static int zero = 0;
+  DynUniformChain<InnerView, 0> c(MakeSublists(&zero), &zero, 3, 1, 3);
+  EXPECT_NE(0, SumRandom(c));
+}
+
+namespace {
+
+// a block diagonal of the sublists (chained along the columns)
+Chain<InnerView, 1> MakeBlockDiag(int* default_value) {
+  ChainOffsetVector<2> offsets;
+  for (size_t i = 0; i < kListCount; ++i)
+    offsets.push_back({{3 * i, 3 * i}});
+  return Chain<InnerView, 1>(MakeSublists(default_value), default_value,
+                             std::move(offsets), 3 * kListCount,
+                             3 * kListCount);
+}
+
+}  // namespace
+
+// visits only the sublist that intersects each row
+TEST(ChainSpeedtest, BlockDiagRowsNonDefault) {
+  static int zero = 0;
+  auto c = MakeBlockDiag(&zero);
+  int chksum = 0;
+  for (int itr = 0; itr < 100; ++itr)
+    for (size_t row = 0; row < c.sizes()[0]; ++row)
+      for (auto it = c.nondefault_dim_cbegin<1>(row),
+               it_end = c.nondefault_dim_cend<1>(row); it != it_end; ++it)
+        chksum += *it;
+  EXPECT_EQ(100 * kListCount, chksum);
+}
+
+TEST(ChainSpeedtest, BlockDiagDense) {
+  static int zero = 0;
+  auto c = MakeBlockDiag(&zero);
+  int chksum = 0;
+  for (int itr = 0; itr < 3; ++itr)
+    for (const auto& value : c)
+      chksum += value;
+  EXPECT_EQ(3 * kListCount, chksum);
+}
@@ -63,6 +63,14 @@ TEST(ChainTest, PolyNoGapNoOffsets) {
   EXPECT_EQ(12, zero_cnt);
 
   AssertValuesEmpty(c2_0_nogap);
+  ExpectDenseIteration(c2_0_nogap);
+
+  // validate the cursor against get() by seeking in both directions
+  auto cursor = c2_0_nogap.cursor();
+  for (unsigned col : {0, 2, 3, 7, 6, 4, 1, 5, 0, 7})
+    for (unsigned row = 0; row < c2_0_nogap.sizes()[1]; ++row)
+      EXPECT_EQ(&c2_0_nogap.get({col, row}), &cursor.seek({col, row}))
+          << "seek(" << col << ", " << row << ')';
 }
 
 TEST(ChainTest, PolyConst) {
@@ -143,7 +151,26 @@ TEST(ChainTest, PolyConst) {
       EXPECT_EQ(c2_1.get({col, row}), c2_1_explicit.get({col, row})) <<
           "Incorrect get(" << col << ", " << row << ')';
 
+  // verify that the sublists are found the same way via other indexes
+  Chain<ListBaseType, 1, kListOpVector, 2, EytzingerPrefixIndex> c2_1_eytz(
+      c2_1_lists_factory(), &digits[10], {{0, {2}}, {2, {1}}, {3, {3}}},
+      {{2, 1}});
+  Chain<ListBaseType, 1, kListOpVector, 2, BTreePrefixIndex> c2_1_btree(
+      c2_1_lists_factory(), &digits[10], {{0, {2}}, {2, {1}}, {3, {3}}},
+      {{2, 1}});
+  auto cursor = c2_1_btree.cursor();
+  for (unsigned row = c2_1.sizes()[1]; row--; )
+    for (unsigned col = 0; col < c2_1.sizes()[0]; ++col) {
+      EXPECT_EQ(&c2_1.get({col, row}), &c2_1_eytz.get({col, row})) <<
+          "Incorrect Eytzinger get(" << col << ", " << row << ')';
+      EXPECT_EQ(&c2_1.get({col, row}), &c2_1_btree.get({col, row})) <<
+          "Incorrect B-tree get(" << col << ", " << row << ')';
+      EXPECT_EQ(&c2_1.get({col, row}), &cursor.seek({col, row})) <<
+          "Incorrect B-tree seek(" << col << ", " << row << ')';
+    }
+
   AssertValuesEmpty(c2_1);
+  ExpectDenseIteration(c2_1);
 }
 
 TEST(ChainTest, Poly1DLeadingGap) {
@@ -166,6 +193,7 @@ TEST(ChainTest, Poly1DLeadingGap) {
   EXPECT_EQ(default_value, c1.get({2}));
 
   AssertValuesEmpty(c1);
+  ExpectDenseIteration(c1);
 }
 
 TEST(ChainTest, PolyTrailingGap) {
@@ -188,6 +216,7 @@ TEST(ChainTest, PolyTrailingGap) {
   EXPECT_EQ(default_value, c3_1.get({0, 2, 0}));
 
   AssertValuesEmpty(c3_1);
+  ExpectDenseIteration(c3_1);
 }
 
 TEST(ChainTest, NestingMakeList) {
@@ -240,6 +269,8 @@ TEST(ChainTest, NestingMakeList) {
   EXPECT_EQ(3, nested.get({0, 6}));
   EXPECT_EQ(4, nested.get({0, 7}));
   EXPECT_EQ(7, nested.get({0, 10}));
+  ExpectDenseIteration(nested);
+  ExpectDimRuns(nested);
 }
 
 TEST(UniformChainTest, PolyNoGaps) {
@@ -283,6 +314,7 @@ TEST(UniformChainTest, PolyNoGaps) {
   EXPECT_EQ(0, uc2_0_3_nogap.get({8, 0}));
 
   AssertValuesEmpty(uc2_0_3_nogap);
+  ExpectDenseIteration(uc2_0_3_nogap);
 }
 
 TEST(UniformChainTest, PolyGapsBeforeOnly) {
@@ -320,6 +352,7 @@ TEST(UniformChainTest, PolyGapsBeforeOnly) {
   EXPECT_EQ(-1, uc2_0_1_2.get({4, 1}));
 
   AssertValuesEmpty(uc2_0_1_2);
+  ExpectDenseIteration(uc2_0_1_2);
 }
 
 TEST(UniformChainTest, PolyGapsAfterOnly) {
@@ -356,6 +389,7 @@ TEST(UniformChainTest, PolyGapsAfterOnly) {
   EXPECT_EQ(0, uc2_0_1_0_3.get({7, 0}));
 
   AssertValuesEmpty(uc2_0_1_0_3);
+  ExpectDenseIteration(uc2_0_1_0_3);
 }
 
 TEST(UniformChainTest, PolyGapsBeforeAndAfter) {
@@ -411,12 +445,25 @@ TEST(UniformChainTest, PolyGapsBeforeAndAfter) {
 
   // validate a few other zero entries (corner cases)
   for (size_t c2 = 0; c2 <= 9; ++c2)
-    if (c2 != 1 && c2 != 5 && c2 != 9)
+    if (c2 != 1 && c2 != 5 && c2 != 9) {
       for (size_t c1 = 0; c1 <= 3; ++c1)
         EXPECT_EQ(-1, uc3_1_1_1_2.get({c1, c2, 0}))
             << "get(" << c1 << ", " << c2 << ", 0)";
+    }
 
   AssertValuesEmpty(uc3_1_1_1_2);
+  ExpectDenseIteration(uc3_1_1_1_2);
+  ExpectDimRuns(uc3_1_1_1_2);
+
+  // iterate over the (non-default) elements along the chain dimension
+  std::vector<int> line;
+  for (auto it = uc3_1_1_1_2.nondefault_dim_begin<1>(2, 0),
+           it_end = uc3_1_1_1_2.nondefault_dim_end<1>(2, 0); it != it_end;
+       ++it)
+    line.push_back(*it);
+  EXPECT_EQ(std::vector<int>({7, 4, 1}), line);
+  EXPECT_EQ(12, std::distance(uc3_1_1_1_2.dim_cbegin<1>(2, 0),
+                              uc3_1_1_1_2.dim_cend<1>(2, 0)));
 }
 
 TEST(UniformChainTest, MakeList) {
@@ -469,4 +516,78 @@ TEST(UniformChainTest, MakeList) {
       EXPECT_EQ(exp, nested.get({c1, c2}))
           << "get(" << c1 << ", " << c2 << ')';
     }
+  ExpectDenseIteration(nested);
+  ExpectDimRuns(nested);
+}
+
+TEST(DynUniformChainTest, SameAsUniformChain) {
+  // same as in UniformChainTest.PolyGapsBeforeAndAfter
+  static int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1};
+  auto make_lists = [&] {
+    return std::move(ListVector<ListBase<int, 3> >()
+                     .Append([&](unsigned c1, unsigned c2, unsigned c3) {
+                         return &digits[9 - c1];
+                       }, 4, 1, 1)
+                     .Append([&](unsigned c1, unsigned c2, unsigned c3) {
+                         return &digits[2 + c1];
+                       }, 4, 1, 1)
+                     .Append([&](unsigned c1, unsigned c2, unsigned c3) {
+                         return &digits[1];
+                       }, 4, 1, 1));
+  };
+  UniformChain<ListBase<int, 3>, 1, 1, 1, 2> uc3_1_1_1_2(make_lists(),
+                                                         &digits[10]);
+  DynUniformChain<ListBase<int, 3>, 1> duc3_1(make_lists(), &digits[10],
+                                              1, 1, 2);
+  ASSERT_EQ(uc3_1_1_1_2.sizes(), duc3_1.sizes());
+  EXPECT_EQ(1, duc3_1.uniform_size());
+  EXPECT_EQ(1, duc3_1.gap_before());
+  EXPECT_EQ(2, duc3_1.gap_after());
+  for (size_t c1 = 0; c1 < 4; ++c1)
+    for (size_t c2 = 0; c2 < 12; ++c2)
+      EXPECT_EQ(&uc3_1_1_1_2.get({c1, c2, 0}), &duc3_1.get({c1, c2, 0}))
+          << "get(" << c1 << ", " << c2 << ", 0)";
+
+  AssertValuesEmpty(duc3_1);
+  ExpectDenseIteration(duc3_1);
+  ExpectDimRuns(duc3_1);
+
+  // iterate over the (non-default) entries along and across the chain
+  std::vector<int> line;
+  std::vector<size_t> line_indexes;
+  for (auto it = duc3_1.entry_dim_cbegin<1>(2, 0),
+           it_end = duc3_1.entry_dim_cend<1>(2, 0); it != it_end; ++it) {
+    line.push_back(it->value());
+    line_indexes.push_back(it->indexes()[1]);
+    EXPECT_EQ(2, it->indexes()[0]);
+  }
+  EXPECT_EQ(std::vector<int>({7, 4, 1}), line);
+  EXPECT_EQ(std::vector<size_t>({1, 5, 9}), line_indexes);
+
+  line.clear();
+  for (auto it = duc3_1.entry_dim_begin<0>(5, 0),
+           it_end = duc3_1.entry_dim_end<0>(5, 0); it != it_end; ++it)
+    line.push_back(it->value());
+  EXPECT_EQ(std::vector<int>({2, 3, 4, 5}), line);
+  EXPECT_EQ(duc3_1.entry_dim_end<0>(6, 0), duc3_1.entry_dim_begin<0>(6, 0));
+}
+
+TEST(DynUniformChainTest, MakeList) {
+  //    0 1 2 3 4 5
+  //     +-+     +-+
+  // 0   |1|     |1|
+  //     +-+     +-+
+  static int one = 1, minus_one = -1;
+  auto duc = MakeList(
+      DynUniformChainTag<0>(),
+      ListVector<ListBase<int, 2> >()
+      .Append([](unsigned, unsigned) { return &one; }, 1, 1)
+      .Append([](unsigned, unsigned) { return &one; }, 1, 1)
+      , &minus_one, 1, 1, 1);
+  ASSERT_EQ(6, duc.sizes()[0]);
+  ASSERT_EQ(1, duc.sizes()[1]);
+  for (size_t c1 = 0; c1 < 6; ++c1)
+    EXPECT_EQ(c1 == 1 || c1 == 4 ? 1 : -1, duc.get({c1, 0})) << c1;
+  ExpectDenseIteration(duc);
+  ExpectDimRuns(duc);
 }
@@ -0,0 +1,159 @@
+#include "../src/compiled_view.hpp"
+
+#include "../src/chain.hpp"
+#include "../src/diag.hpp"
+#include "test.hpp"
+
+namespace {
+
+int default_val = -1;
+
+}  // namespace
+
+TEST(CompiledViewTest, DiagSingleBand) {
+  Diag<int, unsigned, 1, 1> d(&default_val, 100, 100);
+  for (unsigned i = 0; i < 100; ++i)
+    d(i, i) = i;
+  auto f = Freeze(d);
+  EXPECT_EQ(1, f.band_count());  // the diagonal shifts by a column per row
+  EXPECT_EQ(1, f.interval_count());
+  for (size_t row = 0; row < 100; ++row)
+    for (size_t col = 0; col < 100; ++col)
+      ASSERT_EQ(&d(row, col), &f(row, col)) << row << ", " << col;
+
+  f(42, 42) = 1000;
+  EXPECT_EQ(1000, d(42, 42));
+  ExpectDenseIteration(f);
+}
+
+TEST(CompiledViewTest, NestedChain) {
+  // 0 1 2 3 4 5 6 7
+  // +---+-----------+
+  // |1 0|2 2 0 0 0 0| 0
+  // |0 1|0 0 2 2 0 0| 1
+  // +---+---+---+---+
+  //     |3 0|   |4 0| 2
+  //     |0 3|   |0 4| 3
+  //     +---+   +---+
+  typedef Diag<int, unsigned, 1, 1> Diag11;
+  Diag11 d1(&default_val, 2, 2), d3(&default_val, 2, 2),
+      d4(&default_val, 2, 2);
+  Diag<int, unsigned, 1, 2> d2(&default_val, 2, 6);
+  for (unsigned i = 0; i < 2; ++i) {
+    d1(i, i) = 1, d3(i, i) = 3, d4(i, i) = 4;
+    d2(i, 2 * i) = d2(i, 2 * i + 1) = 2;
+  }
+  Chain<ListBase<int, 2>, 1> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(std::move(d1))
+      .Append(
+          ChainTag<0>(), ListVector<ListBase<int, 2> >()
+          .Append(std::move(d2))
+          .Append(
+              ChainTag<1>(), ListVector<ListBase<int, 2> >()
+              .Append(std::move(d3))
+              .Append(std::move(d4))
+              , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 4}})
+              , 2, 6)
+          , &default_val, ChainOffsetVector<2>({{0, 0}, {2, 0}})
+          , 4, 6)
+      , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 2}})
+      , 4, 8);
+
+  CompiledView<int> f(c);
+  ASSERT_EQ(c.sizes(), f.sizes());
+  EXPECT_EQ(2, f.band_count());
+  for (size_t row = 0; row < c.sizes()[0]; ++row)
+    for (size_t col = 0; col < c.sizes()[1]; ++col) {
+      ASSERT_EQ(&c(row, col), &f(row, col)) << row << ", " << col;
+      EXPECT_EQ(&f(row, col), &f.get({row, col}));
+    }
+
+  // the writes are visible both ways
+  c(3, 7) = 40;
+  EXPECT_EQ(40, f(3, 7));
+  f(0, 3) = 20;
+  EXPECT_EQ(20, c(0, 3));
+  EXPECT_EQ(-1, f(3, 0));
+
+  // the values are those not default, in row-major order
+  std::vector<int*> c_values, f_values, f_entries;
+  for (size_t row = 0; row < c.sizes()[0]; ++row)
+    for (size_t col = 0; col < c.sizes()[1]; ++col)
+      if (&c(row, col) != &default_val)
+        c_values.push_back(&c(row, col));
+  for (auto& value : f.values())
+    f_values.push_back(&value);
+  EXPECT_EQ(c_values, f_values);
+  EXPECT_EQ(c_values.size(), f.values().size());
+  f.ForEachEntry([&](const ListBase<int, 2>::SizeArray& indexes, int& value) {
+      EXPECT_EQ(&f(indexes[0], indexes[1]), &value);
+      f_entries.push_back(&value);
+    });
+  EXPECT_EQ(c_values, f_entries);
+  ExpectDenseIteration(f);
+}
+
+TEST(CompiledViewTest, BandAcrossSublists) {
+  // the rows of the band are stored in different sublists
+  typedef Diag<int, unsigned, 1, 1> Diag11;
+  Chain<Diag11, 0> c(
+      ListVector<Diag11>()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 1)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 1)
+      , &default_val);
+  c(0, 0) = 1, c(1, 0) = 2;
+  auto f = Freeze(c);
+  EXPECT_EQ(1, f.band_count());
+  ASSERT_EQ(&c(0, 0), &f(0, 0));
+  ASSERT_EQ(&c(1, 0), &f(1, 0));
+  f(1, 0) = 20;
+  EXPECT_EQ(20, c(1, 0));
+  ExpectDenseIteration(f);
+}
+
+TEST(CompiledViewTest, DefaultFromSource) {
+  // the default of the sublists is more common, but it is stored in them
+  typedef Diag<int, unsigned, 1, 1> Diag11;
+  int sublist_default = -2;
+  Chain<Diag11, 0> c(
+      ListVector<Diag11>()
+      .Append(DiagTag<unsigned, 1, 1>(), &sublist_default, 4, 4)
+      .Append(DiagTag<unsigned, 1, 1>(), &sublist_default, 4, 4)
+      , &default_val);
+  for (unsigned i = 0; i < 8; ++i)
+    c(i, i % 4) = i;
+  auto f = Freeze(c);
+  EXPECT_EQ(&default_val, f.default_value());
+  EXPECT_EQ(&sublist_default, &f(0, 1));
+  EXPECT_EQ(8, f.values().size());
+  std::vector<int> values(f.values().begin(), f.values().end());
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}), values);
+  int sum = 0;
+  f.ForEach([&sum](int value) { sum += value; });
+  EXPECT_EQ(28, sum);
+  ExpectDenseIteration(f);
+}
+
+TEST(CompiledViewTest, Coverage) {
+  Diag<int, unsigned, 4, 4> d(&default_val, 64, 64);
+  d(5, 6) = 56;
+  auto f = Freeze(d);
+  EXPECT_EQ(64 * 64, f.coverage().cell_count());
+  EXPECT_EQ((64 + 1) * sizeof(uint64_t), f.coverage().memory_usage());
+  EXPECT_TRUE(f.coverage().covers({{5, 6}}));
+  EXPECT_FALSE(f.coverage().covers({{5, 8}}));  // off the diagonal blocks
+  for (size_t row = 0; row < 64; ++row)
+    for (size_t col = 0; col < 64; ++col)
+      ASSERT_EQ(&d(row, col), &f(row, col)) << row << ", " << col;
+  EXPECT_EQ(56, f(5, 6));
+  ExpectDenseIteration(f);
+
+  // a coarser index has false positives (but still no false negatives)
+  CompiledView<int> fc(d, 16);
+  EXPECT_EQ(16, fc.coverage().cell_count());
+  EXPECT_TRUE(fc.coverage().covers({{5, 15}}));
+  for (size_t row = 0; row < 64; ++row)
+    for (size_t col = 0; col < 64; ++col)
+      ASSERT_EQ(&d(row, col), &fc(row, col)) << row << ", " << col;
+}
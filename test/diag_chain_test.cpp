@@ -29,6 +29,32 @@ TEST(DiagChainTest, PolyValueIterNoEmpty1x1) {
   EXPECT_EQ(c.values().end(), c.values().end());
 }
 
+TEST(DiagChainTest, ForEachNoEmpty1x1) {
+  static int default_val = -1;
+  Chain<ListBase<int, 2>, 0> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 3, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 3)
+      , &default_val);
+  c(0, 0) = 10, c(1, 1) = 20, c(2, 2) = 30;
+  c(3, 0) = 40;
+  c(4, 0) = 50, c(5, 1) = 60;
+
+  std::vector<int> visited;
+  c.ForEach([&](int& v) { visited.push_back(v); });
+  EXPECT_EQ(std::vector<int>({10, 20, 30, 40, 50, 60}), visited);
+
+  typedef std::array<size_t, 2> SizeArray;
+  std::vector<SizeArray> indexes;
+  c.ForEachEntry([&](const SizeArray& ind, int& v) {
+      EXPECT_EQ(&c(ind[0], ind[1]), &v);
+      indexes.push_back(ind);
+    });
+  EXPECT_EQ(std::vector<SizeArray>({{{0, 0}}, {{1, 1}}, {{2, 2}},
+                                    {{3, 0}}, {{4, 0}}, {{5, 1}}}), indexes);
+}
+
 TEST(DiagChainTest, DimEntryIterNoEmpty1x1) {
   static int default_val = -1;
   typedef Diag<int, unsigned, 1, 1> InnerView;
@@ -102,3 +128,315 @@ TEST(DiagChainTest, PolyValueIterNestedNoEmpty) {
   EXPECT_EQ(c.values().end(), ++vit);
   EXPECT_EQ(c.values().end(), c.values().end());
 }
+
+TEST(DiagChainTest, IndexCoverage) {
+  //    0 1 2 3 4 5 6 7 8 9
+  //   +---+-----+
+  // 0 |1 0|3 0 0|
+  // 1 |0 1|0 3 0|         +-+
+  //   +---+     |         |8|
+  // 2     |0 0 3|         |8|
+  // 3     |     |         |0|
+  // 4     |4    |         +-+
+  //       +-----+
+  // (the column at 8 is a nested chain whose default value is 8, so its
+  // default elements must not be skipped)
+  static int default_val = -1, other_default_val = 8;
+  typedef Diag<int, unsigned, 1, 1> Diag11;
+  Diag11 d1(&default_val, 2, 2), d3(&default_val, 3, 3);
+  for (unsigned i = 0; i < 3; ++i)
+    d3(i, i) = 3;
+  d1(0, 0) = d1(1, 1) = 1;
+  Chain<ListBase<int, 2>, 1> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(std::move(d1))
+      .Append(
+          ChainTag<0>(), ListVector<ListBase<int, 2> >()
+          .Append(std::move(d3))
+          .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 1)
+          , &default_val, ChainOffsetVector<2>({{0, 0}, {4, 0}})
+          , 5, 3)
+      .Append(
+          ChainTag<1>(), ListVector<ListBase<int, 2> >()
+          .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 1)
+          , &other_default_val, ChainOffsetVector<2>({{2, 0}})
+          , 3, 1)
+      , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 2}, {1, 8}})
+      , 5, 10);
+  c(4, 2) = 4;
+
+  // a single cell covers everything, so get() descends into the sublists
+  c.IndexCoverage(1);
+  std::vector<int*> expected;
+  for (size_t row = 0; row < c.sizes()[0]; ++row)
+    for (size_t col = 0; col < c.sizes()[1]; ++col)
+      expected.push_back(&c(row, col));
+
+  for (size_t max_cell_count : {1, 4, 16, 1000}) {
+    c.IndexCoverage(max_cell_count);
+    EXPECT_GE(max_cell_count, c.coverage().cell_count());
+    std::vector<int*> actual;
+    for (size_t row = 0; row < c.sizes()[0]; ++row)
+      for (size_t col = 0; col < c.sizes()[1]; ++col)
+        actual.push_back(&c(row, col));
+    EXPECT_EQ(expected, actual) << "max_cell_count = " << max_cell_count;
+  }
+
+  // with a cell per element, only the diagonals and the column are covered
+  EXPECT_EQ(50, c.coverage().cell_count());
+  EXPECT_TRUE(c.coverage().covers({{1, 1}}));
+  EXPECT_FALSE(c.coverage().covers({{0, 1}}));
+  EXPECT_FALSE(c.coverage().covers({{3, 3}}));  // in a nested gap
+  EXPECT_FALSE(c.coverage().covers({{0, 7}}));  // in a lateral gap
+  EXPECT_TRUE(c.coverage().covers({{2, 8}}));  // the nested default
+  EXPECT_TRUE(c.coverage().covers({{3, 8}}));
+}
+
+TEST(DiagChainTest, IndexCoverageLazyDiag) {
+  // the blocks not allocated yet must be covered, since writes allocate them
+  static int default_val = -1;
+  LazyDiag<int, unsigned, 2, 2> d(&default_val, 8, 8);
+  d(0, 0) = 1;
+  Chain<ListBase<int, 2>, 1> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(std::move(d))
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 8, 2)
+      , &default_val);
+  EXPECT_EQ(80, c.coverage().cell_count());  // indexed by the constructor
+  EXPECT_TRUE(c.coverage().covers({{6, 6}}));
+  EXPECT_FALSE(c.coverage().covers({{0, 2}}));
+
+  c(6, 6) = 7;
+  EXPECT_EQ(-1, default_val);
+  EXPECT_EQ(7, c(6, 6));
+  EXPECT_EQ(-1, c(6, 5));
+  EXPECT_EQ(-1, c(0, 2));
+  EXPECT_EQ(1, c(0, 0));
+}
+
+TEST(DiagChainTest, DimIter) {
+  //    0 1 2 3 4 5 6
+  //   +---+-----+
+  // 0 |1 0|2 0 0|
+  // 1 |0 1|0 2 0|   +-+
+  //   +---+-----+   |3|
+  // 2               |0|
+  //                 +-+
+  static int default_val = -1;
+  Chain<ListBase<int, 2>, 1> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 2)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 1)
+      , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 2}, {1, 6}})
+      , 3, 7);
+  c(0, 0) = c(1, 1) = 1;
+  c(0, 2) = c(1, 3) = 2;
+  c(1, 6) = 3;
+  ExpectDimRuns(c);
+
+  // all elements of a row, including the default ones in the gap
+  std::vector<int> row;
+  for (auto it = c.dim_begin<1>(1), it_end = c.dim_end<1>(1); it != it_end;
+       ++it)
+    row.push_back(*it);
+  EXPECT_EQ(std::vector<int>({-1, 1, -1, 2, -1, -1, 3}), row);
+
+  // only the non-default elements of a row along with their indexes
+  std::vector<std::pair<size_t, int> > entries;
+  for (auto it = c.nondefault_dim_begin<1>(1),
+           it_end = c.nondefault_dim_end<1>(1); it != it_end; ++it)
+    entries.emplace_back(it.index(), *it);
+  EXPECT_EQ((std::vector<std::pair<size_t, int> >{{1, 1}, {3, 2}, {6, 3}}),
+            entries);
+
+  // a column through a single sublist
+  auto cit = c.nondefault_dim_cbegin<0>(6);
+  ASSERT_NE(c.nondefault_dim_cend<0>(6), cit);
+  EXPECT_EQ(1, cit.index());
+  EXPECT_EQ(&c(1, 6), &*cit);
+  EXPECT_EQ(c.nondefault_dim_cend<0>(6), ++cit);
+  EXPECT_EQ(c.nondefault_dim_end<0>(5), c.nondefault_dim_begin<0>(5));
+  EXPECT_EQ(3, std::distance(c.dim_begin<0>(5), c.dim_end<0>(5)));
+
+  // the non-const iterators can write
+  *c.dim_begin<0>(4) = 7;
+  EXPECT_EQ(7, c(0, 4));
+  Chain<ListBase<int, 2>, 1>::ConstDimIterator<0> ccit = c.dim_begin<0>(4);
+  EXPECT_EQ(7, *ccit);
+}
+
+TEST(DiagChainTest, RunsLateralOrder) {
+  //    0 1 2 3 4 5 6 7
+  // 0     +---+   +---+
+  // 1     |2 0|   |4 0|
+  //       |0 2|   |0 4|
+  // 2     +---+---+---+
+  //         |3 0|
+  // 3 +---+ |0 3|
+  //   |1 0| +---+
+  // 4 |0 1|
+  //   +---+
+  // (the rows of the sublists are not sorted, so the lateral bounds of the
+  // sublists are not exact, and the sublists in them must be checked)
+  static int default_val = -1;
+  typedef Diag<int, unsigned, 1, 1> Diag11;
+  Chain<Diag11, 1> c(
+      ListVector<Diag11>()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 2)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 2)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 2)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 2)
+      , &default_val, ChainOffsetVector<2>({{3, 0}, {0, 2}, {2, 4}, {0, 6}})
+      , 5, 8);
+  for (unsigned i = 0; i < 2; ++i) {
+    c(3 + i, i) = 1;
+    c(i, 2 + i) = 2;
+    c(2 + i, 4 + i) = 3;
+    c(i, 6 + i) = 4;
+  }
+  ExpectDimRuns(c);
+  ExpectDenseIteration(c);
+
+  std::vector<int> row;
+  for (auto it = c.nondefault_dim_begin<1>(1),
+           it_end = c.nondefault_dim_end<1>(1); it != it_end; ++it)
+    row.push_back(*it);
+  EXPECT_EQ(std::vector<int>({2, 4}), row);
+
+  std::vector<std::pair<size_t, int> > entries;
+  for (auto it = c.entry_dim_begin<1>(3), it_end = c.entry_dim_end<1>(3);
+       it != it_end; ++it)
+    entries.emplace_back(it->indexes()[1], it->value());
+  EXPECT_EQ((std::vector<std::pair<size_t, int> >{{0, 1}, {5, 3}}), entries);
+}
+
+TEST(DiagChainTest, EntryDimIterAdvance) {
+  //   0 1 2
+  //  +-----+
+  // 0|1    |
+  // 1|  2  |
+  // 2|    3|
+  //  +-----+
+  // 3|     |  (empty)
+  //  +-----+
+  // 4|4    |
+  //  +-----+
+  // 5
+  //  +-----+
+  // 6|5    |
+  // 7|  6  |
+  //  +-----+
+  static int default_val = -1;
+  typedef Diag<int, unsigned, 1, 1> InnerView;
+  Chain<InnerView, 0> c(
+      ListVector<InnerView>()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 3, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 0)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 3)
+      , &default_val, {}, {{3, 1}});
+  c(0, 0) = 1, c(1, 1) = 2, c(2, 2) = 3;
+  c(4, 0) = 4;
+  c(6, 0) = 5, c(7, 1) = 6;
+
+  // column 0 has an entry in all but the empty sublist
+  auto begin = c.entry_dim_begin<0>(0), end = c.entry_dim_end<0>(0);
+  EXPECT_EQ(3, begin.DistanceTo(end));
+  EXPECT_EQ(-3, end.DistanceTo(begin));
+  auto it = end;
+  it.Advance(-1);
+  EXPECT_EQ(5, it->value());
+  EXPECT_EQ(decltype(c)::SizeArray({6, 0}), it->indexes());
+  it.Advance(-1);
+  EXPECT_EQ(4, it->value());
+  it.Advance(-1);
+  EXPECT_EQ(1, it->value());
+  EXPECT_EQ(begin, it);
+  it.Advance(3);
+  EXPECT_EQ(end, it);
+  it.Advance(-3);
+  it.Advance(2);
+  EXPECT_EQ(5, it->value());
+  it.Advance(-2);
+  EXPECT_EQ(begin, it);
+
+  // the entries are stashed in the iterators, so they are only forward ones
+  typedef decltype(c)::ConstEntryDimIterator<0> ConstIter;
+  static_assert(std::is_same<std::iterator_traits<ConstIter>::iterator_category,
+                std::forward_iterator_tag>::value, "");
+  ConstIter cbegin = c.entry_dim_cbegin<0>(0), cend = c.entry_dim_cend<0>(0);
+  auto found = EntryLowerBound(
+      cbegin, cend, 5, [](const ConstIter::value_type& e, size_t row) {
+        return e.indexes()[0] < row;
+      });
+  ASSERT_NE(cend, found);
+  EXPECT_EQ(6, found->indexes()[0]);
+  EXPECT_EQ(2, cbegin.DistanceTo(found));
+
+  // a row along the lateral dimension spans a single sublist
+  auto rbegin = c.entry_dim_begin<1>(7), rend = c.entry_dim_end<1>(7);
+  ASSERT_EQ(1, rbegin.DistanceTo(rend));
+  EXPECT_EQ(6, rbegin->value());
+  EXPECT_EQ(decltype(c)::SizeArray({7, 1}), rbegin->indexes());
+  rend.Advance(-1);
+  EXPECT_EQ(rbegin, rend);
+  EXPECT_EQ(c.entry_dim_begin<1>(5), c.entry_dim_end<1>(5));  // in the gap
+  EXPECT_EQ(c.entry_dim_begin<1>(3), c.entry_dim_end<1>(3));  // empty sublist
+
+  // entries past the diagonal of a non-square sublist
+  auto end2 = c.entry_dim_end<0>(2);
+  EXPECT_EQ(0, end2.DistanceTo(c.entry_dim_end<0>(2)));
+  end2.Advance(-1);
+  EXPECT_EQ(c.entry_dim_begin<0>(2), end2);
+}
+
+namespace {
+
+// Counts the moves of an entry iterator, i.e., the calls of Advance() and
+// DistanceTo(), each of which takes O(#sublists) time for a Chain
+template<class Iter>
+struct MoveCountingIter {
+  void Advance(std::ptrdiff_t n) { ++*moves; it.Advance(n); }
+  std::ptrdiff_t DistanceTo(const MoveCountingIter& other) const {
+    ++*moves;
+    return it.DistanceTo(other.it);
+  }
+  typename Iter::reference operator*() const { return *it; }
+
+  Iter it;
+  size_t* moves;
+};
+
+}  // namespace
+
+TEST(DiagChainTest, EntryLowerBoundComplexity) {
+  // column 0 has an entry in each of the 1000 sublists (stacked vertically)
+  static int default_val = -1;
+  typedef Diag<int, unsigned, 1, 1> InnerView;
+  ListVector<InnerView> lists;
+  for (size_t i = 0; i < 1000; ++i)
+    lists.Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 1);
+  Chain<InnerView, 0> c(std::move(lists), &default_val);
+  for (size_t row = 0; row < 1000; ++row)
+    c(row, 0) = 2 * row;
+
+  typedef decltype(c)::ConstEntryDimIterator<0> ConstIter;
+  typedef MoveCountingIter<ConstIter> CountingIter;
+  for (int value : {-1, 0, 1, 2, 999, 1000, 1997, 1998, 1999}) {
+    size_t moves = 0, comparisons = 0;
+    const CountingIter begin{c.entry_dim_cbegin<0>(0), &moves};
+    const CountingIter end{c.entry_dim_cend<0>(0), &moves};
+    CountingIter found = EntryLowerBound(
+        begin, end, value, [&](ConstIter::value_type& e, int value) {
+          ++comparisons;
+          return e.value() < value;
+        });
+    const std::ptrdiff_t expected = value < 0 ? 0 : (value + 1) / 2;
+    ASSERT_EQ(expected, begin.it.DistanceTo(found.it)) << value;
+    // a halving step per comparison (plus one more after each "less"),
+    // rather than a linear number of increments (as std::lower_bound makes)
+    EXPECT_GE(10u, comparisons) << value;
+    EXPECT_GE(1 + 2 * comparisons, moves) << value;
+  }
+}
@@ -1,6 +1,8 @@
 #include "../src/diag.hpp"
 #include "test.hpp"
 
+#include <vector>
+
 TEST(DiagSpeedtest, SmallHalfDefault) {
   // 1 1 0
   // 1 1 0
@@ -25,3 +27,79 @@ TEST(DiagSpeedtest, SmallHalfDefault) {
   }
   EXPECT_NE(0, chksum);
 }
+
+TEST(DiagSpeedtest, Multiply) {
+  static double zero = 0;
+  Diag<double, unsigned, 4, 4> d(&zero, 100000, 100000);
+  double val = 0;
+  for (auto& v : d.values()) v = ++val / 1e6;
+  std::vector<double> x(100000, 1), y(100000);
+
+  double chksum = 0;
+  for (int i = 0; i < 1000; ++i) {
+    x[i] = i;
+    d.Multiply(x.data(), y.data());
+    chksum += y[i];
+  }
+  EXPECT_NE(0, chksum);
+}
+
+TEST(DiagSpeedtest, MultiplyNaive) {
+  static double zero = 0;
+  Diag<double, unsigned, 4, 4> d(&zero, 100000, 100000);
+  double val = 0;
+  for (auto& v : d.values()) v = ++val / 1e6;
+  std::vector<double> x(100000, 1), y(100000);
+
+  double chksum = 0;
+  for (int i = 0; i < 1000; ++i) {
+    x[i] = i;
+    for (unsigned r = 0; r < 100000; ++r) {
+      y[r] = 0;
+      for (unsigned c = r & ~3u; c < (r & ~3u) + 4; ++c)
+        y[r] += d(r, c) * x[c];
+    }
+    chksum += y[i];
+  }
+  EXPECT_NE(0, chksum);
+}
+
+TEST(DiagSpeedtest, SmallHalfDefaultDyn) {
+  static int zero = 0;
+  DynDiag<int, 2> d(&zero, {2, 3}, 3, 4);
+  for (unsigned r = 0; r < d.block_size(0); ++r)
+    for (unsigned c = 0; c < d.block_size(1); ++c)
+      d(r, c) = 1;
+
+  int chksum = 0;
+  for (int i = 0; i < 50000000; ++i) {
+    int rnd = rand();
+    for (int j = 0; j < 4; ++j, rnd >>= 4) {
+      int c = rnd & 0xF, r = c >> 2;
+      if (c >= 12) continue;
+      c &= 3;
+      chksum += d(r, c);
+    }
+  }
+  EXPECT_NE(0, chksum);
+}
+
+TEST(DiagSpeedtest, Values) {
+  static int zero = 0;
+  Diag<int, unsigned, 3, 5> d(&zero, 1000000, 1666667);
+  long long chksum = 0;
+  for (int i = 0; i < 20; ++i)
+    for (auto& v : d.values())
+      chksum += ++v;
+  EXPECT_NE(0, chksum);
+}
+
+TEST(DiagSpeedtest, ValuesDyn) {
+  static int zero = 0;
+  DynDiag<int, 2> d(&zero, {3, 5}, 1000000, 1666667);
+  long long chksum = 0;
+  for (int i = 0; i < 20; ++i)
+    for (auto& v : d.values())
+      chksum += ++v;
+  EXPECT_NE(0, chksum);
+}
@@ -2,6 +2,9 @@
 #include "test.hpp"
 
 #include <type_traits>
+#include <vector>
+
+#include <cstdint>
 
 typedef ::testing::Types<
   std::integral_constant<unsigned, 3>,
@@ -122,6 +125,67 @@ TEST(DiagTest, Unsigned2DLastNotFull) {
   EXPECT_EQ(41, d_2_3(2, 2));
 }
 
+TEST(DiagTest, ForEach2DLastNotFull) {
+  static int default_val = -1;
+  Diag<int, unsigned, 2, 3> d_2_3(&default_val, 8, 10);
+  int val = 0;
+  for (auto& v : d_2_3.values()) v = val++;
+  ASSERT_EQ(20, val);
+
+  // values are visited in the same order as in values()
+  std::vector<int> visited;
+  d_2_3.ForEach([&](int& v) { visited.push_back(v); });
+  EXPECT_EQ(20, visited.size());
+  for (int i = 0; i < 20; ++i)
+    EXPECT_EQ(i, visited[i]) << "i = " << i;
+
+  // entries outside the last (non-full) block are skipped
+  typedef decltype(d_2_3)::SizeArray SizeArray;
+  std::vector<SizeArray> indexes;
+  d_2_3.ForEachEntry([&](const SizeArray& ind, int& v) {
+      EXPECT_EQ(&d_2_3(ind[0], ind[1]), &v);
+      indexes.push_back(ind);
+    });
+  ASSERT_EQ(20, indexes.size());
+  EXPECT_EQ(SizeArray({0, 0}), indexes[0]);
+  EXPECT_EQ(SizeArray({0, 2}), indexes[2]);
+  EXPECT_EQ(SizeArray({1, 0}), indexes[3]);
+  EXPECT_EQ(SizeArray({2, 3}), indexes[6]);
+  EXPECT_EQ(SizeArray({6, 9}), indexes[18]);
+  EXPECT_EQ(SizeArray({7, 9}), indexes[19]);
+}
+
+TEST(DiagTest, Runs2DLastNotFull) {
+  static int default_val = -1;
+  Diag<int, unsigned, 2, 3> d_2_3(&default_val, 8, 10);
+  int val = 0;
+  for (auto& v : d_2_3.values()) v = val++;
+  ExpectDenseIteration(d_2_3);
+  ExpectDimRuns(d_2_3);
+
+  // row 1 consists of a block line and a (repeated) default stretch, and the
+  // next row starts with the same default value, so they are merged
+  auto runs = d_2_3.runs();
+  ASSERT_LE(3, runs.size());
+  EXPECT_FALSE(runs[0].repeated);
+  EXPECT_EQ(3, runs[0].length);
+  EXPECT_EQ(&d_2_3(0, 0), runs[0].value);
+  EXPECT_TRUE(runs[1].repeated);
+  EXPECT_EQ(&default_val, runs[1].value);
+  EXPECT_EQ(7, runs[1].length);
+  EXPECT_EQ(10, runs[2].start);
+
+  // the last row is default except for the value in the non-full block
+  EXPECT_EQ(&d_2_3(7, 9), &runs.back()[0]);
+  EXPECT_EQ(79, runs.back().start);
+  EXPECT_EQ(1, runs.back().length);
+
+  Diag<int, unsigned, 1, 1> d_1_1(&default_val, 4, 3);
+  d_1_1(1, 1) = 11;
+  ExpectDenseIteration(d_1_1);
+  ExpectDimRuns(d_1_1);
+}
+
 TEST(DiagTest, Unsigned2DSingleFullBlock) {
   Diag<double, unsigned, 4, 1> d_4_1(nullptr, 4, 1);
   for (unsigned i = 0; i < 4; ++i) d_4_1(i, 0) = 10 * (i + 1);
@@ -136,6 +200,23 @@ TEST(DiagTest, Unsigned2DSingleFullBlock) {
   EXPECT_EQ(4, d_4_1.values().size());
 }
 
+TEST(DiagTest, Values2DLastCutInBothDims) {
+  Diag<int, unsigned, 2, 2> d_2_2(nullptr, 3, 3);
+  int val = 0;
+  for (auto& v : d_2_2.values()) v = ++val;
+  EXPECT_EQ(5, val);
+  EXPECT_EQ(5, d_2_2.values().size());
+  EXPECT_EQ(4, d_2_2(1, 1));
+  EXPECT_EQ(5, d_2_2(2, 2));
+}
+
+TEST(DiagTest, BlocksAligned) {
+  Diag<char, unsigned, 3, 1> d_3_1(10);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&d_3_1(0, 0)) % 64);
+  auto d_moved(std::move(d_3_1));
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&d_moved(0, 0)) % 64);
+}
+
 TEST(DiagTest, SizeT3D) {
   static int default_val = -1;
   Diag<int, size_t, 4, 1, 99> d_99_1(&default_val, 24, 7, 100000);
@@ -329,3 +410,295 @@ TEST(DiagTest, PolyVectorAppend) {
   lv.Append(MakeList(DiagTag<int, 3, 3, 3>(), &default_val, 7, 7, 7));
   EXPECT_EQ(3, (static_cast<Diag<int, int, 3, 3, 3>&>(lv[1]).block_count()));
 }
+
+namespace {
+
+template<class DiagType, typename T>
+std::vector<T> NaiveProduct(const DiagType& d, const std::vector<T>& x) {
+  std::vector<T> y(d.sizes()[0]);
+  for (size_t r = 0; r < y.size(); ++r)
+    for (size_t c = 0; c < x.size(); ++c)
+      y[r] += d(r, c) * x[c];
+  return y;
+}
+
+}  // namespace
+
+TEST(DiagTest, Multiply2DLastNotFull) {
+  static int default_val = 0;
+  Diag<int, unsigned, 2, 3> d_2_3(&default_val, 9, 13);
+  int val = 0;
+  for (auto& v : d_2_3.values()) v = ++val;
+  std::vector<int> x(13);
+  for (int c = 0; c < 13; ++c) x[c] = c % 4 - 1;
+  std::vector<int> y(9, 42);
+  d_2_3.Multiply(x.data(), y.data());
+  EXPECT_EQ(NaiveProduct(d_2_3, x), y);
+  EXPECT_EQ(1 * -1 + 2 * 0 + 3 * 1, y[0]);
+  EXPECT_EQ(25 * -1, y[8]);
+
+  // the partial block is cut off by the rows
+  Diag<int, unsigned, 2, 3> d_rows(&default_val, 7, 13);
+  for (auto& v : d_rows.values()) v = ++val;
+  d_rows.Multiply(x.data(), y.data());
+  EXPECT_EQ(NaiveProduct(d_rows, x), std::vector<int>(y.begin(), y.begin() + 7));
+}
+
+TEST(DiagTest, MultiplyAdd2DDefault) {
+  static double default_val = 0.5;
+  Diag<double, size_t, 2, 2> d_2_2(&default_val, 4, 5);
+  double val = 0;
+  for (auto& v : d_2_2.values()) v = ++val;
+  std::vector<double> x = {1, 2, 4, 8, 16};
+  std::vector<double> y = {1, 1, 1, 1};
+  d_2_2.MultiplyAdd(x.data(), y.data());
+  auto exp = NaiveProduct(d_2_2, x);
+  for (auto& e : exp) e += 1;
+  EXPECT_EQ(exp, y);
+  EXPECT_EQ(1 + 1 * 1 + 2 * 2 + 0.5 * (4 + 8 + 16), y[0]);
+
+  // rows below the last block have only default values
+  Diag<double, size_t, 2, 2> d_tall(&default_val, 7, 4);
+  for (auto& v : d_tall.values()) v = ++val;
+  y.assign(7, 0);
+  d_tall.Multiply(x.data(), y.data());
+  EXPECT_EQ(NaiveProduct(d_tall, std::vector<double>(x.begin(), x.begin() + 4)),
+            y);
+  EXPECT_EQ(0.5 * 15, y[6]);
+}
+
+TEST(DiagTest, Multiply2D1x1) {
+  static int default_val = 2;
+  Diag<int, unsigned, 1, 1> d_1_1(&default_val, 3, 4);
+  for (int i = 0; i < 3; ++i)
+    d_1_1(i, i) = i + 1;
+  std::vector<int> x = {1, 10, 100, 1000};
+  std::vector<int> y(3);
+  d_1_1.Multiply(x.data(), y.data());
+  EXPECT_EQ(NaiveProduct(d_1_1, x), y);
+  EXPECT_EQ(1 + 2 * 1110, y[0]);
+
+  d_1_1.MultiplyAdd(x.data(), y.data());
+  EXPECT_EQ(2 * (3 * 100 + 2 * 1011), y[2]);
+}
+
+TEST(DynDiagDimScalerTest, MultDiv) {
+  const size_t xs[] = {0, 1, 2, 3, 5, 7, 14, 16, 42, 19937, size_t(-1)};
+  for (size_t rhs : {1, 2, 3, 4, 7, 64, 1000}) {
+    v::detail::DynDiagDimScaler s(rhs);
+    EXPECT_EQ(rhs, s.rhs());
+    for (size_t x : xs) {
+      EXPECT_EQ(x * rhs, x * s) << x << " * " << rhs;
+      EXPECT_EQ(x / rhs, x / s) << x << " / " << rhs;
+    }
+  }
+}
+
+namespace {
+
+template<class DiagType>
+void FillBlocks(const DiagType& d) {
+  // the value at (r, c) is 100 * (r + 1) + c + 1
+  d.ForEachEntry([](const typename DiagType::SizeArray& indexes, int& v) {
+      v = 100 * (indexes[0] + 1) + indexes[1] + 1;
+    });
+}
+
+}  // namespace
+
+TEST(DynDiagTest, SameAsDiag) {
+  static int default_val = 0;
+  Diag<int, unsigned, 2, 3> d(&default_val, 9, 13);
+  DynDiag<int, 2> dd(&default_val, {2, 3}, 9, 13);
+  EXPECT_EQ(d.block_count(), dd.block_count());
+  EXPECT_EQ(3, dd.block_size(1));
+  EXPECT_EQ(d.values().size(), dd.values().size());
+  FillBlocks(d);
+  FillBlocks(dd);
+  for (size_t r = 0; r < 9; ++r)
+    for (size_t c = 0; c < 13; ++c)
+      EXPECT_EQ(d(r, c), dd(r, c)) << "(" << r << ", " << c << ")";
+  EXPECT_EQ(&default_val, &dd(2, 2));
+  EXPECT_EQ(&default_val, &dd(8, 11));
+  EXPECT_EQ(913, dd.get({8, 12}));
+  EXPECT_TRUE(std::equal(d.values().begin(), d.values().end(),
+                         dd.values().begin()));
+  EXPECT_EQ(dd.values().size(),
+            std::distance(dd.values().begin(), dd.values().end()));
+  ExpectDenseIteration(dd);
+  ExpectDimRuns(dd);
+}
+
+TEST(DynDiagTest, LastCutInBothDims) {
+  static int default_val = -1;
+  DynDiag<int, 2> dd(&default_val, {3, 5}, 7, 12);
+  EXPECT_EQ(3, dd.block_count());
+  EXPECT_EQ(3 * 5 + 3 * 5 + 1 * 2, dd.values().size());
+  FillBlocks(dd);
+  std::vector<int> visited;
+  dd.ForEach([&](int& v) { visited.push_back(v); });
+  EXPECT_EQ(std::vector<int>(dd.values().begin(), dd.values().end()), visited);
+  EXPECT_EQ(712, visited.back());
+  EXPECT_EQ(-1, dd(6, 12 - 3));
+  ExpectDenseIteration(dd);
+  ExpectDimRuns(dd);
+}
+
+TEST(DynDiagTest, SizeT3D) {
+  static int default_val = 0;
+  auto dd = MakeList(DynDiagTag<3>(), &default_val, {1, 2, 4}, 2, 4, 7);
+  EXPECT_EQ(2, dd.block_count());
+  EXPECT_EQ(8 + 6, dd.values().size());
+  int val = 0;
+  for (auto& v : dd.values()) v = ++val;
+  EXPECT_EQ(1, dd(0, 0, 0));
+  EXPECT_EQ(8, dd(0, 1, 3));
+  EXPECT_EQ(9, dd(1, 2, 4));
+  EXPECT_EQ(14, dd(1, 3, 6));
+  EXPECT_EQ(0, dd(1, 1, 4));
+  ExpectDenseIteration(dd);
+  ExpectDimRuns(dd);
+}
+
+TEST(DynDiagTest, CopyAndMove) {
+  static int default_val = 0;
+  DynDiag<int, 2> dd(&default_val, {2, 2}, 3, 3);
+  FillBlocks(dd);
+  auto copy(dd);
+  dd(0, 0) = 0;
+  EXPECT_EQ(101, *copy.values().begin());
+  auto moved(std::move(copy));
+  EXPECT_EQ(101, *moved.values().begin());
+  EXPECT_EQ(5, std::distance(moved.values().begin(), moved.values().end()));
+  copy = moved;
+  EXPECT_EQ(&copy(0, 0), &*copy.values().begin());
+  EXPECT_EQ(303, copy(2, 2));
+}
+
+TEST(DynDiagTest, Multiply) {
+  static int default_val = 0, two = 2;
+  DynDiag<int, 2> dd(&default_val, {2, 3}, 9, 13);
+  int val = 0;
+  for (auto& v : dd.values()) v = ++val;
+  std::vector<int> x(13);
+  for (int c = 0; c < 13; ++c) x[c] = c % 4 - 1;
+  std::vector<int> y(9, 42);
+  dd.Multiply(x.data(), y.data());
+  EXPECT_EQ(NaiveProduct(dd, x), y);
+  EXPECT_EQ(25 * -1, y[8]);
+
+  DynDiag<int, 2> dd_default(&two, {3, 5}, 7, 12);
+  FillBlocks(dd_default);
+  std::vector<int> y7(7);
+  dd_default.Multiply(x.data(), y7.data());
+  EXPECT_EQ(NaiveProduct(dd_default, std::vector<int>(x.begin(),
+                                                      x.begin() + 12)), y7);
+}
+
+TEST(DynDiagTest, MultiplyExactFit) {
+  static int zero = 0, two = 2;
+  const std::vector<int> x = {1, -1, 2, 0, 3, 1, -2, 4};
+  // the last block is full in both or in one of the dimensions
+  const std::vector<std::array<size_t, 4> > shapes = {
+    {{2, 2, 4, 4}}, {{1, 1, 3, 5}}, {{1, 1, 5, 3}}, {{2, 3, 4, 6}},
+    {{2, 3, 4, 8}}, {{3, 2, 8, 4}}, {{4, 4, 8, 8}}};
+  for (const auto& shape : shapes) {
+    for (int* default_value : {&zero, &two}) {
+      DynDiag<int, 2> dd(default_value, {shape[0], shape[1]}, shape[2],
+                         shape[3]);
+      FillBlocks(dd);
+      const std::vector<int> xs(x.begin(), x.begin() + shape[3]);
+      std::vector<int> y(shape[2], 42);
+      dd.Multiply(xs.data(), y.data());
+      EXPECT_EQ(NaiveProduct(dd, xs), y)
+          << shape[0] << "x" << shape[1] << " blocks, " << shape[2] << "x"
+          << shape[3] << ", default: " << *default_value;
+    }
+  }
+}
+
+TEST(LazyDiagTest, AllocateOnWrite) {
+  static int default_val = -1;
+  LazyDiag<int, unsigned, 2, 3> d(&default_val, 9, 13);
+  EXPECT_EQ(5, d.block_count());
+  EXPECT_EQ(0, d.allocated_block_count());
+  EXPECT_EQ(0, d.values().size());
+  EXPECT_EQ(d.values().end(), d.values().begin());
+
+  // reading via get() does not allocate the block, unlike operator()
+  EXPECT_EQ(&default_val, &d.get(2, 3));
+  EXPECT_EQ(0, d.allocated_block_count());
+  d(2, 3) = 42;
+  EXPECT_EQ(1, d.allocated_block_count());
+  EXPECT_EQ(42, d.get(2, 3));
+  EXPECT_EQ(-1, d.get(2, 4));
+  EXPECT_EQ(-1, d.get(3, 5));
+  EXPECT_EQ(&default_val, &d(3, 6));  // outside of blocks
+  EXPECT_EQ(6, d.values().size());
+  EXPECT_EQ(std::vector<int>({42, -1, -1, -1, -1, -1}),
+            std::vector<int>(d.values().begin(), d.values().end()));
+
+  // the last block is cut off in both dimensions
+  d(8, 12) = 7;
+  EXPECT_EQ(2, d.allocated_block_count());
+  EXPECT_EQ(6 + 1, d.values().size());
+  std::vector<int> visited;
+  d.ForEach([&](int& v) { visited.push_back(v); });
+  EXPECT_EQ(std::vector<int>({42, -1, -1, -1, -1, -1, 7}), visited);
+  EXPECT_EQ(visited, std::vector<int>(d.values().begin(), d.values().end()));
+  std::vector<decltype(d)::Box> boxes;
+  d.AppendCoverage({0, 0}, &default_val, &boxes);
+  EXPECT_EQ(5, boxes.size());  // writes can allocate any block
+}
+
+TEST(LazyDiagTest, Runs) {
+  static int default_val = 0;
+  auto d = MakeList(LazyDiagTag<unsigned, 2, 2>(), &default_val, 5, 6);
+  d(1, 1) = 1;
+  auto runs = d.runs();
+  for (const auto& run : runs)
+    if (run.start / 6 >= 2) {
+      EXPECT_EQ(&default_val, &run[0]) << run.start;
+    }
+  EXPECT_EQ(1, d.allocated_block_count());
+  for (size_t i = 0; i < 3; ++i)
+    d(2 * i, 2 * i) = 1;
+  EXPECT_EQ(3, d.allocated_block_count());
+  ExpectDenseIteration(d);
+  ExpectDimRuns(d);
+}
+
+TEST(LazyDiagTest, Multiply) {
+  static int default_val = 3;
+  LazyDiag<int, unsigned, 2, 3> d(&default_val, 9, 13);
+  d(0, 1) = 5;
+  d(5, 7) = -2;
+  d(8, 12) = 4;
+  std::vector<int> x(13);
+  for (int c = 0; c < 13; ++c) x[c] = c % 4 - 1;
+  std::vector<int> y(9, 42);
+  d.Multiply(x.data(), y.data());
+  EXPECT_EQ(3, d.allocated_block_count());
+  EXPECT_EQ(NaiveProduct(d, x), y);  // allocates all blocks
+}
+
+TEST(LazyDiagTest, Compact) {
+  static int default_val = -1;
+  LazyDiag<int, unsigned, 1, 2, 3> d(&default_val, 3, 5, 8);
+  d(0, 1, 2) = 1;
+  d(2, 4, 6) = 2;
+  EXPECT_EQ(2, d.allocated_block_count());
+  auto dense = d.Compact();
+  EXPECT_EQ(3, dense.block_count());
+  EXPECT_EQ(6 + 6 + 2, dense.values().size());
+  for (size_t i = 0; i < 3; ++i)
+    for (size_t j = 0; j < 5; ++j)
+      for (size_t k = 0; k < 8; ++k)
+        EXPECT_EQ(d.get(i, j, k), dense(i, j, k));
+  EXPECT_EQ(2, d.allocated_block_count());
+
+  auto moved(std::move(d));
+  EXPECT_EQ(2, moved(2, 4, 6));
+  EXPECT_EQ(6 + 2, std::distance(moved.values().begin(),
+                                 moved.values().end()));
+}
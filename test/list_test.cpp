@@ -1,5 +1,4 @@
 #include "../src/list.hpp"
-#include "../src/util/memory.hpp"
 #include "test.hpp"
 
 #include <algorithm>
@@ -156,6 +155,17 @@ TEST(ListTest, SimpleNonPoly) {
   *l3_it = 100;
   EXPECT_EQ(20, *++l3_it);
   EXPECT_EQ(100, l.get(1));
+
+  // validate internal iteration
+  std::vector<int> visited;
+  l3.ForEach([&](int& v) { visited.push_back(v); });
+  EXPECT_EQ(std::vector<int>({40, 100, 20}), visited);
+  size_t expected_index = 0;
+  l3.ForEachEntry([&](const std::array<size_t, 1>& indexes, int& v) {
+      EXPECT_EQ(expected_index++, indexes[0]);
+      EXPECT_EQ(&l3.get(indexes[0]), &v);
+    });
+  EXPECT_EQ(3, expected_index);
 }
 
 TEST(ListTest, SimpleNonPolyRandomAccessIterator) {
@@ -267,6 +277,35 @@ TEST(ListTest, SimplePolyRandomAccessIterator) {
   EXPECT_EQ(30, l.get(2));
 }
 
+TEST(ListTest, SimplePolyBidirectional) {
+  std::vector<int> v(100);
+  std::iota(v.begin(), v.end(), 0);
+  PortionVector<int> pv;
+  for (size_t from = 0, size = 1; from < v.size(); from += size++)
+    pv.Append(v.begin() + from, std::min(size, v.size() - from));
+  SimpleList<PortionBase<int> > l(std::move(pv));
+
+  // both increments and decrements cross all portion boundaries
+  int expected = 0;
+  for (auto it = l.lbegin(); it != l.lend(); ++it)
+    EXPECT_EQ(expected++, *it);
+  EXPECT_EQ(100, expected--);
+  for (auto rit = l.rbegin(); rit != l.rend(); ++rit)
+    EXPECT_EQ(expected--, *rit);
+  EXPECT_EQ(-1, expected);
+
+  // advance back and forth by short and long distances
+  auto it = l.lbegin();
+  int index = 0;
+  for (int n : {3, -1, -2, 50, -5, -44, 98, -98, 97, -1, -1, -3, -80, 10}) {
+    it += n;
+    index += n;
+    EXPECT_EQ(index, *it) << "after += " << n;
+    EXPECT_EQ(index, it - l.lbegin());
+  }
+  EXPECT_EQ(l.lend(), it + (100 - index));
+}
+
 template<class L>
 void AssertEqualYellow(const L& l) {
   EXPECT_EQ('y', l.get(0));
@@ -318,6 +357,144 @@ TEST(ListTest, SimplePoly) {
   //        (world.crbegin() + 2, 4));
 }
 
+TEST(ListTest, SimplePolyCursor) {
+  std::vector<int> v(100);
+  std::iota(v.begin(), v.end(), 0);
+  PortionVector<int> pv;
+  for (size_t from = 0, size = 1; from < v.size(); from += size++)
+    pv.Append(v.begin() + from, std::min(size, v.size() - from));
+  SimpleList<PortionBase<int> > l(std::move(pv));
+  ASSERT_EQ(100, l.size());
+
+  // seek forward and backward, by short and long distances
+  auto cursor = l.cursor();
+  for (size_t i : {0, 1, 2, 5, 4, 3, 50, 49, 51, 99, 0, 98, 97, 14, 13, 15})
+    EXPECT_EQ(&l.get(i), &cursor.seek(i)) << "seek(" << i << ")";
+  cursor.seek(42) = -42;
+  EXPECT_EQ(-42, v[42]);
+}
+
+template<template<class> class SkipList>
+void ExpectSameAsSimplePoly(std::vector<int>& v) {
+  auto make_portions = [&v]() {
+    PortionVector<int> pv;
+    for (size_t from = 0, size = 1; from < v.size(); from += size++)
+      pv.Append(v.begin() + from, std::min(size, v.size() - from));
+    return pv;
+  };
+  SimpleList<PortionBase<int> > expected(make_portions());
+  SimpleList<PortionBase<int>, SkipList> l(make_portions());
+  ASSERT_EQ(expected.size(), l.size());
+  for (size_t i = 0; i < l.size(); ++i)
+    EXPECT_EQ(&expected.get(i), &l.get(i)) << "get(" << i << ")";
+  auto cursor = l.cursor();
+  for (size_t i : {0, 1, 2, 5, 4, 3, 50, 49, 51, 99, 0, 98, 97, 14, 13, 15})
+    EXPECT_EQ(&expected.get(i), &cursor.seek(i)) << "seek(" << i << ")";
+  EXPECT_TRUE(std::equal(l.lbegin(), l.lend(), v.begin()));
+  EXPECT_TRUE(std::equal(l.rbegin(), l.rend(), v.rbegin()));
+  for (int n : {3, 50, -44, 48, -49})
+    EXPECT_EQ(*(expected.lbegin() + 49 + n), *(l.lbegin() + 49 + n));
+}
+
+TEST(ListTest, SimplePolyPrefixIndexes) {
+  std::vector<int> v(100);
+  std::iota(v.begin(), v.end(), 0);
+  ExpectSameAsSimplePoly<EytzingerPrefixIndex>(v);
+  ExpectSameAsSimplePoly<BTreePrefixIndex>(v);
+}
+
+TEST(ListTest, SimplePolyGather) {
+  std::vector<int> v(1000);
+  std::iota(v.begin(), v.end(), 0);
+  PortionVector<int> pv;
+  for (size_t from = 0, size = 1; from < v.size(); from += size++)
+    pv.Append(v.begin() + from, std::min(size, v.size() - from));
+  SimpleList<PortionBase<int> > l(std::move(pv));
+
+  // gather more than one chunk of indexes, in no particular order
+  std::vector<size_t> indexes;
+  for (size_t i = 0, last = 1; i < 300; ++i, last = i + last * 65521)
+    indexes.push_back(last % v.size());
+  std::vector<int> values;
+  l.gather(indexes, std::back_inserter(values));
+  EXPECT_EQ(std::vector<int>(indexes.begin(), indexes.end()), values);
+
+  int arr[2];
+  EXPECT_EQ(arr + 2, l.gather({999, 0}, arr));
+  EXPECT_EQ(999, arr[0]);
+  EXPECT_EQ(0, arr[1]);
+}
+
+TEST(ListTest, MutableSimpleInsertErase) {
+  std::vector<int> v(10);
+  std::iota(v.begin(), v.end(), 0);
+  MutableSimpleList<PortionBase<int> > l{PortionVector<int>()};
+  EXPECT_EQ(0, l.size());
+  EXPECT_EQ(0, l.portion_count());
+  EXPECT_EQ(l.lbegin(), l.lend());
+
+  auto expect_values = [&l](const std::vector<int>& expected) {
+    ASSERT_EQ(expected.size(), l.size());
+    EXPECT_EQ(expected.size(), l.sizes()[0]);
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_EQ(expected[i], l.get(i)) << "get(" << i << ")";
+    EXPECT_EQ(expected, std::vector<int>(l.lbegin(), l.lend()));
+    EXPECT_TRUE(std::equal(expected.rbegin(), expected.rend(), l.rbegin()));
+    auto cursor = l.cursor();
+    for (size_t i = expected.size(); i--; )
+      EXPECT_EQ(&l.get(i), &cursor.seek(i)) << "seek(" << i << ")";
+  };
+
+  l.Insert(0, v.begin() + 4, 3);        // 4 5 6
+  expect_values({4, 5, 6});
+  l.Insert(0, v.begin(), 2);            // 0 1 | 4 5 6
+  l.Insert(1, v[9]);                    // 0 1 | 9 | 4 5 6
+  l.Insert(2, v.begin() + 2, 2);        // 0 1 | 9 | 2 3 | 4 5 6
+  l.Insert(4, v.begin() + 7, 2);        // 0 1 | 9 | 2 3 | 4 5 6 | 7 8
+  EXPECT_EQ(5, l.portion_count());
+  expect_values({0, 1, 9, 2, 3, 4, 5, 6, 7, 8});
+
+  l.Erase(1);                           // 0 1 | 2 3 | 4 5 6 | 7 8
+  expect_values({0, 1, 2, 3, 4, 5, 6, 7, 8});
+  l.Erase(3);                           // 0 1 | 2 3 | 4 5 6
+  l.Erase(0);                           // 2 3 | 4 5 6
+  expect_values({2, 3, 4, 5, 6});
+  l.cursor().seek(3) = -5;
+  EXPECT_EQ(-5, v[5]);
+
+  l.Erase(1);
+  l.Erase(0);
+  EXPECT_EQ(0, l.portion_count());
+  expect_values({});
+  l.Insert(0, v[1]);                    // reuse after becoming empty
+  expect_values({1});
+}
+
+TEST(ListTest, MutableSimpleReuseSlots) {
+  int arr[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  MutableSimpleList<Portion<int*> > l{PortionVector<int, Portion<int*> >()};
+  for (int i = 0; i < 4; ++i)
+    l.Insert(0, arr + 2 * i, 2);        // 6 7 | 4 5 | 2 3 | 0 1
+  auto values = [&l] { return std::vector<int>(l.begin(), l.end()); };
+  EXPECT_EQ(std::vector<int>({6, 7, 4, 5, 2, 3, 0, 1}), values());
+
+  l.Erase(1);                           // 6 7 | 2 3 | 0 1
+  l.Erase(2);                           // 6 7 | 2 3
+  l.Insert(1, arr + 1, 3);              // 6 7 | 1 2 3 | 2 3
+  l.Insert(0, arr + 5, 1);              // 5 | 6 7 | 1 2 3 | 2 3
+  l.Insert(4, arr, 1);                  // 5 | 6 7 | 1 2 3 | 2 3 | 0
+  EXPECT_EQ(std::vector<int>({5, 6, 7, 1, 2, 3, 2, 3, 0}), values());
+  EXPECT_EQ(9, l.size());
+  EXPECT_EQ(5, l.portion_count());
+  auto cursor = l.cursor();
+  for (size_t i = 0; i < l.size(); ++i)
+    EXPECT_EQ(&l.get(i), &cursor.seek(i)) << "seek(" << i << ")";
+  EXPECT_EQ(values(), std::vector<int>(l.lbegin(), l.lend()));
+  std::vector<int> spans;
+  l.ForEach([&spans](const int& value) { spans.push_back(value); });
+  EXPECT_EQ(values(), spans);
+}
+
 TEST(ListTest, ImplicitPoly) {
   static char y = 'y';
   static const char *hello_world_str = "hello world";
@@ -0,0 +1,171 @@
+#include "../src/chain.hpp"
+#include "../src/diag.hpp"
+#include "../src/parallel.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+// Returns the values of the ranges in order and checks that they are not empty
+template<class Range>
+std::vector<int> Concat(const std::vector<Range>& parts) {
+  std::vector<int> values;
+  for (const auto& part : parts) {
+    EXPECT_FALSE(part.first == part.second);
+    for (auto it = part.first; it != part.second; ++it)
+      values.push_back(*it);
+  }
+  return values;
+}
+
+// A sequence that can be concatenated (non-commutatively) by Reduce
+struct IntSeq : public std::vector<int> {
+  IntSeq() = default;
+  IntSeq(int value) : std::vector<int>(1, value) {}
+};
+
+template<class Values>
+std::vector<int> Serial(const Values& values) {
+  return std::vector<int>(values.begin(), values.end());
+}
+
+}  // namespace
+
+TEST(ParallelTest, DiagPartition) {
+  static int zero = 0;
+  Diag<int, unsigned, 2, 3> d_2_3(&zero, 9, 13);  // last block not full
+  int i = 0;
+  for (auto& value : d_2_3.values())
+    value = ++i;
+  for (size_t part_count : {1, 2, 3, 4, 5, 10}) {
+    auto parts = d_2_3.values().partition(part_count);
+    EXPECT_EQ(std::min<size_t>(part_count, 5), parts.size());
+    EXPECT_EQ(Serial(d_2_3.values()), Concat(parts)) << part_count;
+  }
+
+  Diag<int, unsigned, 1, 1> d_1_1(&zero, 10, 10);
+  std::iota(d_1_1.values().begin(), d_1_1.values().end(), 1);
+  auto parts = d_1_1.values().partition(4);
+  ASSERT_EQ(4, parts.size());
+  EXPECT_EQ(2, std::distance(parts[0].first, parts[0].second));
+  EXPECT_EQ(3, std::distance(parts[1].first, parts[1].second));
+  EXPECT_EQ(Serial(d_1_1.values()), Concat(parts));
+  EXPECT_EQ(10, d_1_1.values().partition(20).size());
+}
+
+TEST(ParallelTest, ChainPartition) {
+  static int zero = 0;
+  typedef Diag<int, unsigned, 1, 1> InnerView;
+  ListVector<InnerView> lists;
+  for (size_t size : {5, 0, 3, 3, 0, 0, 1, 4, 2, 6})
+    lists.Append(DiagTag<unsigned, 1, 1>(), &zero, size, size);
+  Chain<InnerView, 0> c(std::move(lists), &zero);
+  int i = 0;
+  for (auto& value : c.values())
+    value = ++i;
+  ASSERT_EQ(24, i);
+
+  for (size_t part_count : {1, 2, 3, 4, 6, 24, 100}) {
+    auto parts = c.values().partition(part_count);
+    EXPECT_LE(parts.size(), part_count);
+    EXPECT_EQ(Serial(c.values()), Concat(parts)) << part_count;
+  }
+
+  // split at the 6th (within the 3rd sublist), 12th and 18th value
+  auto parts = c.values().partition(4);
+  ASSERT_EQ(4, parts.size());
+  EXPECT_EQ(6, std::distance(parts[0].first, parts[0].second));
+  EXPECT_EQ(6, std::distance(parts[1].first, parts[1].second));
+  EXPECT_EQ(6, std::distance(parts[2].first, parts[2].second));
+  EXPECT_EQ(6, std::distance(parts[3].first, parts[3].second));
+}
+
+TEST(ParallelTest, ChainPartitionWithinSublist) {
+  // the big sublist is split by its own partition(), or over its spans
+  static int zero = 0;
+  const size_t big_size = 1000000, size = big_size + 10;
+  typedef Diag<int, unsigned, 1, 1> InnerView;
+  ListVector<InnerView> lists;
+  lists.Append(DiagTag<unsigned, 1, 1>(), &zero, big_size, big_size);
+  lists.Append(DiagTag<unsigned, 1, 1>(), &zero, 10, 10);
+  Chain<InnerView, 0> c(std::move(lists), &zero);
+  std::iota(c.values().begin(), c.values().end(), 1);
+
+  ListVector<ListBase<int, 2> > poly_lists;
+  poly_lists.Append(DiagTag<unsigned, 1, 1>(), &zero, big_size, big_size);
+  poly_lists.Append(DiagTag<unsigned, 1, 1>(), &zero, 10, 10);
+  Chain<ListBase<int, 2>, 0> poly_c(std::move(poly_lists), &zero);
+  std::iota(poly_c.values().begin(), poly_c.values().end(), 1);
+
+  for (size_t part_count : {2, 4, 7}) {
+    auto parts = c.values().partition(part_count);
+    ASSERT_EQ(part_count, parts.size());
+    for (const auto& part : parts)
+      EXPECT_NEAR(size / part_count, std::distance(part.first, part.second),
+                  size / part_count / 16) << part_count;
+    EXPECT_EQ(Serial(c.values()), Concat(parts)) << part_count;
+
+    auto poly_parts = poly_c.values().partition(part_count);
+    ASSERT_EQ(part_count, poly_parts.size());
+    for (const auto& part : poly_parts)
+      EXPECT_NEAR(size / part_count,
+                  std::distance(part.first, part.second), 1) << part_count;
+    EXPECT_EQ(Serial(poly_c.values()), Concat(poly_parts)) << part_count;
+  }
+}
+
+TEST(ParallelTest, UniformChainPartition) {
+  static int zero = 0;
+  typedef Diag<int, unsigned, 1, 1> InnerView;
+  ListVector<InnerView> lists;
+  for (int k = 0; k < 4; ++k)
+    lists.Append(DiagTag<unsigned, 1, 1>(), &zero, 2, 2);
+  UniformChain<InnerView, 1, 2, 1> uc(std::move(lists), &zero);
+  std::iota(uc.values().begin(), uc.values().end(), 1);
+  auto parts = uc.values().partition(2);
+  ASSERT_EQ(2, parts.size());
+  EXPECT_EQ(4, std::distance(parts[0].first, parts[0].second));
+  EXPECT_EQ(Serial(uc.values()), Concat(parts));
+}
+
+TEST(ParallelTest, ReduceAndForEach) {
+  static int zero = 0;
+  typedef Diag<int, unsigned, 1, 1> InnerView;
+  ListVector<InnerView> lists;
+  for (size_t k = 0; k < 50; ++k)
+    lists.Append(DiagTag<unsigned, 1, 1>(), &zero, k % 7 * 10, k % 7 * 10);
+  Chain<InnerView, 1> c(std::move(lists), &zero);
+  std::iota(c.values().begin(), c.values().end(), 1);
+  const long n = c.values().size();
+
+  for (size_t thread_count : {1, 2, 3, 8}) {
+    ThreadPool pool(thread_count);
+    EXPECT_EQ(n * (n + 1) / 2, parallel::Reduce(c.values(), 0L,
+                                                std::plus<long>(), &pool));
+
+    // the order is preserved for non-commutative operations
+    IntSeq concat = parallel::Reduce(
+        c.values(), IntSeq(),
+        [](IntSeq lhs, const IntSeq& rhs) {
+          lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+          return lhs;
+        }, &pool);
+    EXPECT_EQ(Serial(c.values()), static_cast<std::vector<int>&>(concat));
+
+    std::mutex mutex;
+    long sum = 0;
+    parallel::ForEach(c.values(), [&](int value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sum += value;
+      }, &pool);
+    EXPECT_EQ(n * (n + 1) / 2, sum);
+  }
+
+  EXPECT_EQ(n * (n + 1) / 2, parallel::Reduce(c.values(), 0L));
+}
@@ -60,7 +60,7 @@ class PortionSpeedTest : public ::testing::Test,
 
   void InitArray(DataType* arr, unsigned size) const {
     std::fill(arr, arr + size, 0);
-    for (int i = 1; i < size; ++i)
+    for (unsigned i = 1; i < size; ++i)
       arr[i] = 2104087157 * arr[i - 1] + i;
   }
 
@@ -0,0 +1,174 @@
+#include "../src/segment.hpp"
+#include "../src/chain.hpp"
+#include "../src/diag.hpp"
+#include "../src/list.hpp"
+#include "../src/sparse_list.hpp"
+#include "test.hpp"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+TEST(SegmentTest, AppendSegment) {
+  int arr[] = {0, 10, 20, 30, 40, 50};
+  SegmentVector<int> s;
+  AppendSegment(arr + 1, 2, &s);
+  AppendSegment(arr + 3, 0, &s);  // ignored
+  AppendSegment(arr + 3, 1, &s);  // merged
+  ASSERT_EQ(1, s.size());
+  EXPECT_EQ(arr + 1, s[0].data);
+  EXPECT_EQ(3, s[0].size);
+  EXPECT_EQ(0, s[0].offset);
+
+  AppendSegment(arr, 1, &s);
+  ASSERT_EQ(2, s.size());
+  EXPECT_EQ(arr, s[1].data);
+  EXPECT_EQ(1, s[1].size);
+  EXPECT_EQ(3, s[1].offset);
+  EXPECT_EQ(4, SegmentedSize(s));
+}
+
+TEST(SegmentTest, Algorithms) {
+  int arr[] = {0, 10, 20, 30, 40, 50};
+  SegmentVector<int> s;
+  AppendSegment(arr + 4, 2, &s);
+  AppendSegment(arr + 1, 2, &s);
+
+  std::vector<int> copy(4);
+  EXPECT_EQ(copy.end(), SegmentedCopy(s, copy.begin()));
+  EXPECT_EQ(std::vector<int>({40, 50, 10, 20}), copy);
+
+  EXPECT_EQ(120, SegmentedAccumulate(s, 0));
+  EXPECT_EQ(0, SegmentedFind(s, 40));
+  EXPECT_EQ(3, SegmentedFind(s, 20));
+  EXPECT_EQ(4, SegmentedFind(s, 30));  // not in any segment
+
+  SegmentedFill(s, 7);
+  EXPECT_EQ(std::vector<int>({0, 7, 7, 30, 7, 7}),
+            std::vector<int>(arr, arr + 6));
+  EXPECT_EQ(0, SegmentedAccumulate(SegmentVector<int>(), 0));
+}
+
+TEST(SegmentTest, SimpleList) {
+  int arr[] = {0, 10, 20, 30, 40, 50};
+  auto l = MakeList(PortionVector<int, Portion<int*> >()
+                    .Append(arr + 1, 2)
+                    .Append(arr + 3, 2)
+                    .Append(arr, 1));
+  auto s = l.segments();
+  ASSERT_EQ(2, s.size());
+  EXPECT_EQ(arr + 1, s[0].data);
+  EXPECT_EQ(4, s[0].size);
+  EXPECT_EQ(arr, s[1].data);
+  EXPECT_EQ(1, s[1].size);
+  EXPECT_EQ(4, s[1].offset);
+  EXPECT_EQ(100, SegmentedAccumulate(s, 0));
+
+  // contiguous values are merged even if the iterator is not a pointer
+  std::vector<int> every10 = {0, 10, 20, 30, 40, 50};
+  SimpleList<PortionBase<int> > pl(
+      PortionVector<int>()
+      .Append(every10.begin() + 1, 2)
+      .Append(every10.rbegin(), 2)
+      .Append(static_cast<int&>(arr[5])));
+  auto ps = pl.segments();
+  ASSERT_EQ(4, ps.size());
+  EXPECT_EQ(2, ps[0].size);
+  EXPECT_EQ(&every10[5], ps[1].data);
+  EXPECT_EQ(&every10[4], ps[2].data);
+  EXPECT_EQ(arr + 5, ps[3].data);
+  EXPECT_EQ(4, ps[3].offset);
+  EXPECT_EQ(170, SegmentedAccumulate(ps, 0));
+
+  // a portion of a vector or a string is a single span, like of a pointer
+  Portion<std::vector<int>::iterator> vp(every10.begin() + 1, 4);
+  size_t span_count = 0;
+  vp.ForEachSpan([&](int* data, size_t size) {
+      EXPECT_EQ(&every10[1], data);
+      EXPECT_EQ(4, size);
+      ++span_count;
+    });
+  EXPECT_EQ(1, span_count);
+  EXPECT_TRUE(IsContiguousIter<std::string::const_iterator>::value);
+  EXPECT_FALSE(IsContiguousIter<std::vector<int>::reverse_iterator>::value);
+  EXPECT_FALSE(IsContiguousIter<std::deque<int>::iterator>::value);
+}
+
+TEST(SegmentTest, DiagLastNotFull) {
+  static int default_val = -1;
+  Diag<int, unsigned, 2, 3> d_2_3(&default_val, 8, 10);
+  int val = 0;
+  for (auto& v : d_2_3.values()) v = val++;
+
+  // the 1st value of the last block is adjacent to the full blocks
+  auto s = d_2_3.segments();
+  ASSERT_EQ(2, s.size());
+  EXPECT_EQ(19, s[0].size);
+  EXPECT_EQ(&d_2_3(0, 0), s[0].data);
+  EXPECT_EQ(&d_2_3(7, 9), s[1].data);
+  EXPECT_EQ(1, s[1].size);
+  EXPECT_EQ(19, s[1].offset);
+
+  std::vector<int> copy(20);
+  SegmentedCopy(s, copy.begin());
+  for (int i = 0; i < 20; ++i)
+    EXPECT_EQ(i, copy[i]) << "i = " << i;
+  EXPECT_EQ(19, SegmentedFind(s, 19));
+}
+
+TEST(SegmentTest, ChainOfDiags) {
+  static int default_val = -1;
+  Chain<ListBase<int, 2>, 0> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 3, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 1, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 3)
+      , &default_val);
+  c(0, 0) = 10, c(1, 1) = 20, c(2, 2) = 30;
+  c(3, 0) = 40;
+  c(4, 0) = 50, c(5, 1) = 60;
+
+  auto s = c.segments();
+  ASSERT_EQ(3, s.size());
+  EXPECT_EQ(3, s[0].size);
+  EXPECT_EQ(&c(0, 0), s[0].data);
+  EXPECT_EQ(3, s[1].offset);
+  EXPECT_EQ(&c(4, 0), s[2].data);
+  EXPECT_EQ(2, s[2].size);
+  EXPECT_EQ(210, SegmentedAccumulate(s, 0));
+  EXPECT_EQ(4, SegmentedFind(s, 50));
+  SegmentedFill(s, 1);
+  EXPECT_EQ(1, c(5, 1));
+  EXPECT_EQ(-1, c(5, 2));
+}
+
+TEST(SegmentTest, ForEachSpan) {
+  static int default_val = -1;
+  Chain<ListBase<int, 2>, 0> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 3, 3)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 2, 3)
+      , &default_val);
+  c(0, 0) = 10, c(1, 1) = 20, c(2, 2) = 30;
+  c(3, 0) = 40, c(4, 1) = 50;
+
+  std::vector<int> visited, span_visited;
+  c.ForEach([&](int& v) { visited.push_back(v); });
+  size_t span_count = 0;
+  c.ForEachSpan([&](int* data, size_t size) {
+    ++span_count;
+    span_visited.insert(span_visited.end(), data, data + size);
+  });
+  EXPECT_EQ(2, span_count);
+  EXPECT_EQ(visited, span_visited);
+}
+
+TEST(SegmentTest, SparseDefault) {
+  int zero = 0;
+  SparseHashList<int, 2> sl(SparseListTag<2>(), &zero, 3, 3);
+  sl.get({0, 1}) = 1;
+  sl.get({2, 2}) = 2;
+  auto s = sl.segments();
+  EXPECT_EQ(2, SegmentedSize(s));
+  EXPECT_EQ(3, SegmentedAccumulate(s, 0));
+}
@@ -1,6 +1,12 @@
 #include "../src/sparse_list.hpp"
+#include "../src/chain.hpp"
 #include "test.hpp"
 
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
 // typedef ::testing::Types<
 //   std::integral_constant<unsigned, 3>,
 //   std::integral_constant<size_t, 4>,
@@ -38,5 +44,354 @@ TEST(SparseListTest, 2D) {
   sm.get({2, 3}) = 4.5;
   EXPECT_EQ(4.5, sm(2, 3));
 
+  sm.get({0, 1}) = 1.5;
+  double sum = 0;
+  sm.ForEach([&](double& v) { sum += v; });
+  EXPECT_EQ(6, sum);
+  std::vector<std::array<size_t, 2> > indexes;
+  sm.ForEachEntry([&](const std::array<size_t, 2>& ind, double& v) {
+      EXPECT_EQ(sm(ind[0], ind[1]), v);
+      indexes.push_back(ind);
+    });
+  EXPECT_EQ((std::vector<std::array<size_t, 2> >{{{0, 1}}, {{2, 3}}}),
+            indexes);
+
   // TODO complete
 }
+
+TEST(SparseListTest, ValuesOrder) {
+  // the values are in row-major order (like ForEachEntry), not insertion order
+  int zero = 0;
+  SparseHashList<int, 2> sl(SparseListTag<2>(), &zero, 3, 4);
+  sl.get({2, 0}) = 3;
+  sl.get({1, 3}) = 2;
+  sl.get({0, 1}) = 1;
+  EXPECT_EQ(std::vector<int>({1, 2, 3}),
+            std::vector<int>(sl.values().begin(), sl.values().end()));
+  std::vector<int> visited;
+  sl.ForEach([&visited](int v) { visited.push_back(v); });
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), visited);
+  EXPECT_EQ(3, sl.segments().size());  // not adjacent in memory in that order
+
+  // the iterators see the values inserted before they are created
+  sl.get({2, 1}) = 4;
+  sl.get({2, 2}) = 5;
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5}),
+            std::vector<int>(sl.begin(), sl.end()));
+  EXPECT_EQ(5, sl.values().size());
+  auto segments = sl.segments();
+  ASSERT_EQ(4, segments.size());  // the last 2 values are adjacent
+  EXPECT_EQ(2, segments.back().size);
+  EXPECT_EQ(&sl(2, 1), segments.back().data);
+
+  // the values of a copy are its own
+  SparseHashList<int, 2> copy(sl);
+  copy.get({0, 0}) = 6;
+  EXPECT_EQ(std::vector<int>({6, 1, 2, 3, 4, 5}),
+            std::vector<int>(copy.values().begin(), copy.values().end()));
+  EXPECT_EQ(5, sl.values().size());
+}
+
+TEST(SparseListTest, WideIndexes) {
+  // the indexes need 3 * 31 bits, so they cannot be packed into 64 bits
+  static int zero = 0;
+  const size_t size = size_t(1) << 30;
+  SparseHashList<int, 3> sl(SparseListTag<3>(), &zero, size, size, size);
+  sl.get({1, 0, 0}) = 1;
+  sl.get({5, 0, 0}) = 5;
+  sl.get({0, 0, size - 1}) = 3;
+  sl.get({size - 1, size - 1, size - 1}) = 7;
+  EXPECT_EQ(4, sl.nondefault_count());
+  EXPECT_EQ(1, sl(1, 0, 0));
+  EXPECT_EQ(5, sl(5, 0, 0));
+  EXPECT_EQ(3, sl(0, 0, size - 1));
+  EXPECT_EQ(7, sl(size - 1, size - 1, size - 1));
+  EXPECT_EQ(&zero, &sl(0, 0, 0));
+  EXPECT_EQ(nullptr, sl.find({{5, 0, 1}}));
+
+  std::vector<int> visited;
+  sl.ForEachEntry([&](const std::array<size_t, 3>& ind, int& v) {
+      EXPECT_EQ(&sl(ind[0], ind[1], ind[2]), &v);
+      visited.push_back(v);
+    });
+  EXPECT_EQ(std::vector<int>({3, 1, 5, 7}), visited);  // in row-major order
+}
+
+TEST(SparseListTest, Runs) {
+  int zero = 0;
+  SparseHashList<int, 2> sl(SparseListTag<2>(), &zero, 3, 4);
+  sl.get({0, 1}) = 1;
+  sl.get({0, 2}) = 2;
+  sl.get({2, 3}) = 3;
+
+  auto runs = sl.runs();
+  ASSERT_EQ(5, runs.size());
+  EXPECT_TRUE(runs[0].repeated);
+  EXPECT_EQ(1, runs[0].length);
+  EXPECT_EQ(1, runs[1][0]);
+  EXPECT_EQ(2, runs[2][0]);
+  EXPECT_EQ(2, runs[2].start);
+  EXPECT_TRUE(runs[3].repeated);
+  EXPECT_EQ(&zero, runs[3].value);
+  EXPECT_EQ(8, runs[3].length);  // spans 3 rows
+  EXPECT_EQ(3, runs[4][0]);
+  EXPECT_EQ(11, runs[4].start);
+  EXPECT_EQ(3, sl.nondefault_count());  // not inserted by runs()
+
+  // column 3 consists of a default stretch followed by the value in row 2
+  decltype(runs) col_runs;
+  sl.AppendDimRuns(0, {{0, 3}}, 0, &col_runs);
+  ASSERT_EQ(2, col_runs.size());
+  EXPECT_EQ(&zero, col_runs[0].value);
+  EXPECT_EQ(2, col_runs[0].length);
+  EXPECT_EQ(3, col_runs[1][0]);
+  EXPECT_EQ(2, col_runs[1].start);
+  EXPECT_EQ(3, sl.nondefault_count());  // not inserted by AppendDimRuns()
+}
+
+namespace {
+
+// the value at (r, c) is 10 * (r + 1) + c + 1 unless it is default
+SparseHashList<int, 2> MakeSparseMatrix(
+    int* default_value, size_t row_count, size_t col_count,
+    const std::vector<std::array<size_t, 2> >& indexes) {
+  SparseHashList<int, 2> sl(SparseListTag<2>(), default_value, row_count,
+                            col_count);
+  for (auto ind : indexes)
+    sl.get(std::move(ind)) = 10 * (ind[0] + 1) + ind[1] + 1;
+  return sl;
+}
+
+}  // namespace
+
+TEST(SparseCsrListTest, Compact) {
+  static int zero = 0;
+  //     0  1  2  3  4
+  // 0   .  .  .  .  .
+  // 1  21  .  .  .  25
+  // 2   .  .  33 34 .
+  // 3   .  42 .  .  .
+  auto sl = MakeSparseMatrix(&zero, 4, 5, {{{2, 3}}, {{1, 4}}, {{3, 1}},
+                                           {{2, 2}}, {{1, 0}}});
+  const auto csr = sl.Compact();
+  EXPECT_EQ(sl.sizes(), csr.sizes());
+  EXPECT_EQ(5, csr.nondefault_count());
+  EXPECT_EQ(std::vector<int>({21, 25, 33, 34, 42}),
+            std::vector<int>(csr.values().begin(), csr.values().end()));
+  for (size_t r = 0; r < 4; ++r)
+    for (size_t c = 0; c < 5; ++c)
+      EXPECT_EQ(sl(r, c), csr(r, c)) << "(" << r << ", " << c << ")";
+  EXPECT_EQ(&zero, &csr(0, 4));
+  EXPECT_EQ(5, sl.nondefault_count());  // not inserted by Compact()
+
+  // the adjacent values in a row are in the same run
+  auto runs = csr.runs();
+  ASSERT_EQ(9, runs.size());
+  EXPECT_EQ(12, runs[5].start);
+  EXPECT_EQ(2, runs[5].length);
+  EXPECT_EQ(34, runs[5][1]);
+  EXPECT_EQ(1, csr.segments().size());
+
+  ExpectDenseIteration(csr);
+  ExpectDimRuns(csr);
+  EXPECT_EQ(csr.size(), std::distance(csr.iterator_begin(),
+                                      csr.iterator_end()));  // dense
+
+  auto made = MakeList(SparseCsrTag(), sl);
+  EXPECT_EQ(34, made(2, 3));
+}
+
+TEST(SparseCsrListTest, DimIter) {
+  static int zero = 0;
+  const auto csr = MakeSparseMatrix(&zero, 4, 4, {{{0, 1}}, {{2, 0}},
+                                                  {{2, 3}}, {{3, 1}}})
+      .Compact();
+  std::vector<int> line;
+  for (auto it = csr.dim_begin<1>(2), it_end = csr.dim_end<1>(2);
+       it != it_end; ++it)
+    line.push_back(*it);
+  EXPECT_EQ(std::vector<int>({31, 0, 0, 34}), line);
+
+  line.clear();
+  for (auto it = csr.nondefault_dim_cbegin<0>(1),
+           it_end = csr.nondefault_dim_cend<0>(1); it != it_end; ++it)
+    line.push_back(*it);
+  EXPECT_EQ(std::vector<int>({12, 42}), line);
+
+  std::vector<size_t> rows;
+  for (auto it = csr.entry_dim_begin<0>(0), it_end = csr.entry_dim_end<0>(0);
+       it != it_end; ++it)
+    rows.push_back(it->indexes()[0]);
+  EXPECT_EQ(std::vector<size_t>({2}), rows);
+}
+
+TEST(SparseCsrListTest, CopyAndMove) {
+  static int zero = 0;
+  auto csr = MakeSparseMatrix(&zero, 3, 3, {{{0, 0}}, {{1, 2}}}).Compact();
+  auto copy(csr);
+  csr(0, 0) = 0;
+  EXPECT_EQ(11, *copy.values().begin());
+  auto moved(std::move(copy));
+  EXPECT_EQ(11, *moved.values().begin());
+  EXPECT_EQ(2, std::distance(moved.values().begin(), moved.values().end()));
+  copy = moved;
+  EXPECT_EQ(&copy(1, 2), &*++copy.values().begin());
+}
+
+TEST(SparseCsrListTest, Multiply) {
+  static int zero = 0, two = 2;
+  const std::vector<std::array<size_t, 2> > indexes = {
+    {{0, 6}}, {{1, 1}}, {{1, 2}}, {{3, 0}}, {{3, 4}}, {{4, 3}}, {{4, 5}}};
+  std::vector<int> x = {1, -1, 2, 0, 3, 1, -2};
+  for (int* default_value : {&zero, &two}) {
+    const auto sl = MakeSparseMatrix(default_value, 5, 7, indexes);
+    const auto csr = sl.Compact();
+    std::vector<int> exp(5);
+    for (size_t r = 0; r < exp.size(); ++r)
+      for (size_t c = 0; c < x.size(); ++c)
+        exp[r] += sl(r, c) * x[c];
+    std::vector<int> y(5, 42);
+    csr.Multiply(x.data(), y.data());
+    EXPECT_EQ(exp, y) << "default: " << *default_value;
+    csr.MultiplyAdd(x.data(), y.data());
+    for (auto& e : exp) e *= 2;
+    EXPECT_EQ(exp, y) << "default: " << *default_value;
+  }
+}
+
+TEST(SparseCsrListTest, InChain) {
+  static int zero = 0;
+  ListVector<ListBase<int, 2> > lv;
+  lv.Append(MakeSparseMatrix(&zero, 2, 2, {{{0, 1}}}).Compact());
+  lv.Append(SparseCsrTag(), MakeSparseMatrix(&zero, 2, 3, {{{1, 0}}}));
+  Chain<ListBase<int, 2>, 1> chain(std::move(lv), &zero);
+  EXPECT_EQ(decltype(chain)::SizeArray({2, 5}), chain.sizes());
+  EXPECT_EQ(12, chain(0, 1));
+  EXPECT_EQ(21, chain(1, 2));
+  EXPECT_EQ(0, chain(1, 0));
+  EXPECT_EQ(2, chain.values().size());
+  ExpectDenseIteration(chain);
+}
+
+TEST(SparseListTest, InsertIntoChain) {
+  // the values of the chain include those inserted after its construction
+  static int zero = 0;
+  ListVector<ListBase<int, 2> > lv;
+  lv.Append(MakeSparseMatrix(&zero, 2, 2, {{{0, 1}}}));
+  lv.Append(MakeSparseMatrix(&zero, 2, 3, {{{1, 0}}}));
+  Chain<ListBase<int, 2>, 1> chain(std::move(lv), &zero);
+  EXPECT_EQ(2, chain.values().size());
+  chain.get({0, 0}) = 11;
+  chain.get({1, 4}) = 23;
+  int sum = 0;
+  chain.ForEach([&sum](int v) { sum += v; });
+  EXPECT_EQ(12 + 21 + 11 + 23, sum);
+  EXPECT_EQ(4, chain.values().size());
+  EXPECT_EQ(sum, std::accumulate(chain.values().begin(), chain.values().end(),
+                                 0));
+}
+
+TEST(SparseMortonListTest, GetAndFind) {
+  static int zero = 0;
+  auto sm = MakeList(SparseMortonTag(), &zero, 5, 7);
+  EXPECT_EQ(SparseMortonList<int>::SizeArray({5, 7}), sm.sizes());
+  sm.get({4, 6}) = 46;
+  sm.get({0, 1}) = 1;
+  sm.get({1, 0}) = 10;
+  EXPECT_EQ(46, sm(4, 6));
+  EXPECT_EQ(&zero, &sm(2, 2));
+  EXPECT_EQ(nullptr, sm.find(3, 3));
+  EXPECT_EQ(3, sm.nondefault_count());  // not inserted by find() or ()
+
+  std::vector<int> visited;
+  sm.ForEachEntry([&](const std::array<size_t, 2>& ind, int& v) {
+      EXPECT_EQ(sm(ind[0], ind[1]), v);
+      visited.push_back(v);
+    });
+  EXPECT_EQ(std::vector<int>({1, 10, 46}), visited);  // in Morton order
+  EXPECT_EQ(3, std::distance(sm.begin(), sm.end()));
+
+  // the values are in the same order, and so are the polymorphic iterators
+  EXPECT_EQ(3, sm.values().size());
+  EXPECT_EQ(visited,
+            std::vector<int>(sm.values().begin(), sm.values().end()));
+  std::vector<int> values;
+  sm.ForEach([&values](int v) { values.push_back(v); });
+  EXPECT_EQ(visited, values);
+  EXPECT_EQ(visited, std::vector<int>(sm.iterator_begin(), sm.iterator_end()));
+}
+
+TEST(SparseMortonListTest, ForEachInRange) {
+  static int zero = 0;
+  SparseMortonList<int> sm(&zero, 40, 50);
+  std::mt19937 gen(42);
+  for (int i = 0; i < 300; ++i) {
+    const size_t row = gen() % 40, col = gen() % 50;
+    sm.get({row, col}) = 100 * row + col;
+  }
+
+  typedef std::array<size_t, 2> SizeArray;
+  for (int i = 0; i < 100; ++i) {
+    SizeArray from{{gen() % 41, gen() % 51}}, to{{gen() % 41, gen() % 51}};
+    std::vector<int> expected;
+    for (size_t r = from[0]; r < to[0]; ++r)
+      for (size_t c = from[1]; c < to[1]; ++c)
+        if (sm.find(r, c) != nullptr)
+          expected.push_back(sm(r, c));
+    std::vector<int> visited;
+    sm.ForEachInRange(from, to, [&](const SizeArray& ind, int& v) {
+        EXPECT_EQ(&sm(ind[0], ind[1]), &v);
+        visited.push_back(v);
+      });
+    std::sort(expected.begin(), expected.end());
+    std::sort(visited.begin(), visited.end());
+    EXPECT_EQ(expected, visited);
+  }
+}
+
+TEST(SparseMortonListTest, Runs) {
+  int zero = 0;
+  SparseMortonList<int> sl(&zero, 3, 4);
+  sl.get({0, 1}) = 1;
+  sl.get({0, 2}) = 2;
+  sl.get({2, 3}) = 3;
+
+  auto runs = sl.runs();
+  ASSERT_EQ(5, runs.size());
+  EXPECT_TRUE(runs[0].repeated);
+  EXPECT_EQ(1, runs[1][0]);
+  EXPECT_EQ(2, runs[2][0]);
+  EXPECT_EQ(&zero, runs[3].value);
+  EXPECT_EQ(8, runs[3].length);  // spans 3 rows
+  EXPECT_EQ(3, runs[4][0]);
+  EXPECT_EQ(11, runs[4].start);
+
+  decltype(runs) col_runs;
+  sl.AppendDimRuns(0, {{0, 3}}, 0, &col_runs);
+  ASSERT_EQ(2, col_runs.size());
+  EXPECT_EQ(2, col_runs[0].length);
+  EXPECT_EQ(3, col_runs[1][0]);
+  EXPECT_EQ(2, col_runs[1].start);
+  EXPECT_EQ(3, sl.nondefault_count());  // not inserted by the runs
+}
+
+TEST(SparseListTest, OccupancyFilter) {
+  static int zero = 0;
+  SparseHashList<int, 2> sl(SparseListTag<2>(), &zero, 100, 100);
+  EXPECT_EQ(64, sl.occupancy_memory_usage());
+  EXPECT_EQ(nullptr, sl.find({{1, 2}}));
+  sl.get({1, 2}) = 12;
+  EXPECT_EQ(64, sl.occupancy_memory_usage());
+  EXPECT_EQ(12, sl(1, 2));
+  EXPECT_EQ(nullptr, sl.find({{2, 1}}));
+
+  // the filter grows as the values are inserted
+  for (size_t i = 0; i < 100; ++i)
+    sl.get({i, (7 * i) % 100}) = i + 1;
+  EXPECT_LT(64, sl.occupancy_memory_usage());
+  for (size_t row = 0; row < 100; ++row)
+    for (size_t col = 0; col < 100; ++col)
+      EXPECT_EQ(col == (7 * row) % 100 ? row + 1 : row == 1 && col == 2 ? 12
+                : 0, sl(row, col)) << row << ", " << col;
+  EXPECT_EQ(101, sl.nondefault_count());
+}
@@ -43,4 +43,75 @@ bool CheckSortedEq(InputIterator1 exp_begin, InputIterator1 exp_end,
   return CheckEq(exp_begin, exp_end, act_begin, act_end, equals);
 }
 
+// Verifies that the (dense) iteration and runs() of the list visit exactly
+// the elements returned by get() in row-major order
+template<class ListType>
+void ExpectDenseIteration(const ListType& list) {
+  typedef typename ListType::SizeArray SizeArray;
+  size_t count = 1;
+  for (const auto& size : list.sizes())
+    count *= size;
+  EXPECT_EQ(count, list.size());
+
+  const auto runs = list.runs();
+  size_t run = 0, run_pos = 0;
+  auto it = list.begin();
+  SizeArray indexes{};
+  for (size_t i = 0; i < count; ++i) {
+    const auto& expected = list.get(SizeArray(indexes));
+    EXPECT_EQ(&expected, &*it) << "i = " << i;
+    ASSERT_LT(run, runs.size()) << "i = " << i;
+    EXPECT_EQ(i, runs[run].start + run_pos);
+    EXPECT_EQ(&expected, &runs[run][run_pos]) << "i = " << i;
+    if (++run_pos == runs[run].length)
+      ++run, run_pos = 0;
+    ++it;
+    for (unsigned dim = indexes.size(); dim--; ) {
+      if (++indexes[dim] < list.sizes()[dim])
+        break;
+      indexes[dim] = 0;
+    }
+  }
+  EXPECT_EQ(list.end(), it);
+  EXPECT_EQ(runs.size(), run);
+}
+
+// Verifies that the runs along each dimension through every line of the list
+// consist of exactly the elements returned by get()
+template<class ListType>
+void ExpectDimRuns(const ListType& list) {
+  typedef typename ListType::SizeArray SizeArray;
+  for (unsigned dim = 0; dim < list.sizes().size(); ++dim) {
+    SizeArray indexes{};
+    bool more = true;
+    while (more) {
+      decltype(list.runs()) runs;
+      list.AppendDimRuns(dim, indexes, 0, &runs);
+      size_t run = 0, run_pos = 0;
+      SizeArray cur(indexes);
+      for (cur[dim] = 0; cur[dim] < list.sizes()[dim]; ++cur[dim]) {
+        ASSERT_LT(run, runs.size()) << "dim = " << dim;
+        EXPECT_EQ(cur[dim], runs[run].start + run_pos);
+        EXPECT_EQ(&list.get(SizeArray(cur)), &runs[run][run_pos])
+            << "dim = " << dim << ", index = " << cur[dim];
+        if (++run_pos == runs[run].length)
+          ++run, run_pos = 0;
+      }
+      EXPECT_EQ(runs.size(), run) << "dim = " << dim;
+
+      // advance to the next line (skipping the index in dim)
+      more = false;
+      for (unsigned d = indexes.size(); d--; ) {
+        if (d == dim)
+          continue;
+        if (++indexes[d] < list.sizes()[d]) {
+          more = true;
+          break;
+        }
+        indexes[d] = 0;
+      }
+    }
+  }
+}
+
 #endif  // CPPVIEWS_TEST_HPP_
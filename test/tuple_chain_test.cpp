@@ -0,0 +1,136 @@
+#include "../src/tuple_chain.hpp"
+
+#include "../src/chain.hpp"
+#include "../src/diag.hpp"
+#include "test.hpp"
+
+#include <array>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+typedef std::array<size_t, 2> SizeArray;
+
+// Builds the same (nested) chain as a Chain and a TupleChain:
+//    0 1 2 3 4 5 6
+//   +---+-----------+
+// 0 |1 0|2 2 0 0 0 0|
+// 1 |0 1|0 0 2 2 0 0|
+//   +---+---+---+---+
+// 2      |3 0|   |4 0|
+// 3      |0 3|   |0 4|
+//        +---+   +---+
+typedef Diag<int, unsigned, 1, 1> Diag11;
+typedef Diag<int, unsigned, 1, 2> Diag12;
+
+int default_val = -1;
+
+Diag11 MakeDiag11(size_t size, int val) {
+  Diag11 d(&default_val, size, size);
+  for (unsigned i = 0; i < size; ++i)
+    d(i, i) = val;
+  return d;
+}
+
+Diag12 MakeDiag12(int val) {
+  Diag12 d(&default_val, 2, 6);
+  for (unsigned i = 0; i < 4; ++i)
+    d(i / 2, i) = val;
+  return d;
+}
+
+}  // namespace
+
+TEST(TupleChainTest, SameAsChain) {
+  Chain<ListBase<int, 2>, 1> c(
+      ListVector<ListBase<int, 2> >()
+      .Append(MakeDiag11(2, 1))
+      .Append(
+          ChainTag<0>(), ListVector<ListBase<int, 2> >()
+          .Append(MakeDiag12(2))
+          .Append(
+              ChainTag<1>(), ListVector<ListBase<int, 2> >()
+              .Append(MakeDiag11(2, 3))
+              .Append(MakeDiag11(2, 4))
+              , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 4}})
+              , 2, 6)
+          , &default_val, ChainOffsetVector<2>({{0, 0}, {2, 0}})
+          , 4, 6)
+      , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 2}})
+      , 4, 8);
+
+  auto tc = MakeList(
+      TupleChainTag<1>(), std::make_tuple(
+          MakeDiag11(2, 1),
+          MakeList(
+              TupleChainTag<0>(), std::make_tuple(
+                  MakeDiag12(2),
+                  MakeList(
+                      TupleChainTag<1>(), std::make_tuple(
+                          MakeDiag11(2, 3),
+                          MakeDiag11(2, 4))
+                      , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 4}})
+                      , 2, 6))
+              , &default_val, ChainOffsetVector<2>({{0, 0}, {2, 0}})
+              , 4, 6))
+      , &default_val, ChainOffsetVector<2>({{0, 0}, {0, 2}})
+      , 4, 8);
+  static_assert(std::is_same<
+                decltype(tc),
+                TupleChain<1, Diag11,
+                           TupleChain<0, Diag12,
+                                      TupleChain<1, Diag11, Diag11> > >
+                >::value, "MakeList deduces the type");
+
+  ASSERT_EQ(c.sizes(), tc.sizes());
+  EXPECT_EQ(c.size(), tc.size());
+  for (size_t row = 0; row < c.sizes()[0]; ++row)
+    for (size_t col = 0; col < c.sizes()[1]; ++col) {
+      EXPECT_EQ(c(row, col), tc(row, col)) << row << ", " << col;
+      EXPECT_EQ(&tc(row, col), &tc.get({row, col}));
+    }
+  EXPECT_EQ(3, tc(2, 2));
+  EXPECT_EQ(4, tc(3, 7));
+  EXPECT_EQ(-1, tc(3, 0));  // not within any sublist
+  EXPECT_EQ(-1, tc(2, 5));  // in the gap between the innermost sublists
+
+  // the values are in the same order
+  std::vector<int> c_values(c.values().begin(), c.values().end());
+  std::vector<int> tc_values(tc.values().begin(), tc.values().end());
+  EXPECT_EQ(c_values, tc_values);
+  EXPECT_EQ(c.values().size(), tc.values().size());
+
+  std::vector<int> visited;
+  tc.ForEach([&](int& v) { visited.push_back(v); });
+  EXPECT_EQ(c_values, visited);
+
+  std::vector<SizeArray> indexes;
+  tc.ForEachEntry([&](const SizeArray& ind, int& v) {
+      EXPECT_EQ(&tc(ind[0], ind[1]), &v);
+      indexes.push_back(ind);
+    });
+  EXPECT_EQ(c_values.size(), indexes.size());
+
+  // the dense iteration (via runs) is the same as via get()
+  auto it = tc.begin();
+  for (size_t row = 0; row < tc.sizes()[0]; ++row)
+    for (size_t col = 0; col < tc.sizes()[1]; ++col, ++it)
+      ASSERT_EQ(&tc(row, col), &*it) << row << ", " << col;
+  EXPECT_EQ(tc.end(), it);
+}
+
+TEST(TupleChainTest, Move) {
+  auto tc = MakeList(TupleChainTag<0>(),
+                     std::make_tuple(MakeDiag11(2, 5), MakeDiag11(1, 6)),
+                     &default_val, ChainOffsetVector<2>({{0, 0}, {2, 1}}),
+                     3, 2);
+  decltype(tc) moved(std::move(tc));
+  EXPECT_EQ(5, moved(1, 1));
+  EXPECT_EQ(6, moved(2, 1));
+  EXPECT_EQ(-1, moved(2, 0));
+  EXPECT_EQ(-1, moved(0, 1));  // off the diagonal
+  std::vector<int> values(moved.values().begin(), moved.values().end());
+  EXPECT_EQ(std::vector<int>({5, 5, 6}), values);
+  EXPECT_EQ(&moved.sublist<1>()(0, 0), &moved(2, 1));
+}
@@ -0,0 +1,41 @@
+#include "../src/util/aligned_allocator.hpp"
+#include "test.hpp"
+
+#include <list>
+#include <numeric>
+#include <vector>
+
+#include <cstdint>
+
+namespace {
+
+template<size_t alignment, typename T>
+bool IsAligned(const T* p) {
+  return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+}  // namespace
+
+TEST(AlignedAllocatorTest, Vector) {
+  std::vector<char, AlignedAllocator<char, 64> > v;
+  for (int i = 0; i < 100; ++i) {
+    v.push_back(i);
+    ASSERT_TRUE(IsAligned<64>(v.data())) << "size = " << v.size();
+  }
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i, v[i]);
+
+  std::vector<double, AlignedAllocator<double, 256> > big(1000, 1.5);
+  EXPECT_TRUE(IsAligned<256>(big.data()));
+  auto copy(big);
+  EXPECT_TRUE(IsAligned<256>(copy.data()));
+  EXPECT_EQ(big, copy);
+}
+
+TEST(AlignedAllocatorTest, Rebind) {
+  std::list<int, AlignedAllocator<int, 32> > l;
+  for (int i = 0; i < 10; ++i)
+    l.push_back(i);
+  EXPECT_EQ(45, std::accumulate(l.begin(), l.end(), 0));
+  EXPECT_TRUE((AlignedAllocator<int, 32>() == AlignedAllocator<char, 32>()));
+}
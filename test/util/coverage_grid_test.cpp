@@ -0,0 +1,66 @@
+#include "../src/util/coverage_grid.hpp"
+
+#include "test.hpp"
+
+#include <vector>
+
+TEST(CoverageGridTest, Exact) {
+  typedef CoverageGrid<2> Grid;
+  Grid grid({{4, 6}}, std::vector<Grid::Box>{
+      {{{0, 0}}, {{1, 2}}},
+      {{{2, 3}}, {{4, 6}}},
+      {{{3, 0}}, {{3, 6}}},  // empty
+    });
+  EXPECT_FALSE(grid.empty());
+  EXPECT_EQ(24, grid.cell_count());
+  for (size_t row = 0; row < 4; ++row)
+    for (size_t col = 0; col < 6; ++col)
+      EXPECT_EQ((row < 1 && col < 2) || (row >= 2 && col >= 3),
+                grid.covers({{row, col}})) << row << ", " << col;
+}
+
+TEST(CoverageGridTest, Coarse) {
+  typedef CoverageGrid<3> Grid;
+  std::vector<Grid::Box> boxes{
+    {{{1, 0, 5}}, {{2, 1, 6}}},
+    {{{30, 40, 50}}, {{31, 100, 51}}},
+  };
+  for (size_t max_cell_count : {1, 2, 10, 100, 1000}) {
+    Grid grid({{64, 100, 60}}, boxes, max_cell_count);
+    EXPECT_GE(max_cell_count, grid.cell_count());
+    // no false negatives
+    for (const auto& box : boxes)
+      for (size_t i = box.first[0]; i < box.second[0]; ++i)
+        for (size_t j = box.first[1]; j < box.second[1]; ++j)
+          for (size_t k = box.first[2]; k < box.second[2]; ++k)
+            ASSERT_TRUE(grid.covers({{i, j, k}})) << i << ", " << j << ", "
+                                                  << k;
+  }
+  EXPECT_FALSE(Grid({{64, 100, 60}}, boxes, 1000).covers({{63, 0, 0}}));
+}
+
+TEST(CoverageGridTest, Mark) {
+  typedef CoverageGrid<2> Grid;
+  Grid grid({{64, 64}}, {}, 64);  // cells of 8 x 8
+  EXPECT_EQ(64, grid.cell_count());
+  EXPECT_FALSE(grid.covers({{0, 0}}));
+  EXPECT_FALSE(grid.covers({{63, 63}}));
+
+  grid.Mark({{{10, 20}}, {{11, 21}}});
+  EXPECT_TRUE(grid.covers({{10, 20}}));
+  EXPECT_TRUE(grid.covers({{8, 16}}));  // the same cell
+  EXPECT_TRUE(grid.covers({{15, 23}}));
+  EXPECT_FALSE(grid.covers({{16, 20}}));
+  EXPECT_FALSE(grid.covers({{10, 24}}));
+
+  grid.Mark({{{63, 10}}, {{64, 50}}});
+  EXPECT_FALSE(grid.covers({{63, 7}}));
+  EXPECT_TRUE(grid.covers({{63, 8}}));
+  EXPECT_TRUE(grid.covers({{56, 30}}));
+  EXPECT_TRUE(grid.covers({{63, 55}}));  // rounded up to the cell
+  EXPECT_FALSE(grid.covers({{63, 56}}));
+  EXPECT_FALSE(grid.covers({{55, 30}}));
+
+  // the bits of 64 cells take a single word, and so does their summary
+  EXPECT_EQ((1 + 1) * sizeof(uint64_t), grid.memory_usage());
+}
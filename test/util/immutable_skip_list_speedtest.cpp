@@ -1,4 +1,5 @@
 #include "../src/util/immutable_skip_list.hpp"
+#include "../src/util/prefix_index.hpp"
 #include "test.hpp"
 #include "bucket_search_vector.hpp"
 
@@ -102,6 +103,15 @@ class ImmutableSkipListSpeedtestBase : public ::testing::Test {
   inline void Get(const L& l,
                   size_t global_index, size_t offset = 0) {
     auto p = l.get(global_index, offset);
+    Hash(p);
+  }
+
+  template<class Cursor>
+  inline void Seek(Cursor& c, size_t global_index) {
+    Hash(c.seek(global_index));
+  }
+
+  inline void Hash(const std::pair<size_t, size_t>& p) {
     hash_ = hasher_((p.first << 4) ^ p.second) + hash_ * 31;
   }
 
@@ -189,6 +199,48 @@ class ImmutableSkipListSpeedtest
     }
   }
 
+  // Looks up the same elements as GetRandom, but in batches
+  template<class L>
+  void GetRandomBatch(const L& l, int count) {
+    constexpr int kBatchSize = 256;
+    size_t indexes[kBatchSize];
+    typename L::Position positions[kBatchSize];
+    size_t last = 1;
+    for (int itr = 0; itr < count; ) {
+      int batch_size = 0;
+      for (; batch_size < kBatchSize && itr < count; ++batch_size, ++itr) {
+        indexes[batch_size] = last & (sizes_sum() - 1);
+        last = itr + last * gLastPrime;
+      }
+      l.get_batch(indexes, batch_size, positions);
+      for (int i = 0; i < batch_size; ++i)
+        this->Hash(positions[i]);
+    }
+  }
+
+  // Looks up elements by a random walk of steps in range [-16, 15]
+  // (either from the root or via a cursor, which is expected to be faster)
+  template<class L>
+  void GetLocal(const L& l, int count) {
+    size_t last = 1, index = sizes_sum() >> 1;
+    for (int itr = 0; itr < count; ++itr) {
+      index = (index + (last & 0x1F) - 16) & (sizes_sum() - 1);
+      this->Get(l, index);
+      last = itr + last * gLastPrime;
+    }
+  }
+
+  template<class L>
+  void SeekLocal(const L& l, int count) {
+    auto cursor = l.cursor();
+    size_t last = 1, index = sizes_sum() >> 1;
+    for (int itr = 0; itr < count; ++itr) {
+      index = (index + (last & 0x1F) - 16) & (sizes_sum() - 1);
+      this->Seek(cursor, index);
+      last = itr + last * gLastPrime;
+    }
+  }
+
   struct Pow2BucketSizeGetter {
     constexpr size_t operator()(size_t index) const {
       // ...00 -> 2 + 2     = 4
@@ -259,6 +311,30 @@ TEST_P(BigImmutableSkipListSpeedtest, Get1MRandom) {
   this->GetRandom(l, 1000000);
 }
 
+TEST_P(BigImmutableSkipListSpeedtest, Get1MRandomBatch) {
+  auto l = ImmutableSkipList<decltype(bsg_)>(bucket_count(), bsg_);
+  this->GetRandomBatch(l, 1000000);
+}
+
+TEST_P(BigImmutableSkipListSpeedtest, Get1MRandomUniform) {
+  struct UniformBucketSizeGetter {      // same sum of sizes as bsg_
+    constexpr size_t operator()(size_t index) const { return 4; }
+  };
+  auto l = ImmutableSkipList<UniformBucketSizeGetter>(bucket_count());
+  ASSERT_EQ(4, l.uniform_size());
+  this->GetRandom(l, 1000000);
+}
+
+TEST_P(BigImmutableSkipListSpeedtest, Get1MLocal) {
+  auto l = ImmutableSkipList<decltype(bsg_)>(bucket_count(), bsg_);
+  this->GetLocal(l, 1000000);
+}
+
+TEST_P(BigImmutableSkipListSpeedtest, Seek1MLocal) {
+  auto l = ImmutableSkipList<decltype(bsg_)>(bucket_count(), bsg_);
+  this->SeekLocal(l, 1000000);
+}
+
 class HugeImmutableSkipListSpeedtest : public ImmutableSkipListSpeedtest {};
 INSTANTIATE_TEST_CASE_P(LgBucketCountMin25, HugeImmutableSkipListSpeedtest,
                         ::testing::Values(
@@ -319,3 +395,42 @@ TEST_P(MediImmutableSkipListSpeedtest, Get6MRandomBucketSearchVector) {
   auto l = BucketSearchVector<decltype(bsg_)>(bucket_count(), bsg_);
   this->GetRandom(l, 6000000);
 }
+
+// Compares the layouts of the search tree (for both small and huge bucket
+// counts, which do not fit in the cache), i.e., binary (ImmutableSkipList),
+// Eytzinger (BFS) and B+-tree with 16 keys per node
+class SkipListLayoutSpeedtest : public ImmutableSkipListSpeedtest {
+ protected:
+  template<class L>
+  void GetRandomAnySize(const L& l, int count) {
+    size_t last = 1;
+    for (int itr = 0; itr < count; ++itr) {
+      this->Get(l, last % sizes_sum());
+      last = itr + last * gLastPrime;
+    }
+  }
+};
+INSTANTIATE_TEST_CASE_P(Lg10BucketCount, SkipListLayoutSpeedtest,
+                        ::testing::Values(
+                            size_t(10),
+                            size_t(100),
+                            size_t(1000),
+                            size_t(10000),
+                            size_t(100000),
+                            size_t(1000000),
+                            size_t(10000000)));
+
+TEST_P(SkipListLayoutSpeedtest, Get1MRandomBinary) {
+  auto l = ImmutableSkipList<decltype(bsg_)>(bucket_count(), bsg_);
+  this->GetRandomAnySize(l, 1000000);
+}
+
+TEST_P(SkipListLayoutSpeedtest, Get1MRandomEytzinger) {
+  auto l = EytzingerPrefixIndex<decltype(bsg_)>(bucket_count(), bsg_);
+  this->GetRandomAnySize(l, 1000000);
+}
+
+TEST_P(SkipListLayoutSpeedtest, Get1MRandomBTree) {
+  auto l = BTreePrefixIndex<decltype(bsg_)>(bucket_count(), bsg_);
+  this->GetRandomAnySize(l, 1000000);
+}
@@ -3,7 +3,9 @@
 #include "../src/util/bit_twiddling.hpp"
 #include "test.hpp"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 TEST(ImmutableSkipListTest, ConstructFull) {
   ImmutableSkipList<> sl(8);
@@ -147,3 +149,135 @@ TEST(ImmutableSkipListTest, GetZeroSize) {
   EXPECT_EQ(0, pos.second);
   EXPECT_GE(7, pos.first);
 }
+
+TEST(ImmutableSkipListTest, GetOffsetMixedSizes) {
+  struct BucketSizeGetter {
+    size_t operator()(size_t bkt_ind) const { return 1 + bkt_ind % 5; }
+  } bsg;
+  ImmutableSkipList<BucketSizeGetter> sl(100, bsg);
+
+  // skips from a right child must not stop at its parent
+  size_t start = 0;  // the global index of the first element in off-th bucket
+  for (size_t off = 0; off < sl.bucket_count(); start += bsg(off++)) {
+    for (size_t ind = 0; start + ind < 300; ++ind) {
+      ASSERT_EQ(sl.get(start + ind), sl.get(ind, off))
+          << "get(" << ind << ", " << off << ") incorrect";
+    }
+  }
+}
+
+TEST(ImmutableSkipListTest, GetBackwardUniqueSizes) {
+  struct BucketSizeGetter {
+    size_t operator()(size_t bkt_ind) const { return 1 + bkt_ind % 3; }
+  } bsg;
+  ImmutableSkipList<BucketSizeGetter> sl(37, bsg);
+
+  size_t start = 0;  // the global index of the first element in off-th bucket
+  for (size_t off = 0; off < sl.bucket_count(); start += bsg(off++)) {
+    for (size_t dist = 1; dist <= start; ++dist) {
+      ASSERT_EQ(sl.get(start - dist), sl.get_backward(dist, off))
+          << "get_backward(" << dist << ", " << off << ") incorrect";
+    }
+  }
+}
+
+TEST(ImmutableSkipListTest, GetBackwardZeroSize) {
+  struct BucketSizeGetter {
+    size_t operator()(size_t bkt_ind) const {
+      return bkt_ind % 4 == 1 ? 2 : 0;
+    }
+  };
+  ImmutableSkipList<BucketSizeGetter> sl(14);
+  typedef decltype(sl)::Position Pos;
+  EXPECT_EQ(Pos(9, 1), sl.get_backward(1, 10));
+  EXPECT_EQ(Pos(9, 1), sl.get_backward(1, 13));
+  EXPECT_EQ(Pos(5, 0), sl.get_backward(2, 9));
+  EXPECT_EQ(Pos(1, 0), sl.get_backward(6, 13));
+}
+
+TEST(ImmutableSkipListTest, CursorRandomWalk) {
+  struct BucketSizeGetter {
+    size_t operator()(size_t bkt_ind) const { return 1 + bkt_ind % 5; }
+  };
+  ImmutableSkipList<BucketSizeGetter> sl(1000);
+  const size_t size = 3 * sl.bucket_count();  // 200 * (1 + 2 + 3 + 4 + 5)
+
+  auto cursor = sl.cursor();
+  size_t index = 0, last = 1;
+  for (int itr = 0; itr < 100000; ++itr) {
+    // mostly short steps, but sometimes jump far away
+    size_t step = itr % 100 ? last % 64 : last % size;
+    index = (last & 0x100 ? index + step : index + size - step) % size;
+    ASSERT_EQ(sl.get(index), cursor.seek(index)) << "seek(" << index << ")";
+    EXPECT_EQ(sl.get(index).first, cursor.bucket_index());
+    last = itr + last * 65521;
+  }
+}
+
+TEST(ImmutableSkipListTest, GetBatch) {
+  struct BucketSizeGetter {
+    size_t operator()(size_t bkt_ind) const { return bkt_ind % 3; }
+  };
+  for (size_t bucket_count : {1, 2, 3, 4, 7, 100}) {
+    ImmutableSkipList<BucketSizeGetter> sl(bucket_count);
+    std::vector<size_t> indexes;
+    for (size_t bkt_ind = 0; bkt_ind < bucket_count; ++bkt_ind)
+      for (size_t i = BucketSizeGetter()(bkt_ind); i--; )
+        indexes.push_back(indexes.size());
+    std::reverse(indexes.begin(), indexes.end());  // not in the group order
+    std::vector<decltype(sl)::Position> positions(indexes.size());
+    sl.get_batch(indexes.data(), indexes.size(), positions.data());
+    for (size_t i = 0; i < indexes.size(); ++i)
+      EXPECT_EQ(sl.get(indexes[i]), positions[i])
+          << "get(" << indexes[i] << ") of " << bucket_count;
+  }
+}
+
+TEST(ImmutableSkipListTest, GetUniformSizes) {
+  struct BucketSizeGetter {
+    size_t operator()(size_t bkt_ind) const {
+      if (bkt_ind < exceptions.size() && exceptions[bkt_ind] != size_t(-1))
+        return exceptions[bkt_ind];
+      return bkt_ind == last_bkt_ind ? last_size : 3;
+    }
+    std::vector<size_t> exceptions;   // size_t(-1) if not an exception
+    size_t last_bkt_ind;
+    size_t last_size;
+  };
+  const size_t x = -1;
+  for (const auto& bsg : {
+      BucketSizeGetter{{}, 20, 3},              // no exceptions
+      BucketSizeGetter{{0}, 20, 0},             // sentinels (like Chain)
+      BucketSizeGetter{{}, 20, 1},              // a shorter last bucket
+      BucketSizeGetter{{x, 7, x, x, 0}, 20, 2}, // mixed, within the limit
+      BucketSizeGetter{{1, 2, 0, 1, x, 5}, 20, 3}}) { // too many exceptions
+    ImmutableSkipList<BucketSizeGetter> sl(21, bsg);
+    const size_t exception_count = std::count_if(
+        bsg.exceptions.begin(), bsg.exceptions.end(),
+        [](size_t size) { return size != size_t(-1); }) + (bsg.last_size != 3);
+    EXPECT_EQ(exception_count <= 4 ? 3 : 0, sl.uniform_size());
+
+    // compare against the positions found by linear search
+    std::vector<std::pair<size_t, size_t> > positions;
+    std::vector<size_t> starts;
+    for (size_t bkt_ind = 0; bkt_ind < sl.bucket_count(); ++bkt_ind) {
+      starts.push_back(positions.size());
+      for (size_t i = 0; i < bsg(bkt_ind); ++i)
+        positions.emplace_back(bkt_ind, i);
+    }
+    for (size_t off = 0; off < sl.bucket_count(); ++off) {
+      for (size_t i = starts[off]; i < positions.size(); ++i)
+        ASSERT_EQ(positions[i], sl.get(i - starts[off], off))
+            << "get(" << i - starts[off] << ", " << off << ")";
+      for (size_t dist = 1; dist <= starts[off]; ++dist)
+        ASSERT_EQ(positions[starts[off] - dist], sl.get_backward(dist, off))
+            << "get_backward(" << dist << ", " << off << ")";
+    }
+
+    // past the end, the position is right after the last bucket
+    if (sl.uniform_size()) {
+      EXPECT_EQ(std::make_pair(size_t(21), size_t(1)),
+                sl.get(positions.size() + 1));
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#include "../src/util/morton.hpp"
+#include "test.hpp"
+
+#include <random>
+
+TEST(MortonTest, DepositExtractBits) {
+  EXPECT_EQ(0x0, DepositBits(0x0, 0xFF));
+  EXPECT_EQ(0x14, DepositBits(0x3, 0x34));
+  EXPECT_EQ(0x24, DepositBits(0x5, 0x34));
+  EXPECT_EQ(0x3, ExtractBits(0x14, 0x34));
+  EXPECT_EQ(0x5, ExtractBits(0xE4, 0x34));
+  EXPECT_EQ(~uint64_t(), DepositBits(~uint64_t(), ~uint64_t()));
+  EXPECT_EQ(UINT64_C(0xFFFFFFFF), ExtractBits(~uint64_t(), kMortonOddBits));
+}
+
+TEST(MortonTest, EncodeDecode) {
+  EXPECT_EQ(0, MortonEncode(0, 0));
+  EXPECT_EQ(1, MortonEncode(0, 1));
+  EXPECT_EQ(2, MortonEncode(1, 0));
+  EXPECT_EQ(3, MortonEncode(1, 1));
+  EXPECT_EQ(4, MortonEncode(0, 2));
+  EXPECT_EQ(kMortonOddBits, MortonEncode(uint32_t(-1), 0));
+
+  std::mt19937 gen(42);
+  for (int i = 0; i < 1000; ++i) {
+    const uint32_t row = gen(), col = gen();
+    const uint64_t key = MortonEncode(row, col);
+    EXPECT_EQ(DepositBits(row, kMortonOddBits) |
+              DepositBits(col, kMortonEvenBits), key);
+    EXPECT_EQ(row, MortonDecodeRow(key));
+    EXPECT_EQ(col, MortonDecodeCol(key));
+  }
+}
+
+TEST(MortonTest, BigMinLitMax) {
+  // compare with the naive search through all keys in a 16 x 16 square
+  const auto in_box = [](uint64_t key, uint64_t min_key, uint64_t max_key) {
+    return MortonDecodeRow(min_key) <= MortonDecodeRow(key) &&
+        MortonDecodeRow(key) <= MortonDecodeRow(max_key) &&
+        MortonDecodeCol(min_key) <= MortonDecodeCol(key) &&
+        MortonDecodeCol(key) <= MortonDecodeCol(max_key);
+  };
+  std::mt19937 gen(42);
+  for (int i = 0; i < 200; ++i) {
+    uint32_t r0 = gen() % 16, r1 = gen() % 16, c0 = gen() % 16,
+        c1 = gen() % 16;
+    if (r0 > r1) std::swap(r0, r1);
+    if (c0 > c1) std::swap(c0, c1);
+    const uint64_t min_key = MortonEncode(r0, c0);
+    const uint64_t max_key = MortonEncode(r1, c1);
+    for (uint64_t key = min_key + 1; key < max_key; ++key) {
+      if (in_box(key, min_key, max_key))
+        continue;
+      uint64_t big_min = key + 1;
+      while (!in_box(big_min, min_key, max_key))
+        ++big_min;
+      EXPECT_EQ(big_min, MortonBigMin(key, min_key, max_key)) << key;
+      uint64_t lit_max = key - 1;
+      while (!in_box(lit_max, min_key, max_key))
+        --lit_max;
+      EXPECT_EQ(lit_max, MortonLitMax(key, min_key, max_key)) << key;
+    }
+  }
+}
@@ -0,0 +1,33 @@
+#include "../src/util/occupancy.hpp"
+#include "test.hpp"
+
+#include <random>
+#include <set>
+
+TEST(BlockedBloomFilterTest, NoFalseNegatives) {
+  BlockedBloomFilter f(1000);
+  EXPECT_EQ(1024, f.capacity());
+  EXPECT_EQ(32 * 64, f.memory_usage());
+  for (uint64_t key = 0; key < 1000; ++key)
+    EXPECT_FALSE(f.MayContain(key << 20));
+  for (uint64_t key = 0; key < 1000; ++key)
+    f.Insert(key << 20);
+  for (uint64_t key = 0; key < 1000; ++key)
+    EXPECT_TRUE(f.MayContain(key << 20)) << key;
+}
+
+TEST(BlockedBloomFilterTest, FalsePositiveRate) {
+  BlockedBloomFilter f(1 << 14);
+  std::mt19937_64 gen(42);
+  std::set<uint64_t> keys;
+  while (keys.size() < f.capacity()) {
+    const uint64_t key = gen();
+    keys.insert(key);
+    f.Insert(key);
+  }
+  size_t false_positives = 0, count = 0;
+  for (uint64_t key = 0; count < 100000; ++key)
+    if (!keys.count(key))
+      ++count, false_positives += f.MayContain(key);
+  EXPECT_LT(false_positives, count / 100);
+}
@@ -0,0 +1,87 @@
+#include "../src/util/order_statistic_tree.hpp"
+
+#include "../src/list.hpp"
+#include "../src/util/immutable_skip_list.hpp"
+#include "test.hpp"
+
+#include <numeric>
+#include <vector>
+
+class OrderStatisticTreeSpeedtest : public ::testing::Test {
+ protected:
+  static const size_t kInsertCount = 1 << 12;
+
+  struct VectorSizeGetter {
+    size_t operator()(size_t index) const { return (*sizes)[index]; }
+    const std::vector<size_t>* sizes;
+  };
+
+  void SetUp() { hash_ = 0; }
+  void TearDown() { EXPECT_NE(hash_, 0xcafebabe); }
+
+  // Inserts a bucket at a pseudo-random position, and returns its index.
+  size_t InsertSize(size_t itr) {
+    size_t index = (itr * 65521) % (sizes_.size() + 1);
+    sizes_.insert(sizes_.begin() + index, 1 + itr % 7);
+    return index;
+  }
+
+  std::vector<size_t> sizes_;
+  size_t hash_;
+};
+
+// baseline: the skip list has to be rebuilt after every insertion
+TEST_F(OrderStatisticTreeSpeedtest, Insert4KRebuildImmutable) {
+  for (size_t itr = 0; itr < kInsertCount; ++itr) {
+    InsertSize(itr);
+    VectorSizeGetter bsg{&sizes_};
+    ImmutableSkipList<VectorSizeGetter> sl(sizes_.size(), bsg);
+    hash_ = hash_ * 31 + sl.get(itr).first;
+  }
+}
+
+TEST_F(OrderStatisticTreeSpeedtest, Insert4KIncremental) {
+  OrderStatisticTree t;
+  for (size_t itr = 0; itr < kInsertCount; ++itr) {
+    size_t index = InsertSize(itr);
+    t.Insert(index, sizes_[index]);
+    hash_ = hash_ * 31 + t.get(itr).first;
+  }
+}
+
+// the portions are not moved in the container (only the tree is updated)
+TEST_F(OrderStatisticTreeSpeedtest, Insert4KMutableSimpleList) {
+  static int arr[7];
+  v::MutableSimpleList<v::PortionBase<int> > l{v::PortionVector<int>()};
+  for (size_t itr = 0; itr < kInsertCount; ++itr) {
+    size_t index = (itr * 65521) % (l.portion_count() + 1);
+    l.Insert(index, arr, 1 + itr % 7);
+    hash_ = hash_ * 31 + (&l.get(itr) - arr);
+  }
+}
+
+TEST_F(OrderStatisticTreeSpeedtest, Get1MRandom) {
+  for (size_t itr = 0; itr < kInsertCount; ++itr)
+    InsertSize(itr);
+  VectorSizeGetter bsg{&sizes_};
+  OrderStatisticTree t(sizes_.size(), bsg);
+  size_t last = 1;
+  for (int itr = 0; itr < 1000000; ++itr) {
+    hash_ = hash_ * 31 + t.get(last % t.size()).first;
+    last = itr + last * 65521;
+  }
+}
+
+TEST_F(OrderStatisticTreeSpeedtest, Get1MRandomImmutable) {
+  for (size_t itr = 0; itr < kInsertCount; ++itr)
+    InsertSize(itr);
+  VectorSizeGetter bsg{&sizes_};
+  ImmutableSkipList<VectorSizeGetter> sl(sizes_.size(), bsg);
+  const size_t size = std::accumulate(sizes_.begin(), sizes_.end(),
+                                      size_t(0));
+  size_t last = 1;
+  for (int itr = 0; itr < 1000000; ++itr) {
+    hash_ = hash_ * 31 + sl.get(last % size).first;
+    last = itr + last * 65521;
+  }
+}
@@ -0,0 +1,132 @@
+#include "../src/util/order_statistic_tree.hpp"
+
+#include "../src/util/immutable_skip_list.hpp"
+#include "test.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct VectorSizeGetter {
+  size_t operator()(size_t index) const { return sizes[index]; }
+  std::vector<size_t> sizes;
+};
+
+// Checks all positions against the ones in an ImmutableSkipList built from
+// scratch (past the end, the position is right after the last bucket).
+void ExpectSameAsRebuilt(const VectorSizeGetter& bsg,
+                         const OrderStatisticTree& t) {
+  ImmutableSkipList<VectorSizeGetter> sl(bsg.sizes.size(), bsg);
+  ASSERT_EQ(bsg.sizes.size(), t.bucket_count());
+  size_t size = 0;
+  for (auto s : bsg.sizes)
+    size += s;
+  ASSERT_EQ(size, t.size());
+
+  auto cursor = t.cursor();
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_EQ(sl.get(i), t.get(i)) << "get(" << i << ")";
+    ASSERT_EQ(sl.get(i), cursor.seek(i)) << "seek(" << i << ")";
+  }
+  for (size_t i = size; i--; )
+    ASSERT_EQ(sl.get(i), cursor.seek(i)) << "seek(" << i << ")";
+  for (size_t i = 0, j = size; i < j--; ++i) {
+    ASSERT_EQ(sl.get(i), cursor.seek(i)) << "seek(" << i << ")";
+    ASSERT_EQ(sl.get(j), cursor.seek(j)) << "seek(" << j << ")";
+  }
+  EXPECT_EQ(std::make_pair(t.bucket_count(), size_t(0)), t.get(size));
+  for (size_t off = 0, start = 0; off < t.bucket_count();
+       start += bsg(off++)) {
+    ASSERT_EQ(start, t.prefix_sum(off));
+    for (size_t i = 0; start + i < size; ++i)
+      ASSERT_EQ(sl.get(i, off), t.get(i, off))
+          << "get(" << i << ", " << off << ")";
+    for (size_t dist = 1; dist <= start; ++dist)
+      ASSERT_EQ(sl.get(start - dist), t.get_backward(dist, off))
+          << "get_backward(" << dist << ", " << off << ")";
+  }
+}
+
+}  // namespace
+
+TEST(OrderStatisticTreeTest, Empty) {
+  OrderStatisticTree t;
+  EXPECT_EQ(0, t.bucket_count());
+  EXPECT_EQ(0, t.size());
+  EXPECT_EQ(std::make_pair(size_t(0), size_t(3)), t.get(3));
+}
+
+TEST(OrderStatisticTreeTest, Construct) {
+  VectorSizeGetter bsg{{2, 0, 3, 1, 0, 0, 4, 1}};
+  OrderStatisticTree t(bsg.sizes.size(), bsg);
+  ExpectSameAsRebuilt(bsg, t);
+}
+
+TEST(OrderStatisticTreeTest, InsertErase) {
+  VectorSizeGetter bsg{{3, 1}};
+  OrderStatisticTree t(bsg.sizes.size(), bsg);
+  t.Insert(1, 2);                       // 3, 2, 1
+  bsg.sizes.insert(bsg.sizes.begin() + 1, 2);
+  ExpectSameAsRebuilt(bsg, t);
+  t.Insert(3, 0);                       // 3, 2, 1, 0
+  t.Insert(0, 5);                       // 5, 3, 2, 1, 0
+  bsg.sizes = {5, 3, 2, 1, 0};
+  ExpectSameAsRebuilt(bsg, t);
+  t.Erase(2);                           // 5, 3, 1, 0
+  t.Erase(0);                           // 3, 1, 0
+  bsg.sizes = {3, 1, 0};
+  ExpectSameAsRebuilt(bsg, t);
+  t.Erase(2);
+  t.Erase(1);
+  t.Erase(0);
+  bsg.sizes.clear();
+  ExpectSameAsRebuilt(bsg, t);
+}
+
+TEST(OrderStatisticTreeTest, InsertEraseRandom) {
+  VectorSizeGetter bsg{{1, 2, 3, 4, 5}};
+  OrderStatisticTree t(bsg.sizes.size(), bsg);
+  size_t last = 1;
+  for (int itr = 0; itr < 300; ++itr) {
+    // insert twice as often as erase, so that the tree grows
+    if (bsg.sizes.empty() || last % 3) {
+      size_t index = last % (bsg.sizes.size() + 1), size = (last >> 8) % 7;
+      t.Insert(index, size);
+      bsg.sizes.insert(bsg.sizes.begin() + index, size);
+    } else {
+      size_t index = last % bsg.sizes.size();
+      t.Erase(index);
+      bsg.sizes.erase(bsg.sizes.begin() + index);
+    }
+    if (itr % 50 == 0)
+      ExpectSameAsRebuilt(bsg, t);
+    last = itr + last * 65521;
+  }
+  ExpectSameAsRebuilt(bsg, t);
+}
+
+TEST(OrderStatisticTreeTest, Values) {
+  VectorSizeGetter bsg{{2, 0, 3}};
+  OrderStatisticTree t(bsg.sizes.size(), bsg);
+  t.Insert(1, 1, 7);                    // sizes: 2, 1, 0, 3
+  t.Insert(4, 2, 9);                    // sizes: 2, 1, 0, 3, 2
+  t.Erase(0);                           // sizes: 1, 0, 3, 2
+  std::vector<size_t> values;
+  for (size_t i = 0; i < t.bucket_count(); ++i)
+    values.push_back(t.value(i));
+  EXPECT_EQ(std::vector<size_t>({7, 1, 2, 9}), values);
+
+  std::vector<size_t> visited;
+  t.ForEachValue(3, [&visited](size_t value) { visited.push_back(value); });
+  EXPECT_EQ(std::vector<size_t>({7, 1, 2}), visited);
+
+  EXPECT_EQ(std::make_pair(size_t(7), size_t(0)), t.locate(0));
+  EXPECT_EQ(std::make_pair(size_t(2), size_t(2)), t.locate(3));
+  EXPECT_EQ(std::make_pair(size_t(9), size_t(1)), t.locate(5));
+  auto cursor = t.cursor();
+  for (size_t i = t.size(); i--; ) {
+    cursor.seek(i);
+    EXPECT_EQ(t.locate(i).first, cursor.value()) << "seek(" << i << ")";
+  }
+}
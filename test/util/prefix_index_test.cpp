@@ -0,0 +1,83 @@
+#include "../src/util/prefix_index.hpp"
+
+#include "../src/util/immutable_skip_list.hpp"
+#include "test.hpp"
+
+#include <utility>
+
+template<class PrefixIndex>
+class PrefixIndexTest : public ::testing::Test {};
+
+struct MixedSizeGetter {             // 1, 0, 2, 0, 3, 0, 1, 0, 2, ...
+  size_t operator()(size_t bkt_ind) const {
+    return bkt_ind & 1 ? 0 : 1 + (bkt_ind >> 1) % 3;
+  }
+};
+
+typedef ::testing::Types<
+  EytzingerPrefixIndex<>,
+  BTreePrefixIndex<>
+  > SingleElementTypes;
+TYPED_TEST_CASE(PrefixIndexTest, SingleElementTypes);
+
+TYPED_TEST(PrefixIndexTest, SingleElement) {
+  for (size_t bucket_count : {0, 1, 2, 15, 16, 17, 100, 256, 257}) {
+    TypeParam l(bucket_count);
+    ASSERT_EQ(bucket_count, l.bucket_count());
+    ASSERT_EQ(bucket_count, l.size());
+    for (size_t i = 0; i < bucket_count; ++i) {
+      ASSERT_EQ(std::make_pair(i, size_t(0)), l.get(i));
+      ASSERT_EQ(std::make_pair(i, size_t(0)), l.get(0, i));
+      ASSERT_EQ(i, l.prefix_sum(i));
+    }
+    // past the end, the position is right after the last bucket
+    EXPECT_EQ(std::make_pair(bucket_count, size_t(2)),
+              l.get(bucket_count + 2));
+  }
+}
+
+template<class PrefixIndex>
+class PrefixIndexMixedTest : public ::testing::Test {};
+
+typedef ::testing::Types<
+  EytzingerPrefixIndex<MixedSizeGetter>,
+  BTreePrefixIndex<MixedSizeGetter>
+  > MixedSizeTypes;
+TYPED_TEST_CASE(PrefixIndexMixedTest, MixedSizeTypes);
+
+// compares all lookups against ImmutableSkipList (including zero-size buckets)
+TYPED_TEST(PrefixIndexMixedTest, SameAsImmutableSkipList) {
+  MixedSizeGetter bsg;
+  for (size_t bucket_count : {1, 2, 3, 16, 33, 300, 1001}) {
+    ImmutableSkipList<MixedSizeGetter> sl(bucket_count);
+    TypeParam l(bucket_count);
+    const size_t size = l.size();
+    size_t start = 0;
+    for (size_t off = 0; off < bucket_count; start += bsg(off++)) {
+      ASSERT_EQ(start, l.prefix_sum(off));
+      for (size_t i = 0; start + i < size; ++i)
+        ASSERT_EQ(sl.get(i, off), l.get(i, off))
+            << "get(" << i << ", " << off << ") of " << bucket_count;
+      for (size_t dist = 1; dist <= start; ++dist)
+        ASSERT_EQ(sl.get(start - dist), l.get_backward(dist, off))
+            << "get_backward(" << dist << ", " << off << ") of "
+            << bucket_count;
+    }
+    EXPECT_EQ(start, size);
+  }
+}
+
+TYPED_TEST(PrefixIndexMixedTest, CursorRandomWalk) {
+  TypeParam l(1000);
+  const size_t size = l.size();
+  auto cursor = l.cursor();
+  size_t index = 0, last = 1;
+  for (int itr = 0; itr < 100000; ++itr) {
+    // mostly short steps, but sometimes jump far away
+    size_t step = itr % 100 ? last % 64 : last % size;
+    index = (last & 0x100 ? index + step : index + size - step) % size;
+    ASSERT_EQ(l.get(index), cursor.seek(index)) << "seek(" << index << ")";
+    EXPECT_EQ(l.get(index).first, cursor.bucket_index());
+    last = itr + last * 65521;
+  }
+}
@@ -0,0 +1,68 @@
+#include "../src/util/robin_hood_map.hpp"
+#include "test.hpp"
+
+#include <map>
+#include <random>
+#include <vector>
+
+TEST(RobinHoodMapTest, Empty) {
+  RobinHoodMap<int> m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(0, m.bucket_count());
+  EXPECT_EQ(nullptr, m.find(42));
+  EXPECT_EQ(m.end(), m.begin());
+}
+
+TEST(RobinHoodMapTest, InsertFind) {
+  RobinHoodMap<int> m;
+  m[5] = 50;
+  m[0] = 1;
+  m[uint64_t(-1)] = -1;
+  EXPECT_EQ(3, m.size());
+  EXPECT_EQ(50, *m.find(5));
+  EXPECT_EQ(1, *m.find(0));
+  EXPECT_EQ(-1, *m.find(uint64_t(-1)));
+  EXPECT_EQ(nullptr, m.find(6));
+  EXPECT_EQ(3, m.size());  // not inserted by find()
+
+  EXPECT_EQ(0, m[6]);
+  EXPECT_EQ(4, m.size());
+  EXPECT_EQ(6, m.key(3));
+  EXPECT_EQ(std::vector<int>({50, 1, -1, 0}),
+            std::vector<int>(m.begin(), m.end()));
+}
+
+TEST(RobinHoodMapTest, StableReferences) {
+  RobinHoodMap<int> m;
+  int& first = m[100];
+  first = 7;
+  for (uint64_t key = 0; key < 1000; ++key)
+    m[key << 20] = key;
+  EXPECT_EQ(&first, m.find(100));
+  EXPECT_EQ(7, first);
+  EXPECT_LE(1000 * 8 / 7, m.bucket_count());
+}
+
+TEST(RobinHoodMapTest, Random) {
+  std::mt19937_64 rng(42);
+  RobinHoodMap<uint64_t> m(100);
+  const size_t bucket_count = m.bucket_count();
+  std::map<uint64_t, uint64_t> expected;
+  for (int i = 0; i < 100; ++i) {
+    const uint64_t key = rng() % 1000;
+    m[key] = expected[key] = i;
+  }
+  EXPECT_EQ(bucket_count, m.bucket_count());  // reserved enough
+  for (int i = 0; i < 20000; ++i) {
+    const uint64_t key = rng() & 0xFFFF;
+    m[key] = expected[key] = i;
+  }
+  ASSERT_EQ(expected.size(), m.size());
+  for (uint64_t key = 0; key <= 0xFFFF; ++key) {
+    const auto it = expected.find(key);
+    if (it == expected.end())
+      EXPECT_EQ(nullptr, m.find(key)) << key;
+    else
+      EXPECT_EQ(it->second, *m.find(key)) << key;
+  }
+}
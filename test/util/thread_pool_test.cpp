@@ -0,0 +1,39 @@
+#include "../src/util/thread_pool.hpp"
+
+#include "test.hpp"
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+TEST(ThreadPoolTest, Submit) {
+  ThreadPool pool(3);
+  EXPECT_EQ(3, pool.size());
+  std::atomic<int> sum(0);
+  std::vector<std::future<int> > results;
+  for (int i = 1; i <= 100; ++i)
+    results.push_back(pool.Submit([&sum, i] { sum += i; return i * i; }));
+  int square_sum = 0;
+  for (auto& result : results)
+    square_sum += result.get();
+  EXPECT_EQ(5050, sum);
+  EXPECT_EQ(338350, square_sum);
+}
+
+TEST(ThreadPoolTest, Exception) {
+  ThreadPool pool(1);
+  auto result = pool.Submit([]() -> int { throw std::runtime_error("x"); });
+  EXPECT_THROW(result.get(), std::runtime_error);
+  EXPECT_EQ(1, pool.Submit([] { return 1; }).get());  // still works
+}
+
+TEST(ThreadPoolTest, DestructorDrains) {
+  std::atomic<int> count(0);
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 50; ++i)
+      pool.Submit([&count] { ++count; });
+  }
+  EXPECT_EQ(50, count);
+}
@@ -0,0 +1,115 @@
+#include "../src/chain.hpp"
+#include "../src/diag.hpp"
+#include "../src/list.hpp"
+#include "../src/sparse_list.hpp"
+#include "test.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+
+size_t gAllocCount = 0;
+
+}  // namespace
+
+// count all allocations (in this binary) to verify that iterators avoid them
+void* operator new(size_t size) {
+  ++gAllocCount;
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+class ViewSpeedTest : public ::testing::Test {
+ protected:
+  static const int kRepeatCount = 1 << 10;
+
+  void SetUp() { hash_ = 0; }
+
+  // Iterates over the values via polymorphic iterators, and copies them
+  // (both directly and by copying the View<T>::Iterator wrappers).
+  // Returns the number of allocations done in the meantime.
+  template<typename T>
+  size_t IterateValues(const View<T>& values) {
+    const size_t alloc_count = gAllocCount;
+    for (int i = 0; i < kRepeatCount; ++i) {
+      auto it_end = values.end();
+      for (auto it = values.begin(); it != it_end; ++it) {
+        auto copy = it;
+        hash_ = hash_ * 31 + *copy++;
+        copy = it_end;
+      }
+    }
+    return gAllocCount - alloc_count;
+  }
+
+  size_t hash_;
+};
+
+TEST_F(ViewSpeedTest, SimpleListZeroAlloc) {
+  std::vector<int> arr(100, 1);
+  SimpleList<PortionBase<int> > l(PortionVector<int>()
+                                  .Append(arr.data(), 50)
+                                  .Append(arr.begin() + 50, 50));
+  EXPECT_EQ(0, IterateValues(l.values()));
+
+  auto l2 = MakeList(PortionVector<int, Portion<int*> >()
+                     .Append(arr.data(), 100));
+  EXPECT_EQ(0, IterateValues(l2.values()));
+}
+
+TEST_F(ViewSpeedTest, DiagZeroAlloc) {
+  static int default_val = 0;
+  Diag<int, unsigned, 2, 3> d_2_3(&default_val, 100, 151);
+  EXPECT_EQ(0, IterateValues(d_2_3.values()));
+  Diag<int, unsigned, 1, 1> d_1_1(&default_val, 100, 100);
+  EXPECT_EQ(0, IterateValues(d_1_1.values()));
+}
+
+TEST_F(ViewSpeedTest, SparseHashListZeroAlloc) {
+  int zero = 0;
+  SparseHashList<int, 2> sl(SparseListTag<2>(), &zero, 100, 100);
+  for (size_t i = 0; i < 100; ++i)
+    sl.get({i, 99 - i}) = i;
+  EXPECT_EQ(0, IterateValues(sl.values()));
+}
+
+TEST_F(ViewSpeedTest, ImplicitListZeroAlloc) {
+  std::vector<int> arr(10 * 10 * 10, 1);
+  auto il = MakeList([&arr](size_t i, size_t j, size_t k) {
+      return &arr[(i * 10 + j) * 10 + k];
+    }, 10, 10, 10);
+  const View<int>& v = il;
+  EXPECT_EQ(0, IterateValues(v));
+}
+
+TEST_F(ViewSpeedTest, ChainZeroAlloc) {
+  static int default_val = 0;
+  typedef Diag<int, unsigned, 1, 1> InnerView;
+  Chain<InnerView, 0> c(
+      ListVector<InnerView>()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 30, 30)
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 50, 50)
+      , &default_val);
+  EXPECT_EQ(0, IterateValues(c.values()));
+}
+
+TEST_F(ViewSpeedTest, PolymorphicChainZeroAlloc) {
+  static int default_val = 0;
+  typedef ListBase<int, 2> InnerView;
+  Chain<InnerView, 1> c(
+      ListVector<InnerView>()
+      .Append(DiagTag<unsigned, 1, 1>(), &default_val, 30, 30)
+      .Append(ChainTag<0>(), ListVector<InnerView>()
+              .Append(DiagTag<unsigned, 2, 3>(), &default_val, 20, 30)
+              .Append(DiagTag<unsigned, 1, 1>(), &default_val, 10, 30),
+              &default_val, ChainOffsetVector<2>({{0, 0}, {20, 0}}), 30, 30)
+      , &default_val);
+  EXPECT_EQ(30 + 20 * 3 + 10, c.values().size());
+  EXPECT_EQ(0, IterateValues(c.values()));
+}